@@ -2,25 +2,381 @@
 #include <sqlite3.h>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <limits>
+#include "../Model/Fingerprint.h"
+
+namespace {
+    // Latest schema; MigrateSchema() brings older files up to it
+    constexpr int kSchemaVersion = 7;
+    
+    void BindFingerprint(sqlite3_stmt* stmt, int index, std::uint64_t fingerprint) {
+        if (fingerprint != 0) {
+            sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(fingerprint));
+        } else {
+            sqlite3_bind_null(stmt, index);
+        }
+    }
+    
+    void BindCurrency(sqlite3_stmt* stmt, int index, CurrencyCode currency) {
+        std::string code = CurrencyToString(currency);
+        sqlite3_bind_text(stmt, index, code.c_str(), 3, SQLITE_TRANSIENT);
+    }
+    
+    CurrencyCode ColumnCurrency(sqlite3_stmt* stmt, int column) {
+        const unsigned char* text = sqlite3_column_text(stmt, column);
+        CurrencyCode currency = kDefaultCurrency;
+        if (text) {
+            ParseCurrency(reinterpret_cast<const char*>(text), currency);
+        }
+        return currency;
+    }
+    
+    // Columns 0-8 as selected by the transaction queries
+    Transaction ColumnTransaction(sqlite3_stmt* stmt) {
+        Transaction transaction;
+        transaction.id = sqlite3_column_int(stmt, 0);
+        transaction.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        transaction.amount = sqlite3_column_double(stmt, 2);
+        transaction.category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        transaction.type = static_cast<TransactionType>(sqlite3_column_int(stmt, 4));
+        transaction.date = static_cast<std::time_t>(sqlite3_column_int64(stmt, 5));
+        transaction.fingerprint = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 6));
+        transaction.currency = ColumnCurrency(stmt, 7);
+        transaction.reconciled = sqlite3_column_int(stmt, 8) != 0;
+        return transaction;
+    }
+    
+    // Prepared filter queries kept at once; past this the cache starts over
+    constexpr size_t kMaxCachedQueries = 32;
+    
+    // A compiled filter's values, in placeholder order
+    struct FilterParameter {
+        enum class Kind { Integer, Real, Text };
+        Kind kind;
+        sqlite3_int64 integer;
+        double real;
+        std::string text;
+    };
+    
+    void AddParameter(std::vector<FilterParameter>& parameters, sqlite3_int64 value) {
+        parameters.push_back({FilterParameter::Kind::Integer, value, 0.0, std::string()});
+    }
+    
+    void AddParameter(std::vector<FilterParameter>& parameters, double value) {
+        parameters.push_back({FilterParameter::Kind::Real, 0, value, std::string()});
+    }
+    
+    void AddParameter(std::vector<FilterParameter>& parameters, const std::string& value) {
+        parameters.push_back({FilterParameter::Kind::Text, 0, 0.0, value});
+    }
+    
+    // Only the shape of the filter reaches the SQL text; every value becomes
+    // a parameter, so two filters that differ in values alone compile alike
+    void CompileFilter(const TransactionFilter& filter, std::string& sql, std::vector<FilterParameter>& parameters) {
+        using Kind = TransactionFilter::Kind;
+        switch (filter.GetKind()) {
+            case Kind::All:
+                sql += "1";
+                break;
+            case Kind::Category:
+                sql += "category = ?";
+                AddParameter(parameters, filter.GetText());
+                break;
+            case Kind::Type:
+                sql += "type = ?";
+                AddParameter(parameters, static_cast<sqlite3_int64>(filter.GetValue()));
+                break;
+            case Kind::Currency:
+                sql += "currency = ?";
+                AddParameter(parameters, CurrencyToString(static_cast<CurrencyCode>(filter.GetValue())));
+                break;
+            case Kind::DateRange:
+            case Kind::AmountRange: {
+                bool dates = filter.GetKind() == Kind::DateRange;
+                bool low = dates ? filter.GetLow() != 0.0 : filter.GetLow() > -std::numeric_limits<double>::infinity();
+                bool high = dates ? filter.GetHigh() != 0.0 : filter.GetHigh() < std::numeric_limits<double>::infinity();
+                if (!low && !high) {
+                    sql += "1";
+                }
+                if (low) {
+                    sql += dates ? "date >= ?" : "amount >= ?";
+                    dates ? AddParameter(parameters, static_cast<sqlite3_int64>(filter.GetLow()))
+                          : AddParameter(parameters, filter.GetLow());
+                }
+                if (high) {
+                    sql += std::string(low ? " AND " : "") + (dates ? "date < ?" : "amount <= ?");
+                    dates ? AddParameter(parameters, static_cast<sqlite3_int64>(filter.GetHigh()))
+                          : AddParameter(parameters, filter.GetHigh());
+                }
+                break;
+            }
+            case Kind::Text: {
+                // LIKE folds ASCII case, as Matches() does; its wildcards in the text are escaped
+                std::string pattern = "%";
+                for (char c : filter.GetText()) {
+                    if (c == '%' || c == '_' || c == '\\') {
+                        pattern += '\\';
+                    }
+                    pattern += c;
+                }
+                pattern += '%';
+                sql += "description LIKE ? ESCAPE '\\'";
+                AddParameter(parameters, pattern);
+                break;
+            }
+            case Kind::And:
+            case Kind::Or: {
+                const auto& children = filter.GetChildren();
+                if (children.empty()) {
+                    sql += filter.GetKind() == Kind::And ? "1" : "0";
+                    break;
+                }
+                sql += "(";
+                for (size_t i = 0; i < children.size(); ++i) {
+                    if (i > 0) {
+                        sql += filter.GetKind() == Kind::And ? " AND " : " OR ";
+                    }
+                    CompileFilter(children[i], sql, parameters);
+                }
+                sql += ")";
+                break;
+            }
+            case Kind::Not:
+                sql += "NOT (";
+                CompileFilter(filter.GetChildren().front(), sql, parameters);
+                sql += ")";
+                break;
+        }
+    }
+    
+    void RecordChange(void* context, int operation, const char* database, const char* table, sqlite3_int64 rowid) {
+        if (std::strcmp(database, "main") != 0 || std::strcmp(table, "transactions") != 0) {
+            return;
+        }
+        
+        RowChange::Kind kind = operation == SQLITE_INSERT ? RowChange::Kind::Insert
+                               : operation == SQLITE_DELETE ? RowChange::Kind::Delete : RowChange::Kind::Update;
+        static_cast<std::vector<RowChange>*>(context)->push_back({kind, rowid});
+    }
+    
+    // Separates a journaled row's tag names; trimmed names cannot hold it
+    constexpr char kTagSeparator = '\x1f';
+    
+    // Statements a journal replay runs once per image, prepared once per replay
+    struct JournalStatements {
+        sqlite3_stmt* readRows = nullptr;
+        sqlite3_stmt* readTags = nullptr;
+        sqlite3_stmt* upsert = nullptr;
+        sqlite3_stmt* touch = nullptr;
+        sqlite3_stmt* erase = nullptr;
+        sqlite3_stmt* untag = nullptr;
+        sqlite3_stmt* name = nullptr;
+        sqlite3_stmt* tag = nullptr;
+        
+        bool Prepare(sqlite3* db) {
+            const char* const sql[] = {
+                "SELECT id, description, amount, category, type, date, fingerprint, currency, reconciled "
+                "FROM transactions WHERE id BETWEEN ? AND ? ORDER BY id;",
+                "SELECT transaction_id, name FROM transaction_tags JOIN tags ON tags.id = tag_id "
+                "WHERE transaction_id BETWEEN ? AND ? ORDER BY transaction_id, name;",
+                "INSERT INTO transactions (id, description, amount, category, type, date, fingerprint, currency, reconciled) "
+                "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) ON CONFLICT (id) DO UPDATE SET description = excluded.description, "
+                "amount = excluded.amount, category = excluded.category, type = excluded.type, date = excluded.date, "
+                "fingerprint = excluded.fingerprint, currency = excluded.currency, reconciled = excluded.reconciled;",
+                // Inserts below the highest id are invisible to the change counters; an update is not
+                "UPDATE transactions SET id = id WHERE id = ?;",
+                "DELETE FROM transactions WHERE id BETWEEN ? AND ?;",
+                "DELETE FROM transaction_tags WHERE transaction_id = ?;",
+                "INSERT OR IGNORE INTO tags (name) VALUES (?);",
+                "INSERT OR IGNORE INTO transaction_tags (tag_id, transaction_id) SELECT id, ? FROM tags WHERE name = ?;",
+            };
+            sqlite3_stmt** targets[] = { &readRows, &readTags, &upsert, &touch, &erase, &untag, &name, &tag };
+            for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); ++i) {
+                if (sqlite3_prepare_v2(db, sql[i], -1, targets[i], nullptr) != SQLITE_OK) {
+                    std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+                    return false;
+                }
+            }
+            return true;
+        }
+        
+        ~JournalStatements() {
+            for (sqlite3_stmt* stmt : { readRows, readTags, upsert, touch, erase, untag, name, tag }) {
+                sqlite3_finalize(stmt);
+            }
+        }
+    };
+    
+    bool Run(sqlite3_stmt* stmt) {
+        int result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        return result == SQLITE_DONE;
+    }
+    
+    // Appends the rows now stored at the span's ids, with their tags
+    void ReadImages(JournalStatements& statements, const JournalImage& span, std::vector<JournalImage>& images) {
+        size_t first = images.size();
+        sqlite3_bind_int(statements.readRows, 1, span.firstId);
+        sqlite3_bind_int(statements.readRows, 2, span.lastId);
+        while (sqlite3_step(statements.readRows) == SQLITE_ROW) {
+            Transaction row = ColumnTransaction(statements.readRows);
+            images.push_back({row.id, row.id, true, row, {}});
+        }
+        sqlite3_reset(statements.readRows);
+        
+        sqlite3_bind_int(statements.readTags, 1, span.firstId);
+        sqlite3_bind_int(statements.readTags, 2, span.lastId);
+        size_t next = first;
+        while (sqlite3_step(statements.readTags) == SQLITE_ROW) {
+            int id = sqlite3_column_int(statements.readTags, 0);
+            while (next < images.size() && images[next].firstId < id) {
+                ++next;
+            }
+            if (next < images.size() && images[next].firstId == id) {
+                images[next].tags.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(statements.readTags, 1)));
+            }
+        }
+        sqlite3_reset(statements.readTags);
+    }
+    
+    bool ApplyImage(JournalStatements& statements, const JournalImage& image, bool wasPresent) {
+        if (!image.present) {
+            sqlite3_bind_int(statements.erase, 1, image.firstId);
+            sqlite3_bind_int(statements.erase, 2, image.lastId);
+            return Run(statements.erase);
+        }
+        
+        const Transaction& row = image.row;
+        sqlite3_bind_int(statements.upsert, 1, image.firstId);
+        sqlite3_bind_text(statements.upsert, 2, row.description.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(statements.upsert, 3, row.amount);
+        sqlite3_bind_text(statements.upsert, 4, row.category.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(statements.upsert, 5, static_cast<int>(row.type));
+        sqlite3_bind_int64(statements.upsert, 6, static_cast<sqlite3_int64>(row.date));
+        BindFingerprint(statements.upsert, 7, row.fingerprint);
+        BindCurrency(statements.upsert, 8, row.currency);
+        sqlite3_bind_int(statements.upsert, 9, row.reconciled ? 1 : 0);
+        if (!Run(statements.upsert)) {
+            return false;
+        }
+        if (!wasPresent) {
+            sqlite3_bind_int(statements.touch, 1, image.firstId);
+            if (!Run(statements.touch)) {
+                return false;
+            }
+        }
+        
+        sqlite3_bind_int(statements.untag, 1, image.firstId);
+        if (!Run(statements.untag)) {
+            return false;
+        }
+        for (const std::string& tag : image.tags) {
+            sqlite3_bind_text(statements.name, 1, tag.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(statements.tag, 1, image.firstId);
+            sqlite3_bind_text(statements.tag, 2, tag.c_str(), -1, SQLITE_STATIC);
+            if (!Run(statements.name) || !Run(statements.tag)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // Free pages a maintenance call hands back at most (1 MB with 4 KB
+    // pages), and the share of the file that must be free before it does:
+    // inserts reuse free pages, so a little slack is cheaper than returning it
+    constexpr std::int64_t kVacuumPagesPerStep = 256;
+    constexpr std::int64_t kVacuumSlackDivisor = 16;
+    constexpr std::time_t kOptimizeInterval = 6 * 60 * 60;
+    
+    // Pages per backup step (1 MB with 4 KB pages), and the pauses that let
+    // writers in between steps
+    constexpr int kBackupPagesPerStep = 256;
+    constexpr int kBackupPauseMs = 2;
+    constexpr int kBackupBusyPauseMs = 50;
+    
+    // Copies one batch of pages; returns what sqlite3_backup_step() did
+    using BackupStep = std::function<int(sqlite3_backup* backup)>;
+    
+    bool CopyDatabase(sqlite3* destination, sqlite3* source, const DatabaseHandler::BackupProgress& progress,
+                      const BackupStep& step) {
+        sqlite3_backup* backup = sqlite3_backup_init(destination, "main", source, "main");
+        if (!backup) {
+            std::cerr << "Cannot start backup: " << sqlite3_errmsg(destination) << std::endl;
+            return false;
+        }
+        
+        int result;
+        do {
+            result = step(backup);
+            bool busy = result == SQLITE_BUSY || result == SQLITE_LOCKED;
+            if (busy) {
+                // Another connection holds a lock, or this one is mid-write: retry shortly
+                result = SQLITE_OK;
+            }
+            if (result != SQLITE_OK && result != SQLITE_DONE) {
+                break;
+            }
+            if (progress && !progress(sqlite3_backup_remaining(backup), sqlite3_backup_pagecount(backup))) {
+                break;
+            }
+            if (result == SQLITE_OK) {
+                sqlite3_sleep(busy ? kBackupBusyPauseMs : kBackupPauseMs);
+            }
+        } while (result == SQLITE_OK);
+        
+        // Finishing early rolls back whatever was written to the destination
+        sqlite3_backup_finish(backup);
+        if (result != SQLITE_OK && result != SQLITE_DONE) {
+            std::cerr << "Backup failed: " << sqlite3_errstr(result) << std::endl;
+        }
+        return result == SQLITE_DONE;
+    }
+}
 
 DatabaseHandler::DatabaseHandler(const std::string& dbPath) 
-    : db_(nullptr), dbPath_(dbPath) {
+    : db_(nullptr), dbPath_(dbPath), batchOpen_(false), batchRows_(0), stopFlusher_(false), lastOptimized_(0) {
 }
 
 DatabaseHandler::~DatabaseHandler() {
+    {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        stopFlusher_ = true;
+    }
+    batchOpened_.notify_all();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    if (db_) {
+        FlushWrites();
+        ExecuteSQL("PRAGMA optimize;");  // Recommended on close; analyzes only what the session's queries needed
+    }
+    ClearQueries();
+    ClearJournalQueries();
     if (db_) {
         sqlite3_close(db_);
     }
 }
 
 bool DatabaseHandler::Initialize() {
-    int result = sqlite3_open(dbPath_.c_str(), &db_);
+    // Serialized, so a backup can read through this connection from a worker thread
+    int result = sqlite3_open_v2(dbPath_.c_str(), &db_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX,
+                                 nullptr);
     if (result != SQLITE_OK) {
         std::cerr << "Cannot open database: " << sqlite3_errmsg(db_) << std::endl;
         return false;
     }
     
-    return CreateTables();
+    sqlite3_update_hook(db_, RecordChange, &changes_);
+    
+    // Only takes on a file with no tables yet; existing ledgers switch over
+    // in CompactStorage(). The limit keeps PRAGMA optimize quick on big ledgers.
+    ExecuteSQL("PRAGMA auto_vacuum = INCREMENTAL; PRAGMA analysis_limit = 1000;");
+    
+    return CreateTables() && MigrateSchema();
 }
 
 bool DatabaseHandler::CreateTables() {
@@ -31,184 +387,1664 @@ bool DatabaseHandler::CreateTables() {
             amount REAL NOT NULL,
             category TEXT NOT NULL,
             type INTEGER NOT NULL,
-            date INTEGER NOT NULL
+            date INTEGER NOT NULL,
+            fingerprint INTEGER,
+            currency TEXT NOT NULL DEFAULT 'USD',
+            reconciled INTEGER NOT NULL DEFAULT 0
+        );
+        
+        CREATE TABLE IF NOT EXISTS recurring_rules (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            description TEXT NOT NULL,
+            amount REAL NOT NULL,
+            category TEXT NOT NULL,
+            type INTEGER NOT NULL,
+            unit INTEGER NOT NULL,
+            interval INTEGER NOT NULL,
+            day_of_month INTEGER NOT NULL,
+            next_due INTEGER NOT NULL,
+            end_date INTEGER NOT NULL DEFAULT 0,
+            currency TEXT NOT NULL DEFAULT 'USD'
+        );
+        
+        -- Quotes as published: 1 base buys rate quote on day (calendar days
+        -- since 1970-01-01). Cross rates are derived in memory.
+        CREATE TABLE IF NOT EXISTS exchange_rates (
+            base TEXT NOT NULL,
+            quote TEXT NOT NULL,
+            day INTEGER NOT NULL,
+            rate REAL NOT NULL,
+            PRIMARY KEY (base, quote, day)
+        ) WITHOUT ROWID;
+        
+        CREATE TABLE IF NOT EXISTS settings (
+            key TEXT PRIMARY KEY,
+            value TEXT NOT NULL
+        ) WITHOUT ROWID;
+        
+        -- Per bucket of 1024 ids (BucketChanges::kBucketBits), the number of
+        -- updates and deletes made to it by any program. Built-in SQL only, so
+        -- the triggers work for every writer, sqlite3 shell and scripts
+        -- included. Inserts are not counted: ids only grow, so new rows are
+        -- the ones above the highest id already seen, and imports stay fast.
+        CREATE TABLE IF NOT EXISTS transaction_changes (
+            bucket INTEGER PRIMARY KEY,
+            changes INTEGER NOT NULL
         );
+        
+        CREATE TRIGGER IF NOT EXISTS transactions_count_update AFTER UPDATE ON transactions BEGIN
+            INSERT INTO transaction_changes (bucket, changes) VALUES (OLD.id >> 10, 1)
+                ON CONFLICT (bucket) DO UPDATE SET changes = changes + 1;
+            INSERT INTO transaction_changes (bucket, changes) VALUES (NEW.id >> 10, 1)
+                ON CONFLICT (bucket) DO UPDATE SET changes = changes + 1;
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS transactions_count_delete AFTER DELETE ON transactions BEGIN
+            INSERT INTO transaction_changes (bucket, changes) VALUES (OLD.id >> 10, 1)
+                ON CONFLICT (bucket) DO UPDATE SET changes = changes + 1;
+        END;
     )";
     
     return ExecuteSQL(createTableSQL);
 }
 
-bool DatabaseHandler::ExecuteSQL(const std::string& sql) {
-    char* errorMessage = nullptr;
-    int result = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errorMessage);
+bool DatabaseHandler::MigrateSchema() {
+    // PRAGMA user_version records the last migration applied to this file
+    int version = GetSchemaVersion();
+    if (version >= kSchemaVersion) {
+        return true;
+    }
     
-    if (result != SQLITE_OK) {
-        std::cerr << "SQL error: " << errorMessage << std::endl;
-        sqlite3_free(errorMessage);
+    if (!ExecuteSQL("BEGIN IMMEDIATE;")) {
         return false;
     }
     
-    return true;
+    bool migrated = true;
+    if (version < 1) {
+        // Duplicate detection: a unique fingerprint per row (NULLs do not collide)
+        migrated = (HasColumn("transactions", "fingerprint") ||
+                    ExecuteSQL("ALTER TABLE transactions ADD COLUMN fingerprint INTEGER;")) &&
+                   BackfillFingerprints() &&
+                   ExecuteSQL("CREATE UNIQUE INDEX IF NOT EXISTS idx_transactions_fingerprint ON transactions(fingerprint);");
+    }
+    
+    if (migrated && version < 2) {
+        // Currencies: everything stored so far was entered as dollars
+        migrated = (HasColumn("transactions", "currency") ||
+                    ExecuteSQL("ALTER TABLE transactions ADD COLUMN currency TEXT NOT NULL DEFAULT 'USD';")) &&
+                   (HasColumn("recurring_rules", "currency") ||
+                    ExecuteSQL("ALTER TABLE recurring_rules ADD COLUMN currency TEXT NOT NULL DEFAULT 'USD';"));
+    }
+    
+    if (migrated && version < 3) {
+        // Date order for loading the cache and date-range scans; the rowid
+        // rides along in every index entry, so (date, id) order needs no sort
+        migrated = ExecuteSQL("CREATE INDEX IF NOT EXISTS idx_transactions_date ON transactions(date);");
+    }
+    
+    if (migrated && version < 4) {
+        // Tags: names once, then one (tag, transaction) pair per assignment,
+        // clustered by tag for loading and indexed by transaction for deletes
+        migrated = ExecuteSQL(R"(
+            CREATE TABLE IF NOT EXISTS tags (
+                id INTEGER PRIMARY KEY,
+                name TEXT NOT NULL UNIQUE
+            );
+            
+            CREATE TABLE IF NOT EXISTS transaction_tags (
+                tag_id INTEGER NOT NULL,
+                transaction_id INTEGER NOT NULL,
+                PRIMARY KEY (tag_id, transaction_id)
+            ) WITHOUT ROWID;
+            
+            CREATE INDEX IF NOT EXISTS idx_transaction_tags_transaction ON transaction_tags(transaction_id);
+            
+            CREATE TRIGGER IF NOT EXISTS transactions_untag AFTER DELETE ON transactions BEGIN
+                DELETE FROM transaction_tags WHERE transaction_id = OLD.id;
+            END;
+        )");
+    }
+    
+    if (migrated && version < 5) {
+        // Reconciliation: rows matched against a bank statement
+        migrated = HasColumn("transactions", "reconciled") ||
+                   ExecuteSQL("ALTER TABLE transactions ADD COLUMN reconciled INTEGER NOT NULL DEFAULT 0;");
+    }
+    
+    if (migrated && version < 6) {
+        // Undo journal: a step per user action and, for each id or run of
+        // ids it touched, the other side of the change
+        migrated = ExecuteSQL(R"(
+            CREATE TABLE IF NOT EXISTS journal_steps (
+                id INTEGER PRIMARY KEY,
+                label TEXT NOT NULL,
+                undone INTEGER NOT NULL DEFAULT 0
+            );
+            
+            CREATE TABLE IF NOT EXISTS journal_rows (
+                step INTEGER NOT NULL,
+                first_id INTEGER NOT NULL,
+                last_id INTEGER NOT NULL,
+                present INTEGER NOT NULL,
+                description TEXT,
+                amount REAL,
+                category TEXT,
+                type INTEGER,
+                date INTEGER,
+                fingerprint INTEGER,
+                currency TEXT,
+                reconciled INTEGER,
+                tags TEXT,
+                PRIMARY KEY (step, first_id)
+            ) WITHOUT ROWID;
+        )");
+    }
+    
+    if (migrated && version < 7) {
+        // Fingerprints now cover the currency, so keys from version 1 on are
+        // worked out again; clearing them first keeps the unique index from
+        // seeing a new key that an unvisited row still holds
+        migrated = (version < 1 || (ExecuteSQL("UPDATE transactions SET fingerprint = NULL;") &&
+                                    BackfillFingerprints())) &&
+                   RekeyJournalFingerprints();
+    }
+    
+    if (!migrated || !ExecuteSQL("PRAGMA user_version = " + std::to_string(kSchemaVersion) + ";")) {
+        std::cerr << "Failed to migrate database from schema version " << version << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    
+    return ExecuteSQL("COMMIT;");
 }
 
-bool DatabaseHandler::AddTransaction(const Transaction& transaction) {
-    const char* insertSQL = R"(
-        INSERT INTO transactions (description, amount, category, type, date)
-        VALUES (?, ?, ?, ?, ?);
-    )";
-    
+bool DatabaseHandler::BackfillFingerprints() {
+    // Runs before the later migrations add their columns, so read only what
+    // the original table had; without a currency column every row is in the
+    // default currency. Ordinals follow insertion order within each (day,
+    // amount, currency, description) group.
+    std::vector<Transaction> transactions;
     sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, insertSQL, -1, &stmt, nullptr);
+    bool hasCurrency = HasColumn("transactions", "currency");
+    std::string selectSQL = std::string("SELECT id, description, amount, type, date") +
+                            (hasCurrency ? ", currency" : "") + " FROM transactions ORDER BY date, id;";
+    int result = sqlite3_prepare_v2(db_, selectSQL.c_str(), -1, &stmt, nullptr);
     
     if (result != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
         return false;
     }
     
-    sqlite3_bind_text(stmt, 1, transaction.description.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_double(stmt, 2, transaction.amount);
-    sqlite3_bind_text(stmt, 3, transaction.category.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 4, static_cast<int>(transaction.type));
-    sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(transaction.date));
-    
-    result = sqlite3_step(stmt);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        Transaction transaction;
+        transaction.id = sqlite3_column_int(stmt, 0);
+        transaction.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        transaction.amount = sqlite3_column_double(stmt, 2);
+        transaction.type = static_cast<TransactionType>(sqlite3_column_int(stmt, 3));
+        transaction.date = static_cast<std::time_t>(sqlite3_column_int64(stmt, 4));
+        transaction.currency = hasCurrency ? ColumnCurrency(stmt, 5) : kDefaultCurrency;
+        transactions.push_back(transaction);
+    }
     sqlite3_finalize(stmt);
     
-    return result == SQLITE_DONE;
-}
-
-bool DatabaseHandler::UpdateTransaction(const Transaction& transaction) {
-    const char* updateSQL = R"(
-        UPDATE transactions 
-        SET description = ?, amount = ?, category = ?, type = ?, date = ?
-        WHERE id = ?;
-    )";
-    
-    sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, updateSQL, -1, &stmt, nullptr);
+    result = sqlite3_prepare_v2(db_, "UPDATE transactions SET fingerprint = ? WHERE id = ?;", -1, &stmt, nullptr);
     
     if (result != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
         return false;
     }
     
-    sqlite3_bind_text(stmt, 1, transaction.description.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_double(stmt, 2, transaction.amount);
-    sqlite3_bind_text(stmt, 3, transaction.category.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 4, static_cast<int>(transaction.type));
-    sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(transaction.date));
-    sqlite3_bind_int(stmt, 6, transaction.id);
+    std::unordered_map<std::uint64_t, std::uint32_t> ordinals;
+    for (const auto& transaction : transactions) {
+        std::uint64_t base = BaseFingerprint(transaction);
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(Fingerprint(base, ordinals[base]++)));
+        sqlite3_bind_int(stmt, 2, transaction.id);
+        
+        result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        
+        if (result != SQLITE_DONE) {
+            std::cerr << "Failed to store fingerprint: " << sqlite3_errmsg(db_) << std::endl;
+            sqlite3_finalize(stmt);
+            return false;
+        }
+    }
     
-    result = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
-    
-    return result == SQLITE_DONE;
+    return true;
 }
 
-bool DatabaseHandler::DeleteTransaction(int id) {
-    const char* deleteSQL = "DELETE FROM transactions WHERE id = ?;";
-    
+bool DatabaseHandler::RekeyJournalFingerprints() {
+    // A row the undo journal would bring back takes the key its id holds now
+    // when the base still matches, as an edit would keep it, and otherwise
+    // the first ordinal no stored row or other image uses
+    std::unordered_map<int, std::pair<std::uint64_t, std::uint64_t>> stored; // id -> (base, fingerprint)
+    std::unordered_set<std::uint64_t> taken;
     sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, deleteSQL, -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(db_, "SELECT id, description, amount, type, date, currency, fingerprint FROM transactions;",
+                                    -1, &stmt, nullptr);
     
     if (result != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
         return false;
     }
     
-    sqlite3_bind_int(stmt, 1, id);
-    result = sqlite3_step(stmt);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        Transaction transaction;
+        transaction.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        transaction.amount = sqlite3_column_double(stmt, 2);
+        transaction.type = static_cast<TransactionType>(sqlite3_column_int(stmt, 3));
+        transaction.date = static_cast<std::time_t>(sqlite3_column_int64(stmt, 4));
+        transaction.currency = ColumnCurrency(stmt, 5);
+        std::uint64_t fingerprint = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 6));
+        stored[sqlite3_column_int(stmt, 0)] = {BaseFingerprint(transaction), fingerprint};
+        taken.insert(fingerprint);
+    }
     sqlite3_finalize(stmt);
     
-    return result == SQLITE_DONE;
-}
-
-std::vector<Transaction> DatabaseHandler::GetAllTransactions() {
-    std::vector<Transaction> transactions;
-    const char* selectSQL = "SELECT id, description, amount, category, type, date FROM transactions ORDER BY date DESC;";
-    
-    sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
+    std::vector<std::pair<std::pair<int, int>, Transaction>> images; // (step, id) -> row
+    result = sqlite3_prepare_v2(db_, "SELECT step, first_id, description, amount, type, date, currency FROM journal_rows "
+                                     "WHERE present = 1 ORDER BY step, first_id;", -1, &stmt, nullptr);
     
     if (result != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
-        return transactions;
+        return false;
     }
     
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         Transaction transaction;
-        transaction.id = sqlite3_column_int(stmt, 0);
-        transaction.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        transaction.amount = sqlite3_column_double(stmt, 2);
-        transaction.category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        const unsigned char* description = sqlite3_column_text(stmt, 2);
+        transaction.description = description ? reinterpret_cast<const char*>(description) : "";
+        transaction.amount = sqlite3_column_double(stmt, 3);
         transaction.type = static_cast<TransactionType>(sqlite3_column_int(stmt, 4));
         transaction.date = static_cast<std::time_t>(sqlite3_column_int64(stmt, 5));
+        transaction.currency = ColumnCurrency(stmt, 6);
+        images.push_back({{sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1)}, transaction});
+    }
+    sqlite3_finalize(stmt);
+    
+    result = sqlite3_prepare_v2(db_, "UPDATE journal_rows SET fingerprint = ? WHERE step = ? AND first_id = ?;", -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    for (const auto& image : images) {
+        std::uint64_t base = BaseFingerprint(image.second);
+        auto live = stored.find(image.first.second);
+        std::uint64_t fingerprint;
+        if (live != stored.end() && live->second.first == base) {
+            fingerprint = live->second.second;
+        } else {
+            std::uint32_t ordinal = 0;
+            while (taken.count(Fingerprint(base, ordinal)) > 0) {
+                ++ordinal;
+            }
+            fingerprint = Fingerprint(base, ordinal);
+            taken.insert(fingerprint);
+        }
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(fingerprint));
+        sqlite3_bind_int(stmt, 2, image.first.first);
+        sqlite3_bind_int(stmt, 3, image.first.second);
         
-        transactions.push_back(transaction);
+        result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        
+        if (result != SQLITE_DONE) {
+            std::cerr << "Failed to store fingerprint: " << sqlite3_errmsg(db_) << std::endl;
+            sqlite3_finalize(stmt);
+            return false;
+        }
     }
     
     sqlite3_finalize(stmt);
-    return transactions;
+    return true;
 }
 
-std::vector<Transaction> DatabaseHandler::GetTransactionsByCategory(const std::string& category) {
-    std::vector<Transaction> transactions;
-    const char* selectSQL = "SELECT id, description, amount, category, type, date FROM transactions WHERE category = ? ORDER BY date DESC;";
+bool DatabaseHandler::RebuildStrict() {
+    // The usual SQLite table rebuild: copy the rows into the new shape, swap
+    // it in under the old name, then put back the indexes and triggers the
+    // migrations hung on the old table
+    const char* createSQL = R"(
+        CREATE TABLE transactions_compact (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            description TEXT NOT NULL,
+            amount REAL NOT NULL,
+            category TEXT NOT NULL,
+            type INTEGER NOT NULL,
+            date INTEGER NOT NULL,
+            fingerprint INTEGER,
+            currency TEXT NOT NULL DEFAULT 'USD',
+            reconciled INTEGER NOT NULL DEFAULT 0
+        ) STRICT;
+        
+        INSERT INTO transactions_compact (id, description, amount, category, type, date, fingerprint, currency, reconciled)
+            SELECT id, description, amount, category, type, date, fingerprint, currency, reconciled
+            FROM transactions ORDER BY id;
+        
+        DROP TABLE transactions;
+        ALTER TABLE transactions_compact RENAME TO transactions;
+    )";
     
+    std::vector<std::string> dependents;
     sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
-    
-    if (result != SQLITE_OK) {
+    if (sqlite3_prepare_v2(db_, "SELECT sql FROM sqlite_master WHERE tbl_name = 'transactions' "
+                                "AND type IN ('index', 'trigger') AND sql IS NOT NULL;", -1, &stmt, nullptr) != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
-        return transactions;
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        dependents.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
     }
+    sqlite3_finalize(stmt);
     
-    sqlite3_bind_text(stmt, 1, category.c_str(), -1, SQLITE_STATIC);
+    if (!ExecuteSQL("BEGIN IMMEDIATE;")) {
+        return false;
+    }
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        Transaction transaction;
-        transaction.id = sqlite3_column_int(stmt, 0);
-        transaction.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        transaction.amount = sqlite3_column_double(stmt, 2);
-        transaction.category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        transaction.type = static_cast<TransactionType>(sqlite3_column_int(stmt, 4));
-        transaction.date = static_cast<std::time_t>(sqlite3_column_int64(stmt, 5));
-        
-        transactions.push_back(transaction);
+    // Ids are never handed out twice, so the sequence must survive the
+    // rebuild even where the highest ids have been deleted
+    bool rebuilt = ExecuteSQL("CREATE TEMP TABLE compact_sequence AS "
+                              "SELECT seq FROM sqlite_sequence WHERE name = 'transactions';") &&
+                   ExecuteSQL(createSQL);
+    for (size_t i = 0; rebuilt && i < dependents.size(); ++i) {
+        rebuilt = ExecuteSQL(dependents[i]);
     }
+    rebuilt = rebuilt &&
+              ExecuteSQL("DELETE FROM sqlite_sequence WHERE name IN ('transactions', 'transactions_compact');"
+                         "INSERT INTO sqlite_sequence (name, seq) SELECT 'transactions', seq FROM "
+                         "(SELECT MAX(seq) AS seq FROM (SELECT seq FROM temp.compact_sequence "
+                         "UNION ALL SELECT MAX(id) FROM transactions)) WHERE seq IS NOT NULL;"
+                         "DROP TABLE temp.compact_sequence;");
     
-    sqlite3_finalize(stmt);
-    return transactions;
+    if (!rebuilt || !ExecuteSQL("COMMIT;")) {
+        std::cerr << "Failed to rebuild the transactions table; the ledger is unchanged" << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    return true;
 }
 
-std::vector<Transaction> DatabaseHandler::GetTransactionsByType(TransactionType type) {
-    std::vector<Transaction> transactions;
-    const char* selectSQL = "SELECT id, description, amount, category, type, date FROM transactions WHERE type = ? ORDER BY date DESC;";
+std::int64_t DatabaseHandler::ReadPragma(const char* name) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, (std::string("PRAGMA ") + name + ";").c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+    
+    std::int64_t value = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int64(stmt, 0);
+    }
     
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+bool DatabaseHandler::HasColumn(const std::string& table, const std::string& column) {
     sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
+    std::string pragmaSQL = "PRAGMA table_info(" + table + ");";
+    if (sqlite3_prepare_v2(db_, pragmaSQL.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
     
-    if (result != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
-        return transactions;
+    bool found = false;
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+        found = column == reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
     }
     
-    sqlite3_bind_int(stmt, 1, static_cast<int>(type));
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int DatabaseHandler::GetSchemaVersion() {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, "PRAGMA user_version;", -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        Transaction transaction;
-        transaction.id = sqlite3_column_int(stmt, 0);
-        transaction.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        transaction.amount = sqlite3_column_double(stmt, 2);
-        transaction.category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        transaction.type = static_cast<TransactionType>(sqlite3_column_int(stmt, 4));
-        transaction.date = static_cast<std::time_t>(sqlite3_column_int64(stmt, 5));
-        
-        transactions.push_back(transaction);
+    int version = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
     }
     
     sqlite3_finalize(stmt);
-    return transactions;
+    return version;
+}
+
+bool DatabaseHandler::ExecuteSQL(const std::string& sql) {
+    char* errorMessage = nullptr;
+    int result = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errorMessage);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "SQL error: " << errorMessage << std::endl;
+        sqlite3_free(errorMessage);
+        return false;
+    }
+    
+    return true;
+}
+
+bool DatabaseHandler::AddTransaction(const Transaction& transaction) {
+    const char* insertSQL = R"(
+        INSERT INTO transactions (description, amount, category, type, date, fingerprint, currency)
+        VALUES (?, ?, ?, ?, ?, ?, ?);
+    )";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, insertSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, transaction.description.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 2, transaction.amount);
+    sqlite3_bind_text(stmt, 3, transaction.category.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 4, static_cast<int>(transaction.type));
+    sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(transaction.date));
+    BindFingerprint(stmt, 6, transaction.fingerprint);
+    BindCurrency(stmt, 7, transaction.currency);
+    
+    return StepWrite(stmt);
+}
+
+bool DatabaseHandler::AddTransactions(const std::vector<Transaction>& transactions, size_t* inserted) {
+    // One prepared statement and one transaction for the whole batch, so the
+    // journal is synced once instead of once per row
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (!BeginTransaction()) {
+        return false;
+    }
+    
+    size_t count = 0;
+    if (!InsertRows(transactions, count)) {
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    
+    if (!CommitTransaction(count)) {
+        return false;
+    }
+    
+    if (inserted) {
+        *inserted = count;
+    }
+    return true;
+}
+
+bool DatabaseHandler::InsertRows(const std::vector<Transaction>& transactions, size_t& inserted) {
+    // Rows whose fingerprint is already stored are left out rather than failing the batch
+    const char* insertSQL = R"(
+        INSERT OR IGNORE INTO transactions (description, amount, category, type, date, fingerprint, currency)
+        VALUES (?, ?, ?, ?, ?, ?, ?);
+    )";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, insertSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    for (const auto& transaction : transactions) {
+        sqlite3_bind_text(stmt, 1, transaction.description.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 2, transaction.amount);
+        sqlite3_bind_text(stmt, 3, transaction.category.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 4, static_cast<int>(transaction.type));
+        sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(transaction.date));
+        BindFingerprint(stmt, 6, transaction.fingerprint);
+        BindCurrency(stmt, 7, transaction.currency);
+        
+        result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        
+        if (result != SQLITE_DONE) {
+            std::cerr << "Failed to insert transaction: " << sqlite3_errmsg(db_) << std::endl;
+            sqlite3_finalize(stmt);
+            return false;
+        }
+        inserted += static_cast<size_t>(sqlite3_changes(db_));
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool DatabaseHandler::AddRecurringRule(const RecurringRule& rule) {
+    const char* insertSQL = R"(
+        INSERT INTO recurring_rules (description, amount, category, type, unit, interval, day_of_month, next_due, end_date,
+                                     currency)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);
+    )";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, insertSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, rule.description.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 2, rule.amount);
+    sqlite3_bind_text(stmt, 3, rule.category.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 4, static_cast<int>(rule.type));
+    sqlite3_bind_int(stmt, 5, static_cast<int>(rule.unit));
+    sqlite3_bind_int(stmt, 6, rule.interval);
+    sqlite3_bind_int(stmt, 7, rule.dayOfMonth);
+    sqlite3_bind_int64(stmt, 8, static_cast<sqlite3_int64>(rule.nextDue));
+    sqlite3_bind_int64(stmt, 9, static_cast<sqlite3_int64>(rule.endDate));
+    BindCurrency(stmt, 10, rule.currency);
+    
+    result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    return result == SQLITE_DONE;
+}
+
+bool DatabaseHandler::DeleteRecurringRule(int id) {
+    const char* deleteSQL = "DELETE FROM recurring_rules WHERE id = ?;";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, deleteSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    sqlite3_bind_int(stmt, 1, id);
+    result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    return result == SQLITE_DONE;
+}
+
+std::vector<RecurringRule> DatabaseHandler::GetRecurringRules() {
+    std::vector<RecurringRule> rules;
+    const char* selectSQL = R"(
+        SELECT id, description, amount, category, type, unit, interval, day_of_month, next_due, end_date, currency
+        FROM recurring_rules ORDER BY id;
+    )";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return rules;
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        RecurringRule rule;
+        rule.id = sqlite3_column_int(stmt, 0);
+        rule.description = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        rule.amount = sqlite3_column_double(stmt, 2);
+        rule.category = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        rule.type = static_cast<TransactionType>(sqlite3_column_int(stmt, 4));
+        rule.unit = static_cast<RecurrenceUnit>(sqlite3_column_int(stmt, 5));
+        rule.interval = sqlite3_column_int(stmt, 6);
+        rule.dayOfMonth = sqlite3_column_int(stmt, 7);
+        rule.nextDue = static_cast<std::time_t>(sqlite3_column_int64(stmt, 8));
+        rule.endDate = static_cast<std::time_t>(sqlite3_column_int64(stmt, 9));
+        rule.currency = ColumnCurrency(stmt, 10);
+        
+        rules.push_back(rule);
+    }
+    
+    sqlite3_finalize(stmt);
+    return rules;
+}
+
+bool DatabaseHandler::MaterializeRecurring(const std::vector<Transaction>& occurrences,
+                                           const std::vector<std::pair<int, std::time_t>>& nextDueByRule) {
+    // The occurrences and the rules' new due dates commit together, so a
+    // crash can neither lose an occurrence nor write it twice
+    const char* advanceSQL = "UPDATE recurring_rules SET next_due = ? WHERE id = ?;";
+    
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (!BeginTransaction()) {
+        return false;
+    }
+    
+    size_t inserted = 0;
+    if (!InsertRows(occurrences, inserted)) {
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, advanceSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    
+    for (const auto& entry : nextDueByRule) {
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(entry.second));
+        sqlite3_bind_int(stmt, 2, entry.first);
+        
+        result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        
+        if (result != SQLITE_DONE) {
+            std::cerr << "Failed to advance recurring rule: " << sqlite3_errmsg(db_) << std::endl;
+            sqlite3_finalize(stmt);
+            ExecuteSQL("ROLLBACK;");
+            return false;
+        }
+    }
+    
+    sqlite3_finalize(stmt);
+    return CommitTransaction(inserted + nextDueByRule.size());
+}
+
+bool DatabaseHandler::AddExchangeRates(const std::vector<ExchangeRate>& rates) {
+    // A later quote for the same pair and day replaces the earlier one
+    const char* upsertSQL = R"(
+        INSERT INTO exchange_rates (base, quote, day, rate) VALUES (?, ?, ?, ?)
+        ON CONFLICT (base, quote, day) DO UPDATE SET rate = excluded.rate;
+    )";
+    
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (!BeginTransaction()) {
+        return false;
+    }
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, upsertSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    
+    for (const auto& rate : rates) {
+        BindCurrency(stmt, 1, rate.base);
+        BindCurrency(stmt, 2, rate.quote);
+        sqlite3_bind_int(stmt, 3, rate.day);
+        sqlite3_bind_double(stmt, 4, rate.rate);
+        
+        result = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        
+        if (result != SQLITE_DONE) {
+            std::cerr << "Failed to store exchange rate: " << sqlite3_errmsg(db_) << std::endl;
+            sqlite3_finalize(stmt);
+            ExecuteSQL("ROLLBACK;");
+            return false;
+        }
+    }
+    
+    sqlite3_finalize(stmt);
+    return CommitTransaction(rates.size());
+}
+
+std::vector<ExchangeRate> DatabaseHandler::GetExchangeRates() {
+    std::vector<ExchangeRate> rates;
+    const char* selectSQL = "SELECT base, quote, day, rate FROM exchange_rates ORDER BY base, quote, day;";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return rates;
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ExchangeRate rate;
+        rate.base = ColumnCurrency(stmt, 0);
+        rate.quote = ColumnCurrency(stmt, 1);
+        rate.day = sqlite3_column_int(stmt, 2);
+        rate.rate = sqlite3_column_double(stmt, 3);
+        if (rate.rate > 0.0) {
+            rates.push_back(rate);
+        }
+    }
+    
+    sqlite3_finalize(stmt);
+    return rates;
+}
+
+bool DatabaseHandler::GetSetting(const std::string& key, std::string& value) {
+    const char* selectSQL = "SELECT value FROM settings WHERE key = ?;";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+    
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        value = text ? reinterpret_cast<const char*>(text) : "";
+    }
+    
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool DatabaseHandler::SetSetting(const std::string& key, const std::string& value) {
+    const char* upsertSQL = R"(
+        INSERT INTO settings (key, value) VALUES (?, ?)
+        ON CONFLICT (key) DO UPDATE SET value = excluded.value;
+    )";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, upsertSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, value.c_str(), -1, SQLITE_STATIC);
+    
+    result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    return result == SQLITE_DONE;
+}
+
+int DatabaseHandler::GetLastInsertId() const {
+    return db_ ? static_cast<int>(sqlite3_last_insert_rowid(db_)) : 0;
+}
+
+bool DatabaseHandler::UpdateTransaction(const Transaction& transaction) {
+    const char* updateSQL = R"(
+        UPDATE transactions 
+        SET description = ?, amount = ?, category = ?, type = ?, date = ?, fingerprint = ?, currency = ?
+        WHERE id = ?;
+    )";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, updateSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, transaction.description.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 2, transaction.amount);
+    sqlite3_bind_text(stmt, 3, transaction.category.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 4, static_cast<int>(transaction.type));
+    sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(transaction.date));
+    BindFingerprint(stmt, 6, transaction.fingerprint);
+    BindCurrency(stmt, 7, transaction.currency);
+    sqlite3_bind_int(stmt, 8, transaction.id);
+    
+    return StepWrite(stmt);
+}
+
+bool DatabaseHandler::DeleteTransaction(int id) {
+    const char* deleteSQL = "DELETE FROM transactions WHERE id = ?;";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, deleteSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    sqlite3_bind_int(stmt, 1, id);
+    return StepWrite(stmt);
+}
+
+size_t DatabaseHandler::MergeCategories(const std::vector<std::pair<std::uint64_t, std::string>>& categoriesByFingerprint) {
+    // Only rows still filed under the catch-all category take the incoming one
+    const char* mergeSQL = "UPDATE transactions SET category = ? WHERE fingerprint = ? AND category = 'Other';";
+    
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (categoriesByFingerprint.empty() || !BeginTransaction()) {
+        return 0;
+    }
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, mergeSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return 0;
+    }
+    
+    size_t merged = 0;
+    for (const auto& entry : categoriesByFingerprint) {
+        sqlite3_bind_text(stmt, 1, entry.second.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(entry.first));
+        
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            merged += static_cast<size_t>(sqlite3_changes(db_));
+        }
+        sqlite3_reset(stmt);
+    }
+    
+    sqlite3_finalize(stmt);
+    return CommitTransaction(merged) ? merged : 0;
+}
+
+std::vector<Transaction> DatabaseHandler::GetAllTransactions() {
+    std::vector<Transaction> transactions;
+    // Rows the cache cannot key by int are left out, as the change checks leave them
+    const char* selectSQL = "SELECT id, description, amount, category, type, date, fingerprint, currency, reconciled FROM transactions "
+                            "WHERE id BETWEEN -2147483648 AND 2147483647 ORDER BY date DESC, id DESC;";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return transactions;
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        transactions.push_back(ColumnTransaction(stmt));
+    }
+    
+    sqlite3_finalize(stmt);
+    return transactions;
+}
+
+std::vector<Transaction> DatabaseHandler::GetTransactionsByCategory(const std::string& category) {
+    return QueryTransactions(TransactionFilter::Category(category));
+}
+
+std::vector<Transaction> DatabaseHandler::GetTransactionsByType(TransactionType type) {
+    return QueryTransactions(TransactionFilter::Type(type));
+}
+
+std::vector<Transaction> DatabaseHandler::QueryTransactions(const TransactionFilter& filter) {
+    std::vector<Transaction> transactions;
+    if (!db_) {
+        return transactions;
+    }
+    
+    std::string selectSQL = "SELECT id, description, amount, category, type, date, fingerprint, currency, reconciled FROM transactions WHERE ";
+    std::vector<FilterParameter> parameters;
+    CompileFilter(filter, selectSQL, parameters);
+    selectSQL += " ORDER BY date DESC, id DESC;";
+    
+    auto cached = queries_.find(selectSQL);
+    sqlite3_stmt* stmt = cached != queries_.end() ? cached->second : nullptr;
+    if (!stmt) {
+        int result = sqlite3_prepare_v2(db_, selectSQL.c_str(), -1, &stmt, nullptr);
+        if (result != SQLITE_OK) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+            return transactions;
+        }
+        
+        if (queries_.size() >= kMaxCachedQueries) {
+            ClearQueries();
+        }
+        queries_.emplace(selectSQL, stmt);
+    }
+    
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        const FilterParameter& parameter = parameters[i];
+        int index = static_cast<int>(i) + 1;
+        switch (parameter.kind) {
+            case FilterParameter::Kind::Integer:
+                sqlite3_bind_int64(stmt, index, parameter.integer);
+                break;
+            case FilterParameter::Kind::Real:
+                sqlite3_bind_double(stmt, index, parameter.real);
+                break;
+            case FilterParameter::Kind::Text:
+                sqlite3_bind_text(stmt, index, parameter.text.c_str(), -1, SQLITE_STATIC);
+                break;
+        }
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        transactions.push_back(ColumnTransaction(stmt));
+    }
+    
+    // Kept for the next filter of this shape; the parameters are about to go
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return transactions;
+}
+
+void DatabaseHandler::ClearQueries() {
+    for (auto& query : queries_) {
+        sqlite3_finalize(query.second);
+    }
+    queries_.clear();
+}
+
+void DatabaseHandler::ClearJournalQueries() {
+    for (auto& query : journalQueries_) {
+        sqlite3_finalize(query.second);
+    }
+    journalQueries_.clear();
+}
+
+std::vector<RowChange> DatabaseHandler::TakeChanges() {
+    std::vector<RowChange> changes;
+    changes.swap(changes_);
+    return changes;
+}
+
+std::int64_t DatabaseHandler::GetDataVersion() {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, "PRAGMA data_version;", -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+    
+    std::int64_t version = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int64(stmt, 0);
+    }
+    
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+std::int64_t DatabaseHandler::GetMaxId() {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, "SELECT MAX(id) FROM transactions;", -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+    
+    std::int64_t maxId = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        maxId = sqlite3_column_int64(stmt, 0);
+    }
+    
+    sqlite3_finalize(stmt);
+    return maxId;
+}
+
+std::vector<BucketChanges> DatabaseHandler::GetBucketChanges() {
+    std::vector<BucketChanges> buckets;
+    const char* selectSQL = "SELECT bucket, changes FROM transaction_changes ORDER BY bucket;";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return buckets;
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        buckets.push_back({sqlite3_column_int64(stmt, 0), sqlite3_column_int64(stmt, 1)});
+    }
+    
+    sqlite3_finalize(stmt);
+    return buckets;
+}
+
+std::vector<Transaction> DatabaseHandler::GetTransactionsInRange(std::int64_t firstId, std::int64_t lastId) {
+    std::vector<Transaction> transactions;
+    const char* selectSQL = "SELECT id, description, amount, category, type, date, fingerprint, currency, reconciled FROM transactions WHERE id BETWEEN ? AND ? ORDER BY id;";
+    
+    sqlite3_stmt* stmt;
+    int result = sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr);
+    
+    if (result != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return transactions;
+    }
+    
+    sqlite3_bind_int64(stmt, 1, firstId);
+    sqlite3_bind_int64(stmt, 2, lastId);
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        transactions.push_back(ColumnTransaction(stmt));
+    }
+    
+    sqlite3_finalize(stmt);
+    return transactions;
+}
+
+bool DatabaseHandler::AddTag(const std::vector<int>& ids, const std::string& tag) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (ids.empty() || !BeginTransaction()) {
+        return ids.empty();
+    }
+    
+    // Only ids that are stored get the tag
+    const char* nameSQL = "INSERT OR IGNORE INTO tags (name) VALUES (?);";
+    const char* tagSQL = "INSERT OR IGNORE INTO transaction_tags (tag_id, transaction_id) "
+                         "SELECT (SELECT id FROM tags WHERE name = ?), id FROM transactions WHERE id = ?;";
+    
+    sqlite3_stmt* nameStmt = nullptr;
+    sqlite3_stmt* tagStmt = nullptr;
+    bool added = sqlite3_prepare_v2(db_, nameSQL, -1, &nameStmt, nullptr) == SQLITE_OK &&
+                 sqlite3_prepare_v2(db_, tagSQL, -1, &tagStmt, nullptr) == SQLITE_OK;
+    if (!added) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+    } else {
+        sqlite3_bind_text(nameStmt, 1, tag.c_str(), -1, SQLITE_STATIC);
+        added = sqlite3_step(nameStmt) == SQLITE_DONE;
+        
+        sqlite3_bind_text(tagStmt, 1, tag.c_str(), -1, SQLITE_STATIC);
+        for (size_t i = 0; added && i < ids.size(); ++i) {
+            sqlite3_bind_int(tagStmt, 2, ids[i]);
+            added = sqlite3_step(tagStmt) == SQLITE_DONE;
+            sqlite3_reset(tagStmt);
+        }
+    }
+    
+    sqlite3_finalize(nameStmt);
+    sqlite3_finalize(tagStmt);
+    if (!added) {
+        std::cerr << "Failed to add tag: " << sqlite3_errmsg(db_) << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    return CommitTransaction(ids.size());
+}
+
+bool DatabaseHandler::RemoveTag(const std::vector<int>& ids, const std::string& tag) {
+    const char* deleteSQL = "DELETE FROM transaction_tags WHERE tag_id = (SELECT id FROM tags WHERE name = ?) "
+                            "AND transaction_id = ?;";
+    
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (ids.empty() || !BeginTransaction()) {
+        return ids.empty();
+    }
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, deleteSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    
+    bool removed = true;
+    sqlite3_bind_text(stmt, 1, tag.c_str(), -1, SQLITE_STATIC);
+    for (size_t i = 0; removed && i < ids.size(); ++i) {
+        sqlite3_bind_int(stmt, 2, ids[i]);
+        removed = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_reset(stmt);
+    }
+    
+    sqlite3_finalize(stmt);
+    if (!removed) {
+        std::cerr << "Failed to remove tag: " << sqlite3_errmsg(db_) << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    return CommitTransaction(ids.size());
+}
+
+std::vector<std::pair<int, std::string>> DatabaseHandler::GetTagAssignments() {
+    std::vector<std::pair<int, std::string>> assignments;
+    const char* selectSQL = "SELECT transaction_id, name FROM transaction_tags JOIN tags ON tags.id = tag_id "
+                            "ORDER BY tag_id, transaction_id;";
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return assignments;
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        assignments.emplace_back(sqlite3_column_int(stmt, 0), reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
+    }
+    
+    sqlite3_finalize(stmt);
+    return assignments;
+}
+
+bool DatabaseHandler::SetReconciled(const std::vector<int>& ids, bool reconciled) {
+    const char* updateSQL = "UPDATE transactions SET reconciled = ? WHERE id = ? AND reconciled != ?;";
+    
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (ids.empty() || !BeginTransaction()) {
+        return ids.empty();
+    }
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, updateSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    
+    // Rows already in that state are left alone, so they stay out of the change capture
+    bool updated = true;
+    sqlite3_bind_int(stmt, 1, reconciled ? 1 : 0);
+    sqlite3_bind_int(stmt, 3, reconciled ? 1 : 0);
+    for (size_t i = 0; updated && i < ids.size(); ++i) {
+        sqlite3_bind_int(stmt, 2, ids[i]);
+        updated = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_reset(stmt);
+    }
+    
+    sqlite3_finalize(stmt);
+    if (!updated) {
+        std::cerr << "Failed to mark transactions reconciled: " << sqlite3_errmsg(db_) << std::endl;
+        ExecuteSQL("ROLLBACK;");
+        return false;
+    }
+    return CommitTransaction(ids.size());
+}
+
+bool DatabaseHandler::AddJournalStep(const std::string& label, const std::vector<JournalImage>& images,
+                                     size_t keepSteps, int* stepId) {
+    // Undone steps are always the newest, so step ids stay consecutive
+    const char* const dropSQL[] = {
+        "DELETE FROM journal_rows WHERE step IN (SELECT id FROM journal_steps WHERE undone != 0);",
+        "DELETE FROM journal_steps WHERE undone != 0;",
+    };
+    const char* const pruneSQL[] = {
+        "DELETE FROM journal_rows WHERE step <= ?;",
+        "DELETE FROM journal_steps WHERE id <= ?;",
+    };
+    
+    return RunInSavepoint([&]() {
+        for (const char* sql : dropSQL) {
+            sqlite3_stmt* stmt = JournalQuery(sql);
+            if (!stmt || !Run(stmt)) {
+                return false;
+            }
+        }
+        
+        sqlite3_stmt* stmt = JournalQuery("INSERT INTO journal_steps (label) VALUES (?);");
+        if (!stmt) {
+            return false;
+        }
+        sqlite3_bind_text(stmt, 1, label.c_str(), -1, SQLITE_STATIC);
+        if (!Run(stmt)) {
+            std::cerr << "Failed to add journal step: " << sqlite3_errmsg(db_) << std::endl;
+            return false;
+        }
+        
+        int added = static_cast<int>(sqlite3_last_insert_rowid(db_));
+        for (const char* sql : pruneSQL) {
+            stmt = JournalQuery(sql);
+            if (!stmt) {
+                return false;
+            }
+            sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(added) - static_cast<sqlite3_int64>(keepSteps));
+            if (!Run(stmt)) {
+                return false;
+            }
+        }
+        
+        if (!WriteJournalRows(added, images)) {
+            return false;
+        }
+        if (stepId) {
+            *stepId = added;
+        }
+        return true;
+    });
+}
+
+std::vector<JournalStep> DatabaseHandler::GetJournalSteps() {
+    std::vector<JournalStep> steps;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, "SELECT id, label, undone FROM journal_steps ORDER BY id;", -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return steps;
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        steps.push_back({sqlite3_column_int(stmt, 0), reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                         sqlite3_column_int(stmt, 2) != 0});
+    }
+    
+    sqlite3_finalize(stmt);
+    return steps;
+}
+
+bool DatabaseHandler::ReplayJournalStep(int stepId, std::vector<JournalImage>& applied) {
+    const char* selectSQL = "SELECT first_id, description, amount, category, type, date, fingerprint, currency, "
+                            "reconciled, last_id, present, tags FROM journal_rows WHERE step = ? ORDER BY first_id;";
+    
+    applied.clear();
+    std::vector<JournalImage> stored;
+    bool replayed = RunInSavepoint([&]() {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db_, selectSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+            return false;
+        }
+        sqlite3_bind_int(stmt, 1, stepId);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            JournalImage image{sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 9), sqlite3_column_int(stmt, 10) != 0,
+                               Transaction(), {}};
+            if (image.present) {
+                image.row = ColumnTransaction(stmt);
+                const unsigned char* tags = sqlite3_column_text(stmt, 11);
+                std::istringstream names(tags ? reinterpret_cast<const char*>(tags) : "");
+                for (std::string name; std::getline(names, name, kTagSeparator);) {
+                    image.tags.push_back(name);
+                }
+            }
+            stored.push_back(std::move(image));
+        }
+        sqlite3_finalize(stmt);
+        
+        // Each image goes in over what is there now, which is kept in its place
+        JournalStatements statements;
+        if (!statements.Prepare(db_)) {
+            return false;
+        }
+        std::vector<JournalImage> found;
+        for (const JournalImage& image : stored) {
+            size_t before = found.size();
+            ReadImages(statements, image, found);
+            bool wasPresent = found.size() > before;
+            if (image.present && !wasPresent) {
+                found.push_back({image.firstId, image.firstId, false, Transaction(), {}});
+            }
+            if (!ApplyImage(statements, image, wasPresent)) {
+                std::cerr << "Failed to replay journal step: " << sqlite3_errmsg(db_) << std::endl;
+                return false;
+            }
+        }
+        
+        return ExecuteSQL("DELETE FROM journal_rows WHERE step = " + std::to_string(stepId) + ";") &&
+               WriteJournalRows(stepId, std::move(found)) &&
+               ExecuteSQL("UPDATE journal_steps SET undone = 1 - undone WHERE id = " + std::to_string(stepId) + ";");
+    });
+    
+    if (replayed) {
+        applied = std::move(stored);
+    }
+    return replayed;
+}
+
+bool DatabaseHandler::WriteJournalRows(int stepId, std::vector<JournalImage> images) {
+    const char* insertSQL = "INSERT INTO journal_rows (step, first_id, last_id, present, description, amount, category, "
+                            "type, date, fingerprint, currency, reconciled, tags) "
+                            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    
+    // Runs of absent ids, as an import leaves behind, are stored as one row
+    std::sort(images.begin(), images.end(), [](const JournalImage& a, const JournalImage& b) {
+        return a.firstId < b.firstId;
+    });
+    size_t kept = 0;
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (kept > 0 && !images[i].present && !images[kept - 1].present && images[kept - 1].lastId + 1 == images[i].firstId) {
+            images[kept - 1].lastId = images[i].lastId;
+        } else if (kept++ != i) {
+            images[kept - 1] = std::move(images[i]);
+        }
+    }
+    images.resize(kept);
+    
+    sqlite3_stmt* stmt = JournalQuery(insertSQL);
+    if (!stmt) {
+        return false;
+    }
+    
+    bool written = true;
+    for (size_t i = 0; written && i < images.size(); ++i) {
+        const JournalImage& image = images[i];
+        sqlite3_clear_bindings(stmt);
+        sqlite3_bind_int(stmt, 1, stepId);
+        sqlite3_bind_int(stmt, 2, image.firstId);
+        sqlite3_bind_int(stmt, 3, image.lastId);
+        sqlite3_bind_int(stmt, 4, image.present ? 1 : 0);
+        
+        std::string tags;
+        if (image.present) {
+            for (const std::string& tag : image.tags) {
+                tags += (tags.empty() ? "" : std::string(1, kTagSeparator)) + tag;
+            }
+            sqlite3_bind_text(stmt, 5, image.row.description.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_double(stmt, 6, image.row.amount);
+            sqlite3_bind_text(stmt, 7, image.row.category.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 8, static_cast<int>(image.row.type));
+            sqlite3_bind_int64(stmt, 9, static_cast<sqlite3_int64>(image.row.date));
+            BindFingerprint(stmt, 10, image.row.fingerprint);
+            BindCurrency(stmt, 11, image.row.currency);
+            sqlite3_bind_int(stmt, 12, image.row.reconciled ? 1 : 0);
+            sqlite3_bind_text(stmt, 13, tags.c_str(), -1, SQLITE_STATIC);
+        }
+        
+        written = Run(stmt);
+    }
+    
+    if (!written) {
+        std::cerr << "Failed to write journal: " << sqlite3_errmsg(db_) << std::endl;
+    }
+    return written;
+}
+
+bool DatabaseHandler::BackupTo(const std::string& path, const BackupProgress& progress) {
+    sqlite3* destination = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &destination, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        std::cerr << "Cannot open backup file: " << sqlite3_errmsg(destination) << std::endl;
+        sqlite3_close(destination);
+        return false;
+    }
+    
+    // Each batch of pages is copied with no write batch open and none able to
+    // start, so rows that are not yet committed never reach the copy
+    bool copied = CopyDatabase(destination, db_, progress, [this](sqlite3_backup* backup) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        if (!CommitBatch()) {
+            return SQLITE_BUSY;
+        }
+        return sqlite3_backup_step(backup, kBackupPagesPerStep);
+    });
+    sqlite3_close(destination);
+    return copied;
+}
+
+bool DatabaseHandler::RestoreFrom(const std::string& path, const BackupProgress& progress) {
+    // An open batch would keep the copy from writing
+    if (!FlushWrites()) {
+        return false;
+    }
+    
+    sqlite3* source = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &source, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Cannot open backup file: " << sqlite3_errmsg(source) << std::endl;
+        sqlite3_close(source);
+        return false;
+    }
+    
+    // Refuse anything that is not a ledger before overwriting this one
+    sqlite3_stmt* stmt;
+    bool isLedger = false;
+    if (sqlite3_prepare_v2(source, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'transactions';",
+                           -1, &stmt, nullptr) == SQLITE_OK) {
+        isLedger = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
+    if (!isLedger) {
+        std::cerr << "Not a finance tracker database: " << path << std::endl;
+        sqlite3_close(source);
+        return false;
+    }
+    
+    // Statements left open on this connection would keep the copy from finishing
+    ClearQueries();
+    ClearJournalQueries();
+    bool copied = CopyDatabase(db_, source, progress, [](sqlite3_backup* backup) {
+        return sqlite3_backup_step(backup, kBackupPagesPerStep);
+    });
+    sqlite3_close(source);
+    
+    // The backup may predate later migrations
+    return copied && CreateTables() && MigrateSchema();
+}
+
+bool DatabaseHandler::SetDurability(const WriteBatching& batching) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (!CommitBatch()) {
+        return false;
+    }
+    
+    // WAL stays once set; with synchronous=FULL it is as safe as the rollback journal
+    bool relaxed = batching.durability == Durability::Relaxed;
+    if ((relaxed && !ExecuteSQL("PRAGMA journal_mode = WAL;")) ||
+        !ExecuteSQL(relaxed ? "PRAGMA synchronous = NORMAL;" : "PRAGMA synchronous = FULL;")) {
+        return false;
+    }
+    
+    batching_ = batching;
+    batching_.maxDelayMs = std::max(batching_.maxDelayMs, 0);
+    batching_.maxRows = std::max<size_t>(batching_.maxRows, 1);
+    if (batching_.durability != Durability::Strict && !flusher_.joinable()) {
+        flusher_ = std::thread(&DatabaseHandler::FlushLoop, this);
+    }
+    return true;
+}
+
+WriteBatching DatabaseHandler::GetDurability() {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    return batching_;
+}
+
+bool DatabaseHandler::FlushWrites() {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    return CommitBatch();
+}
+
+CommitStats DatabaseHandler::GetCommitStats() {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    return stats_;
+}
+
+bool DatabaseHandler::StepWrite(sqlite3_stmt* stmt) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (batching_.durability != Durability::Strict && !batchOpen_) {
+        // If the batch cannot start, this write simply commits on its own
+        if (ExecuteSQL("BEGIN IMMEDIATE;")) {
+            batchOpen_ = true;
+            batchRows_ = 0;
+            batchStart_ = Clock::now();
+            batchOpened_.notify_one();
+        }
+    }
+    
+    Clock::time_point start = Clock::now();
+    int result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    if (!batchOpen_) {
+        if (result == SQLITE_DONE) {
+            RecordCommit(1, Clock::now() - start);
+        }
+        return result == SQLITE_DONE;
+    }
+    
+    // A few errors (disk full, I/O) roll back the whole transaction
+    if (sqlite3_get_autocommit(db_)) {
+        std::cerr << "Write failed and rolled back a batch of " << batchRows_ << " writes" << std::endl;
+        batchOpen_ = false;
+        ++stats_.lostBatches;
+        return false;
+    }
+    
+    if (result == SQLITE_DONE && ++batchRows_ >= batching_.maxRows) {
+        CommitBatch();
+    }
+    return result == SQLITE_DONE;
+}
+
+bool DatabaseHandler::CommitBatch() {
+    if (!batchOpen_) {
+        return true;
+    }
+    
+    Clock::time_point start = Clock::now();
+    if (ExecuteSQL("COMMIT;")) {
+        batchOpen_ = false;
+        RecordCommit(batchRows_, Clock::now() - start);
+        return true;
+    }
+    
+    if (sqlite3_get_autocommit(db_)) {
+        std::cerr << "Commit failed; a batch of " << batchRows_ << " writes was rolled back" << std::endl;
+        batchOpen_ = false;
+        ++stats_.lostBatches;
+    } else {
+        // Still open, typically busy behind another connection's readers: try again a delay later
+        batchStart_ = Clock::now();
+    }
+    return false;
+}
+
+void DatabaseHandler::RecordCommit(size_t rows, Clock::duration elapsed) {
+    if (rows == 0) {
+        return;
+    }
+    
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    ++stats_.commits;
+    stats_.rows += rows;
+    stats_.largestBatch = std::max(stats_.largestBatch, rows);
+    stats_.totalSeconds += seconds;
+    stats_.slowestSeconds = std::max(stats_.slowestSeconds, seconds);
+    
+    size_t sizeBucket = 0;
+    for (size_t n = rows; n > 1 && sizeBucket + 1 < CommitStats::kBuckets; n >>= 1) {
+        ++sizeBucket;
+    }
+    size_t latencyBucket = 0;
+    for (double limit = 0.001; seconds >= limit && latencyBucket + 1 < CommitStats::kBuckets; limit *= 2) {
+        ++latencyBucket;
+    }
+    ++stats_.batchSizes[sizeBucket];
+    ++stats_.latencies[latencyBucket];
+}
+
+void DatabaseHandler::FlushLoop() {
+    std::unique_lock<std::mutex> lock(writeMutex_);
+    while (!stopFlusher_) {
+        if (!batchOpen_) {
+            batchOpened_.wait(lock);
+            continue;
+        }
+        
+        Clock::time_point due = batchStart_ + std::chrono::milliseconds(batching_.maxDelayMs);
+        if (Clock::now() >= due) {
+            CommitBatch();
+        } else {
+            batchOpened_.wait_until(lock, due);
+        }
+    }
+}
+
+sqlite3_stmt* DatabaseHandler::JournalQuery(const char* sql) {
+    auto cached = journalQueries_.find(sql);
+    if (cached != journalQueries_.end()) {
+        return cached->second;
+    }
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+        return nullptr;
+    }
+    journalQueries_.emplace(sql, stmt);
+    return stmt;
+}
+
+bool DatabaseHandler::RunInSavepoint(const std::function<bool()>& body) {
+    // Inside an open batch this nests, so journaling does not force a
+    // commit; otherwise the savepoint is a transaction of its own
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (!ExecuteSQL("SAVEPOINT journal;")) {
+        return false;
+    }
+    
+    if (body()) {
+        if (ExecuteSQL("RELEASE journal;")) {
+            return true;
+        }
+        if (batchOpen_ || sqlite3_get_autocommit(db_)) {
+            return false;
+        }
+    } else {
+        ExecuteSQL("ROLLBACK TO journal;");
+    }
+    ExecuteSQL(batchOpen_ ? "RELEASE journal;" : "ROLLBACK;");
+    return false;
+}
+
+bool DatabaseHandler::BeginTransaction() {
+    // Bulk writes run in a transaction of their own, after whatever is
+    // batched. The caller holds writeMutex_ from here to the commit or
+    // rollback, so neither the flusher nor a single-row write can step in.
+    return CommitBatch() && ExecuteSQL("BEGIN IMMEDIATE;");
+}
+
+bool DatabaseHandler::CommitTransaction(size_t rows) {
+    Clock::time_point start = Clock::now();
+    if (!ExecuteSQL("COMMIT;")) {
+        // Not left open for the next writer to commit by accident
+        if (!sqlite3_get_autocommit(db_)) {
+            ExecuteSQL("ROLLBACK;");
+        }
+        return false;
+    }
+    
+    RecordCommit(rows, Clock::now() - start);
+    return true;
+}
+
+StorageStats DatabaseHandler::GetStorageStats() {
+    StorageStats stats;
+    stats.pageSize = ReadPragma("page_size");
+    stats.pages = ReadPragma("page_count");
+    stats.freePages = ReadPragma("freelist_count");
+    stats.incrementalVacuum = ReadPragma("auto_vacuum") == 2;
+    
+    // The table list reports STRICT from SQLite 3.37 on; before that nothing is
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, "SELECT strict FROM pragma_table_list WHERE schema = 'main' AND name = 'transactions';",
+                           -1, &stmt, nullptr) == SQLITE_OK) {
+        stats.strict = sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) != 0;
+        sqlite3_finalize(stmt);
+    }
+    return stats;
+}
+
+bool DatabaseHandler::CompactStorage(StorageStats& before, StorageStats& after) {
+    // VACUUM cannot run inside a transaction, and statements left open on
+    // the connection would keep it and the rebuild from running. The batch
+    // is committed under the lock, so no write can open another before then.
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (!CommitBatch()) {
+        return false;
+    }
+    ClearQueries();
+    ClearJournalQueries();
+    
+    before = GetStorageStats();
+    bool rebuild = !before.strict && sqlite3_libversion_number() >= 3037000;
+    if (rebuild && !RebuildStrict()) {
+        return false;
+    }
+    
+    // Switching auto-vacuum mode only takes effect through a full VACUUM.
+    // Without a mode to switch or free pages to drop it would copy the file
+    // for nothing.
+    bool vacuum = rebuild || !before.incrementalVacuum || before.freePages > 0;
+    if ((vacuum && (!ExecuteSQL("PRAGMA auto_vacuum = INCREMENTAL;") || !ExecuteSQL("VACUUM;"))) ||
+        !ExecuteSQL("ANALYZE;")) {
+        return false;
+    }
+    
+    lastOptimized_ = std::time(nullptr);
+    after = GetStorageStats();
+    return true;
+}
+
+void DatabaseHandler::RunMaintenance(std::time_t now) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (lastOptimized_ == 0) {
+        lastOptimized_ = now;  // Opening a ledger is not the time for it
+    }
+    
+    // Joins the open batch if there is one, so it costs no commit of its own then
+    if (ReadPragma("auto_vacuum") == 2) {
+        std::int64_t free = ReadPragma("freelist_count");
+        if (free > 0 && free >= ReadPragma("page_count") / kVacuumSlackDivisor) {
+            ExecuteSQL("PRAGMA incremental_vacuum(" + std::to_string(std::min(free, kVacuumPagesPerStep)) + ");");
+        }
+    }
+    
+    if (now - lastOptimized_ >= kOptimizeInterval) {
+        ExecuteSQL("PRAGMA optimize;");
+        lastOptimized_ = now;
+    }
 }
 
 double DatabaseHandler::GetTotalByType(TransactionType type) {
@@ -253,4 +2089,4 @@ double DatabaseHandler::GetTotalByCategory(const std::string& category) {
     
     sqlite3_finalize(stmt);
     return total;
-} 
\ No newline at end of file
+}
\ No newline at end of file
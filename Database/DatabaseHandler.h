@@ -1,14 +1,101 @@
 #pragma once
 #include "../Model/Transaction.h"
+#include "../Model/RecurringRule.h"
+#include "../Model/TransactionFilter.h"
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 // Forward declaration to avoid including sqlite3.h in header
 struct sqlite3;
+struct sqlite3_stmt;
+
+// A write to the transactions table seen by the update hook
+struct RowChange {
+    enum class Kind { Insert, Update, Delete };
+    Kind kind;
+    std::int64_t rowid;
+};
+
+// Updates and deletes ever made to one bucket of 2^kBucketBits consecutive ids
+struct BucketChanges {
+    static constexpr int kBucketBits = 10;
+    std::int64_t bucket;
+    std::int64_t changes;
+};
+
+// One id, or a run of ids, as an undo journal step left or found them.
+// A run is only ever stored as absent: no row at any of its ids.
+struct JournalImage {
+    int firstId;
+    int lastId;
+    bool present;
+    Transaction row;                // When present; row.id == firstId
+    std::vector<std::string> tags;  // The row's tags, when present
+};
+
+struct JournalStep {
+    int id;  // Grows with each step
+    std::string label;
+    bool undone;
+};
+
+// How single-row writes reach the disk.
+//   Strict: each write commits, synced, before it returns.
+//   Group: writes join an open transaction that commits once its first
+//     write is maxDelayMs old or it holds maxRows writes, so a burst pays
+//     for one sync instead of one each. A crash loses at most that window,
+//     never part of a write.
+//   Relaxed: as Group, with the file switched to WAL and synchronous=NORMAL,
+//     so commits skip the sync altogether; a crash of the app loses nothing
+//     committed, a power cut can lose the last commits.
+enum class Durability { Strict, Group, Relaxed };
+
+struct WriteBatching {
+    Durability durability = Durability::Strict;
+    int maxDelayMs = 10;
+    size_t maxRows = 500;
+};
+
+// Commits since the handler was opened. Bulk writes (imports, recurring
+// batches, tags) commit on their own and count as one commit of their rows.
+struct CommitStats {
+    static constexpr size_t kBuckets = 8;
+    std::uint64_t commits = 0;
+    std::uint64_t rows = 0;
+    std::uint64_t lostBatches = 0;   // Batches the database rolled back when their commit failed
+    size_t largestBatch = 0;
+    double totalSeconds = 0.0;       // Spent committing
+    double slowestSeconds = 0.0;
+    std::array<std::uint64_t, kBuckets> batchSizes{};  // 1, 2-3, 4-7, ... rows; the last bucket is open-ended
+    std::array<std::uint64_t, kBuckets> latencies{};   // Under 1 ms, 1-2 ms, 2-4 ms, ...
+};
+
+// The ledger file as the database header describes it
+struct StorageStats {
+    std::int64_t pageSize = 0;
+    std::int64_t pages = 0;
+    std::int64_t freePages = 0;       // Unused pages still held by the file
+    bool incrementalVacuum = false;   // auto_vacuum = INCREMENTAL
+    bool strict = false;              // transactions is a STRICT table
+    
+    std::int64_t GetBytes() const { return pageSize * pages; }
+};
 
 class DatabaseHandler {
 public:
+    using BackupProgress = std::function<bool(int remainingPages, int totalPages)>;
+    
     explicit DatabaseHandler(const std::string& dbPath);
     ~DatabaseHandler();
     
@@ -19,22 +106,163 @@ public:
     // Database operations
     bool Initialize();
     bool AddTransaction(const Transaction& transaction);
+    bool AddTransactions(const std::vector<Transaction>& transactions, size_t* inserted = nullptr);
     bool UpdateTransaction(const Transaction& transaction);
     bool DeleteTransaction(int id);
+    size_t MergeCategories(const std::vector<std::pair<std::uint64_t, std::string>>& categoriesByFingerprint);
     std::vector<Transaction> GetAllTransactions();
     std::vector<Transaction> GetTransactionsByCategory(const std::string& category);
     std::vector<Transaction> GetTransactionsByType(TransactionType type);
     
+    // Rows matching filter, newest first. The filter is compiled to a WHERE
+    // clause with its values as parameters, so filters of the same shape
+    // share one SQL text; the prepared statement is kept per text and only
+    // rebound on later calls.
+    std::vector<Transaction> QueryTransactions(const TransactionFilter& filter);
+    
+    // Tags, many per transaction. Adding skips ids that are not stored and
+    // pairs already there; deleting a transaction drops its tags.
+    // GetTagAssignments() lists (transaction id, tag) pairs grouped by tag,
+    // ids ascending within each.
+    bool AddTag(const std::vector<int>& ids, const std::string& tag);
+    bool RemoveTag(const std::vector<int>& ids, const std::string& tag);
+    std::vector<std::pair<int, std::string>> GetTagAssignments();
+    
+    // Sets the reconciled flag on every listed row in one transaction
+    bool SetReconciled(const std::vector<int>& ids, bool reconciled);
+    
+    // Recurring rules. Materializing inserts the due occurrences and moves
+    // each rule's next due date in a single transaction.
+    bool AddRecurringRule(const RecurringRule& rule);
+    bool DeleteRecurringRule(int id);
+    std::vector<RecurringRule> GetRecurringRules();
+    bool MaterializeRecurring(const std::vector<Transaction>& occurrences,
+                              const std::vector<std::pair<int, std::time_t>>& nextDueByRule);
+    
+    // Exchange rates. Adding replaces any quote already stored for the same
+    // pair and day.
+    bool AddExchangeRates(const std::vector<ExchangeRate>& rates);
+    std::vector<ExchangeRate> GetExchangeRates();
+    
+    // Undo journal. A step keeps, for every id it touched, the other side
+    // of the change: the rows as they were before it while it stands, as
+    // it left them once undone. Replaying a step swaps the two in one
+    // transaction and hands back the images written, so undo and redo are
+    // the same operation. Adding a step drops the undone ones and all but
+    // the newest keepSteps.
+    bool AddJournalStep(const std::string& label, const std::vector<JournalImage>& images, size_t keepSteps,
+                        int* stepId = nullptr);
+    std::vector<JournalStep> GetJournalSteps();
+    bool ReplayJournalStep(int stepId, std::vector<JournalImage>& applied);
+    
+    // Per-ledger preferences, stored in the ledger file itself
+    bool GetSetting(const std::string& key, std::string& value);
+    bool SetSetting(const std::string& key, const std::string& value);
+    
+    // Change capture. Every write made through this connection to the
+    // transactions table is recorded until TakeChanges(), rolled back ones
+    // included. PRAGMA data_version moves only when another connection
+    // commits, so comparing it is a cheap way to notice foreign writers.
+    // Triggers count the updates and deletes to each bucket of ids whoever
+    // makes them; the buckets whose count moved, plus the ids above the last
+    // known maximum, are the ranges to read again.
+    std::vector<RowChange> TakeChanges();
+    std::int64_t GetDataVersion();
+    std::int64_t GetMaxId();
+    std::vector<BucketChanges> GetBucketChanges();
+    std::vector<Transaction> GetTransactionsInRange(std::int64_t firstId, std::int64_t lastId);
+    
+    // Online backup with sqlite3_backup_step. Pages are copied in small
+    // batches and the source is unlocked between them, so other writers keep
+    // going; writes made through this connection meanwhile are carried into
+    // the copy once committed, and each batch commits the open write batch
+    // first. Progress runs after each batch and returns false to stop.
+    // BackupTo() may run on a worker thread while the owning thread keeps
+    // using the handler. RestoreFrom() replaces the open database in place and
+    // brings it up to the current schema; the handler must not be used until
+    // it returns, and stopping early leaves the database as it was.
+    bool BackupTo(const std::string& path, const BackupProgress& progress);
+    bool RestoreFrom(const std::string& path, const BackupProgress& progress);
+    
     // Analytics
     double GetTotalByType(TransactionType type);
     double GetTotalByCategory(const std::string& category);
     
+    // Write-behind. Under Group and Relaxed, AddTransaction(),
+    // UpdateTransaction() and DeleteTransaction() return once their row is
+    // written into the open batch; a flusher thread commits it when it falls
+    // due. Reads through this handler see the batch at once, other
+    // connections only after the commit. Bulk writes, restores and closing
+    // the handler commit the batch first. Changing the mode commits too.
+    bool SetDurability(const WriteBatching& batching);
+    WriteBatching GetDurability();
+    bool FlushWrites();
+    CommitStats GetCommitStats();
+    
+    // Storage maintenance. CompactStorage() rewrites the file once: the
+    // transactions table is rebuilt as a STRICT table, so every column holds
+    // only its declared type (needs SQLite 3.37; older programs can no longer
+    // open the ledger), auto-vacuum is switched to INCREMENTAL, free pages
+    // go back to the file system and the planner statistics are gathered
+    // afresh. It commits the open batch first and fails, leaving the ledger
+    // as it was, if a stored value does not fit its column. A file already
+    // in that form with no free pages is only analyzed. The result is not
+    // always smaller: a ledger with little to reclaim can grow by a page or
+    // two, since the statistics live in a table of their own. Values keep
+    // their encoding; category and currency stay TEXT in every row. New
+    // ledgers start with incremental auto-vacuum. RunMaintenance() is cheap
+    // enough for a timer: it hands back free pages a bounded step at a time
+    // once they make up a noticeable part of the file, and runs PRAGMA
+    // optimize every few hours.
+    StorageStats GetStorageStats();
+    bool CompactStorage(StorageStats& before, StorageStats& after);
+    void RunMaintenance(std::time_t now);
+    
     bool IsConnected() const { return db_ != nullptr; }
+    int GetLastInsertId() const;
 
 private:
+    using Clock = std::chrono::steady_clock;
+    
     sqlite3* db_;
     std::string dbPath_;
+    std::vector<RowChange> changes_;
+    std::unordered_map<std::string, sqlite3_stmt*> queries_;  // QueryTransactions() statements by SQL
+    std::unordered_map<const char*, sqlite3_stmt*> journalQueries_;  // By the address of their SQL literal
+    
+    // Guards the batch, the stats and the settings; the flusher commits under
+    // it, and bulk writes hold it from BEGIN to COMMIT or ROLLBACK
+    std::mutex writeMutex_;
+    std::condition_variable batchOpened_;
+    WriteBatching batching_;
+    bool batchOpen_;
+    size_t batchRows_;
+    Clock::time_point batchStart_;
+    bool stopFlusher_;
+    std::thread flusher_;
+    CommitStats stats_;
+    std::time_t lastOptimized_;
+    
+    bool StepWrite(sqlite3_stmt* stmt);
+    bool CommitBatch();
+    void RecordCommit(size_t rows, Clock::duration elapsed);
+    void FlushLoop();
+    bool BeginTransaction();
+    bool CommitTransaction(size_t rows);
+    bool RunInSavepoint(const std::function<bool()>& body);
+    bool WriteJournalRows(int stepId, std::vector<JournalImage> images);
+    sqlite3_stmt* JournalQuery(const char* sql);
     
     bool CreateTables();
+    bool MigrateSchema();
+    bool BackfillFingerprints();
+    bool RekeyJournalFingerprints();
+    bool InsertRows(const std::vector<Transaction>& transactions, size_t& inserted);
+    bool RebuildStrict();
+    std::int64_t ReadPragma(const char* name);
+    bool HasColumn(const std::string& table, const std::string& column);
+    int GetSchemaVersion();
     bool ExecuteSQL(const std::string& sql);
+    void ClearQueries();
+    void ClearJournalQueries();
 }; 
\ No newline at end of file
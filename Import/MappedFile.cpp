@@ -0,0 +1,131 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+MappedFile::MappedFile()
+    : data_(nullptr), size_(0), open_(false)
+#ifdef _WIN32
+    , file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        error_ = "Cannot open " + path;
+        return false;
+    }
+    
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size)) {
+        error_ = "Cannot read the size of " + path;
+        Close();
+        return false;
+    }
+    
+    size_ = static_cast<size_t>(size.QuadPart);
+    open_ = true;
+    if (size_ == 0) {
+        return true;
+    }
+    
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_) {
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!data_) {
+        error_ = "Cannot map " + path;
+        Close();
+        return false;
+    }
+    
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+    }
+    
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    mapping_ = nullptr;
+    file_ = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+    
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "Cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        error_ = "Cannot read the size of " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    
+    size_ = static_cast<size_t>(status.st_size);
+    if (size_ > 0) {
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            error_ = "Cannot map " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        
+        // Statements are read front to back exactly once
+        madvise(mapped, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(mapped);
+    }
+    
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    open_ = true;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#endif
\ No newline at end of file
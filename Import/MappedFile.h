@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The contents stay valid until
+// Close() or destruction; an empty file maps to a null pointer of size 0.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    
+    // Disable copy constructor and assignment operator
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool Open(const std::string& path);
+    void Close();
+    
+    const char* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+    bool IsOpen() const { return open_; }
+    const std::string& GetError() const { return error_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    bool open_;
+    std::string error_;
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "RateParser.h"
+#include <chrono>
+#include <cmath>
+#include <string>
+
+namespace {
+    bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+    
+    std::string_view Trim(std::string_view text) {
+        while (!text.empty() && IsSpace(text.front())) {
+            text.remove_prefix(1);
+        }
+        while (!text.empty() && IsSpace(text.back())) {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+    
+    // Up to four fields; tabs count as separators before spaces are trimmed
+    size_t SplitLine(std::string_view line, std::string_view fields[4]) {
+        size_t count = 0;
+        size_t start = 0;
+        for (size_t i = 0; i <= line.size() && count < 4; ++i) {
+            if (i == line.size() || line[i] == ',' || line[i] == ';' || line[i] == '\t') {
+                fields[count++] = Trim(line.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+        return count;
+    }
+    
+    void Reject(size_t line, const std::string& message, ImportReport& report) {
+        ++report.rowsRejected;
+        if (report.errors.size() < ImportReport::kMaxErrors) {
+            report.errors.push_back({line, message});
+        }
+    }
+}
+
+bool RateParser::Parse(const char* data, size_t size, std::vector<ExchangeRate>& rates, ImportReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    report.bytesTotal = size;
+    
+    std::string_view text(data, size);
+    if (text.size() >= 3 && text.substr(0, 3) == "\xEF\xBB\xBF") {
+        text.remove_prefix(3);
+    }
+    
+    size_t lineNumber = 0;
+    bool firstLine = true;
+    while (!text.empty()) {
+        size_t newline = text.find('\n');
+        std::string_view line = Trim(text.substr(0, newline));
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        ++lineNumber;
+        if (line.empty()) {
+            continue;
+        }
+        
+        std::string_view fields[4];
+        size_t count = SplitLine(line, fields);
+        
+        int year, month, day;
+        bool dated = count > 0 && StatementParser::ParseDate(fields[0], year, month, day);
+        if (firstLine && !dated) {
+            firstLine = false;
+            continue; // Header
+        }
+        firstLine = false;
+        
+        ++report.rowsParsed;
+        ExchangeRate rate;
+        if (!dated) {
+            Reject(lineNumber, "Unrecognized date \"" + std::string(fields[0]) + "\"", report);
+            continue;
+        }
+        if (count < 4 || !ParseCurrency(std::string(fields[1]), rate.base) ||
+            !ParseCurrency(std::string(fields[2]), rate.quote)) {
+            Reject(lineNumber, "Expected date, base currency, quote currency, rate", report);
+            continue;
+        }
+        if (!ParseRate(fields[3], rate.rate) || rate.rate <= 0.0 || rate.base == rate.quote) {
+            Reject(lineNumber, "Unusable rate \"" + std::string(fields[3]) + "\"", report);
+            continue;
+        }
+        
+        rate.day = DaysFromCivil(year, month, day);
+        rates.push_back(rate);
+        ++report.rowsImported;
+    }
+    
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool RateParser::ParseRate(std::string_view text, double& rate) {
+    size_t i = 0;
+    double mantissa = 0.0;
+    int scale = 0;
+    int digits = 0;
+    bool decimal = false;
+    for (; i < text.size(); ++i) {
+        char c = text[i];
+        if (c >= '0' && c <= '9') {
+            mantissa = mantissa * 10.0 + (c - '0');
+            scale -= decimal ? 1 : 0;
+            ++digits;
+        } else if (c == '.' && !decimal) {
+            decimal = true;
+        } else {
+            break;
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+    
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        bool negative = false;
+        if (++i < text.size() && (text[i] == '-' || text[i] == '+')) {
+            negative = text[i++] == '-';
+        }
+        int exponent = 0;
+        size_t exponentStart = i;
+        while (i < text.size() && text[i] >= '0' && text[i] <= '9' && exponent < 1000) {
+            exponent = exponent * 10 + (text[i++] - '0');
+        }
+        if (i == exponentStart) {
+            return false;
+        }
+        scale += negative ? -exponent : exponent;
+    }
+    if (i != text.size()) {
+        return false;
+    }
+    
+    rate = scale < 0 ? mantissa / std::pow(10.0, -scale) : mantissa * std::pow(10.0, scale);
+    return std::isfinite(rate);
+}
\ No newline at end of file
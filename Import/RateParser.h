@@ -0,0 +1,17 @@
+#pragma once
+#include "../Model/Currency.h"
+#include "StatementParser.h"
+#include <string_view>
+#include <vector>
+
+// Reads exchange rate files: one quote per line as date, base, quote, rate
+// (comma, semicolon or tab separated), e.g. "2024-03-01,EUR,USD,1.0812" for
+// 1 EUR = 1.0812 USD. A header line and blank lines are skipped; bad lines
+// are rejected into the report and the rest still read.
+class RateParser {
+public:
+    static bool Parse(const char* data, size_t size, std::vector<ExchangeRate>& rates, ImportReport& report);
+    
+    // Plain decimal with optional exponent, independent of the C locale
+    static bool ParseRate(std::string_view text, double& rate);
+};
\ No newline at end of file
@@ -0,0 +1,707 @@
+#include "StatementParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STATEMENT_SCAN_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+    bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+    
+    bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+    
+    char FoldAscii(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    
+    std::string_view Trim(std::string_view text) {
+        while (!text.empty() && IsSpace(text.front())) {
+            text.remove_prefix(1);
+        }
+        while (!text.empty() && IsSpace(text.back())) {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+    
+    std::string Folded(std::string_view text) {
+        std::string folded(Trim(text));
+        std::transform(folded.begin(), folded.end(), folded.begin(), FoldAscii);
+        return folded;
+    }
+    
+    // Short excerpt of a bad field for error messages
+    std::string Quote(std::string_view text) {
+        constexpr size_t kMaxExcerpt = 40;
+        std::string excerpt(text.substr(0, kMaxExcerpt));
+        return "\"" + excerpt + (text.size() > kMaxExcerpt ? "...\"" : "\"");
+    }
+
+#ifdef STATEMENT_SCAN_SSE2
+    int LowestBit(unsigned mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+#endif
+    
+    // First byte in [p, end) equal to a, b or c, or end when there is none.
+    // Compares 16 bytes per step; the scalar loop only handles the tail.
+    const char* FindAny(const char* p, const char* end, char a, char b, char c) {
+#ifdef STATEMENT_SCAN_SSE2
+        const __m128i matchA = _mm_set1_epi8(a);
+        const __m128i matchB = _mm_set1_epi8(b);
+        const __m128i matchC = _mm_set1_epi8(c);
+        while (end - p >= 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, matchA), _mm_cmpeq_epi8(block, matchB)),
+                                        _mm_cmpeq_epi8(block, matchC));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+            if (mask != 0) {
+                return p + LowestBit(mask);
+            }
+            p += 16;
+        }
+#endif
+        for (; p < end; ++p) {
+            if (*p == a || *p == b || *p == c) {
+                return p;
+            }
+        }
+        return end;
+    }
+    
+    const char* FindText(const char* p, const char* end, std::string_view text) {
+        std::string_view haystack(p, static_cast<size_t>(end - p));
+        size_t found = haystack.find(text);
+        return found == std::string_view::npos ? end : p + found;
+    }
+    
+    // The most frequent of , ; tab | on the first line
+    char DetectDelimiter(const char* p, const char* end) {
+        const char* lineEnd = FindAny(p, end, '\n', '\n', '\n');
+        const char candidates[] = {',', ';', '\t', '|'};
+        char best = ',';
+        long bestCount = 0;
+        for (char candidate : candidates) {
+            long count = static_cast<long>(std::count(p, lineEnd, candidate));
+            if (count > bestCount) {
+                best = candidate;
+                bestCount = count;
+            }
+        }
+        return best;
+    }
+    
+    // Splits the CSV record starting at p into fields and returns the start of
+    // the next record. Quoted fields may hold delimiters, line breaks and ""
+    // escapes; only fields with escapes are copied, into scratch.
+    const char* SplitRecord(const char* p, const char* end, char delimiter,
+                            std::vector<std::string_view>& fields, std::deque<std::string>& scratch) {
+        fields.clear();
+        size_t scratchUsed = 0;
+        
+        while (true) {
+            if (p < end && *p == '"') {
+                const char* start = ++p;
+                bool escaped = false;
+                while (true) {
+                    p = FindAny(p, end, '"', '"', '"');
+                    if (end - p >= 2 && p[1] == '"') {
+                        escaped = true;
+                        p += 2;
+                        continue;
+                    }
+                    break;
+                }
+                
+                if (escaped) {
+                    if (scratchUsed == scratch.size()) {
+                        scratch.emplace_back();
+                    }
+                    std::string& unescaped = scratch[scratchUsed++];
+                    unescaped.clear();
+                    for (const char* c = start; c < p; ++c) {
+                        unescaped.push_back(*c);
+                        if (*c == '"') {
+                            ++c;
+                        }
+                    }
+                    fields.emplace_back(unescaped);
+                } else {
+                    fields.emplace_back(start, static_cast<size_t>(p - start));
+                }
+                
+                // Anything between the closing quote and the delimiter is dropped
+                p = FindAny(p < end ? p + 1 : p, end, delimiter, '\n', '\r');
+            } else {
+                const char* start = p;
+                p = FindAny(p, end, delimiter, '\n', '\r');
+                fields.emplace_back(start, static_cast<size_t>(p - start));
+            }
+            
+            if (p >= end) {
+                return end;
+            }
+            if (*p == delimiter) {
+                ++p;
+                continue;
+            }
+            
+            // Line break: \n, \r or \r\n
+            if (*p == '\r' && end - p >= 2 && p[1] == '\n') {
+                ++p;
+            }
+            return p + 1;
+        }
+    }
+    
+    bool ParseTypeName(std::string_view text, TransactionType& type) {
+        std::string name = Folded(text);
+        if (name == "income" || name == "credit" || name == "cr" || name == "deposit") {
+            type = TransactionType::Income;
+            return true;
+        }
+        if (name == "expense" || name == "debit" || name == "dr" || name == "withdrawal" || name == "payment") {
+            type = TransactionType::Expense;
+            return true;
+        }
+        return false;
+    }
+    
+    // Decodes the character entities OFX allows in text values
+    std::string DecodeEntities(std::string_view text) {
+        std::string decoded;
+        decoded.reserve(text.size());
+        while (!text.empty()) {
+            size_t amp = text.find('&');
+            decoded.append(text.substr(0, amp));
+            if (amp == std::string_view::npos) {
+                break;
+            }
+            
+            text.remove_prefix(amp);
+            static const struct {
+                std::string_view entity;
+                char value;
+            } entities[] = {{"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}, {"&nbsp;", ' '}};
+            bool matched = false;
+            for (const auto& entity : entities) {
+                if (text.substr(0, entity.entity.size()) == entity.entity) {
+                    decoded.push_back(entity.value);
+                    text.remove_prefix(entity.entity.size());
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched) {
+                decoded.push_back('&');
+                text.remove_prefix(1);
+            }
+        }
+        return decoded;
+    }
+    
+    bool IsLeapYear(int year) {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+    
+    int DaysInMonth(int year, int month) {
+        static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        return month == 2 && IsLeapYear(year) ? 29 : days[month - 1];
+    }
+}
+
+StatementFormat StatementParser::DetectFormat(const std::string& path, const char* data, size_t size) {
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos) {
+        std::string extension = Folded(std::string_view(path).substr(dot + 1));
+        if (extension == "ofx" || extension == "qfx") {
+            return StatementFormat::Ofx;
+        }
+        if (extension == "csv" || extension == "txt") {
+            return StatementFormat::Csv;
+        }
+    }
+    
+    // Unknown extension: OFX files announce themselves in the first few lines
+    const char* end = data + std::min<size_t>(size, 1024);
+    if (FindText(data, end, "OFXHEADER") != end || FindText(data, end, "<OFX>") != end) {
+        return StatementFormat::Ofx;
+    }
+    return StatementFormat::Csv;
+}
+
+bool StatementParser::Parse(const char* data, size_t size, StatementFormat format, const RowSink& sink,
+                            ImportReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    data_ = data;
+    size_ = size;
+    lineCursor_ = data;
+    lineNumber_ = 1;
+    chunk_.clear();
+    chunk_.reserve(chunkRows_);
+    report.bytesTotal = size;
+    
+    bool completed = format == StatementFormat::Ofx ? ParseOfx(sink, report) : ParseCsv(sink, report);
+    
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return completed;
+}
+
+bool StatementParser::ParseCsv(const RowSink& sink, ImportReport& report) {
+    const char* p = data_;
+    const char* end = data_ + size_;
+    if (size_ >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) {
+        p += 3; // UTF-8 byte order mark
+    }
+    
+    const char delimiter = DetectDelimiter(p, end);
+    std::vector<std::string_view> fields;
+    std::deque<std::string> scratch;
+    CsvColumns columns;
+    bool firstRecord = true;
+    
+    while (p < end) {
+        const char* record = p;
+        p = SplitRecord(p, end, delimiter, fields, scratch);
+        if (fields.size() == 1 && Trim(fields[0]).empty()) {
+            continue; // Blank line
+        }
+        
+        if (firstRecord) {
+            firstRecord = false;
+            bool isHeader = false;
+            CsvColumns mapped = MapColumns(fields, isHeader);
+            if (isHeader) {
+                columns = mapped;
+                continue;
+            }
+        }
+        
+        auto field = [&](int index) {
+            return index >= 0 && static_cast<size_t>(index) < fields.size() ? Trim(fields[index]) : std::string_view();
+        };
+        
+        int year, month, day;
+        std::time_t date;
+        if (!ParseDate(field(columns.date), year, month, day)) {
+            Reject(record, "Unrecognized date " + Quote(field(columns.date)), report);
+            continue;
+        }
+        if (!ToTime(year, month, day, date)) {
+            Reject(record, "Date out of range " + Quote(field(columns.date)), report);
+            continue;
+        }
+        
+        std::int64_t cents = 0;
+        if (columns.amount >= 0) {
+            if (!ParseCents(field(columns.amount), cents)) {
+                Reject(record, "Unrecognized amount " + Quote(field(columns.amount)), report);
+                continue;
+            }
+        } else {
+            // Separate debit and credit columns; either may be blank
+            std::int64_t debit = 0;
+            std::int64_t credit = 0;
+            std::string_view debitText = field(columns.debit);
+            std::string_view creditText = field(columns.credit);
+            if ((debitText.empty() && creditText.empty()) ||
+                (!debitText.empty() && !ParseCents(debitText, debit)) ||
+                (!creditText.empty() && !ParseCents(creditText, credit))) {
+                Reject(record, "Unrecognized debit/credit " + Quote(debitText) + " " + Quote(creditText), report);
+                continue;
+            }
+            cents = (credit < 0 ? -credit : credit) - (debit < 0 ? -debit : debit);
+        }
+        
+        if (cents == 0) {
+            Reject(record, "Zero amount", report);
+            continue;
+        }
+        
+        // An explicit type column wins over the sign of the amount
+        TransactionType type = cents < 0 ? TransactionType::Expense : TransactionType::Income;
+        if (columns.type >= 0) {
+            ParseTypeName(field(columns.type), type);
+        }
+        
+        std::string_view description = field(columns.description);
+        if (description.empty()) {
+            Reject(record, "Missing description", report);
+            continue;
+        }
+        
+        CurrencyCode currency = kDefaultCurrency;
+        std::string_view currencyText = field(columns.currency);
+        if (!currencyText.empty() && !ParseCurrency(std::string(currencyText), currency)) {
+            Reject(record, "Unrecognized currency " + Quote(currencyText), report);
+            continue;
+        }
+        
+        Transaction row(0, std::string(description), static_cast<double>(cents < 0 ? -cents : cents) / 100.0,
+                        std::string(field(columns.category)), type, date);
+        row.currency = currency;
+        if (!AcceptRow(std::move(row), p, sink, report)) {
+            return false;
+        }
+    }
+    
+    return Flush(end, sink, report);
+}
+
+bool StatementParser::ParseOfx(const RowSink& sink, ImportReport& report) {
+    const std::string_view open = "<STMTTRN>";
+    const std::string_view close = "</STMTTRN>";
+    const char* end = data_ + size_;
+    const char* p = FindText(data_, end, open);
+    
+    // Each statement names its currency once, ahead of its transactions
+    const std::string_view currencyTag = "<CURDEF>";
+    CurrencyCode currency = kDefaultCurrency;
+    const char* currencyScan = data_;
+    
+    while (p < end) {
+        const char* record = p;
+        for (const char* tag = FindText(currencyScan, record, currencyTag); tag < record;
+             tag = FindText(tag + currencyTag.size(), record, currencyTag)) {
+            const char* value = tag + currencyTag.size();
+            const char* valueEnd = FindAny(value, record, '<', '<', '<');
+            ParseCurrency(std::string(Trim(std::string_view(value, static_cast<size_t>(valueEnd - value)))), currency);
+        }
+        currencyScan = record;
+        
+        const char* blockEnd = FindText(p + open.size(), end, close);
+        const char* next = FindText(p + open.size(), end, open);
+        blockEnd = std::min(blockEnd, next); // SGML files may omit closing tags
+        
+        std::string_view posted, amount, name, memo;
+        const char* q = p + open.size();
+        while (q < blockEnd) {
+            q = FindAny(q, blockEnd, '<', '<', '<');
+            const char* tag = q + 1;
+            q = FindAny(tag, blockEnd, '>', '>', '>');
+            if (q >= blockEnd) {
+                break;
+            }
+            
+            std::string_view tagName(tag, static_cast<size_t>(q - tag));
+            const char* value = q + 1;
+            q = FindAny(value, blockEnd, '<', '<', '<');
+            std::string_view text = Trim(std::string_view(value, static_cast<size_t>(q - value)));
+            if (tagName == "DTPOSTED") {
+                posted = text;
+            } else if (tagName == "TRNAMT") {
+                amount = text;
+            } else if (tagName == "NAME") {
+                name = text;
+            } else if (tagName == "MEMO") {
+                memo = text;
+            }
+        }
+        p = next;
+        
+        int year, month, day;
+        std::time_t date;
+        std::int64_t cents = 0;
+        if (!ParseDate(posted, year, month, day) || !ToTime(year, month, day, date)) {
+            Reject(record, "Unrecognized DTPOSTED " + Quote(posted), report);
+            continue;
+        }
+        if (!ParseCents(amount, cents)) {
+            Reject(record, "Unrecognized TRNAMT " + Quote(amount), report);
+            continue;
+        }
+        if (cents == 0) {
+            Reject(record, "Zero amount", report);
+            continue;
+        }
+        if (name.empty()) {
+            name = memo;
+        }
+        if (name.empty()) {
+            Reject(record, "Missing NAME and MEMO", report);
+            continue;
+        }
+        
+        Transaction row(0, DecodeEntities(name), static_cast<double>(cents < 0 ? -cents : cents) / 100.0, "",
+                        cents < 0 ? TransactionType::Expense : TransactionType::Income, date);
+        row.currency = currency;
+        if (!AcceptRow(std::move(row), blockEnd, sink, report)) {
+            return false;
+        }
+    }
+    
+    return Flush(end, sink, report);
+}
+
+bool StatementParser::AcceptRow(Transaction&& row, const char* position, const RowSink& sink, ImportReport& report) {
+    ++report.rowsParsed;
+    chunk_.push_back(std::move(row));
+    if (chunk_.size() >= chunkRows_) {
+        return Flush(position, sink, report);
+    }
+    return true;
+}
+
+bool StatementParser::Flush(const char* position, const RowSink& sink, ImportReport& report) {
+    if (!chunk_.empty()) {
+        if (!sink(chunk_)) {
+            return false;
+        }
+        chunk_.clear();
+    }
+    
+    if (progress_ && !progress_(static_cast<size_t>(position - data_), size_)) {
+        report.cancelled = true;
+        return false;
+    }
+    return true;
+}
+
+void StatementParser::Reject(const char* position, const std::string& message, ImportReport& report) {
+    ++report.rowsRejected;
+    if (report.errors.size() < ImportReport::kMaxErrors) {
+        report.errors.push_back({LineAt(position), message});
+    }
+}
+
+size_t StatementParser::LineAt(const char* position) {
+    // Rejections arrive in file order, so the count only ever moves forward
+    lineNumber_ += static_cast<size_t>(std::count(lineCursor_, position, '\n'));
+    lineCursor_ = position;
+    return lineNumber_;
+}
+
+bool StatementParser::ToTime(int year, int month, int day, std::time_t& time) {
+    int key = year * 10000 + month * 100 + day;
+    if (key == lastDay_) {
+        time = lastTime_;
+        return true;
+    }
+    
+    auto cached = dayTimes_.find(key);
+    if (cached == dayTimes_.end()) {
+        std::tm calendar{};
+        calendar.tm_year = year - 1900;
+        calendar.tm_mon = month - 1;
+        calendar.tm_mday = day;
+        calendar.tm_isdst = -1;
+        std::time_t converted = std::mktime(&calendar);
+        if (converted == static_cast<std::time_t>(-1)) {
+            return false;
+        }
+        cached = dayTimes_.emplace(key, converted).first;
+    }
+    
+    lastDay_ = key;
+    lastTime_ = cached->second;
+    time = lastTime_;
+    return true;
+}
+
+StatementParser::CsvColumns StatementParser::MapColumns(const std::vector<std::string_view>& header, bool& isHeader) {
+    // Roles are claimed in this order, each by its first keyword that matches
+    // an unclaimed column, so "Debit Amount" is a debit column, not the amount
+    static const struct {
+        int CsvColumns::*column;
+        std::vector<const char*> keywords;
+    } roles[] = {
+        {&CsvColumns::date, {"date", "posted", "booked"}},
+        {&CsvColumns::debit, {"debit", "withdrawal", "money out", "paid out"}},
+        {&CsvColumns::credit, {"credit", "deposit", "money in", "paid in"}},
+        {&CsvColumns::amount, {"amount", "value", "sum"}},
+        {&CsvColumns::description, {"description", "payee", "merchant", "name", "memo", "details", "narrative", "reference"}},
+        {&CsvColumns::category, {"category"}},
+        {&CsvColumns::type, {"type", "dr/cr", "cr/dr"}},
+        {&CsvColumns::currency, {"currency", "ccy"}}
+    };
+    
+    CsvColumns columns;
+    columns.date = columns.description = columns.amount = -1;
+    
+    std::vector<std::string> names;
+    names.reserve(header.size());
+    for (std::string_view field : header) {
+        int year, month, day;
+        if (ParseDate(Trim(field), year, month, day)) {
+            isHeader = false; // A data row, not a header
+            return CsvColumns();
+        }
+        names.push_back(Folded(field));
+    }
+    
+    std::vector<bool> claimed(names.size(), false);
+    for (const auto& role : roles) {
+        for (const char* keyword : role.keywords) {
+            for (size_t i = 0; i < names.size() && columns.*role.column < 0; ++i) {
+                if (!claimed[i] && names[i].find(keyword) != std::string::npos) {
+                    columns.*role.column = static_cast<int>(i);
+                    claimed[i] = true;
+                }
+            }
+        }
+    }
+    
+    isHeader = columns.date >= 0 && (columns.amount >= 0 || columns.debit >= 0 || columns.credit >= 0);
+    return columns;
+}
+
+bool StatementParser::ParseCents(std::string_view text, std::int64_t& cents) {
+    text = Trim(text);
+    bool negative = false;
+    
+    // Accounting negatives "(12.34)" and trailing signs "12.34-"
+    if (text.size() >= 2 && text.front() == '(' && text.back() == ')') {
+        negative = true;
+        text = Trim(text.substr(1, text.size() - 2));
+    }
+    if (!text.empty() && text.back() == '-') {
+        negative = !negative;
+        text = Trim(text.substr(0, text.size() - 1));
+    }
+    
+    // Signs and currency symbols ahead of the number, in either order
+    size_t i = 0;
+    while (i < text.size() && !IsDigit(text[i]) && text[i] != '.' && text[i] != ',') {
+        if (text[i] == '-') {
+            negative = !negative;
+        }
+        ++i;
+    }
+    
+    // The number itself: digits plus grouping and decimal separators
+    size_t begin = i;
+    while (i < text.size() && (IsDigit(text[i]) || text[i] == '.' || text[i] == ',' || text[i] == ' ' || text[i] == '\'')) {
+        ++i;
+    }
+    std::string_view number = Trim(text.substr(begin, i - begin));
+    for (; i < text.size(); ++i) {
+        if (IsDigit(text[i])) {
+            return false; // Digits after a trailing currency code or other text
+        }
+    }
+    
+    // The last separator is the decimal point if it is the only '.', or the
+    // only ',' with at most two digits after it ("1.234,56", "12,5")
+    size_t decimal = number.find_last_of(".,");
+    if (decimal != std::string_view::npos) {
+        char separator = number[decimal];
+        size_t occurrences = static_cast<size_t>(std::count(number.begin(), number.end(), separator));
+        size_t fraction = number.size() - decimal - 1;
+        bool isDecimal = occurrences == 1 && (separator == '.' || fraction <= 2);
+        for (size_t j = decimal + 1; j < number.size() && isDecimal; ++j) {
+            isDecimal = IsDigit(number[j]);
+        }
+        if (!isDecimal) {
+            decimal = std::string_view::npos;
+        }
+    }
+    
+    std::int64_t whole = 0;
+    int wholeDigits = 0;
+    for (size_t j = 0; j < std::min(decimal, number.size()); ++j) {
+        if (IsDigit(number[j])) {
+            if (++wholeDigits > 15) {
+                return false;
+            }
+            whole = whole * 10 + (number[j] - '0');
+        }
+    }
+    
+    // Two fractional digits, rounded half up on the third
+    std::int64_t fractionCents = 0;
+    int fractionDigits = 0;
+    if (decimal != std::string_view::npos) {
+        for (size_t j = decimal + 1; j < number.size() && fractionDigits < 3; ++j, ++fractionDigits) {
+            int digit = number[j] - '0';
+            if (fractionDigits < 2) {
+                fractionCents = fractionCents * 10 + digit;
+            } else if (digit >= 5) {
+                ++fractionCents;
+            }
+        }
+        if (fractionDigits == 1) {
+            fractionCents *= 10;
+        }
+    }
+    if (wholeDigits == 0 && fractionDigits == 0) {
+        return false;
+    }
+    
+    cents = whole * 100 + fractionCents;
+    if (negative) {
+        cents = -cents;
+    }
+    return true;
+}
+
+bool StatementParser::ParseDate(std::string_view text, int& year, int& month, int& day) {
+    size_t i = 0;
+    auto readNumber = [&](int& value, size_t maxDigits) {
+        size_t start = i;
+        value = 0;
+        while (i < text.size() && i - start < maxDigits && IsDigit(text[i])) {
+            value = value * 10 + (text[i++] - '0');
+        }
+        return i - start;
+    };
+    
+    int first;
+    size_t firstDigits = readNumber(first, 8);
+    if (firstDigits == 8) {
+        // YYYYMMDD, as in OFX; a time and zone may follow
+        year = first / 10000;
+        month = first / 100 % 100;
+        day = first % 100;
+    } else {
+        if (firstDigits == 0 || i >= text.size()) {
+            return false;
+        }
+        char separator = text[i++];
+        if (separator != '-' && separator != '/' && separator != '.') {
+            return false;
+        }
+        
+        int second;
+        int third;
+        if (readNumber(second, 2) == 0 || i >= text.size() || text[i++] != separator) {
+            return false;
+        }
+        size_t thirdDigits = readNumber(third, 4);
+        if (thirdDigits == 0 || (i < text.size() && IsDigit(text[i]))) {
+            return false;
+        }
+        
+        if (firstDigits == 4) {
+            year = first;
+            month = second;
+            day = third;
+        } else if (thirdDigits == 4) {
+            // D.M.Y with dots; otherwise M/D/Y unless the first part cannot be a month
+            year = third;
+            bool dayFirst = separator == '.' || first > 12;
+            month = dayFirst ? second : first;
+            day = dayFirst ? first : second;
+        } else {
+            return false;
+        }
+    }
+    
+    return year >= 1900 && year <= 9999 && month >= 1 && month <= 12 && day >= 1 && day <= DaysInMonth(year, month);
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+
+enum class StatementFormat {
+    Csv,
+    Ofx
+};
+
+struct ImportError {
+    size_t line;            // 1-based line in the statement file
+    std::string message;
+};
+
+struct ImportReport {
+    size_t bytesTotal = 0;
+    size_t rowsParsed = 0;
+    size_t rowsImported = 0;
+    size_t rowsSkipped = 0;    // Already stored
+    size_t rowsMerged = 0;     // Already stored; their category filled in a stored "Other"
+    size_t rowsRejected = 0;
+    std::vector<ImportError> errors;   // First kMaxErrors rejections only
+    bool cancelled = false;
+    double seconds = 0.0;
+    
+    static constexpr size_t kMaxErrors = 100;
+};
+
+// Parses CSV and OFX/QFX bank statements straight out of a memory buffer.
+// Field boundaries are found with a 16-byte-at-a-time delimiter scanner
+// (SSE2 where available), and dates and amounts are parsed by hand into
+// integer cents, so no row ever goes through a stream or locale.
+//
+// CSV columns are located by header name (date, description/payee/memo,
+// amount or debit/credit, category, type, currency); without a header the
+// first three columns are taken as date, description and amount. Negative
+// amounts are expenses. OFX amounts are in the statement's CURDEF. Rows are
+// handed to the sink in chunks; the sink returns false to stop, as does the
+// progress callback.
+class StatementParser {
+public:
+    using RowSink = std::function<bool(std::vector<Transaction>& rows)>;
+    using Progress = std::function<bool(size_t bytesDone, size_t bytesTotal)>;
+    
+    static constexpr size_t kDefaultChunkRows = 8192;
+    
+    static StatementFormat DetectFormat(const std::string& path, const char* data, size_t size);
+    
+    void SetChunkRows(size_t rows) { chunkRows_ = rows > 0 ? rows : 1; }
+    void SetProgress(Progress progress) { progress_ = std::move(progress); }
+    
+    bool Parse(const char* data, size_t size, StatementFormat format, const RowSink& sink, ImportReport& report);
+    
+    // Field parsers, exposed for reuse by other importers
+    static bool ParseCents(std::string_view text, std::int64_t& cents);
+    static bool ParseDate(std::string_view text, int& year, int& month, int& day);
+
+private:
+    struct CsvColumns {
+        int date = 0;
+        int description = 1;
+        int amount = 2;
+        int debit = -1;
+        int credit = -1;
+        int category = -1;
+        int type = -1;
+        int currency = -1;
+    };
+    
+    size_t chunkRows_ = kDefaultChunkRows;
+    Progress progress_;
+    
+    // Cursor state shared by both formats
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const char* lineCursor_ = nullptr;
+    size_t lineNumber_ = 1;
+    std::vector<Transaction> chunk_;
+    
+    // Local midnight per calendar day (yyyymmdd); mktime is far slower than parsing
+    std::unordered_map<int, std::time_t> dayTimes_;
+    int lastDay_ = -1;
+    std::time_t lastTime_ = 0;
+    
+    bool ParseCsv(const RowSink& sink, ImportReport& report);
+    bool ParseOfx(const RowSink& sink, ImportReport& report);
+    bool AcceptRow(Transaction&& row, const char* position, const RowSink& sink, ImportReport& report);
+    bool Flush(const char* position, const RowSink& sink, ImportReport& report);
+    void Reject(const char* position, const std::string& message, ImportReport& report);
+    size_t LineAt(const char* position);
+    bool ToTime(int year, int month, int day, std::time_t& time);
+    static CsvColumns MapColumns(const std::vector<std::string_view>& header, bool& isHeader);
+};
\ No newline at end of file
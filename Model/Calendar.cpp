@@ -0,0 +1,56 @@
+#include "Calendar.h"
+
+std::int32_t DaysFromCivil(int year, int month, int day) {
+    // Shift the year to start in March so the leap day comes last
+    year -= month <= 2 ? 1 : 0;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+void CivilFromDays(std::int32_t days, int& year, int& month, int& day) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int shiftedMonth = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+void DayCursor::Seek(std::time_t date) {
+    std::tm calendar{};
+#ifdef _WIN32
+    bool known = localtime_s(&calendar, &date) == 0;
+#else
+    bool known = localtime_r(&date, &calendar) != nullptr;
+#endif
+    if (!known) {
+        // Out of the C library's range; answer for this instant only
+        start_ = date;
+        end_ = date + 1;
+        day_ = static_cast<std::int32_t>(date / 86400);
+        return;
+    }
+    
+    day_ = DaysFromCivil(calendar.tm_year + 1900, calendar.tm_mon + 1, calendar.tm_mday);
+    
+    // Bounds of that local day, whatever length DST makes it
+    calendar.tm_hour = 0;
+    calendar.tm_min = 0;
+    calendar.tm_sec = 0;
+    calendar.tm_isdst = -1;
+    start_ = std::mktime(&calendar);
+    calendar.tm_mday += 1;
+    calendar.tm_hour = 0;
+    calendar.tm_isdst = -1;
+    end_ = std::mktime(&calendar);
+    if (start_ > date || end_ <= date) {
+        start_ = date;
+        end_ = date + 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+std::int32_t DaysFromCivil(int year, int month, int day);
+
+// Local calendar day of a time. Remembers where the last day it looked up
+// starts and ends, so a date-ordered pass calls into the C library once per
+// day rather than once per row.
+class DayCursor {
+public:
+    std::int32_t operator()(std::time_t date) {
+        if (date < start_ || date >= end_) {
+            Seek(date);
+        }
+        return day_;
+    }
+
+private:
+    std::time_t start_ = 1;
+    std::time_t end_ = 0;
+    std::int32_t day_ = 0;
+    
+    void Seek(std::time_t date);
+};
+
+// Inverse of DaysFromCivil()
+void CivilFromDays(std::int32_t days, int& year, int& month, int& day);
+
+// Months since January 1970, for bucketing by calendar month
+inline std::int32_t MonthIndex(int year, int month) {
+    return (year - 1970) * 12 + (month - 1);
+}
\ No newline at end of file
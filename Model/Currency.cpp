@@ -0,0 +1,46 @@
+#include "Currency.h"
+#include <cmath>
+#include <cstdio>
+
+bool ParseCurrency(const std::string& text, CurrencyCode& code) {
+    if (text.size() != 3) {
+        return false;
+    }
+    
+    char letters[3];
+    for (int i = 0; i < 3; ++i) {
+        char c = text[i];
+        if (c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+        if (c < 'A' || c > 'Z') {
+            return false;
+        }
+        letters[i] = c;
+    }
+    
+    code = MakeCurrency(letters[0], letters[1], letters[2]);
+    return true;
+}
+
+std::string CurrencyToString(CurrencyCode code) {
+    return {static_cast<char>((code >> 16) & 0xff), static_cast<char>((code >> 8) & 0xff),
+            static_cast<char>(code & 0xff)};
+}
+
+std::string FormatMoney(double amount, CurrencyCode code) {
+    const char* symbol = nullptr;
+    int decimals = 2;
+    switch (code) {
+        case MakeCurrency('U', 'S', 'D'): symbol = "$"; break;
+        case MakeCurrency('E', 'U', 'R'): symbol = "€"; break;
+        case MakeCurrency('G', 'B', 'P'): symbol = "£"; break;
+        case MakeCurrency('J', 'P', 'Y'): symbol = "¥"; decimals = 0; break;
+        default: break;
+    }
+    
+    char number[64];
+    std::snprintf(number, sizeof(number), "%.*f", decimals, std::fabs(amount));
+    std::string sign = amount < 0 && std::stod(number) != 0.0 ? "-" : "";
+    return symbol ? sign + symbol + number : sign + number + " " + CurrencyToString(code);
+}
\ No newline at end of file
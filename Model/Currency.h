@@ -0,0 +1,32 @@
+#pragma once
+#include "Calendar.h"
+#include <cstdint>
+#include <string>
+
+// ISO 4217 code packed into an integer ('U' << 16 | 'S' << 8 | 'D' for USD),
+// so each row carries 4 bytes and comparisons are integer compares.
+using CurrencyCode = std::uint32_t;
+
+constexpr CurrencyCode MakeCurrency(char a, char b, char c) {
+    return static_cast<CurrencyCode>(static_cast<unsigned char>(a)) << 16 |
+           static_cast<CurrencyCode>(static_cast<unsigned char>(b)) << 8 |
+           static_cast<CurrencyCode>(static_cast<unsigned char>(c));
+}
+
+// Rows stored before currencies were tracked are in this currency
+constexpr CurrencyCode kDefaultCurrency = MakeCurrency('U', 'S', 'D');
+
+// Three letters, case-insensitive; false for anything else
+bool ParseCurrency(const std::string& text, CurrencyCode& code);
+std::string CurrencyToString(CurrencyCode code);
+
+// "$1234.50", "€12.00", "¥1500", "1234.50 CHF" (UTF-8)
+std::string FormatMoney(double amount, CurrencyCode code);
+
+// One quote: 1 unit of base buys rate units of quote on that day
+struct ExchangeRate {
+    CurrencyCode base;
+    CurrencyCode quote;
+    std::int32_t day;       // DaysFromCivil()
+    double rate;
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "Fingerprint.h"
+#include <cmath>
+
+namespace {
+    constexpr std::uint64_t kFnvOffset = 14695981039346656037ull;
+    constexpr std::uint64_t kFnvPrime = 1099511628211ull;
+    
+    std::uint64_t Mix(std::uint64_t hash, std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xff)) * kFnvPrime;
+        }
+        return hash;
+    }
+    
+    // Local yyyymmdd; localtime is slow, and rows arrive grouped by day
+    std::int64_t DayKey(std::time_t date) {
+        thread_local std::time_t lastDate = 0;
+        thread_local std::int64_t lastKey = -1;
+        if (lastKey < 0 || date != lastDate) {
+            std::tm* day = std::localtime(&date);
+            lastKey = day ? (day->tm_year + 1900) * 10000 + (day->tm_mon + 1) * 100 + day->tm_mday : 0;
+            lastDate = date;
+        }
+        return lastKey;
+    }
+}
+
+std::uint64_t BaseFingerprint(const Transaction& transaction) {
+    std::int64_t dayKey = DayKey(transaction.date);
+    std::int64_t cents = std::llround(transaction.amount * 100.0);
+    if (transaction.type == TransactionType::Expense) {
+        cents = -cents;
+    }
+    
+    std::uint64_t hash = Mix(Mix(kFnvOffset, static_cast<std::uint64_t>(dayKey)), static_cast<std::uint64_t>(cents));
+    hash = Mix(hash, transaction.currency);
+    
+    // Lower-case the description and collapse every run of whitespace to one space
+    bool pendingSpace = false;
+    bool started = false;
+    for (unsigned char c : transaction.description) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            pendingSpace = true;
+            continue;
+        }
+        if (pendingSpace && started) {
+            hash = (hash ^ ' ') * kFnvPrime;
+        }
+        pendingSpace = false;
+        started = true;
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<unsigned char>(c - 'A' + 'a');
+        }
+        hash = (hash ^ c) * kFnvPrime;
+    }
+    return hash;
+}
+
+std::uint64_t Fingerprint(std::uint64_t base, std::uint32_t ordinal) {
+    // splitmix64 finalizer over the base and ordinal
+    std::uint64_t value = base + 0x9e3779b97f4a7c15ull * (ordinal + 1ull);
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value != 0 ? value : 1; // 0 means "no fingerprint"
+}
\ No newline at end of file
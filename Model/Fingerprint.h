@@ -0,0 +1,11 @@
+#pragma once
+#include "Transaction.h"
+#include <cstdint>
+
+// Duplicate-detection keys. The base key covers the local calendar day, the
+// signed amount in cents, the currency and the description with case and
+// spacing normalized. The ordinal tells genuinely repeated rows apart (two identical
+// coffees on one day): the n-th copy in a re-imported statement matches the
+// n-th stored copy and nothing else.
+std::uint64_t BaseFingerprint(const Transaction& transaction);
+std::uint64_t Fingerprint(std::uint64_t base, std::uint32_t ordinal);
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#include "Transaction.h"
+#include <string>
+#include <ctime>
+
+enum class RecurrenceUnit {
+    Day,
+    Week,
+    Month
+};
+
+struct RecurringRule {
+    int id;
+    std::string description;
+    double amount;
+    std::string category;
+    TransactionType type;
+    CurrencyCode currency;
+    RecurrenceUnit unit;
+    int interval;           // Every `interval` units
+    int dayOfMonth;         // Monthly rules; clamped to short months
+    std::time_t nextDue;    // Next occurrence not yet materialized
+    std::time_t endDate;    // Last allowed occurrence, 0 for none
+    
+    // Constructor
+    RecurringRule() : id(0), amount(0.0), type(TransactionType::Expense), currency(kDefaultCurrency),
+                      unit(RecurrenceUnit::Month), interval(1), dayOfMonth(1), nextDue(0), endDate(0) {}
+    
+    bool IsFinished() const { return endDate != 0 && nextDue > endDate; }
+};
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
+#include "Currency.h"
 #include <string>
 #include <ctime>
+#include <cstdint>
 
 enum class TransactionType {
     Income,
@@ -14,13 +16,18 @@ struct Transaction {
     std::string category;
     TransactionType type;
     std::time_t date;
+    std::uint64_t fingerprint;  // Duplicate-detection key, 0 when not assigned
+    CurrencyCode currency;      // What amount is in
+    bool reconciled;            // Matched against a bank statement line
     
     // Constructor
-    Transaction() : id(0), amount(0.0), type(TransactionType::Expense), date(std::time(nullptr)) {}
+    Transaction() : id(0), amount(0.0), type(TransactionType::Expense), date(std::time(nullptr)), fingerprint(0),
+                    currency(kDefaultCurrency), reconciled(false) {}
     
     Transaction(int id, const std::string& desc, double amt, const std::string& cat, 
                 TransactionType t, std::time_t d = std::time(nullptr))
-        : id(id), description(desc), amount(amt), category(cat), type(t), date(d) {}
+        : id(id), description(desc), amount(amt), category(cat), type(t), date(d), fingerprint(0),
+          currency(kDefaultCurrency), reconciled(false) {}
     
     // Helper methods
     std::string GetTypeString() const {
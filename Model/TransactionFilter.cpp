@@ -0,0 +1,141 @@
+#include "TransactionFilter.h"
+#include <algorithm>
+
+namespace {
+    char FoldCase(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    
+    bool ContainsFolded(const std::string& text, const std::string& part) {
+        auto found = std::search(text.begin(), text.end(), part.begin(), part.end(),
+                                 [](char a, char b) { return FoldCase(a) == FoldCase(b); });
+        return found != text.end() || part.empty();
+    }
+}
+
+TransactionFilter TransactionFilter::Category(const std::string& category) {
+    TransactionFilter filter(Kind::Category);
+    filter.text_ = category;
+    return filter;
+}
+
+TransactionFilter TransactionFilter::Type(TransactionType type) {
+    TransactionFilter filter(Kind::Type);
+    filter.value_ = static_cast<int>(type);
+    return filter;
+}
+
+TransactionFilter TransactionFilter::Currency(CurrencyCode currency) {
+    TransactionFilter filter(Kind::Currency);
+    filter.value_ = static_cast<int>(currency);
+    return filter;
+}
+
+TransactionFilter TransactionFilter::DateRange(std::time_t from, std::time_t to) {
+    TransactionFilter filter(Kind::DateRange);
+    filter.low_ = static_cast<double>(from);
+    filter.high_ = static_cast<double>(to);
+    return filter;
+}
+
+TransactionFilter TransactionFilter::AmountRange(double min, double max) {
+    TransactionFilter filter(Kind::AmountRange);
+    filter.low_ = min;
+    filter.high_ = max;
+    return filter;
+}
+
+TransactionFilter TransactionFilter::Text(const std::string& text) {
+    TransactionFilter filter(Kind::Text);
+    filter.text_ = text;
+    return filter;
+}
+
+TransactionFilter TransactionFilter::Join(Kind kind, TransactionFilter left, TransactionFilter right) {
+    TransactionFilter joined(kind);
+    for (TransactionFilter* side : {&left, &right}) {
+        if (side->kind_ == kind) {
+            for (auto& child : side->children_) {
+                joined.children_.push_back(std::move(child));
+            }
+        } else {
+            joined.children_.push_back(std::move(*side));
+        }
+    }
+    return joined;
+}
+
+TransactionFilter operator&&(TransactionFilter left, TransactionFilter right) {
+    if (left.kind_ == TransactionFilter::Kind::All) {
+        return right;
+    }
+    if (right.kind_ == TransactionFilter::Kind::All) {
+        return left;
+    }
+    return TransactionFilter::Join(TransactionFilter::Kind::And, std::move(left), std::move(right));
+}
+
+TransactionFilter operator||(TransactionFilter left, TransactionFilter right) {
+    if (left.kind_ == TransactionFilter::Kind::All || right.kind_ == TransactionFilter::Kind::All) {
+        return TransactionFilter();
+    }
+    return TransactionFilter::Join(TransactionFilter::Kind::Or, std::move(left), std::move(right));
+}
+
+TransactionFilter operator!(TransactionFilter filter) {
+    if (filter.kind_ == TransactionFilter::Kind::Not) {
+        return std::move(filter.children_.front());
+    }
+    TransactionFilter negated(TransactionFilter::Kind::Not);
+    negated.children_.push_back(std::move(filter));
+    return negated;
+}
+
+bool TransactionFilter::Matches(const Transaction& transaction) const {
+    switch (kind_) {
+        case Kind::All:
+            return true;
+        case Kind::Category:
+            return transaction.category == text_;
+        case Kind::Type:
+            return static_cast<int>(transaction.type) == value_;
+        case Kind::Currency:
+            return static_cast<int>(transaction.currency) == value_;
+        case Kind::DateRange:
+            return (low_ == 0.0 || transaction.date >= low_) && (high_ == 0.0 || transaction.date < high_);
+        case Kind::AmountRange:
+            return transaction.amount >= low_ && transaction.amount <= high_;
+        case Kind::Text:
+            return ContainsFolded(transaction.description, text_);
+        case Kind::And:
+            return std::all_of(children_.begin(), children_.end(),
+                               [&](const TransactionFilter& child) { return child.Matches(transaction); });
+        case Kind::Or:
+            return std::any_of(children_.begin(), children_.end(),
+                               [&](const TransactionFilter& child) { return child.Matches(transaction); });
+        case Kind::Not:
+            return !children_.front().Matches(transaction);
+    }
+    return false;
+}
+
+void TransactionFilter::DateBounds(std::time_t& from, std::time_t& to) const {
+    from = 0;
+    to = 0;
+    auto narrow = [&](const TransactionFilter& range) {
+        std::time_t low = static_cast<std::time_t>(range.low_);
+        std::time_t high = static_cast<std::time_t>(range.high_);
+        from = std::max(from, low);
+        to = to == 0 ? high : high == 0 ? to : std::min(to, high);
+    };
+    
+    if (kind_ == Kind::DateRange) {
+        narrow(*this);
+    } else if (kind_ == Kind::And) {
+        for (const auto& child : children_) {
+            if (child.kind_ == Kind::DateRange) {
+                narrow(child);
+            }
+        }
+    }
+}
\ No newline at end of file
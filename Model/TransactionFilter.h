@@ -0,0 +1,77 @@
+#pragma once
+#include "Transaction.h"
+#include <string>
+#include <vector>
+#include <ctime>
+#include <limits>
+
+// A condition on transactions, put together from small pieces with &&, ||
+// and !:
+//
+//     TransactionFilter::Category("Food") && TransactionFilter::Type(TransactionType::Expense) &&
+//         TransactionFilter::AmountRange(20.0) && !TransactionFilter::Text("coffee")
+//
+// The same filter can be checked against rows in memory with Matches(), or
+// handed to DatabaseHandler::QueryTransactions(), which compiles it to SQL
+// with the values as bound parameters.
+class TransactionFilter {
+public:
+    enum class Kind {
+        All,          // Matches every row
+        Category,
+        Type,
+        Currency,
+        DateRange,
+        AmountRange,
+        Text,
+        And,
+        Or,
+        Not
+    };
+    
+    TransactionFilter() : kind_(Kind::All), value_(0), low_(0.0), high_(0.0) {}
+    
+    static TransactionFilter Category(const std::string& category);
+    static TransactionFilter Type(TransactionType type);
+    static TransactionFilter Currency(CurrencyCode currency);
+    
+    // From from up to but not including to; a zero bound leaves that end open
+    static TransactionFilter DateRange(std::time_t from, std::time_t to);
+    
+    // Both bounds included; an infinite bound leaves that end open
+    static TransactionFilter AmountRange(double min, double max = std::numeric_limits<double>::infinity());
+    
+    // Description contains text, ignoring ASCII case like SQL's LIKE
+    static TransactionFilter Text(const std::string& text);
+    
+    // Chains of the same operator stay flat, and All drops out where it can
+    friend TransactionFilter operator&&(TransactionFilter left, TransactionFilter right);
+    friend TransactionFilter operator||(TransactionFilter left, TransactionFilter right);
+    friend TransactionFilter operator!(TransactionFilter filter);
+    
+    bool Matches(const Transaction& transaction) const;
+    
+    // Dates every match falls within, [from, to) with 0 for an open end, as
+    // far as the top level pins them down; lets a date-ordered cache skip
+    // straight to the rows that can match
+    void DateBounds(std::time_t& from, std::time_t& to) const;
+    
+    Kind GetKind() const { return kind_; }
+    const std::string& GetText() const { return text_; }   // Category or Text
+    int GetValue() const { return value_; }                // Type or Currency
+    double GetLow() const { return low_; }                 // DateRange or AmountRange
+    double GetHigh() const { return high_; }
+    const std::vector<TransactionFilter>& GetChildren() const { return children_; }
+
+private:
+    Kind kind_;
+    std::string text_;
+    int value_;
+    double low_;
+    double high_;
+    std::vector<TransactionFilter> children_;
+    
+    explicit TransactionFilter(Kind kind) : kind_(kind), value_(0), low_(0.0), high_(0.0) {}
+    
+    static TransactionFilter Join(Kind kind, TransactionFilter left, TransactionFilter right);
+};
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include "Json.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Recursive descent over the request text. Nesting is capped so a hostile
+// request cannot exhaust the stack.
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text_(text), position_(0) {}
+    
+    bool ParseDocument(JsonValue& value, std::string& error) {
+        if (!ParseValue(value, 0)) {
+            error = error_ + " at offset " + std::to_string(position_);
+            return false;
+        }
+        SkipSpace();
+        if (position_ != text_.size()) {
+            error = "Unexpected trailing characters at offset " + std::to_string(position_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr int kMaxDepth = 64;
+    
+    const std::string& text_;
+    size_t position_;
+    std::string error_;
+    
+    bool Fail(const char* message) {
+        error_ = message;
+        return false;
+    }
+    
+    void SkipSpace() {
+        while (position_ < text_.size() &&
+               (text_[position_] == ' ' || text_[position_] == '\t' || text_[position_] == '\r' ||
+                text_[position_] == '\n')) {
+            ++position_;
+        }
+    }
+    
+    bool Consume(const char* literal) {
+        size_t length = std::char_traits<char>::length(literal);
+        if (text_.compare(position_, length, literal) != 0) {
+            return false;
+        }
+        position_ += length;
+        return true;
+    }
+    
+    bool ParseValue(JsonValue& value, int depth) {
+        if (depth > kMaxDepth) {
+            return Fail("Nesting too deep");
+        }
+        
+        SkipSpace();
+        if (position_ >= text_.size()) {
+            return Fail("Unexpected end of input");
+        }
+        
+        switch (text_[position_]) {
+            case '{':
+                return ParseObject(value, depth);
+            case '[':
+                return ParseArray(value, depth);
+            case '"':
+                value = JsonValue(std::string());
+                return ParseString(value.string_);
+            case 't':
+                value = JsonValue(true);
+                return Consume("true") || Fail("Invalid literal");
+            case 'f':
+                value = JsonValue(false);
+                return Consume("false") || Fail("Invalid literal");
+            case 'n':
+                value = JsonValue();
+                return Consume("null") || Fail("Invalid literal");
+            default:
+                return ParseNumber(value);
+        }
+    }
+    
+    bool ParseObject(JsonValue& value, int depth) {
+        value = JsonValue::MakeObject();
+        ++position_;
+        SkipSpace();
+        if (position_ < text_.size() && text_[position_] == '}') {
+            ++position_;
+            return true;
+        }
+        
+        while (true) {
+            SkipSpace();
+            std::string key;
+            if (position_ >= text_.size() || text_[position_] != '"' || !ParseString(key)) {
+                return error_.empty() ? Fail("Expected a member name") : false;
+            }
+            SkipSpace();
+            if (position_ >= text_.size() || text_[position_] != ':') {
+                return Fail("Expected ':'");
+            }
+            ++position_;
+            
+            JsonValue member;
+            if (!ParseValue(member, depth + 1)) {
+                return false;
+            }
+            value.Set(key, std::move(member));
+            
+            SkipSpace();
+            if (position_ < text_.size() && text_[position_] == ',') {
+                ++position_;
+            } else if (position_ < text_.size() && text_[position_] == '}') {
+                ++position_;
+                return true;
+            } else {
+                return Fail("Expected ',' or '}'");
+            }
+        }
+    }
+    
+    bool ParseArray(JsonValue& value, int depth) {
+        value = JsonValue::MakeArray();
+        ++position_;
+        SkipSpace();
+        if (position_ < text_.size() && text_[position_] == ']') {
+            ++position_;
+            return true;
+        }
+        
+        while (true) {
+            JsonValue item;
+            if (!ParseValue(item, depth + 1)) {
+                return false;
+            }
+            value.Push(std::move(item));
+            
+            SkipSpace();
+            if (position_ < text_.size() && text_[position_] == ',') {
+                ++position_;
+            } else if (position_ < text_.size() && text_[position_] == ']') {
+                ++position_;
+                return true;
+            } else {
+                return Fail("Expected ',' or ']'");
+            }
+        }
+    }
+    
+    bool ParseHex(unsigned& code) {
+        if (position_ + 4 > text_.size()) {
+            return Fail("Truncated \\u escape");
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text_[position_++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= static_cast<unsigned>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= static_cast<unsigned>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= static_cast<unsigned>(c - 'A' + 10);
+            } else {
+                return Fail("Invalid \\u escape");
+            }
+        }
+        return true;
+    }
+    
+    static void AppendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+    
+    bool ParseString(std::string& out) {
+        ++position_; // Opening quote
+        while (position_ < text_.size()) {
+            char c = text_[position_++];
+            if (c == '"') {
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return Fail("Control character in string");
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            
+            if (position_ >= text_.size()) {
+                break;
+            }
+            char escape = text_[position_++];
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned code;
+                    if (!ParseHex(code)) {
+                        return false;
+                    }
+                    // A high surrogate must be followed by its low half
+                    if (code >= 0xD800 && code <= 0xDBFF) {
+                        unsigned low;
+                        if (!Consume("\\u") || !ParseHex(low) || low < 0xDC00 || low > 0xDFFF) {
+                            return Fail("Invalid surrogate pair");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                        return Fail("Invalid surrogate pair");
+                    }
+                    AppendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return Fail("Invalid escape");
+            }
+        }
+        return Fail("Unterminated string");
+    }
+    
+    bool ParseNumber(JsonValue& value) {
+        size_t start = position_;
+        if (position_ < text_.size() && text_[position_] == '-') {
+            ++position_;
+        }
+        while (position_ < text_.size() &&
+               ((text_[position_] >= '0' && text_[position_] <= '9') || text_[position_] == '.' ||
+                text_[position_] == 'e' || text_[position_] == 'E' || text_[position_] == '+' ||
+                text_[position_] == '-')) {
+            ++position_;
+        }
+        if (position_ == start) {
+            return Fail("Unexpected character");
+        }
+        
+        std::string number = text_.substr(start, position_ - start);
+        char* end = nullptr;
+        double parsed = std::strtod(number.c_str(), &end);
+        if (end != number.c_str() + number.size() || !std::isfinite(parsed)) {
+            return Fail("Invalid number");
+        }
+        value = JsonValue(parsed);
+        return true;
+    }
+};
+
+JsonValue JsonValue::MakeArray() {
+    JsonValue value;
+    value.type_ = Type::Array;
+    return value;
+}
+
+JsonValue JsonValue::MakeObject() {
+    JsonValue value;
+    value.type_ = Type::Object;
+    return value;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+    static const JsonValue null;
+    for (const auto& member : members_) {
+        if (member.first == key) {
+            return member.second;
+        }
+    }
+    return null;
+}
+
+JsonValue& JsonValue::Set(const std::string& key, JsonValue value) {
+    for (auto& member : members_) {
+        if (member.first == key) {
+            member.second = std::move(value);
+            return member.second;
+        }
+    }
+    members_.emplace_back(key, std::move(value));
+    return members_.back().second;
+}
+
+void JsonValue::Push(JsonValue value) {
+    items_.push_back(std::move(value));
+}
+
+std::string JsonValue::Dump() const {
+    std::string out;
+    DumpTo(out);
+    return out;
+}
+
+namespace {
+    void DumpString(const std::string& text, std::string& out) {
+        out += '"';
+        for (unsigned char c : text) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        char escape[8];
+                        std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                        out += escape;
+                    } else {
+                        out += static_cast<char>(c);
+                    }
+            }
+        }
+        out += '"';
+    }
+}
+
+void JsonValue::DumpTo(std::string& out) const {
+    switch (type_) {
+        case Type::Null:
+            out += "null";
+            break;
+        case Type::Bool:
+            out += bool_ ? "true" : "false";
+            break;
+        case Type::Number: {
+            // Whole numbers print without a fraction; 15 digits keep amounts like 12.34 exact
+            char buffer[32];
+            if (std::nearbyint(number_) == number_ && std::fabs(number_) < 1e15) {
+                std::snprintf(buffer, sizeof(buffer), "%.0f", number_);
+            } else {
+                std::snprintf(buffer, sizeof(buffer), "%.15g", number_);
+            }
+            out += buffer;
+            break;
+        }
+        case Type::String:
+            DumpString(string_, out);
+            break;
+        case Type::Array:
+            out += '[';
+            for (size_t i = 0; i < items_.size(); ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                items_[i].DumpTo(out);
+            }
+            out += ']';
+            break;
+        case Type::Object:
+            out += '{';
+            for (size_t i = 0; i < members_.size(); ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                DumpString(members_[i].first, out);
+                out += ':';
+                members_[i].second.DumpTo(out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+bool JsonValue::Parse(const std::string& text, JsonValue& value, std::string& error) {
+    JsonParser parser(text);
+    return parser.ParseDocument(value, error);
+}
\ No newline at end of file
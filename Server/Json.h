@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+// Small JSON document model for the query server: parse one value from a
+// request line, build responses, serialize compactly. Objects keep their
+// members in insertion order; lookups are linear, which suits the handful
+// of keys a request carries.
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    
+    JsonValue() : type_(Type::Null), bool_(false), number_(0.0) {}
+    JsonValue(bool value) : type_(Type::Bool), bool_(value), number_(0.0) {}
+    JsonValue(double value) : type_(Type::Number), bool_(false), number_(value) {}
+    JsonValue(int value) : JsonValue(static_cast<double>(value)) {}
+    JsonValue(long long value) : JsonValue(static_cast<double>(value)) {}
+    JsonValue(size_t value) : JsonValue(static_cast<double>(value)) {}
+    JsonValue(const char* value) : type_(Type::String), bool_(false), number_(0.0), string_(value) {}
+    JsonValue(std::string value) : type_(Type::String), bool_(false), number_(0.0), string_(std::move(value)) {}
+    
+    static JsonValue MakeArray();
+    static JsonValue MakeObject();
+    
+    Type GetType() const { return type_; }
+    bool IsNull() const { return type_ == Type::Null; }
+    bool IsNumber() const { return type_ == Type::Number; }
+    bool IsString() const { return type_ == Type::String; }
+    bool IsObject() const { return type_ == Type::Object; }
+    
+    bool AsBool(bool fallback = false) const { return type_ == Type::Bool ? bool_ : fallback; }
+    double AsNumber(double fallback = 0.0) const { return type_ == Type::Number ? number_ : fallback; }
+    const std::string& AsString() const { return string_; }
+    
+    // Object members; a missing key (or a non-object) reads as null
+    const JsonValue& operator[](const std::string& key) const;
+    bool Has(const std::string& key) const { return !(*this)[key].IsNull(); }
+    JsonValue& Set(const std::string& key, JsonValue value);
+    
+    // Array elements
+    void Push(JsonValue value);
+    const std::vector<JsonValue>& Items() const { return items_; }
+    
+    std::string Dump() const;
+    void DumpTo(std::string& out) const;
+    
+    // Parses text holding exactly one value; on failure fills error
+    static bool Parse(const std::string& text, JsonValue& value, std::string& error);
+
+private:
+    Type type_;
+    bool bool_;
+    double number_;
+    std::string string_;
+    std::vector<JsonValue> items_;
+    std::vector<std::pair<std::string, JsonValue>> members_;
+    
+    friend class JsonParser;
+};
\ No newline at end of file
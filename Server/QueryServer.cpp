@@ -0,0 +1,436 @@
+#include "QueryServer.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+    // A request line longer than this is refused and the client dropped
+    constexpr size_t kMaxLineBytes = 1 << 20;
+    constexpr size_t kReadChunk = 64 * 1024;
+    
+    bool SetNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+    
+    std::string ErrorLine(const std::string& message) {
+        JsonValue response = JsonValue::MakeObject();
+        response.Set("id", JsonValue());
+        response.Set("error", message);
+        return response.Dump() + '\n';
+    }
+}
+
+QueryServer::QueryServer(TransactionManager& manager, Options options)
+    : handler_(manager)
+    , options_(std::move(options))
+    , listenFd_(-1)
+    , wakeFds_{-1, -1}
+    , stopping_(false)
+    , nextConnection_(1)
+    , maintenanceDue_(false)
+    , shuttingDown_(false) {
+    if (options_.readers == 0) {
+        options_.readers = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+QueryServer::~QueryServer() {
+    Shutdown();
+}
+
+bool QueryServer::Start() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options_.socketPath.empty() || options_.socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path is empty or too long: " << options_.socketPath << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, options_.socketPath.c_str());
+    
+    // Writing to a client that hung up must fail the write, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    if (pipe(wakeFds_) != 0 || !SetNonBlocking(wakeFds_[0]) || !SetNonBlocking(wakeFds_[1])) {
+        std::cerr << "Failed to create wake pipe: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    // Connecting tells a live server apart from a socket file left by a crash
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0) {
+        bool live = connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        int probeError = errno;
+        close(probe);
+        if (live) {
+            std::cerr << "Another server is already listening on " << options_.socketPath << std::endl;
+            return false;
+        }
+        if (probeError == ECONNREFUSED) {
+            unlink(options_.socketPath.c_str());
+        }
+    }
+    
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    // The ledger is private: only the owner may connect
+    mode_t previousMask = umask(0177);
+    int bound = bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    umask(previousMask);
+    
+    if (bound != 0 || listen(listenFd_, SOMAXCONN) != 0 || !SetNonBlocking(listenFd_)) {
+        std::cerr << "Failed to listen on " << options_.socketPath << ": " << std::strerror(errno) << std::endl;
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    
+    return true;
+}
+
+void QueryServer::Run() {
+    if (listenFd_ < 0) {
+        return;
+    }
+    
+    for (size_t i = 0; i < options_.readers; ++i) {
+        workers_.emplace_back(&QueryServer::ReaderLoop, this);
+    }
+    workers_.emplace_back(&QueryServer::WriterLoop, this);
+    
+    using Clock = std::chrono::steady_clock;
+    const auto maintenanceInterval = std::chrono::seconds(options_.maintenanceSeconds);
+    auto nextMaintenance = Clock::now() + maintenanceInterval;
+    
+    std::vector<pollfd> descriptors;
+    std::vector<std::uint64_t> ids;
+    while (!stopping_.load()) {
+        descriptors.clear();
+        ids.clear();
+        descriptors.push_back({wakeFds_[0], POLLIN, 0});
+        descriptors.push_back({listenFd_, POLLIN, 0});
+        for (const auto& entry : connections_) {
+            const Connection& connection = entry.second;
+            short events = 0;
+            if (!connection.closing && connection.pending < options_.maxPendingPerConnection) {
+                events |= POLLIN;
+            }
+            if (!connection.output.empty()) {
+                events |= POLLOUT;
+            }
+            // A negative fd is skipped, so a hung-up client that is only
+            // waiting on workers does not keep poll() returning POLLHUP
+            int fd = connection.closing && connection.output.empty() ? -1 : connection.fd;
+            descriptors.push_back({fd, events, 0});
+            ids.push_back(entry.first);
+        }
+        
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextMaintenance - Clock::now());
+        int ready = poll(descriptors.data(), descriptors.size(), std::max<int>(0, static_cast<int>(wait.count())));
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        
+        if (Clock::now() >= nextMaintenance) {
+            nextMaintenance = Clock::now() + maintenanceInterval;
+            {
+                std::lock_guard<std::mutex> lock(jobsMutex_);
+                maintenanceDue_ = true;
+            }
+            writesReady_.notify_one();
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        
+        if (descriptors[0].revents & POLLIN) {
+            char drain[256];
+            while (read(wakeFds_[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        DrainCompletions();
+        
+        if (descriptors[1].revents & POLLIN) {
+            Accept();
+        }
+        
+        for (size_t i = 0; i < ids.size(); ++i) {
+            short revents = descriptors[i + 2].revents;
+            auto it = connections_.find(ids[i]);
+            if (revents == 0 || it == connections_.end()) {
+                continue;
+            }
+            
+            Connection& connection = it->second;
+            bool healthy = !(revents & (POLLERR | POLLNVAL));
+            if (healthy && (revents & (POLLIN | POLLHUP)) && !connection.closing) {
+                healthy = ReadFrom(ids[i], connection);
+            }
+            if (healthy && (revents & POLLOUT)) {
+                healthy = WriteTo(connection);
+            }
+            
+            if (!healthy || (connection.closing && connection.pending == 0 && connection.output.empty())) {
+                CloseConnection(ids[i]);
+            }
+        }
+    }
+    
+    Shutdown();
+}
+
+void QueryServer::Stop() {
+    stopping_.store(true);
+    Wake();
+}
+
+void QueryServer::ReaderLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex_);
+            readsReady_.wait(lock, [this] { return shuttingDown_ || !reads_.empty(); });
+            if (shuttingDown_) {
+                return;
+            }
+            job = std::move(reads_.front());
+            reads_.pop_front();
+        }
+        Complete(job.connection, handler_.Handle(job.request));
+    }
+}
+
+void QueryServer::WriterLoop() {
+    while (true) {
+        Job job;
+        bool maintain = false;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex_);
+            writesReady_.wait(lock, [this] { return shuttingDown_ || maintenanceDue_ || !writes_.empty(); });
+            if (shuttingDown_) {
+                return;
+            }
+            if (maintenanceDue_) {
+                maintain = true;
+                maintenanceDue_ = false;
+            } else {
+                job = std::move(writes_.front());
+                writes_.pop_front();
+            }
+        }
+        
+        if (maintain) {
+            handler_.Maintain(std::time(nullptr));
+        } else {
+            Complete(job.connection, handler_.Handle(job.request));
+        }
+    }
+}
+
+void QueryServer::Complete(std::uint64_t connection, const JsonValue& response) {
+    // Serialize here so the I/O thread only copies bytes
+    std::string line = response.Dump();
+    line += '\n';
+    
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(completionsMutex_);
+        first = completions_.empty();
+        completions_.push_back({connection, std::move(line)});
+    }
+    if (first) {
+        Wake();
+    }
+}
+
+void QueryServer::Wake() {
+    if (wakeFds_[1] >= 0) {
+        char byte = 0;
+        ssize_t ignored = write(wakeFds_[1], &byte, 1);  // A full pipe already means a wakeup is pending
+        (void)ignored;
+    }
+}
+
+void QueryServer::Accept() {
+    while (true) {
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+        
+        if (connections_.size() >= options_.maxConnections || !SetNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+        connections_.emplace(nextConnection_++, Connection{fd, std::string(), std::string(), 0, false});
+    }
+}
+
+bool QueryServer::ReadFrom(std::uint64_t id, Connection& connection) {
+    char buffer[kReadChunk];
+    while (true) {
+        ssize_t received = read(connection.fd, buffer, sizeof(buffer));
+        if (received > 0) {
+            connection.input.append(buffer, static_cast<size_t>(received));
+            if (static_cast<size_t>(received) < sizeof(buffer)) {
+                break;
+            }
+        } else if (received == 0) {
+            // The client is done sending; answer what it asked, then close
+            connection.closing = true;
+            break;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+    
+    size_t start = 0;
+    size_t newline;
+    while ((newline = connection.input.find('\n', start)) != std::string::npos) {
+        size_t end = newline;
+        if (end > start && connection.input[end - 1] == '\r') {
+            --end;
+        }
+        if (end > start) {
+            Dispatch(id, connection, connection.input.substr(start, end - start));
+        }
+        start = newline + 1;
+    }
+    connection.input.erase(0, start);
+    
+    if (connection.input.size() > kMaxLineBytes) {
+        connection.output += ErrorLine("Request line too long");
+        connection.input.clear();
+        connection.closing = true;
+    }
+    
+    return WriteTo(connection);
+}
+
+bool QueryServer::WriteTo(Connection& connection) {
+    size_t sent = 0;
+    while (sent < connection.output.size()) {
+        ssize_t written = write(connection.fd, connection.output.data() + sent, connection.output.size() - sent);
+        if (written > 0) {
+            sent += static_cast<size_t>(written);
+        } else if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    connection.output.erase(0, sent);
+    return true;
+}
+
+void QueryServer::Dispatch(std::uint64_t id, Connection& connection, const std::string& line) {
+    JsonValue request;
+    std::string error;
+    if (!JsonValue::Parse(line, request, error)) {
+        connection.output += ErrorLine("Invalid JSON: " + error);
+        return;
+    }
+    
+    bool write = RequestHandler::IsWrite(request["method"].AsString());
+    ++connection.pending;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        (write ? writes_ : reads_).push_back({id, std::move(request)});
+    }
+    if (write) {
+        writesReady_.notify_one();
+    } else {
+        readsReady_.notify_one();
+    }
+}
+
+void QueryServer::DrainCompletions() {
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock(completionsMutex_);
+        completions.swap(completions_);
+    }
+    
+    for (auto& completion : completions) {
+        auto it = connections_.find(completion.connection);
+        if (it == connections_.end()) {
+            continue;  // The client left before its answer was ready
+        }
+        
+        Connection& connection = it->second;
+        --connection.pending;
+        connection.output += completion.response;
+    }
+    
+    // Send right away rather than waiting a poll() round for POLLOUT
+    std::vector<std::uint64_t> finished;
+    for (auto& entry : connections_) {
+        Connection& connection = entry.second;
+        if (!connection.output.empty() && !WriteTo(connection)) {
+            finished.push_back(entry.first);
+        } else if (connection.closing && connection.pending == 0 && connection.output.empty()) {
+            finished.push_back(entry.first);
+        }
+    }
+    for (std::uint64_t id : finished) {
+        CloseConnection(id);
+    }
+}
+
+void QueryServer::CloseConnection(std::uint64_t id) {
+    auto it = connections_.find(id);
+    if (it != connections_.end()) {
+        close(it->second.fd);
+        connections_.erase(it);
+    }
+}
+
+void QueryServer::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex_);
+        shuttingDown_ = true;
+    }
+    readsReady_.notify_all();
+    writesReady_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    
+    while (!connections_.empty()) {
+        CloseConnection(connections_.begin()->first);
+    }
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+        unlink(options_.socketPath.c_str());
+    }
+    for (int& fd : wakeFds_) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include "RequestHandler.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Headless access to the ledger for local scripts: newline-delimited JSON
+// over a Unix domain socket (POSIX only). One thread multiplexes every
+// connection with poll() and parses requests; reads go to a pool of worker
+// threads and writes to a single writer thread, so they apply one at a time
+// in arrival order. Responses carry the request's id and may come back out of
+// order when one connection mixes reads and writes.
+class QueryServer {
+public:
+    struct Options {
+        std::string socketPath = "finance_tracker.sock";
+        size_t readers = 0;              // 0 means one per hardware thread
+        size_t maxConnections = 256;
+        size_t maxPendingPerConnection = 64;  // Past this, stop reading from the client
+        int maintenanceSeconds = 2;
+    };
+    
+    QueryServer(TransactionManager& manager, Options options);
+    ~QueryServer();
+    
+    // Disable copy constructor and assignment operator
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+    
+    // Creates the socket, readable by the owner only. Fails if another
+    // server is already listening on it; a file left by a crash is replaced.
+    bool Start();
+    
+    // Serves on the calling thread until Stop()
+    void Run();
+    
+    // Safe from any thread, including a signal handler
+    void Stop();
+
+private:
+    struct Connection {
+        int fd;
+        std::string input;
+        std::string output;
+        size_t pending;  // Requests handed to workers and not yet answered
+        bool closing;    // Peer finished sending; close once answered
+    };
+    
+    struct Job {
+        std::uint64_t connection;
+        JsonValue request;
+    };
+    
+    struct Completion {
+        std::uint64_t connection;
+        std::string response;
+    };
+    
+    RequestHandler handler_;
+    Options options_;
+    int listenFd_;
+    int wakeFds_[2];  // Workers and Stop() nudge poll() through this pipe
+    std::atomic<bool> stopping_;
+    
+    // Owned by the I/O thread
+    std::unordered_map<std::uint64_t, Connection> connections_;
+    std::uint64_t nextConnection_;
+    
+    std::mutex jobsMutex_;
+    std::condition_variable readsReady_;
+    std::condition_variable writesReady_;
+    std::deque<Job> reads_;
+    std::deque<Job> writes_;
+    bool maintenanceDue_;
+    bool shuttingDown_;
+    std::vector<std::thread> workers_;
+    
+    std::mutex completionsMutex_;
+    std::vector<Completion> completions_;
+    
+    void ReaderLoop();
+    void WriterLoop();
+    void Complete(std::uint64_t connection, const JsonValue& response);
+    void Wake();
+    
+    void Accept();
+    bool ReadFrom(std::uint64_t id, Connection& connection);
+    bool WriteTo(Connection& connection);
+    void Dispatch(std::uint64_t id, Connection& connection, const std::string& line);
+    void DrainCompletions();
+    void CloseConnection(std::uint64_t id);
+    void Shutdown();
+};
\ No newline at end of file
@@ -0,0 +1,455 @@
+#include "RequestHandler.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+namespace {
+    constexpr long long kDefaultPageSize = 50;
+    constexpr long long kMaxPageSize = 1000;
+    
+    // Sums of many amounts drift off the cent; report them as money
+    double ToCents(double amount) {
+        return std::round(amount * 100.0) / 100.0;
+    }
+    
+    JsonValue ToJson(const Transaction& transaction) {
+        JsonValue item = JsonValue::MakeObject();
+        item.Set("id", transaction.id);
+        item.Set("description", transaction.description);
+        item.Set("amount", transaction.amount);
+        item.Set("currency", CurrencyToString(transaction.currency));
+        item.Set("category", transaction.category);
+        item.Set("type", transaction.type == TransactionType::Income ? "income" : "expense");
+        item.Set("date", static_cast<long long>(transaction.date));
+        return item;
+    }
+    
+    JsonValue ToJson(const CurrencyConverter::Totals& totals) {
+        std::map<std::string, double> sorted(totals.byCategory.begin(), totals.byCategory.end());
+        JsonValue categories = JsonValue::MakeObject();
+        for (const auto& category : sorted) {
+            categories.Set(category.first, ToCents(category.second));
+        }
+        
+        JsonValue result = JsonValue::MakeObject();
+        result.Set("currency", CurrencyToString(totals.currency));
+        result.Set("count", totals.rows);
+        result.Set("unconverted", totals.unconverted);
+        result.Set("income", ToCents(totals.income));
+        result.Set("expenses", ToCents(totals.expenses));
+        result.Set("balance", ToCents(totals.income - totals.expenses));
+        result.Set("categories", std::move(categories));
+        return result;
+    }
+    
+    JsonValue ToJson(const StorageStats& stats) {
+        JsonValue result = JsonValue::MakeObject();
+        result.Set("bytes", static_cast<long long>(stats.GetBytes()));
+        result.Set("page_size", static_cast<long long>(stats.pageSize));
+        result.Set("pages", static_cast<long long>(stats.pages));
+        result.Set("free_pages", static_cast<long long>(stats.freePages));
+        result.Set("incremental_vacuum", stats.incrementalVacuum);
+        result.Set("strict", stats.strict);
+        return result;
+    }
+    
+    // Whole number within [minimum, maximum]; absent values take the fallback
+    bool ReadInteger(const JsonValue& value, const char* name, long long minimum, long long maximum,
+                     long long fallback, long long& out, std::string& error) {
+        if (value.IsNull()) {
+            out = fallback;
+            return true;
+        }
+        
+        double number = value.AsNumber(std::nan(""));
+        if (!value.IsNumber() || std::floor(number) != number || number < minimum || number > maximum) {
+            error = std::string("\"") + name + "\" must be a whole number from " + std::to_string(minimum) +
+                    " to " + std::to_string(maximum);
+            return false;
+        }
+        out = static_cast<long long>(number);
+        return true;
+    }
+    
+    bool ReadId(const JsonValue& params, long long& id, std::string& error) {
+        if (params["id"].IsNull()) {
+            error = "\"id\" is required";
+            return false;
+        }
+        return ReadInteger(params["id"], "id", 1, 2147483647LL, 0, id, error);
+    }
+    
+    bool ReadPage(const JsonValue& params, long long& offset, long long& limit, std::string& error) {
+        return ReadInteger(params["offset"], "offset", 0, 2147483647LL, 0, offset, error) &&
+               ReadInteger(params["limit"], "limit", 1, kMaxPageSize, kDefaultPageSize, limit, error);
+    }
+    
+    // Optional times in seconds since 1970; absent or 0 is open-ended (and,
+    // for a transaction's date, now or unchanged)
+    bool ReadDate(const JsonValue& value, const char* name, std::time_t& date, std::string& error) {
+        long long seconds;
+        if (!ReadInteger(value, name, 0, 253402300799LL, 0, seconds, error)) {  // Up to the end of 9999
+            return false;
+        }
+        date = static_cast<std::time_t>(seconds);
+        return true;
+    }
+    
+    // Snapshot rows dated in [from, to), from the optional "from" and "to"
+    bool ReadRange(const JsonValue& params, const TransactionSnapshot& rows, size_t& first, size_t& last,
+                   std::string& error) {
+        std::time_t from;
+        std::time_t to;
+        if (!ReadDate(params["from"], "from", from, error) || !ReadDate(params["to"], "to", to, error)) {
+            return false;
+        }
+        first = to ? rows.FirstBefore(to) : 0;
+        last = std::max(first, from ? rows.FirstBefore(from) : rows.size());
+        return true;
+    }
+    
+    // Optional three-letter code; absent leaves currency as it was
+    bool ReadCurrency(const JsonValue& value, CurrencyCode& currency, std::string& error) {
+        if (value.IsNull()) {
+            return true;
+        }
+        if (!value.IsString() || !ParseCurrency(value.AsString(), currency)) {
+            error = "\"currency\" must be a three-letter currency code";
+            return false;
+        }
+        return true;
+    }
+    
+    // The fields add and update share; the same rules the entry form applies
+    bool ReadFields(const JsonValue& params, std::string& description, double& amount, std::string& category,
+                    TransactionType& type, std::string& error) {
+        description = params["description"].AsString();
+        category = params["category"].AsString();
+        amount = params["amount"].AsNumber(0.0);
+        const std::string& typeName = params["type"].AsString();
+        
+        if (description.empty() || category.empty()) {
+            error = "\"description\" and \"category\" must be non-empty strings";
+            return false;
+        }
+        if (!params["amount"].IsNumber() || amount <= 0) {
+            error = "\"amount\" must be a positive number";
+            return false;
+        }
+        if (typeName == "income") {
+            type = TransactionType::Income;
+        } else if (typeName == "expense") {
+            type = TransactionType::Expense;
+        } else {
+            error = "\"type\" must be \"income\" or \"expense\"";
+            return false;
+        }
+        return true;
+    }
+}
+
+RequestHandler::RequestHandler(TransactionManager& manager)
+    : manager_(manager)
+    , totalsVersion_(static_cast<std::uint64_t>(-1)) {
+}
+
+bool RequestHandler::IsWrite(const std::string& method) {
+    return method == "add" || method == "update" || method == "delete";
+}
+
+JsonValue RequestHandler::Handle(const JsonValue& request) {
+    JsonValue response = JsonValue::MakeObject();
+    response.Set("id", request["id"]);
+    
+    const std::string& method = request["method"].AsString();
+    const JsonValue& params = request["params"];
+    JsonValue result;
+    std::string error;
+    bool handled = false;
+    
+    if (!request.IsObject() || !request["method"].IsString()) {
+        error = "A request must be an object with a \"method\" string";
+    } else if (!params.IsNull() && !params.IsObject()) {
+        error = "\"params\" must be an object";
+    } else if (method == "list") {
+        handled = List(params, result, error);
+    } else if (method == "get") {
+        handled = Get(params, result, error);
+    } else if (method == "search") {
+        handled = Search(params, result, error);
+    } else if (method == "totals") {
+        handled = GetTotals(params, result, error);
+    } else if (method == "add") {
+        handled = Add(params, result, error);
+    } else if (method == "update") {
+        handled = Update(params, result, error);
+    } else if (method == "delete") {
+        handled = Delete(params, result, error);
+    } else if (method == "stats") {
+        handled = GetStats(result);
+    } else {
+        error = "Unknown method \"" + method + "\"";
+    }
+    
+    if (handled) {
+        response.Set("result", std::move(result));
+    } else {
+        response.Set("error", std::move(error));
+    }
+    return response;
+}
+
+void RequestHandler::Maintain(std::time_t now) {
+    std::unique_lock<std::shared_mutex> lock = LockForWrite();
+    manager_.CheckExternalChanges();
+    
+    manager_.RunMaintenance(now);
+    
+    BackupService& backups = manager_.GetBackups();
+    backups.RunIfDue(now);
+    
+    BackupService::Result outcome;
+    if (backups.TakeResult(outcome)) {
+        if (outcome.succeeded) {
+            std::cout << "Backup saved to " << outcome.path << std::endl;
+        } else if (!outcome.cancelled) {
+            std::cerr << "Backup to " << outcome.path << " failed" << std::endl;
+        }
+    }
+}
+
+std::shared_lock<std::shared_mutex> RequestHandler::LockForRead() {
+    // Passing through the turnstile first keeps a steady stream of readers
+    // from starving a writer
+    {
+        std::lock_guard<std::mutex> gate(turnstile_);
+    }
+    return std::shared_lock<std::shared_mutex>(ledgerMutex_);
+}
+
+std::unique_lock<std::shared_mutex> RequestHandler::LockForWrite() {
+    std::lock_guard<std::mutex> gate(turnstile_);
+    return std::unique_lock<std::shared_mutex>(ledgerMutex_);
+}
+
+bool RequestHandler::List(const JsonValue& params, JsonValue& result, std::string& error) {
+    long long offset;
+    long long limit;
+    size_t first;
+    size_t last;
+    TransactionManager::Snapshot snapshot = manager_.GetSnapshot();
+    if (!ReadPage(params, offset, limit, error) || !ReadRange(params, *snapshot, first, last, error)) {
+        return false;
+    }
+    
+    // Rows come newest first, as in the window's default order
+    JsonValue items = JsonValue::MakeArray();
+    size_t begin = std::min(last, first + static_cast<size_t>(offset));
+    auto end = snapshot->IteratorAt(std::min(last, begin + static_cast<size_t>(limit)));
+    for (auto row = snapshot->IteratorAt(begin); row != end; ++row) {
+        items.Push(ToJson(*row));
+    }
+    
+    result = JsonValue::MakeObject();
+    result.Set("total", last - first);
+    result.Set("version", static_cast<long long>(snapshot->GetVersion()));
+    result.Set("items", std::move(items));
+    return true;
+}
+
+bool RequestHandler::Get(const JsonValue& params, JsonValue& result, std::string& error) {
+    long long id;
+    if (!ReadId(params, id, error)) {
+        return false;
+    }
+    
+    Transaction transaction;
+    bool found;
+    {
+        std::shared_lock<std::shared_mutex> lock = LockForRead();
+        found = manager_.GetTransaction(static_cast<int>(id), transaction);
+    }
+    if (!found) {
+        error = "No transaction with id " + std::to_string(id);
+        return false;
+    }
+    
+    result = ToJson(transaction);
+    return true;
+}
+
+bool RequestHandler::Search(const JsonValue& params, JsonValue& result, std::string& error) {
+    const std::string& text = params["text"].AsString();
+    long long offset;
+    long long limit;
+    if (text.empty()) {
+        error = "\"text\" must be a non-empty string";
+        return false;
+    }
+    if (!ReadPage(params, offset, limit, error)) {
+        return false;
+    }
+    
+    // Newest (highest id) matches first; only the requested page is fetched
+    JsonValue items = JsonValue::MakeArray();
+    size_t total;
+    {
+        std::shared_lock<std::shared_mutex> lock = LockForRead();
+        std::vector<int> ids = manager_.SearchDescriptions(text);
+        total = ids.size();
+        size_t end = std::min(total, static_cast<size_t>(offset + limit));
+        for (size_t i = static_cast<size_t>(offset); i < end; ++i) {
+            Transaction transaction;
+            if (manager_.GetTransaction(ids[total - 1 - i], transaction)) {
+                items.Push(ToJson(transaction));
+            }
+        }
+    }
+    
+    result = JsonValue::MakeObject();
+    result.Set("total", total);
+    result.Set("items", std::move(items));
+    return true;
+}
+
+bool RequestHandler::GetTotals(const JsonValue& params, JsonValue& result, std::string& error) {
+    CurrencyCode currency = manager_.GetReportingCurrency();
+    size_t first;
+    size_t last;
+    TransactionManager::Snapshot snapshot = manager_.GetSnapshot();
+    CurrencyConverter::Ptr converter = manager_.GetConverter();
+    if (!ReadCurrency(params["currency"], currency, error) || !ReadRange(params, *snapshot, first, last, error)) {
+        return false;
+    }
+    
+    // Only all-time totals are cached; a range costs just its own rows
+    if (first > 0 || last < snapshot->size()) {
+        result = ToJson(converter->Summarize(*snapshot, currency, first, last));
+        return true;
+    }
+    
+    std::lock_guard<std::mutex> lock(totalsMutex_);
+    if (totalsVersion_ != snapshot->GetVersion() || totalsConverter_ != converter) {
+        totals_.clear();
+        totalsVersion_ = snapshot->GetVersion();
+        totalsConverter_ = converter;
+    }
+    
+    auto cached = totals_.find(currency);
+    if (cached == totals_.end()) {
+        cached = totals_.emplace(currency, converter->Summarize(*snapshot, currency)).first;
+    }
+    result = ToJson(cached->second);
+    return true;
+}
+
+bool RequestHandler::GetStats(JsonValue& result) {
+    // The handler keeps the commit figures under its own lock; the storage
+    // figures are read from the ledger's connection, so they wait like any
+    // other read for writes (a compaction, say) to finish
+    const char* const modes[] = { "strict", "group", "relaxed" };
+    WriteBatching batching = manager_.GetDurability();
+    CommitStats stats = manager_.GetCommitStats();
+    
+    JsonValue batchSizes = JsonValue::MakeArray();
+    JsonValue latencies = JsonValue::MakeArray();
+    for (size_t i = 0; i < CommitStats::kBuckets; ++i) {
+        batchSizes.Push(static_cast<long long>(stats.batchSizes[i]));
+        latencies.Push(static_cast<long long>(stats.latencies[i]));
+    }
+    
+    result = JsonValue::MakeObject();
+    result.Set("durability", modes[static_cast<int>(batching.durability)]);
+    result.Set("commits", static_cast<long long>(stats.commits));
+    result.Set("rows", static_cast<long long>(stats.rows));
+    result.Set("lost_batches", static_cast<long long>(stats.lostBatches));
+    result.Set("largest_batch", stats.largestBatch);
+    result.Set("mean_batch", stats.commits ? static_cast<double>(stats.rows) / stats.commits : 0.0);
+    result.Set("mean_commit_ms", stats.commits ? stats.totalSeconds * 1000.0 / stats.commits : 0.0);
+    result.Set("slowest_commit_ms", stats.slowestSeconds * 1000.0);
+    result.Set("batch_sizes", std::move(batchSizes));  // 1, 2-3, 4-7, ... rows
+    result.Set("commit_ms", std::move(latencies));     // Under 1, 1-2, 2-4, ... ms
+    
+    std::shared_lock<std::shared_mutex> lock = LockForRead();
+    result.Set("storage", ToJson(manager_.GetStorageStats()));
+    return true;
+}
+
+bool RequestHandler::Add(const JsonValue& params, JsonValue& result, std::string& error) {
+    std::string description;
+    std::string category;
+    double amount;
+    TransactionType type;
+    CurrencyCode currency = manager_.GetReportingCurrency();
+    std::time_t date;
+    if (!ReadFields(params, description, amount, category, type, error) ||
+        !ReadCurrency(params["currency"], currency, error) || !ReadDate(params["date"], "date", date, error)) {
+        return false;
+    }
+    
+    int id = 0;
+    std::unique_lock<std::shared_mutex> lock = LockForWrite();
+    if (!manager_.AddTransaction(description, amount, category, type, currency, date, &id)) {
+        error = "The transaction could not be saved";
+        return false;
+    }
+    
+    result = JsonValue::MakeObject();
+    result.Set("id", id);
+    return true;
+}
+
+bool RequestHandler::Update(const JsonValue& params, JsonValue& result, std::string& error) {
+    long long id;
+    std::string description;
+    std::string category;
+    double amount;
+    TransactionType type;
+    std::time_t date;
+    if (!ReadId(params, id, error) || !ReadFields(params, description, amount, category, type, error) ||
+        !ReadDate(params["date"], "date", date, error)) {
+        return false;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock = LockForWrite();
+    Transaction existing;
+    if (!manager_.GetTransaction(static_cast<int>(id), existing)) {
+        error = "No transaction with id " + std::to_string(id);
+        return false;
+    }
+    CurrencyCode currency = existing.currency;
+    if (!ReadCurrency(params["currency"], currency, error)) {
+        return false;
+    }
+    if (!manager_.UpdateTransaction(static_cast<int>(id), description, amount, category, type, currency, date)) {
+        error = "The transaction could not be saved";
+        return false;
+    }
+    
+    result = JsonValue::MakeObject();
+    result.Set("id", id);
+    return true;
+}
+
+bool RequestHandler::Delete(const JsonValue& params, JsonValue& result, std::string& error) {
+    long long id;
+    if (!ReadId(params, id, error)) {
+        return false;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock = LockForWrite();
+    Transaction existing;
+    if (!manager_.GetTransaction(static_cast<int>(id), existing)) {
+        error = "No transaction with id " + std::to_string(id);
+        return false;
+    }
+    if (!manager_.DeleteTransaction(static_cast<int>(id))) {
+        error = "The transaction could not be deleted";
+        return false;
+    }
+    
+    result = JsonValue::MakeObject();
+    result.Set("id", id);
+    return true;
+}
\ No newline at end of file
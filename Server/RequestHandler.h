@@ -0,0 +1,56 @@
+#pragma once
+#include "Json.h"
+#include "../ViewModel/TransactionManager.h"
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Maps query-server requests onto a TransactionManager. Handle() may run on
+// many threads at once: list and totals read a lock-free snapshot, get and
+// search take the shared side of the ledger lock, and writes (plus
+// Maintain()) take the exclusive side.
+//
+// A request is {"id": any, "method": name, "params": {...}}; the response
+// echoes the id with either "result" or "error".
+class RequestHandler {
+public:
+    explicit RequestHandler(TransactionManager& manager);
+    
+    static bool IsWrite(const std::string& method);
+    
+    JsonValue Handle(const JsonValue& request);
+    
+    // Periodic upkeep for the writer thread: picks up commits made by other
+    // programs, runs a scheduled backup when one is due and a storage
+    // maintenance step
+    void Maintain(std::time_t now);
+
+private:
+    TransactionManager& manager_;
+    std::shared_mutex ledgerMutex_;
+    std::mutex turnstile_;  // A waiting writer holds it so new readers queue behind it
+    
+    // Sums for one snapshot version and rate cache, per currency asked for;
+    // the first totals request after a write computes them for the rest
+    std::mutex totalsMutex_;
+    std::uint64_t totalsVersion_;
+    CurrencyConverter::Ptr totalsConverter_;
+    std::map<CurrencyCode, CurrencyConverter::Totals> totals_;
+    
+    std::shared_lock<std::shared_mutex> LockForRead();
+    std::unique_lock<std::shared_mutex> LockForWrite();
+    
+    bool List(const JsonValue& params, JsonValue& result, std::string& error);
+    bool Get(const JsonValue& params, JsonValue& result, std::string& error);
+    bool Search(const JsonValue& params, JsonValue& result, std::string& error);
+    bool GetTotals(const JsonValue& params, JsonValue& result, std::string& error);
+    bool Add(const JsonValue& params, JsonValue& result, std::string& error);
+    bool Update(const JsonValue& params, JsonValue& result, std::string& error);
+    bool Delete(const JsonValue& params, JsonValue& result, std::string& error);
+    bool GetStats(JsonValue& result);
+};
\ No newline at end of file
@@ -0,0 +1,183 @@
+// Backups on the worker thread: a copy taken while writes are batched and
+// still arriving holds whole committed batches and nothing else, cancelling
+// leaves no file behind, scheduled backups rotate down to the newest few
+// without touching other files, and restoring one reloads the manager.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sqlite3.h>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+    BackupService::Result Wait(BackupService& backups) {
+        while (backups.IsRunning()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        BackupService::Result result;
+        CHECK(backups.TakeResult(result));
+        return result;
+    }
+    
+    // What another program sees in the file
+    std::vector<int> StoredIds(const std::string& path) {
+        sqlite3* db = nullptr;
+        sqlite3_stmt* stmt;
+        std::vector<int> ids;
+        if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK &&
+            sqlite3_prepare_v2(db, "SELECT id FROM transactions ORDER BY id;", -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                ids.push_back(sqlite3_column_int(stmt, 0));
+            }
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(db);
+        return ids;
+    }
+    
+    std::vector<int> CachedIds(const TransactionManager& manager) {
+        std::vector<int> ids;
+        for (const auto& row : manager.GetTransactions()) {
+            ids.push_back(row.id);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+    
+    // Enough pages that a copy takes many steps
+    void Fill(const std::string& path, int rows) {
+        sqlite3* db = nullptr;
+        CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+        std::string sql = "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < " +
+                          std::to_string(rows) + ") "
+                          "INSERT INTO transactions (description, amount, category, type, date) "
+                          "SELECT 'Filler ' || hex(randomblob(40)), i % 90 + 0.5, 'Other', 1, 1600000000 + i * 60 FROM n;";
+        CHECK(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(db);
+    }
+    
+    std::string ScheduledName(const std::string& prefix, std::time_t when) {
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&when));
+        return prefix + "-" + stamp + ".db";
+    }
+}
+
+int main() {
+    test::ScratchFile file("BackupServiceTest");
+    test::ScratchFile copy("BackupServiceTestCopy");
+    test::ScratchFile cancelled("BackupServiceTestCancelled");
+    const std::string directory = "BackupServiceTest.backups";
+    std::error_code error;
+    fs::remove_all(directory, error);
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.IsInitialized());
+    }
+    Fill(file.Path(), 30000);
+    
+    {
+        TransactionManager manager(file.Path());
+        BackupService& backups = manager.GetBackups();
+        WriteBatching batching;
+        batching.durability = Durability::Group;
+        batching.maxDelayMs = 60000;
+        batching.maxRows = 100000;
+        CHECK(manager.SetDurability(batching));
+        
+        // An open batch when the copy starts, and more writes while it runs
+        for (int i = 0; i < 50; ++i) {
+            CHECK(manager.AddTransaction("Before " + std::to_string(i), 2.0, "Food", TransactionType::Expense,
+                                         kDefaultCurrency, 1700000000 + i));
+        }
+        std::vector<int> started = CachedIds(manager);
+        CHECK(StoredIds(file.Path()).size() < started.size());
+        CHECK(backups.Start(copy.Path()));
+        CHECK(!backups.Start(cancelled.Path()));
+        int during = 0;
+        while (backups.IsRunning()) {
+            CHECK(manager.AddTransaction("During " + std::to_string(during++), 3.0, "Food", TransactionType::Expense,
+                                         kDefaultCurrency, 1700100000));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        BackupService::Result result = Wait(backups);
+        CHECK(result.succeeded && !result.cancelled && !result.scheduled && result.path == copy.Path());
+        CHECK(!fs::exists(copy.Path() + ".partial"));
+        CHECK(backups.GetProgress() == 1.0);
+        
+        // Everything written before the start, then a run of later writes
+        // with nothing missing in between and nothing from an open batch
+        std::vector<int> all = CachedIds(manager);
+        std::vector<int> saved = StoredIds(copy.Path());
+        CHECK(saved.size() >= started.size() && saved.size() <= all.size());
+        CHECK(std::equal(saved.begin(), saved.end(), all.begin()));
+        CHECK(manager.FlushWrites());
+        CHECK(StoredIds(file.Path()) == all);
+        
+        // Cancelled straight away: no backup and no partial file left
+        CHECK(backups.Start(cancelled.Path()));
+        backups.Cancel();
+        result = Wait(backups);
+        CHECK(!result.succeeded && result.cancelled);
+        CHECK(!fs::exists(cancelled.Path()) && !fs::exists(cancelled.Path() + ".partial"));
+        CHECK(!backups.TakeResult(result));
+        
+        // Restoring brings back the rows, and the cache, of the copy
+        CHECK(manager.DeleteTransaction(saved.front()));
+        CHECK(manager.AddTransaction("After", 4.0, "Food", TransactionType::Expense, kDefaultCurrency, 1700200000));
+        CHECK(manager.RestoreBackup(copy.Path()));
+        CHECK(CachedIds(manager) == saved);
+        Transaction restored;
+        CHECK(manager.GetTransaction(saved.front(), restored) && restored.description.compare(0, 7, "Filler ") == 0);
+        CHECK(manager.GetTransactions().size() == saved.size());
+        CHECK(StoredIds(file.Path()) == saved);
+        CHECK(!manager.RestoreBackup(directory + "/missing.db"));
+        CHECK(CachedIds(manager) == saved);
+    }
+    
+    // Scheduled backups: only the newest few of this prefix survive
+    {
+        CHECK(fs::create_directories(directory, error));
+        const char* const foreign[] = {"ledger-notes.db", "ledger2-20240101-000000.db",
+                                       "ledger-old-20240101-000000.db", "ledger-20240101-000000.db.partial"};
+        for (const char* name : foreign) {
+            std::ofstream(fs::path(directory) / name) << "not a backup";
+        }
+        
+        TransactionManager manager(file.Path());
+        BackupService& backups = manager.GetBackups();
+        const std::time_t start = 1700000000;
+        const std::time_t hour = 3600;
+        backups.SetSchedule(directory, "ledger", hour, 3);
+        CHECK(backups.ListBackups().empty());
+        for (int run = 0; run < 5; ++run) {
+            CHECK(backups.RunIfDue(start + run * hour));
+            BackupService::Result result = Wait(backups);
+            CHECK(result.succeeded && result.scheduled);
+            CHECK(!backups.RunIfDue(start + run * hour + hour / 2));
+        }
+        std::vector<std::string> expected;
+        for (int run = 4; run >= 2; --run) {
+            expected.push_back((fs::path(directory) / ScheduledName("ledger", start + run * hour)).string());
+        }
+        CHECK(backups.ListBackups() == expected);
+        for (const char* name : foreign) {
+            CHECK(fs::exists(fs::path(directory) / name));
+        }
+        
+        // The newest backup sets the clock again after a restart
+        backups.SetSchedule(directory, "ledger", hour, 3);
+        CHECK(!backups.RunIfDue(start + 4 * hour + hour / 2));
+        CHECK(backups.RunIfDue(start + 5 * hour));
+        CHECK(Wait(backups).succeeded);
+        CHECK(backups.ListBackups().size() == 3);
+        CHECK(StoredIds(backups.ListBackups().front()) == CachedIds(manager));
+    }
+    fs::remove_all(directory, error);
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+// Running balances from the Fenwick-tree index against a plain recount,
+// through appends, edits, removals and rebuilds, in one currency and in
+// several converted to a reporting currency.
+#include "Check.h"
+#include "ViewModel/BalanceIndex.h"
+#include "ViewModel/CurrencyConverter.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+    const CurrencyCode kEuro = MakeCurrency('E', 'U', 'R');
+    const CurrencyCode kYen = MakeCurrency('J', 'P', 'Y');
+    
+    bool Near(double a, double b) {
+        return std::fabs(a - b) < 0.005;
+    }
+    
+    double Signed(const Transaction& transaction) {
+        double cents = std::round(transaction.amount * 100.0);
+        return (transaction.type == TransactionType::Income ? cents : -cents) / 100.0;
+    }
+    
+    // Balance after each row by summing everything up to it in (date, id) order
+    double RecountAfter(const std::vector<Transaction>& rows, int id) {
+        const Transaction& target = *std::find_if(rows.begin(), rows.end(),
+                                                  [id](const Transaction& row) { return row.id == id; });
+        double balance = 0.0;
+        for (const auto& row : rows) {
+            if (row.date < target.date || (row.date == target.date && row.id <= target.id)) {
+                balance += Signed(row);
+            }
+        }
+        return balance;
+    }
+    
+    void CheckAgainstRecount(const BalanceIndex& index, const std::vector<Transaction>& rows) {
+        CHECK(index.Size() == rows.size());
+        double total = 0.0;
+        for (const auto& row : rows) {
+            CHECK(Near(index.GetBalanceAfter(row.id), RecountAfter(rows, row.id)));
+            total += Signed(row);
+        }
+        CHECK(Near(index.GetTotal(), total));
+    }
+}
+
+int main() {
+    CurrencyConverter noRates;
+    CurrencyConverter::Conversion dollars = noRates.To(kDefaultCurrency);
+    
+    // Built from rows in any order
+    std::vector<Transaction> rows;
+    std::mt19937 random(7);
+    for (int id = 1; id <= 300; ++id) {
+        rows.emplace_back(id, "row", 1 + random() % 50000 / 100.0, "Food",
+                          random() % 3 ? TransactionType::Expense : TransactionType::Income,
+                          1700000000 + static_cast<std::time_t>(random() % 100) * 86400);
+    }
+    BalanceIndex index;
+    index.Build(rows, dollars);
+    CheckAgainstRecount(index, rows);
+    
+    // Balance as of a date covers every row dated up to it
+    std::time_t cutoff = 1700000000 + 50 * 86400;
+    double asOf = 0.0;
+    for (const auto& row : rows) {
+        asOf += row.date <= cutoff ? Signed(row) : 0.0;
+    }
+    CHECK(Near(index.GetBalanceAsOf(cutoff), asOf));
+    CHECK(index.GetBalanceAsOf(1600000000) == 0.0);
+    
+    // In-place edits keep every prefix right
+    for (int i = 0; i < 50; ++i) {
+        Transaction& row = rows[random() % rows.size()];
+        row.amount = 1 + random() % 1000;
+        row.type = random() % 2 ? TransactionType::Expense : TransactionType::Income;
+        CHECK(index.Update(row, dollars));
+    }
+    for (int i = 0; i < 30; ++i) {
+        size_t at = random() % rows.size();
+        CHECK(index.Remove(rows[at].id));
+        rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(at));
+    }
+    CHECK(!index.Remove(100000));
+    CheckAgainstRecount(index, rows);
+    
+    // Appending works only at the end; anything else asks for a rebuild
+    std::time_t lastDate = 0;
+    for (const auto& row : rows) {
+        lastDate = std::max(lastDate, row.date);
+    }
+    Transaction late(1000, "late", 12.34, "Food", TransactionType::Income, lastDate + 1);
+    CHECK(index.Append(late, dollars));
+    rows.push_back(late);
+    Transaction early(1001, "early", 5.0, "Food", TransactionType::Expense, 1600000000);
+    CHECK(!index.Append(early, dollars));
+    Transaction moved = rows.front();
+    moved.date += 1;
+    CHECK(!index.Update(moved, dollars));
+    rows.push_back(early);
+    index.Build(rows, dollars);
+    CheckAgainstRecount(index, rows);
+    
+    std::time_t date;
+    CHECK(index.LookupDate(early.id, date) && date == early.date);
+    CHECK(!index.LookupDate(99999, date));
+    
+    // Other currencies are converted on the way in; rows with no rate to the
+    // reporting currency count for nothing
+    CurrencyConverter rates;
+    std::int32_t firstDay = DaysFromCivil(2023, 1, 1);
+    rates.Build({{kEuro, kDefaultCurrency, firstDay, 1.25}});
+    CurrencyConverter::Conversion toDollars = rates.To(kDefaultCurrency);
+    
+    std::vector<Transaction> mixed = {
+        Transaction(1, "salary", 1000.0, "Income", TransactionType::Income, 1700000000),
+        Transaction(2, "rent", 400.0, "Housing", TransactionType::Expense, 1700086400),
+        Transaction(3, "sushi", 3000.0, "Food", TransactionType::Expense, 1700172800),
+    };
+    mixed[1].currency = kEuro;
+    mixed[2].currency = kYen;
+    BalanceIndex converted;
+    converted.Build(mixed, toDollars);
+    CHECK(Near(converted.GetBalanceAfter(1), 1000.0));
+    CHECK(Near(converted.GetBalanceAfter(2), 1000.0 - 500.0));
+    CHECK(Near(converted.GetTotal(), 500.0));
+    
+    Transaction edited = mixed[1];
+    edited.amount = 800.0;
+    CHECK(converted.Update(edited, toDollars));
+    CHECK(Near(converted.GetTotal(), 0.0));
+    
+    // The same rows in euros
+    converted.Build(mixed, rates.To(kEuro));
+    CHECK(Near(converted.GetBalanceAfter(1), 800.0));
+    CHECK(Near(converted.GetTotal(), 800.0 - 400.0));
+    
+    return test::Result();
+}
\ No newline at end of file
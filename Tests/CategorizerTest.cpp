@@ -0,0 +1,92 @@
+// The incremental categorizer: learns obvious categories, agrees with a
+// model built in one go, takes back what Untrain removes, keeps its
+// weights when more categories than the initial slots arrive, and gives
+// the same answers one at a time and in a batch.
+#include "Check.h"
+#include "ViewModel/Categorizer.h"
+#include <cmath>
+
+namespace {
+    bool Same(const CategoryPrediction& a, const CategoryPrediction& b) {
+        return a.category == b.category && std::fabs(a.confidence - b.confidence) < 1e-9;
+    }
+    
+    Transaction Row(const std::string& description, const std::string& category) {
+        return Transaction(0, description, 1.0, category, TransactionType::Expense, 1700000000);
+    }
+}
+
+int main() {
+    std::vector<Transaction> rows = {
+        Row("STARBUCKS #1234 Coffee", "Food"),
+        Row("Corner cafe coffee", "Food"),
+        Row("Supermarket groceries", "Food"),
+        Row("Rent payment March", "Housing"),
+        Row("Rent payment April", "Housing"),
+        Row("Shell fuel station 0042", "Transport"),
+        Row("Metro ticket", "Transport"),
+        Row("uncategorised", ""),
+    };
+    const std::vector<std::string> queries = {
+        "coffee", "RENT payment May", "fuel", "metro ticket 12", "cafe groceries", "nothing known", "", "12345",
+    };
+    
+    Categorizer empty;
+    CHECK(empty.Classify("coffee").category.empty());
+    
+    Categorizer built;
+    built.Build(rows);
+    CHECK(built.GetCategoryCount() == 3);
+    CHECK(built.GetTrainingCount() == 7);  // The row without a category is skipped
+    CHECK(built.Classify("coffee").category == "Food");
+    CHECK(built.Classify("RENT payment May").category == "Housing");
+    CHECK(built.Classify("Shell FUEL").category == "Transport");
+    CHECK(built.Classify("coffee").confidence > 0.5 && built.Classify("coffee").confidence <= 1.0);
+    
+    // Training row by row ends where Build does
+    Categorizer incremental;
+    for (const auto& row : rows) {
+        incremental.Train(row.description, row.category);
+    }
+    for (const auto& query : queries) {
+        CHECK(Same(incremental.Classify(query), built.Classify(query)));
+    }
+    
+    // Untrain undoes Train exactly, and ignores what was never learned
+    incremental.Train("Rent coffee fuel", "Transport");
+    CHECK(!Same(incremental.Classify("rent coffee fuel"), built.Classify("rent coffee fuel")));
+    incremental.Untrain("Rent coffee fuel", "Transport");
+    incremental.Untrain("coffee", "Unknown");
+    for (const auto& query : queries) {
+        CHECK(Same(incremental.Classify(query), built.Classify(query)));
+    }
+    
+    // An edit moves a description to another category
+    incremental.Untrain("Metro ticket", "Transport");
+    incremental.Train("Metro ticket", "Leisure");
+    incremental.Train("Museum ticket", "Leisure");
+    CHECK(incremental.Classify("ticket").category == "Leisure");
+    
+    // More categories than the initial class slots
+    Categorizer many;
+    for (int i = 0; i < 40; ++i) {
+        std::string word = "word" + std::string(1, static_cast<char>('a' + i % 26)) + std::to_string(i / 26);
+        many.Train(word + " shop", "Category " + std::to_string(i));
+    }
+    CHECK(many.GetCategoryCount() == 40);
+    CHECK(many.Classify("wordd0").category == "Category 3");
+    CHECK(many.Classify("wordn1 shop").category == "Category 39");
+    
+    // A batch above the threading threshold answers like one at a time
+    std::vector<std::string> batch;
+    for (int i = 0; i < 5000; ++i) {
+        batch.push_back(queries[static_cast<size_t>(i) % queries.size()]);
+    }
+    std::vector<CategoryPrediction> predictions = built.ClassifyBatch(batch);
+    CHECK(predictions.size() == batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        CHECK(Same(predictions[i], built.Classify(batch[i])));
+    }
+    
+    return test::Result();
+}
\ No newline at end of file
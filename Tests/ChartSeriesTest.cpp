@@ -0,0 +1,177 @@
+// Chart data against a plain walk over the rows in date order: per-slot
+// balance low, high and close for random ranges and slot widths, carried
+// closes over empty slots, and monthly flows grouped into aligned bars.
+#include "Check.h"
+#include "ViewModel/ChartSeries.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+
+namespace {
+    std::time_t LocalNoon(std::int32_t day) {
+        int year, month, dayOfMonth;
+        CivilFromDays(day, year, month, dayOfMonth);
+        std::tm calendar{};
+        calendar.tm_year = year - 1900;
+        calendar.tm_mon = month - 1;
+        calendar.tm_mday = dayOfMonth;
+        calendar.tm_hour = 12;
+        calendar.tm_isdst = -1;
+        return std::mktime(&calendar);
+    }
+    
+    bool Near(double a, double b) {
+        return std::fabs(a - b) < 1e-6;
+    }
+    
+    // Every balance a day passes through, starting from the previous close
+    struct Day {
+        double low;
+        double high;
+        double close;
+    };
+    
+    struct Walk {
+        std::map<std::int32_t, Day> days;
+        std::map<std::int32_t, std::pair<double, double>> months;  // MonthIndex -> (income, expenses)
+    };
+    
+    Walk WalkRows(std::vector<Transaction> rows, std::map<int, std::int32_t>& dayOfId) {
+        std::sort(rows.begin(), rows.end(), [](const Transaction& a, const Transaction& b) {
+            return a.date != b.date ? a.date < b.date : a.id < b.id;
+        });
+        Walk walk;
+        double balance = 0.0;
+        for (const auto& row : rows) {
+            if (row.currency != kDefaultCurrency) {
+                continue;
+            }
+            std::int32_t day = dayOfId[row.id];
+            auto found = walk.days.find(day);
+            if (found == walk.days.end()) {
+                found = walk.days.emplace(day, Day{balance, balance, balance}).first;
+            }
+            balance += row.type == TransactionType::Income ? row.amount : -row.amount;
+            found->second = {std::min(found->second.low, balance), std::max(found->second.high, balance), balance};
+            
+            int year, month, dayOfMonth;
+            CivilFromDays(day, year, month, dayOfMonth);
+            auto& flows = walk.months[MonthIndex(year, month)];
+            (row.type == TransactionType::Income ? flows.first : flows.second) += row.amount;
+        }
+        return walk;
+    }
+    
+    BalanceBucket Expected(const Walk& walk, double from, double to) {
+        BalanceBucket bucket{0.0, 0.0, 0.0, true};
+        bool any = false;
+        for (const auto& entry : walk.days) {
+            if (entry.first < from) {
+                bucket = {entry.second.close, entry.second.close, entry.second.close, false};
+            } else if (entry.first < to) {
+                const Day& day = entry.second;
+                bucket.low = any ? std::min(bucket.low, day.low) : day.low;
+                bucket.high = any ? std::max(bucket.high, day.high) : day.high;
+                bucket.close = day.close;
+                bucket.empty = false;
+                any = true;
+            }
+        }
+        return bucket;
+    }
+    
+    bool Same(const BalanceBucket& a, const BalanceBucket& b) {
+        return a.empty == b.empty && Near(a.low, b.low) && Near(a.high, b.high) && Near(a.close, b.close);
+    }
+}
+
+int main() {
+    CurrencyConverter noRates;
+    CurrencyConverter::Conversion dollars = noRates.To(kDefaultCurrency);
+    
+    CHECK(ChartSeries::Build(*TransactionSnapshot::Create({}, 1), dollars)->Empty());
+    
+    // A year of rows, several on most days, a few in a currency with no rate
+    std::mt19937 random(23);
+    const std::int32_t firstDay = DaysFromCivil(2023, 11, 20);
+    std::vector<Transaction> rows;
+    std::map<int, std::int32_t> dayOfId;
+    for (int id = 1; id <= 2000; ++id) {
+        std::int32_t day = firstDay + static_cast<std::int32_t>(random() % 400);
+        if (day % 7 == 0) {
+            day += 1;  // Leave gaps
+        }
+        std::time_t date = LocalNoon(day) + (static_cast<std::time_t>(random() % 7200) - 3600);
+        rows.emplace_back(id, "Row", 1 + random() % 20000 / 100.0, "Food",
+                          random() % 3 ? TransactionType::Expense : TransactionType::Income, date);
+        if (random() % 50 == 0) {
+            rows.back().currency = MakeCurrency('E', 'U', 'R');
+        }
+        dayOfId[id] = day;
+    }
+    Walk walk = WalkRows(rows, dayOfId);
+    
+    std::vector<Transaction> newestFirst = rows;
+    std::sort(newestFirst.begin(), newestFirst.end(), [](const Transaction& a, const Transaction& b) {
+        return a.date != b.date ? a.date > b.date : a.id > b.id;
+    });
+    ChartSeries::Ptr chart = ChartSeries::Build(*TransactionSnapshot::Create(newestFirst, 1), dollars);
+    CHECK(chart->GetFirstDay() == walk.days.begin()->first);
+    CHECK(chart->GetLastDay() == walk.days.rbegin()->first);
+    CHECK(chart->GetCurrency() == kDefaultCurrency);
+    
+    // Random views, including ones reaching before the first and past the last day
+    for (int view = 0; view < 300; ++view) {
+        double from = firstDay - 30 + static_cast<double>(random() % 4600) / 10.0;
+        double width = 0.25 + static_cast<double>(random() % 400) / 10.0;
+        size_t slots = 1 + random() % 120;
+        std::vector<BalanceBucket> buckets = chart->GetBalance(from, width, slots);
+        CHECK(buckets.size() == slots);
+        for (size_t slot = 0; slot < buckets.size(); ++slot) {
+            double lo = std::ceil(from + static_cast<double>(slot) * width);
+            double hi = std::ceil(from + static_cast<double>(slot + 1) * width);
+            CHECK(Same(buckets[slot], Expected(walk, lo, hi)));
+        }
+    }
+    CHECK(chart->GetBalance(firstDay, 0.0, 3)[0].empty);
+    
+    // Monthly flows, one bar per month and grouped into aligned bars
+    std::int32_t firstMonth = walk.months.begin()->first;
+    std::int32_t lastMonth = walk.months.rbegin()->first;
+    for (size_t maxBars : {size_t(100), size_t(5), size_t(4), size_t(1)}) {
+        for (std::int32_t from = firstMonth - 2; from <= firstMonth + 3; ++from) {
+            std::vector<FlowBucket> bars = chart->GetFlows(from, lastMonth + 1, maxBars);
+            CHECK(!bars.empty() && bars.size() <= maxBars + 1);
+            std::int32_t group = bars.empty() ? 1 : bars.front().months;
+            for (const auto& bar : bars) {
+                CHECK(bar.months == group && ((bar.firstMonth % group) + group) % group == 0);
+                double income = 0.0;
+                double expenses = 0.0;
+                for (const auto& month : walk.months) {
+                    if (month.first >= bar.firstMonth && month.first < bar.firstMonth + bar.months) {
+                        income += month.second.first;
+                        expenses += month.second.second;
+                    }
+                }
+                CHECK(Near(bar.income, income) && Near(bar.expenses, expenses));
+            }
+        }
+    }
+    CHECK(chart->GetFlows(lastMonth, firstMonth, 10).empty());
+    
+    // Converted into another currency when a rate exists
+    CurrencyConverter rates;
+    rates.Build({{MakeCurrency('E', 'U', 'R'), kDefaultCurrency, firstDay, 2.0}});
+    ChartSeries::Ptr euros = ChartSeries::Build(*TransactionSnapshot::Create(newestFirst, 1),
+                                                rates.To(MakeCurrency('E', 'U', 'R')));
+    double total = 0.0;
+    for (const auto& row : rows) {
+        double amount = row.currency == kDefaultCurrency ? row.amount / 2.0 : row.amount;
+        total += row.type == TransactionType::Income ? amount : -amount;
+    }
+    std::vector<BalanceBucket> all = euros->GetBalance(euros->GetFirstDay(), 1000.0, 1);
+    CHECK(Near(all[0].close, total));
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// Minimal support for the behaviour tests: CHECK reports a failed condition
+// with its location and carries on, and main() returns test::Result() so
+// ctest sees the outcome. No framework, so the tests build wherever the
+// application's own sources do.
+namespace test {
+    inline int& Failures() {
+        static int failures = 0;
+        return failures;
+    }
+    
+    inline bool Report(bool passed, const char* condition, const char* file, int line) {
+        if (!passed) {
+            std::cerr << file << ":" << line << ": CHECK(" << condition << ") failed" << std::endl;
+            ++Failures();
+        }
+        return passed;
+    }
+    
+    inline int Result() {
+        if (Failures() > 0) {
+            std::cerr << Failures() << " check(s) failed" << std::endl;
+        }
+        return Failures() > 0 ? 1 : 0;
+    }
+    
+    // A ledger file in the working directory, named after the test so that
+    // tests run in parallel never share one. It is removed, with its journal
+    // and WAL files, before use and again when the test is done.
+    class ScratchFile {
+    public:
+        explicit ScratchFile(const std::string& name) : path_(name + ".db") {
+            Remove();
+        }
+        ~ScratchFile() { Remove(); }
+        
+        ScratchFile(const ScratchFile&) = delete;
+        ScratchFile& operator=(const ScratchFile&) = delete;
+        
+        const std::string& Path() const { return path_; }
+    
+    private:
+        std::string path_;
+        
+        void Remove() const {
+            for (const char* suffix : {"", "-journal", "-wal", "-shm"}) {
+                std::remove((path_ + suffix).c_str());
+            }
+        }
+    };
+}
+
+#define CHECK(condition) test::Report(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
\ No newline at end of file
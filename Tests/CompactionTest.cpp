@@ -0,0 +1,145 @@
+// Storage compaction on a churned ledger from the first release: every row
+// and value type, the id sequence and the indexes survive the rebuild, the
+// file ends up STRICT (SQLite 3.37 on) with incremental auto-vacuum and no
+// free pages, and compacting again changes nothing. A value that does not
+// fit its column leaves the ledger as it was; maintenance hands pages back.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <sqlite3.h>
+
+namespace {
+    bool Execute(const std::string& path, const char* sql) {
+        sqlite3* db = nullptr;
+        bool done = sqlite3_open(path.c_str(), &db) == SQLITE_OK &&
+                    sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+        sqlite3_close(db);
+        return done;
+    }
+    
+    // Every result row as text, its columns' storage classes included
+    std::vector<std::string> Dump(const std::string& path, const char* sql) {
+        sqlite3* db = nullptr;
+        sqlite3_stmt* stmt;
+        std::vector<std::string> rows;
+        if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK &&
+            sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                std::string row;
+                for (int column = 0; column < sqlite3_column_count(stmt); ++column) {
+                    const unsigned char* text = sqlite3_column_text(stmt, column);
+                    row += std::to_string(sqlite3_column_type(stmt, column)) + ':' +
+                           (text ? reinterpret_cast<const char*>(text) : "") + '|';
+                }
+                rows.push_back(row);
+            }
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(db);
+        return rows;
+    }
+    
+    const char* const kRows = "SELECT * FROM transactions ORDER BY id;";
+    const char* const kSequence = "SELECT seq FROM sqlite_sequence WHERE name = 'transactions';";
+    const char* const kDependents = "SELECT type, name, sql FROM sqlite_master WHERE tbl_name = 'transactions' "
+                                    "AND type IN ('index', 'trigger') ORDER BY name;";
+    
+    // The first release's table, filled and then thinned out, highest ids included
+    void WriteChurnedLedger(const std::string& path, int rows) {
+        std::string sql = "CREATE TABLE transactions (id INTEGER PRIMARY KEY AUTOINCREMENT, description TEXT NOT NULL, "
+                          "amount REAL NOT NULL, category TEXT NOT NULL, type INTEGER NOT NULL, date INTEGER NOT NULL);"
+                          "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < " +
+                          std::to_string(rows) + ") "
+                          "INSERT INTO transactions (description, amount, category, type, date) "
+                          "SELECT 'Row ' || i || ' ' || hex(randomblob(20)), i % 97 + 0.25, 'Category ' || (i % 7), "
+                          "i % 3 = 0, 1700000000 + i * 600 FROM n;"
+                          "DELETE FROM transactions WHERE id % 3 = 1 OR id BETWEEN " + std::to_string(rows / 4) + " AND " +
+                          std::to_string(rows / 2) + " OR id > " + std::to_string(rows - 50) + ";";
+        CHECK(Execute(path, sql.c_str()));
+    }
+}
+
+int main() {
+    const bool strictSupported = sqlite3_libversion_number() >= 3037000;
+    
+    test::ScratchFile file("CompactionTest");
+    WriteChurnedLedger(file.Path(), 20000);
+    {
+        DatabaseHandler db(file.Path());
+        CHECK(db.Initialize());  // Migrates to the current columns first
+    }
+    std::vector<std::string> rows = Dump(file.Path(), kRows);
+    std::vector<std::string> sequence = Dump(file.Path(), kSequence);
+    std::vector<std::string> dependents = Dump(file.Path(), kDependents);
+    CHECK(!rows.empty() && sequence == std::vector<std::string>{"1:20000|"});
+    
+    {
+        DatabaseHandler db(file.Path());
+        CHECK(db.Initialize());
+        StorageStats before;
+        StorageStats after;
+        CHECK(db.CompactStorage(before, after));
+        CHECK(!before.strict && !before.incrementalVacuum && before.freePages > 0);
+        CHECK(after.strict == strictSupported && after.incrementalVacuum && after.freePages == 0);
+        CHECK(after.GetBytes() < before.GetBytes());
+        CHECK(after.pageSize == before.pageSize);
+        
+        // Once compacted there is nothing left to rewrite
+        StorageStats again;
+        CHECK(db.CompactStorage(before, again));
+        CHECK(before.strict == after.strict && before.incrementalVacuum && before.freePages == 0);
+        CHECK(again.strict == after.strict && again.incrementalVacuum && again.freePages == 0);
+        CHECK(again.pages == after.pages);
+    }
+    CHECK(Dump(file.Path(), kRows) == rows);
+    CHECK(Dump(file.Path(), kSequence) == sequence);
+    CHECK(Dump(file.Path(), kDependents) == dependents);
+    CHECK(Dump(file.Path(), "PRAGMA integrity_check;") == std::vector<std::string>{"3:ok|"});
+    if (strictSupported) {
+        CHECK(!Execute(file.Path(), "INSERT INTO transactions (description, amount, category, type, date) "
+                                    "VALUES ('Bad', 'lots', 'Food', 1, 1700000000);"));
+    }
+    
+    // The cache is untouched, and deleted ids are still not handed out again
+    {
+        TransactionManager manager(file.Path());
+        size_t count = manager.GetTransactions().size();
+        StorageStats before;
+        StorageStats after;
+        CHECK(manager.CompactStorage(before, after));
+        CHECK(manager.GetTransactions().size() == count);
+        int id = 0;
+        CHECK(manager.AddTransaction("After", 5.0, "Food", TransactionType::Expense, kDefaultCurrency, 1700000000, &id));
+        CHECK(id == 20001);
+        
+        // Deleting most rows frees pages; maintenance returns them a step at a time
+        CHECK(Execute(file.Path(), "DELETE FROM transactions WHERE id % 4 <> 0;"));
+        manager.CheckExternalChanges();
+        StorageStats churned = manager.GetStorageStats();
+        CHECK(churned.freePages > 0);
+        manager.RunMaintenance(std::time(nullptr));
+        StorageStats trimmed = manager.GetStorageStats();
+        CHECK(trimmed.freePages < churned.freePages && trimmed.pages < churned.pages);
+    }
+    
+    // A value that does not fit its column stops the rebuild, not the ledger
+    test::ScratchFile mixed("CompactionTestMixed");
+    WriteChurnedLedger(mixed.Path(), 300);
+    CHECK(Execute(mixed.Path(), "UPDATE transactions SET type = 'expense' WHERE id = 2;"));
+    {
+        DatabaseHandler db(mixed.Path());
+        CHECK(db.Initialize());
+    }
+    rows = Dump(mixed.Path(), kRows);
+    {
+        DatabaseHandler db(mixed.Path());
+        CHECK(db.Initialize());
+        StorageStats before;
+        StorageStats after;
+        CHECK(db.CompactStorage(before, after) != strictSupported);
+        CHECK(!db.GetStorageStats().strict);
+        CHECK(db.GetStorageStats().pages == before.pages);
+    }
+    CHECK(Dump(mixed.Path(), kRows) == rows);
+    
+    return test::Result();
+}
\ No newline at end of file
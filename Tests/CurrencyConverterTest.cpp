@@ -0,0 +1,149 @@
+// Exchange rates: daily series filled between quotes and held past both
+// ends, inverse and chained conversions, rejected quotes, the batch
+// kernels against per-row conversion, and rates and the reporting currency
+// stored in the ledger across a reopen.
+#include "Check.h"
+#include "Import/RateParser.h"
+#include "ViewModel/TransactionManager.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace {
+    const CurrencyCode kEuro = MakeCurrency('E', 'U', 'R');
+    const CurrencyCode kPound = MakeCurrency('G', 'B', 'P');
+    const CurrencyCode kYen = MakeCurrency('J', 'P', 'Y');
+    
+    bool Near(double a, double b) {
+        return std::fabs(a - b) < 1e-9 * std::max(1.0, std::fabs(b));
+    }
+    
+    double Convert(const CurrencyConverter::Conversion& conversion, double amount, CurrencyCode from,
+                   std::int32_t day) {
+        double converted = 0.0;
+        return conversion.Convert(amount, from, day, converted) ? converted : NAN;
+    }
+    
+    std::time_t Local(std::int32_t day) {
+        int year, month, dayOfMonth;
+        CivilFromDays(day, year, month, dayOfMonth);
+        std::tm calendar{};
+        calendar.tm_year = year - 1900;
+        calendar.tm_mon = month - 1;
+        calendar.tm_mday = dayOfMonth;
+        calendar.tm_hour = 12;
+        calendar.tm_isdst = -1;
+        return std::mktime(&calendar);
+    }
+}
+
+int main() {
+    const std::int32_t day = DaysFromCivil(2024, 3, 1);
+    
+    // Without rates only same-currency amounts convert
+    CurrencyConverter none;
+    CHECK(!none.HasRates());
+    CHECK(Convert(none.To(kDefaultCurrency), 5.0, kDefaultCurrency, day) == 5.0);
+    CHECK(std::isnan(Convert(none.To(kDefaultCurrency), 5.0, kEuro, day)));
+    
+    // EUR quoted against USD twice; GBP only against EUR; junk quotes ignored
+    CurrencyConverter rates;
+    rates.Build({
+        {kEuro, kDefaultCurrency, day, 1.10},
+        {kEuro, kDefaultCurrency, day + 10, 1.20},
+        {kPound, kEuro, day + 5, 1.15},
+        {kEuro, kEuro, day, 2.0},
+        {kYen, kDefaultCurrency, day, 0.0},
+        {kYen, kDefaultCurrency, day, NAN},
+    });
+    CHECK(rates.HasRates());
+    CHECK((rates.GetCurrencies() == std::vector<CurrencyCode>{kEuro, kPound, kDefaultCurrency}));
+    
+    CurrencyConverter::Conversion toDollars = rates.To(kDefaultCurrency);
+    CHECK(Near(Convert(toDollars, 100.0, kEuro, day - 30), 110.0));     // Before the first quote
+    CHECK(Near(Convert(toDollars, 100.0, kEuro, day + 9), 110.0));      // Gap keeps the previous rate
+    CHECK(Near(Convert(toDollars, 100.0, kEuro, day + 10), 120.0));
+    CHECK(Near(Convert(toDollars, 100.0, kEuro, day + 400), 120.0));    // After the last quote
+    CHECK(Near(Convert(toDollars, 100.0, kPound, day), 115.0 * 1.10));  // Chained through EUR
+    CHECK(Near(Convert(toDollars, 100.0, kPound, day + 10), 115.0 * 1.20));
+    CHECK(std::isnan(Convert(toDollars, 100.0, kYen, day)));
+    
+    CurrencyConverter::Conversion toEuros = rates.To(kEuro);
+    CHECK(Near(Convert(toEuros, 110.0, kDefaultCurrency, day), 100.0));  // Inverse
+    CHECK(Near(Convert(toEuros, 100.0, kPound, day + 20), 115.0));
+    CHECK(Near(Convert(toEuros, 7.0, kEuro, day), 7.0));
+    CHECK(std::isnan(Convert(rates.To(kYen), 1.0, kDefaultCurrency, day)));
+    
+    // Batch kernels agree with converting row by row
+    std::vector<Transaction> rows;
+    const CurrencyCode currencies[] = {kDefaultCurrency, kEuro, kPound, kYen};
+    for (int i = 0; i < 40; ++i) {
+        rows.emplace_back(40 - i, "Row", 10.0 + i, i % 3 ? "Food" : "Rent",
+                          i % 4 ? TransactionType::Expense : TransactionType::Income, Local(day + 20 - i));
+        rows.back().currency = currencies[i % 4];
+    }
+    TransactionSnapshot::Ptr snapshot = TransactionSnapshot::Create(rows, 1);
+    
+    std::vector<double> amounts;
+    rates.ConvertAmounts(*snapshot, kEuro, amounts);
+    CHECK(amounts.size() == rows.size());
+    CurrencyConverter::Totals expected;
+    for (size_t i = 10; i < 30; ++i) {
+        const Transaction& row = rows[i];
+        double converted = Convert(toEuros, row.amount, row.currency, day + 20 - static_cast<int>(i));
+        double sign = row.type == TransactionType::Income ? 1.0 : -1.0;
+        if (std::isnan(converted)) {
+            CHECK(std::isnan(amounts[i]));
+            ++expected.unconverted;
+            continue;
+        }
+        CHECK(Near(amounts[i], sign * converted));
+        (row.type == TransactionType::Income ? expected.income : expected.expenses) += converted;
+        expected.byCategory[row.category] += converted;
+    }
+    CurrencyConverter::Totals totals = rates.Summarize(*snapshot, kEuro, 10, 30);
+    CHECK(totals.currency == kEuro && totals.rows == 20);
+    CHECK(totals.unconverted == expected.unconverted && totals.unconverted == 5);
+    CHECK(Near(totals.income, expected.income));
+    CHECK(Near(totals.expenses, expected.expenses));
+    CHECK(Near(totals.byCategory["Food"], expected.byCategory["Food"]));
+    CHECK(Near(totals.byCategory["Rent"], expected.byCategory["Rent"]));
+    
+    // Rate files
+    std::vector<ExchangeRate> parsed;
+    ImportReport report;
+    std::string text = "date,base,quote,rate\n2024-03-01,eur,USD,1.0812\n\n2024-03-02;GBP;EUR;1.1e0\n"
+                       "2024-03-03,EUR,USD,abc\n2024-03-04,EURO,USD,1\n";
+    RateParser::Parse(text.data(), text.size(), parsed, report);
+    CHECK(parsed.size() == 2 && report.rowsRejected == 2);
+    if (parsed.size() == 2) {
+        CHECK(parsed[0].base == kEuro && parsed[0].quote == kDefaultCurrency && Near(parsed[0].rate, 1.0812));
+        CHECK(parsed[0].day == day);
+        CHECK(parsed[1].base == kPound && Near(parsed[1].rate, 1.1));
+    }
+    
+    // Through the manager: rates and the reporting currency live in the ledger
+    test::ScratchFile file("CurrencyConverterTest");
+    const std::string ratesPath = "CurrencyConverterTest.rates.csv";
+    std::ofstream(ratesPath) << "2024-03-01,EUR,USD,1.25\n";
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.AddTransaction("Pay", 100.0, "Income", TransactionType::Income, kDefaultCurrency, Local(day)));
+        CHECK(manager.AddTransaction("Hotel", 40.0, "Travel", TransactionType::Expense, kEuro, Local(day + 1)));
+        ImportReport imported;
+        CHECK(manager.ImportExchangeRates(ratesPath, imported));
+        CHECK(manager.SetReportingCurrency(kEuro));
+        CHECK(Near(manager.GetTotals(kEuro).income, 80.0));
+        CHECK(Near(manager.GetBalanceAsOf(Local(day + 2)), 80.0 - 40.0));
+    }
+    std::remove(ratesPath.c_str());
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.GetReportingCurrency() == kEuro);
+        CHECK(manager.GetConverter()->HasRates());
+        CHECK(Near(manager.GetBalanceAsOf(Local(day + 2)), 40.0));
+        CHECK(Near(manager.GetTotals(kDefaultCurrency).expenses, 50.0));
+    }
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+// Date ranges run from from up to but not including to. FirstBefore() on a
+// snapshot whose runs of equal dates straddle chunk borders, and the
+// manager's range rows, range totals and period, are checked against a
+// linear filter for bounds on a row's date, either side of it, past either
+// end of the ledger, open at one end, and empty or reversed.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <sqlite3.h>
+
+namespace {
+    const std::time_t kBase = 1700000000;
+    
+    bool Newer(const Transaction& a, const Transaction& b) {
+        return a.date != b.date ? a.date > b.date : a.id > b.id;
+    }
+    
+    bool InRange(std::time_t date, std::time_t from, std::time_t to) {
+        return (!from || date >= from) && (!to || date < to);
+    }
+    
+    // Row dates and the seconds either side, the ledger's ends and beyond
+    std::vector<std::time_t> Bounds(const std::vector<Transaction>& rows) {
+        std::set<std::time_t> bounds = {0, 1};
+        for (const auto& row : rows) {
+            bounds.insert({row.date - 1, row.date, row.date + 1});
+        }
+        bounds.insert(rows.front().date + 86400);
+        bounds.insert(rows.back().date - 86400);
+        return std::vector<std::time_t>(bounds.begin(), bounds.end());
+    }
+    
+    bool Near(double a, double b) {
+        return std::fabs(a - b) < 1e-6;
+    }
+}
+
+int main() {
+    // Few distinct dates, so each one covers rows on both sides of a chunk border
+    std::vector<Transaction> rows;
+    for (int id = 1; id <= 6000; ++id) {
+        rows.emplace_back(id, "row", 1.0, "Food", TransactionType::Expense,
+                          kBase + static_cast<std::time_t>((id * 7919) % 40) * 3600);
+    }
+    std::sort(rows.begin(), rows.end(), Newer);
+    TransactionSnapshot::Ptr snapshot = TransactionSnapshot::Create(rows, 1);
+    const size_t chunk = TransactionSnapshot::kChunkSize;
+    for (size_t border = chunk; border < rows.size(); border += chunk) {
+        CHECK(rows[border - 1].date == rows[border].date);
+    }
+    for (std::time_t date : Bounds(rows)) {
+        size_t expected = static_cast<size_t>(std::count_if(rows.begin(), rows.end(), [&](const Transaction& row) {
+            return row.date >= date;
+        }));
+        CHECK(snapshot->FirstBefore(date) == expected);
+    }
+    CHECK(TransactionSnapshot::Create({}, 1)->FirstBefore(kBase) == 0);
+    
+    // Through the manager, on a ledger written by another program
+    test::ScratchFile file("DateRangeTest");
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.IsInitialized());
+    }
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open(file.Path().c_str(), &db) == SQLITE_OK);
+    CHECK(sqlite3_exec(db, "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 3000) "
+                           "INSERT INTO transactions (description, amount, category, type, date) "
+                           "SELECT 'Row ' || i, i % 97 + 0.25, 'Cat' || (i % 3), i % 4 <> 0, "
+                           "1700000000 + ((i * 7919) % 60) * 3600 FROM n;", nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(db);
+    
+    TransactionManager manager(file.Path());
+    rows.assign(manager.GetTransactions().begin(), manager.GetTransactions().end());
+    CHECK(rows.size() == 3000 && std::is_sorted(rows.begin(), rows.end(), Newer));
+    std::vector<std::time_t> bounds = Bounds(rows);
+    size_t checked = 0;
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        for (size_t j = i % 7; j < bounds.size(); j += 7) {
+            std::time_t from = bounds[i];
+            std::time_t to = bounds[j];
+            std::vector<int> expected;
+            double income = 0.0;
+            double expenses = 0.0;
+            double closing = 0.0;
+            for (const auto& row : rows) {
+                if (InRange(row.date, from, to)) {
+                    expected.push_back(row.id);
+                    (row.type == TransactionType::Income ? income : expenses) += row.amount;
+                }
+                if (!to || row.date < to) {
+                    closing += row.type == TransactionType::Income ? row.amount : -row.amount;
+                }
+            }
+            
+            std::vector<int> ids;
+            for (const auto& row : manager.GetTransactionsInRange(from, to)) {
+                ids.push_back(row.id);
+            }
+            CHECK(ids == expected);
+            
+            CurrencyConverter::Totals totals = manager.GetTotalsInRange(from, to);
+            CHECK(totals.rows == expected.size() && Near(totals.income, income) && Near(totals.expenses, expenses));
+            
+            manager.SetPeriod(from, to);
+            std::vector<int> viewIds;
+            for (std::uint32_t row : manager.GetViewRows()) {
+                viewIds.push_back(manager.GetTransactions()[row].id);
+            }
+            std::sort(viewIds.begin(), viewIds.end());
+            std::sort(expected.begin(), expected.end());
+            CHECK(viewIds == expected);
+            const CurrencyConverter::Totals& period = manager.GetPeriodTotals();
+            CHECK(period.rows == expected.size() && Near(period.income, income) && Near(period.expenses, expenses));
+            CHECK(Near(manager.GetPeriodClosingBalance(), closing));
+            ++checked;
+        }
+    }
+    CHECK(checked > 1000);
+    
+    // A range with no rows in it, and one that ends before it starts
+    CHECK(manager.GetTransactionsInRange(kBase + 1, kBase + 2).empty());
+    CHECK(manager.GetTransactionsInRange(kBase + 7200, kBase + 3600).empty());
+    CHECK(manager.GetTotalsInRange(kBase + 7200, kBase + 3600).rows == 0);
+    manager.SetPeriod(kBase + 3600, kBase + 3600);
+    CHECK(manager.GetViewRows().empty() && manager.GetPeriodTotals().rows == 0);
+    manager.SetPeriod(0, 0);
+    CHECK(!manager.HasPeriod() && manager.GetViewRows().size() == rows.size());
+    
+    return test::Result();
+}
\ No newline at end of file
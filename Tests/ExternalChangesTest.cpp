@@ -0,0 +1,125 @@
+// Another program writes to the ledger while the manager has it open:
+// CheckExternalChanges() notices, reads back only what moved, and ends up
+// with the same rows, balance and search results as a fresh load. Its own
+// writes, and foreign writes to other tables, are not reported.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <sqlite3.h>
+#include <tuple>
+
+namespace {
+    bool Foreign(const std::string& path, const std::string& sql) {
+        sqlite3* db = nullptr;
+        bool ok = sqlite3_open(path.c_str(), &db) == SQLITE_OK &&
+                  sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+        sqlite3_close(db);
+        return ok;
+    }
+    
+    using Row = std::tuple<int, std::string, double, std::string, std::time_t>;
+    
+    std::vector<Row> Rows(const TransactionSnapshot& snapshot) {
+        std::vector<Row> rows;
+        for (const auto& transaction : snapshot) {
+            rows.emplace_back(transaction.id, transaction.description, transaction.amount, transaction.category,
+                              transaction.date);
+        }
+        return rows;
+    }
+    
+    bool MatchesFreshLoad(const TransactionManager& manager, const std::string& path) {
+        TransactionManager fresh(path);
+        return Rows(manager.GetTransactions()) == Rows(fresh.GetTransactions()) &&
+               manager.GetBalance() == fresh.GetBalance();
+    }
+}
+
+int main() {
+    test::ScratchFile file("ExternalChangesTest");
+    {
+        TransactionManager creator(file.Path());  // Lays down the schema
+    }
+    // Enough rows to span several change buckets
+    CHECK(Foreign(file.Path(), R"(
+        WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < 2999)
+        INSERT INTO transactions (description, amount, category, type, date)
+            SELECT 'Row ' || i, 1.0 + i % 50, 'Food', 1, 1700000000 + i * 3600 FROM n;
+    )"));
+    
+    TransactionManager manager(file.Path());
+    CHECK(manager.IsInitialized());
+    CHECK(manager.GetTransactions().size() == 3000);
+    CHECK(!manager.CheckExternalChanges());
+    
+    // Its own writes are already in the cache
+    CHECK(manager.AddTransaction("Own", 5.0, "Food", TransactionType::Income, kDefaultCurrency, 1800000000));
+    CHECK(!manager.CheckExternalChanges());
+    
+    // Foreign inserts, edits and deletes across buckets, in one commit
+    CHECK(Foreign(file.Path(), R"(
+        BEGIN;
+        INSERT INTO transactions (description, amount, category, type, date)
+            VALUES ('Foreign payee', 42.0, 'Travel', 1, 1750000000);
+        UPDATE transactions SET amount = 99.0, description = 'Edited elsewhere' WHERE id IN (5, 1500, 2999);
+        DELETE FROM transactions WHERE id IN (10, 11, 2048);
+        COMMIT;
+    )"));
+    CHECK(manager.CheckExternalChanges());
+    CHECK(MatchesFreshLoad(manager, file.Path()));
+    CHECK(manager.SearchDescriptions("foreign payee").size() == 1);
+    CHECK(manager.SearchDescriptions("edited elsewhere").size() == 3);
+    CHECK(!manager.CheckExternalChanges());
+    
+    // A row written with an id far past the others, and one removed at the top
+    CHECK(Foreign(file.Path(), "INSERT INTO transactions (id, description, amount, category, type, date) "
+                               "VALUES (500000, 'Far away', 7.0, 'Other', 0, 1760000000);"));
+    CHECK(manager.CheckExternalChanges());
+    CHECK(MatchesFreshLoad(manager, file.Path()));
+    CHECK(Foreign(file.Path(), "DELETE FROM transactions WHERE id = 500000;"));
+    CHECK(manager.CheckExternalChanges());
+    CHECK(MatchesFreshLoad(manager, file.Path()));
+    
+    // Separate commits between two checks all arrive
+    CHECK(Foreign(file.Path(), "UPDATE transactions SET category = 'Moved' WHERE id = 20;"));
+    CHECK(Foreign(file.Path(), "DELETE FROM transactions WHERE id = 21;"));
+    CHECK(Foreign(file.Path(), "UPDATE transactions SET date = 1600000000 WHERE id = 1024;"));
+    CHECK(manager.CheckExternalChanges());
+    CHECK(MatchesFreshLoad(manager, file.Path()));
+    
+    // Another table only: nothing to read back
+    CHECK(Foreign(file.Path(), "INSERT OR REPLACE INTO settings (key, value) VALUES ('unrelated', 'x');"));
+    CHECK(!manager.CheckExternalChanges());
+    
+    // Writes after a foreign change still land where a fresh load puts them
+    CHECK(Foreign(file.Path(), "UPDATE transactions SET amount = 1.0 WHERE id = 30;"));
+    CHECK(manager.AddTransaction("After", 3.0, "Food", TransactionType::Expense, kDefaultCurrency, 1650000000));
+    manager.CheckExternalChanges();
+    CHECK(MatchesFreshLoad(manager, file.Path()));
+    
+    // A row at the very top of the id space, read back alone
+    CHECK(Foreign(file.Path(), "INSERT INTO transactions (id, description, amount, category, type, date) "
+                               "VALUES (2147483647, 'Top', 4.0, 'Other', 1, 1760000000);"));
+    CHECK(manager.CheckExternalChanges());
+    CHECK(MatchesFreshLoad(manager, file.Path()));
+    CHECK(Foreign(file.Path(), "UPDATE transactions SET amount = 6.0 WHERE id = 2147483647;"));
+    CHECK(manager.CheckExternalChanges());
+    Transaction top;
+    CHECK(manager.GetTransaction(2147483647, top) && top.amount == 6.0);
+    manager.SetFilterText("top");
+    CHECK(manager.GetViewRows().size() == 1);
+    manager.SetFilterText("");
+    
+    // Past what the cache can key: left out, without visiting every id up to
+    // it. Last, since AUTOINCREMENT carries on from there.
+    size_t cached = manager.GetTransactions().size();
+    CHECK(Foreign(file.Path(), "INSERT INTO transactions (id, description, amount, category, type, date) "
+                               "VALUES (5000000000, 'Beyond', 4.0, 'Other', 1, 1760000000);"));
+    manager.CheckExternalChanges();
+    CHECK(manager.GetTransactions().size() == cached);
+    CHECK(MatchesFreshLoad(manager, file.Path()));
+    CHECK(Foreign(file.Path(), "DELETE FROM transactions WHERE id = 5000000000;"));
+    manager.CheckExternalChanges();
+    CHECK(MatchesFreshLoad(manager, file.Path()));
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+// Monthly flows kept up row by row must equal flows rebuilt from the rows
+// left, through adds, edits that move a category's first row and deletes
+// that empty a category, both directly and through the manager's forecast.
+// The forecast's bands are ordered and, for a fixed seed, the same whatever
+// the number of threads.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include "Model/Calendar.h"
+#include <map>
+#include <random>
+
+namespace {
+    const char* const kCategories[] = {"Rent", "Food", "Salary", "Gym", "Travel"};
+    
+    bool Same(const MonthlyFlows& a, const MonthlyFlows& b) {
+        if (a.GetCategories().size() != b.GetCategories().size()) {
+            return false;
+        }
+        for (auto left = a.GetCategories().begin(), right = b.GetCategories().begin();
+             left != a.GetCategories().end(); ++left, ++right) {
+            if (left->first != right->first || left->second.firstMonth != right->second.firstMonth ||
+                left->second.net != right->second.net || left->second.dayWeight != right->second.dayWeight ||
+                left->second.rows != right->second.rows) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    bool Same(const CashFlowForecast& a, const CashFlowForecast& b) {
+        if (a.GetDays().size() != b.GetDays().size() || a.GetPaths() != b.GetPaths()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.GetDays().size(); ++i) {
+            const ForecastDay& left = a.GetDays()[i];
+            const ForecastDay& right = b.GetDays()[i];
+            if (left.day != right.day || left.p5 != right.p5 || left.p25 != right.p25 || left.median != right.median ||
+                left.p75 != right.p75 || left.p95 != right.p95) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    struct Row {
+        Transaction transaction;
+        std::int32_t day;
+    };
+    
+    MonthlyFlows Rebuild(const std::map<int, Row>& rows) {
+        MonthlyFlows flows;
+        for (const auto& row : rows) {
+            flows.Add(row.second.transaction, row.second.transaction.amount, row.second.day);
+        }
+        return flows;
+    }
+}
+
+int main() {
+    // Directly: random adds, edits and removes against a rebuild each time
+    std::mt19937 random(45);
+    const std::int32_t firstDay = DaysFromCivil(2021, 1, 1);
+    std::map<int, Row> rows;
+    MonthlyFlows flows;
+    for (int step = 0; step < 3000; ++step) {
+        unsigned kind = rows.size() < 20 ? 0 : random() % 3;
+        auto pick = rows.begin();
+        if (!rows.empty()) {
+            std::advance(pick, random() % rows.size());
+        }
+        Row row{Transaction(step + 1, "row", (1 + random() % 4000) * 0.25, kCategories[random() % 5],
+                            random() % 3 ? TransactionType::Expense : TransactionType::Income, 0),
+                firstDay + static_cast<std::int32_t>(random() % 1100)};
+        if (kind == 0) {
+            flows.Add(row.transaction, row.transaction.amount, row.day);
+            rows.emplace(row.transaction.id, row);
+        } else if (kind == 1) {
+            // An edit, as the manager makes it: the old row out, the new one in
+            row.transaction.id = pick->first;
+            flows.Remove(pick->second.transaction, pick->second.transaction.amount, pick->second.day);
+            flows.Add(row.transaction, row.transaction.amount, row.day);
+            pick->second = row;
+        } else {
+            flows.Remove(pick->second.transaction, pick->second.transaction.amount, pick->second.day);
+            rows.erase(pick);
+        }
+        if (step % 50 == 0 || step > 2950) {
+            CHECK(Same(flows, Rebuild(rows)));
+        }
+    }
+    
+    // Down to nothing, oldest first, so every category's first month moves
+    std::vector<std::pair<std::int32_t, int>> byDay;
+    for (const auto& row : rows) {
+        byDay.emplace_back(row.second.day, row.first);
+    }
+    std::sort(byDay.begin(), byDay.end());
+    for (size_t i = 0; i < byDay.size(); ++i) {
+        const Row& row = rows.at(byDay[i].second);
+        flows.Remove(row.transaction, row.transaction.amount, row.day);
+        rows.erase(byDay[i].second);
+        if (i % 25 == 0) {
+            CHECK(Same(flows, Rebuild(rows)));
+        }
+    }
+    CHECK(flows.GetCategories().empty());
+    flows.Remove(Transaction(1, "row", 5.0, "Food", TransactionType::Expense, 0), 5.0, firstDay);
+    CHECK(flows.GetCategories().empty());
+    
+    // The forecast: ordered bands, one per day to the end of the horizon,
+    // and the same numbers for any number of threads
+    for (int i = 0; i < 900; ++i) {
+        Row row{Transaction(i + 1, "row", (1 + random() % 4000) * 0.25, kCategories[random() % 5],
+                            i % 4 ? TransactionType::Expense : TransactionType::Income, 0),
+                firstDay + static_cast<std::int32_t>(random() % 1000)};
+        flows.Add(row.transaction, row.transaction.amount, row.day);
+    }
+    const std::int32_t today = firstDay + 1003;
+    ForecastOptions options;
+    options.months = 6;
+    options.paths = 1000;
+    options.threads = 1;
+    CashFlowForecast::Ptr single = CashFlowForecast::Build(flows, 2500.0, today, options);
+    const std::vector<ForecastDay>& days = single->GetDays();
+    int year, month, dayOfMonth;
+    CivilFromDays(today, year, month, dayOfMonth);
+    CHECK(!days.empty() && days.front().day == today);
+    CHECK(days.back().day + 1 == DaysFromCivil(year + (month + 6) / 12, (month + 6) % 12 + 1, 1));
+    CHECK(single->GetMonthEnds().size() == 7 && single->GetPaths() == 1000);
+    CHECK(days.front().p5 == 2500.0 && days.front().p95 == 2500.0);
+    bool spread = false;
+    for (size_t i = 0; i < days.size(); ++i) {
+        const ForecastDay& day = days[i];
+        CHECK(day.day == today + static_cast<std::int32_t>(i));
+        CHECK(day.p5 <= day.p25 && day.p25 <= day.median && day.median <= day.p75 && day.p75 <= day.p95);
+        spread = spread || day.p5 < day.p95;
+    }
+    CHECK(spread);
+    for (size_t threads : {2, 3, 7, 0}) {
+        options.threads = threads;
+        CHECK(Same(*CashFlowForecast::Build(flows, 2500.0, today, options), *single));
+    }
+    options.seed += 1;
+    CHECK(!Same(*CashFlowForecast::Build(flows, 2500.0, today, options), *single));
+    
+    // Through the manager: a forecast after edits and deletes equals one
+    // from a ledger opened afresh
+    test::ScratchFile file("ForecastTest");
+    const std::time_t now = std::time(nullptr);
+    options = ForecastOptions();
+    options.paths = 600;
+    {
+        TransactionManager manager(file.Path());
+        std::vector<int> ids;
+        for (int i = 0; i < 300; ++i) {
+            int id = 0;
+            std::time_t date = now - static_cast<std::time_t>(10 + random() % 900) * 86400;
+            CHECK(manager.AddTransaction("Row " + std::to_string(i), (1 + random() % 4000) * 0.25,
+                                         kCategories[i % 5], i % 4 ? TransactionType::Expense : TransactionType::Income,
+                                         kDefaultCurrency, date, &id));
+            ids.push_back(id);
+        }
+        CashFlowForecast::Ptr before = manager.GetForecast(options);
+        CHECK(before->GetDays().size() > 180);
+        
+        // Gym's rows all move to recent months, Travel's all go, and some
+        // rows change amount and direction
+        Transaction row;
+        for (int id : ids) {
+            if (!manager.GetTransaction(id, row)) {
+                continue;
+            }
+            if (row.category == "Gym") {
+                CHECK(manager.UpdateTransaction(id, row.description, row.amount, row.category, row.type, row.currency,
+                                                now - static_cast<std::time_t>(10 + random() % 60) * 86400));
+            } else if (row.category == "Travel") {
+                CHECK(manager.DeleteTransaction(id));
+            } else if (random() % 5 == 0) {
+                CHECK(manager.UpdateTransaction(id, row.description, row.amount + 0.75, row.category,
+                                                TransactionType::Income, row.currency, row.date));
+            }
+        }
+        CashFlowForecast::Ptr kept = manager.GetForecast(options);
+        TransactionManager fresh(file.Path());
+        CHECK(Same(*kept, *fresh.GetForecast(options)));
+        CHECK(!Same(*kept, *before));
+    }
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+// Group commit: batched writes are visible at once through the handler but
+// only to other connections after the batch commits, bulk writes commit the
+// batch before their own transaction, and a failed write loses exactly what
+// the database rolled back, with the manager's cache following suit.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <sqlite3.h>
+
+namespace {
+    // What another program sees
+    long long CountRows(const std::string& path, const std::string& where = "1") {
+        sqlite3* db = nullptr;
+        long long count = -1;
+        sqlite3_stmt* stmt;
+        std::string sql = "SELECT COUNT(*) FROM transactions WHERE " + where + ";";
+        if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK &&
+            sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                count = sqlite3_column_int64(stmt, 0);
+            }
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(db);
+        return count;
+    }
+    
+    // Writes with these descriptions fail: "abort" undoes only its own
+    // statement, "rollback" the whole open transaction
+    void AddPoisonTriggers(const std::string& path) {
+        sqlite3* db = nullptr;
+        CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+        CHECK(sqlite3_exec(db, R"(
+            CREATE TRIGGER poison_abort BEFORE INSERT ON transactions WHEN NEW.description = 'abort' BEGIN
+                SELECT RAISE(ABORT, 'poisoned row');
+            END;
+            CREATE TRIGGER poison_rollback BEFORE INSERT ON transactions WHEN NEW.description = 'rollback' BEGIN
+                SELECT RAISE(ROLLBACK, 'poisoned batch');
+            END;
+        )", nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(db);
+    }
+    
+    Transaction Row(const std::string& description, std::time_t date) {
+        return Transaction(0, description, 10.0, "Food", TransactionType::Expense, date);
+    }
+    
+    bool Add(TransactionManager& manager, const std::string& description, std::time_t date) {
+        return manager.AddTransaction(description, 10.0, "Food", TransactionType::Expense, kDefaultCurrency, date);
+    }
+}
+
+int main() {
+    test::ScratchFile file("GroupCommitTest");
+    const std::time_t day = 1700000000;
+    
+    // Handler level: a batch held open by a long delay
+    {
+        DatabaseHandler db(file.Path());
+        CHECK(db.Initialize());
+        WriteBatching batching;
+        batching.durability = Durability::Group;
+        batching.maxDelayMs = 60000;
+        batching.maxRows = 1000;
+        CHECK(db.SetDurability(batching));
+        AddPoisonTriggers(file.Path());
+        
+        CHECK(db.AddTransaction(Row("first", day)));
+        CHECK(db.AddTransaction(Row("second", day + 1)));
+        CHECK(db.GetAllTransactions().size() == 2);  // Read-your-writes
+        CHECK(CountRows(file.Path()) == 0);          // Not committed yet
+        
+        // A statement-level failure leaves the rest of the batch alone
+        CHECK(!db.AddTransaction(Row("abort", day + 2)));
+        CHECK(db.AddTransaction(Row("third", day + 3)));
+        CHECK(db.GetCommitStats().lostBatches == 0);
+        
+        // A bulk write commits the batch first, and its own failure rolls
+        // back only its own rows
+        CHECK(!db.AddTransactions({Row("bulk 1", day + 4), Row("abort", day + 5), Row("bulk 2", day + 6)}, nullptr));
+        CHECK(CountRows(file.Path()) == 3);
+        CHECK(CountRows(file.Path(), "description LIKE 'bulk%'") == 0);
+        
+        size_t inserted = 0;
+        CHECK(db.AddTransactions({Row("bulk 3", day + 7), Row("bulk 4", day + 8)}, &inserted));
+        CHECK(inserted == 2);
+        CHECK(CountRows(file.Path()) == 5);
+        
+        // Losing the whole batch is counted
+        CHECK(db.AddTransaction(Row("fourth", day + 9)));
+        CHECK(!db.AddTransaction(Row("rollback", day + 10)));
+        CHECK(db.GetCommitStats().lostBatches == 1);
+        CHECK(db.FlushWrites());
+        CHECK(CountRows(file.Path()) == 5);
+        CHECK(CountRows(file.Path(), "description = 'fourth'") == 0);
+        
+        // and writing carries on in a fresh batch
+        CHECK(db.AddTransaction(Row("fifth", day + 11)));
+        CHECK(db.FlushWrites());
+        CHECK(CountRows(file.Path()) == 6);
+    }
+    
+    // Manager level: the cache and the undo history drop what the database
+    // lost as soon as the failing write returns
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.IsInitialized());
+        WriteBatching batching;
+        batching.durability = Durability::Group;
+        batching.maxDelayMs = 60000;
+        CHECK(manager.SetDurability(batching));
+        size_t before = manager.GetTransactions().size();
+        CHECK(before == 6);
+        
+        CHECK(Add(manager, "sixth", day + 12));
+        CHECK(Add(manager, "seventh", day + 13));
+        CHECK(manager.GetTransactions().size() == before + 2);
+        CHECK(manager.CanUndo());
+        CHECK(!Add(manager, "rollback", day + 14));
+        CHECK(manager.GetTransactions().size() == before);
+        CHECK(manager.GetBalance() == -10.0 * static_cast<double>(before));
+        CHECK(!manager.CanUndo());  // Their journal steps went with them
+        
+        CHECK(Add(manager, "eighth", day + 15));
+        CHECK(manager.FlushWrites());
+        CHECK(manager.GetTransactions().size() == before + 1);
+        CHECK(CountRows(file.Path()) == static_cast<long long>(before) + 1);
+    }
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+// The ledger registry: open ledgers are closed least recently used first
+// once the memory budget is exceeded, except the current ledger and one
+// whose backup is still running; ledgers.conf reads back what was saved;
+// and two ledgers whose files share a name keep their backups apart.
+#include "Check.h"
+#include "ViewModel/LedgerRegistry.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sqlite3.h>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // A ledger with rows, written the way another program would
+    void CreateLedger(const std::string& path, int rows) {
+        {
+            TransactionManager manager(path);
+            CHECK(manager.IsInitialized());
+        }
+        sqlite3* db = nullptr;
+        CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+        std::string sql = "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < " +
+                          std::to_string(rows) + ") "
+                          "INSERT INTO transactions (description, amount, category, type, date) "
+                          "SELECT 'Row ' || i, i % 50 + 1.0, 'Other', 0, 1700000000 + i * 60 FROM n;";
+        CHECK(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(db);
+    }
+    
+    std::string OpenNames(const LedgerRegistry& registry) {
+        std::string names;
+        for (const auto& ledger : registry.GetLedgers()) {
+            if (ledger.open) {
+                names += ledger.name;
+            }
+        }
+        return names;
+    }
+    
+    size_t Usage(const LedgerRegistry& registry, const std::string& name) {
+        for (const auto& ledger : registry.GetLedgers()) {
+            if (ledger.name == name) {
+                return ledger.memoryUsage;
+            }
+        }
+        return 0;
+    }
+    
+    void WaitForBackup(TransactionManager& manager) {
+        while (manager.GetBackups().IsRunning()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+int main() {
+    test::ScratchFile a("LedgerRegistryTestA");
+    test::ScratchFile b("LedgerRegistryTestB");
+    test::ScratchFile c("LedgerRegistryTestC");
+    const std::string config = "LedgerRegistryTest.conf";
+    std::remove(config.c_str());
+    CreateLedger(a.Path(), 3000);
+    CreateLedger(b.Path(), 2000);
+    CreateLedger(c.Path(), 1000);
+    
+    {
+        LedgerRegistry registry(config);
+        CHECK(!registry.Load());
+        CHECK(registry.AddLedger("A", a.Path()) && registry.AddLedger("B", b.Path()) && registry.AddLedger("C", c.Path()));
+        CHECK(!registry.AddLedger("A", "elsewhere.db"));
+        CHECK(!registry.AddLedger("Again", "./" + a.Path()));
+        CHECK(!registry.AddLedger("Tab\tName", "other.db"));
+        CHECK(!registry.Open("Nobody") && registry.GetCurrent() == nullptr);
+        
+        for (const char* name : {"A", "B", "C"}) {
+            CHECK(registry.Open(name) != nullptr);
+        }
+        CHECK(OpenNames(registry) == "ABC" && registry.GetCurrentName() == "C");
+        CHECK(Usage(registry, "A") > Usage(registry, "B") && Usage(registry, "B") > Usage(registry, "C"));
+        CHECK(registry.GetMemoryUsage() == Usage(registry, "A") + Usage(registry, "B") + Usage(registry, "C"));
+        
+        // Just over what B and C take: A, the least recently used, goes
+        registry.SetMemoryBudget(Usage(registry, "B") + Usage(registry, "C"));
+        CHECK(OpenNames(registry) == "BC");
+        CHECK(Usage(registry, "A") == 0 && registry.GetMemoryUsage() <= registry.GetMemoryBudget());
+        
+        // Room for A and C: reopening A closes B, the least recently used
+        registry.SetMemoryBudget(Usage(registry, "C") + Usage(registry, "B") * 2);
+        CHECK(OpenNames(registry) == "BC");
+        CHECK(registry.Open("A") != nullptr);
+        CHECK(OpenNames(registry) == "AC");
+        CHECK(registry.Open("C") != nullptr && registry.Open("B") != nullptr);
+        CHECK(OpenNames(registry) == "BC");
+        
+        // The current ledger stays open however small the budget
+        registry.SetMemoryBudget(1);
+        CHECK(OpenNames(registry) == "B" && registry.GetCurrent() != nullptr);
+        CHECK(!registry.RemoveLedger("B"));
+        
+        // A ledger with a backup running is not closed until it finishes. A
+        // lock held by another program keeps the copy waiting meanwhile.
+        registry.SetMemoryBudget(LedgerRegistry::kDefaultMemoryBudget);
+        TransactionManager* held = registry.Open("A");
+        CHECK(held != nullptr && registry.Open("C") != nullptr);
+        sqlite3* other = nullptr;
+        CHECK(sqlite3_open(a.Path().c_str(), &other) == SQLITE_OK);
+        CHECK(sqlite3_exec(other, "BEGIN EXCLUSIVE;", nullptr, nullptr, nullptr) == SQLITE_OK);
+        CHECK(held->GetBackups().Start("LedgerRegistryTestA.backup.db"));
+        registry.SetMemoryBudget(1);
+        CHECK(OpenNames(registry) == "AC");
+        CHECK(held->GetBackups().IsRunning());
+        CHECK(sqlite3_exec(other, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(other);
+        WaitForBackup(*held);
+        BackupService::Result result;
+        CHECK(held->GetBackups().TakeResult(result) && result.succeeded);
+        std::remove("LedgerRegistryTestA.backup.db");
+        registry.SetMemoryBudget(1);
+        CHECK(OpenNames(registry) == "C");
+        registry.SetMemoryBudget(size_t(3) << 20);
+        
+        CHECK(registry.RemoveLedger("B"));
+        CHECK(registry.AddLedger("B again", b.Path()));
+        CHECK(registry.Save());
+    }
+    
+    // ledgers.conf: the budget, the current ledger and the list, in order
+    {
+        LedgerRegistry registry(config);
+        CHECK(registry.Load());
+        CHECK(registry.GetMemoryBudget() == size_t(3) << 20);
+        CHECK(registry.GetCurrentName() == "C" && OpenNames(registry).empty());
+        std::vector<LedgerRegistry::Ledger> ledgers = registry.GetLedgers();
+        CHECK(ledgers.size() == 3);
+        if (ledgers.size() == 3) {
+            CHECK(ledgers[0].name == "A" && ledgers[0].path == a.Path());
+            CHECK(ledgers[1].name == "C" && ledgers[1].path == c.Path());
+            CHECK(ledgers[2].name == "B again" && ledgers[2].path == b.Path());
+        }
+        TransactionManager* current = registry.Open(registry.GetCurrentName());
+        CHECK(current != nullptr && current->GetTransactions().size() == 1000);
+    }
+    {
+        std::ofstream(config, std::ios::app) << "no equals sign\r\n"
+                                                "ledger=Missing tab\n"
+                                                "ledger=Copy\t" << c.Path() << "\n"
+                                                "current=Unknown\n"
+                                                "# comment\n";
+        LedgerRegistry registry(config);
+        CHECK(registry.Load());
+        CHECK(registry.GetLedgers().size() == 3 && registry.GetCurrentName().empty());
+    }
+    std::remove(config.c_str());
+    
+    // Two ledgers named finance.db in different folders, and a finance-tracker.db
+    std::error_code error;
+    fs::remove_all("LedgerRegistryTest.folders", error);
+    fs::remove_all("backups", error);
+    const std::string paths[] = {"LedgerRegistryTest.folders/home/finance.db", "LedgerRegistryTest.folders/work/finance.db",
+                                 "LedgerRegistryTest.folders/home/finance-tracker.db"};
+    {
+        LedgerRegistry registry("LedgerRegistryTest.folders.conf");
+        for (const std::string& path : paths) {
+            CHECK(fs::create_directories(fs::path(path).parent_path(), error) || !error);
+            CreateLedger(path, 10);
+            CHECK(registry.AddLedger(path, path));
+        }
+        const std::time_t now = 1700000000;
+        for (const std::string& path : paths) {
+            TransactionManager* manager = registry.Open(path);
+            CHECK(manager != nullptr && manager->GetBackups().RunIfDue(now));
+            WaitForBackup(*manager);
+        }
+        for (const std::string& path : paths) {
+            TransactionManager* manager = registry.Open(path);
+            CHECK(manager->GetBackups().ListBackups().size() == 1);
+        }
+        size_t files = 0;
+        for (fs::directory_iterator it("backups", error), end; !error && it != end; it.increment(error)) {
+            ++files;
+        }
+        CHECK(files == 3);
+    }
+    fs::remove_all("LedgerRegistryTest.folders", error);
+    fs::remove_all("backups", error);
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+// Opens a ledger written by the first release (transactions table only, no
+// fingerprint, currency or reconciled column, no user_version) and checks
+// that the migrations bring it to the current schema with its rows intact,
+// then that a version 6 file gets fingerprints that cover the currency.
+#include "Check.h"
+#include "Database/DatabaseHandler.h"
+#include "Model/Fingerprint.h"
+#include <algorithm>
+#include <map>
+#include <sqlite3.h>
+#include <set>
+
+namespace {
+    bool Execute(sqlite3* db, const char* sql) {
+        return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+    
+    long long QueryNumber(const std::string& path, const char* sql) {
+        sqlite3* db = nullptr;
+        long long value = -1;
+        sqlite3_stmt* stmt;
+        if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK &&
+            sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                value = sqlite3_column_int64(stmt, 0);
+            }
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(db);
+        return value;
+    }
+    
+    void WriteOriginalLedger(const std::string& path) {
+        sqlite3* db = nullptr;
+        CHECK(sqlite3_open(path.c_str(), &db) == SQLITE_OK);
+        CHECK(Execute(db, R"(
+            CREATE TABLE transactions (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                description TEXT NOT NULL,
+                amount REAL NOT NULL,
+                category TEXT NOT NULL,
+                type INTEGER NOT NULL,
+                date INTEGER NOT NULL
+            );
+            INSERT INTO transactions (description, amount, category, type, date) VALUES
+                ('Coffee', 3.5, 'Food', 1, 1700000000),
+                ('Coffee', 3.5, 'Food', 1, 1700000600),
+                ('Salary', 2000, 'Income', 0, 1700100000),
+                ('Rent', 900, 'Housing', 1, 1700200000);
+        )"));
+        sqlite3_close(db);
+    }
+}
+
+int main() {
+    test::ScratchFile file("MigrationTest");
+    WriteOriginalLedger(file.Path());
+    
+    long long version;
+    {
+        DatabaseHandler db(file.Path());
+        CHECK(db.Initialize());
+        
+        std::vector<Transaction> rows = db.GetAllTransactions();
+        CHECK(rows.size() == 4);
+        
+        // Every row gets a fingerprint, and the two identical coffees distinct ones
+        std::set<std::uint64_t> fingerprints;
+        for (const auto& row : rows) {
+            CHECK(row.fingerprint != 0);
+            CHECK(row.currency == kDefaultCurrency);
+            CHECK(!row.reconciled);
+            fingerprints.insert(row.fingerprint);
+        }
+        CHECK(fingerprints.size() == rows.size());
+        
+        // So the first coffee is recognised as a duplicate on re-import
+        Transaction again = rows.back();
+        again.id = 0;
+        again.fingerprint = Fingerprint(BaseFingerprint(again), 0);
+        size_t inserted = 99;
+        CHECK(db.AddTransactions({again}, &inserted));
+        CHECK(inserted == 0);
+        
+        // Later features work on the migrated file
+        CHECK(db.AddTag({rows[0].id}, "groceries"));
+        CHECK(db.GetTagAssignments().size() == 1);
+        CHECK(db.SetReconciled({rows[1].id}, true));
+    }
+    
+    version = QueryNumber(file.Path(), "PRAGMA user_version;");
+    CHECK(version > 0);
+    CHECK(QueryNumber(file.Path(), "SELECT COUNT(*) FROM transactions WHERE fingerprint IS NULL;") == 0);
+    CHECK(QueryNumber(file.Path(), "SELECT COUNT(*) FROM sqlite_master WHERE name IN "
+                                   "('idx_transactions_fingerprint', 'idx_transactions_date', 'tags', "
+                                   "'transaction_tags', 'journal_steps', 'journal_rows');") == 6);
+    CHECK(QueryNumber(file.Path(), "SELECT reconciled FROM transactions WHERE id = 3;") == 1);
+    
+    // Opening the migrated ledger again changes nothing
+    {
+        DatabaseHandler db(file.Path());
+        CHECK(db.Initialize());
+        CHECK(db.GetAllTransactions().size() == 4);
+    }
+    CHECK(QueryNumber(file.Path(), "PRAGMA user_version;") == version);
+    
+    // A version 6 file: keys from before the currency counted, a euro coffee
+    // that matches the first one in all else, and an undo image of another
+    sqlite3* db = nullptr;
+    CHECK(sqlite3_open(file.Path().c_str(), &db) == SQLITE_OK);
+    CHECK(Execute(db, R"(
+        UPDATE transactions SET fingerprint = id * 1000 + 7;
+        INSERT INTO transactions (description, amount, category, type, date, fingerprint, currency) VALUES
+            ('Coffee', 3.5, 'Food', 1, 1700000000, 99007, 'EUR');
+        INSERT INTO journal_steps (id, label) VALUES (1, 'Delete');
+        INSERT INTO journal_rows (step, first_id, last_id, present, description, amount, category, type, date,
+                                  fingerprint, currency, reconciled, tags) VALUES
+            (1, 50, 50, 1, 'Coffee', 3.5, 'Food', 1, 1700000000, 50007, 'EUR', 0, ''),
+            (1, 1, 1, 1, 'Coffee', 3.5, 'Food', 1, 1700000000, 1007, 'USD', 0, '');
+        PRAGMA user_version = 6;
+    )"));
+    sqlite3_close(db);
+    {
+        DatabaseHandler db(file.Path());
+        CHECK(db.Initialize());
+        std::vector<Transaction> rows = db.GetAllTransactions();
+        CHECK(rows.size() == 5);
+        
+        // Each row holds its n-th key, counted by date then id within its group
+        std::map<std::uint64_t, std::uint32_t> ordinals;
+        std::sort(rows.begin(), rows.end(), [](const Transaction& a, const Transaction& b) {
+            return a.date != b.date ? a.date < b.date : a.id < b.id;
+        });
+        for (const auto& row : rows) {
+            std::uint64_t base = BaseFingerprint(row);
+            CHECK(row.fingerprint == Fingerprint(base, ordinals[base]++));
+        }
+        Transaction dollars = rows.front();
+        Transaction euros = dollars;
+        euros.currency = MakeCurrency('E', 'U', 'R');
+        CHECK(BaseFingerprint(dollars) != BaseFingerprint(euros));
+        CHECK(ordinals[BaseFingerprint(euros)] == 1);
+        
+        // The image of row 1 keeps its key; the other euro coffee takes the next one
+        CHECK(QueryNumber(file.Path(), "SELECT fingerprint FROM journal_rows WHERE first_id = 1;") ==
+              static_cast<long long>(dollars.fingerprint));
+        CHECK(QueryNumber(file.Path(), "SELECT fingerprint FROM journal_rows WHERE first_id = 50;") ==
+              static_cast<long long>(Fingerprint(BaseFingerprint(euros), 1)));
+    }
+    CHECK(QueryNumber(file.Path(), "PRAGMA user_version;") == version);
+    CHECK(QueryNumber(file.Path(), "SELECT COUNT(*) FROM transactions WHERE fingerprint IS NULL OR "
+                                   "fingerprint IN (1007, 2007, 3007, 4007, 99007);") == 0);
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+// Statement matching against a nested loop over every line and row: the
+// same pairs within the day and amount windows, taken best first, and the
+// same missing lines and extra rows, for random tolerances. Then a statement
+// file reconciled through the manager, with the flags kept across a reopen.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+namespace {
+    const CurrencyCode kEuro = MakeCurrency('E', 'U', 'R');
+    const char* const kDescriptions[] = {"POS 4411 STARBUCKS SEATTLE", "Starbucks", "Shell Oil 5521", "SHELL",
+                                         "Rent", "Payroll ACME", "Amazon Mktp", "AMZN Digital"};
+    
+    std::time_t Local(std::int32_t day, int hour) {
+        int year, month, dayOfMonth;
+        CivilFromDays(day, year, month, dayOfMonth);
+        std::tm calendar{};
+        calendar.tm_year = year - 1900;
+        calendar.tm_mon = month - 1;
+        calendar.tm_mday = dayOfMonth;
+        calendar.tm_hour = hour;
+        calendar.tm_isdst = -1;
+        return std::mktime(&calendar);
+    }
+    
+    std::int64_t SignedCents(const Transaction& transaction) {
+        std::int64_t cents = std::llround(transaction.amount * 100.0);
+        return transaction.type == TransactionType::Expense ? -cents : cents;
+    }
+    
+    struct Pair {
+        double score;
+        size_t line;
+        size_t row;
+    };
+    
+    // Every line against every row, then the best pairs first
+    void Expected(const std::vector<Transaction>& lines, const std::vector<std::int32_t>& lineDays,
+                  const std::vector<Transaction>& rows, const std::vector<std::int32_t>& rowDays,
+                  const ReconcileOptions& options, ReconcileReport& report) {
+        const std::int64_t centsTolerance = std::llround(options.amountTolerance * 100.0);
+        std::vector<Pair> pairs;
+        for (size_t line = 0; line < lines.size(); ++line) {
+            for (size_t row = 0; row < rows.size(); ++row) {
+                int dayGap = std::abs(lineDays[line] - rowDays[row]);
+                std::int64_t centsGap = std::llabs(SignedCents(lines[line]) - SignedCents(rows[row]));
+                if (lines[line].currency != rows[row].currency || dayGap > options.dayTolerance ||
+                    centsGap > centsTolerance) {
+                    continue;
+                }
+                double likeness = Reconciler::Likeness(lines[line].description, rows[row].description);
+                double dayFit = 1.0 - dayGap / (options.dayTolerance + 1.0);
+                double amountFit = 1.0 - static_cast<double>(centsGap) / (centsTolerance + 1.0);
+                double score = 0.5 * likeness + 0.3 * dayFit + 0.2 * amountFit;
+                if (score >= options.minScore) {
+                    pairs.push_back({score, line, row});
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b) {
+            if (a.score != b.score) {
+                return a.score > b.score;
+            }
+            return a.line != b.line ? a.line < b.line : a.row < b.row;
+        });
+        
+        std::vector<bool> lineUsed(lines.size());
+        std::vector<bool> rowUsed(rows.size());
+        for (const Pair& pair : pairs) {
+            if (!lineUsed[pair.line] && !rowUsed[pair.row]) {
+                lineUsed[pair.line] = rowUsed[pair.row] = true;
+                report.matched.push_back({pair.line, rows[pair.row].id, pair.score});
+            }
+        }
+        std::sort(report.matched.begin(), report.matched.end(),
+                  [](const ReconcileMatch& a, const ReconcileMatch& b) { return a.line < b.line; });
+        for (size_t line = 0; line < lines.size(); ++line) {
+            if (!lineUsed[line]) {
+                report.missing.push_back(line);
+            }
+        }
+        if (!lines.empty()) {
+            auto span = std::minmax_element(lineDays.begin(), lineDays.end());
+            for (size_t row = 0; row < rows.size(); ++row) {
+                if (!rowUsed[row] && !rows[row].reconciled && rowDays[row] >= *span.first && rowDays[row] <= *span.second) {
+                    report.extra.push_back(rows[row].id);
+                }
+            }
+        }
+    }
+    
+    bool Same(const ReconcileReport& a, const ReconcileReport& b) {
+        if (a.matched.size() != b.matched.size() || a.missing != b.missing || a.extra != b.extra) {
+            return false;
+        }
+        for (size_t i = 0; i < a.matched.size(); ++i) {
+            if (a.matched[i].line != b.matched[i].line || a.matched[i].id != b.matched[i].id ||
+                std::fabs(a.matched[i].score - b.matched[i].score) > 1e-12) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    CHECK(Reconciler::Likeness("POS 4411 STARBUCKS SEATTLE", "Starbucks") == 1.0);
+    CHECK(Reconciler::Likeness("Starbucks", "Shell") < 0.5);
+    CHECK(Reconciler::Likeness("", "Starbucks") == 0.0);
+    
+    // Lines that are ledger rows moved a little, among lines with no row at all
+    std::mt19937 random(43);
+    const std::int32_t firstDay = DaysFromCivil(2024, 2, 20);
+    for (int round = 0; round < 40; ++round) {
+        std::vector<Transaction> rows;
+        std::vector<std::int32_t> rowDays;
+        for (int id = 1; id <= 600; ++id) {
+            std::int32_t day = firstDay + static_cast<std::int32_t>(random() % 40);
+            rows.emplace_back(id * 3, kDescriptions[random() % 8], (1 + random() % 30) * 0.5, "Other",
+                              random() % 4 ? TransactionType::Expense : TransactionType::Income,
+                              Local(day, 8 + static_cast<int>(random() % 12)));
+            rows.back().currency = random() % 5 ? kDefaultCurrency : kEuro;
+            rows.back().reconciled = random() % 6 == 0;
+            rowDays.push_back(day);
+        }
+        
+        std::vector<Transaction> lines;
+        std::vector<std::int32_t> lineDays;
+        for (int i = 0; i < 400; ++i) {
+            Transaction line;
+            std::int32_t day;
+            if (random() % 4) {
+                size_t source = random() % rows.size();
+                line = rows[source];
+                day = rowDays[source] + static_cast<std::int32_t>(random() % 5) - 2;
+                line.amount += (random() % 3) * 0.25;
+                line.description = kDescriptions[random() % 8];
+            } else {
+                day = firstDay + 5 + static_cast<std::int32_t>(random() % 20);
+                line = Transaction(0, kDescriptions[random() % 8], (1 + random() % 30) * 0.5, "Other",
+                                   TransactionType::Expense, 0);
+            }
+            line.id = 0;
+            line.reconciled = false;
+            line.date = Local(day, 12);
+            lines.push_back(line);
+            lineDays.push_back(day);
+        }
+        
+        ReconcileOptions options;
+        options.dayTolerance = static_cast<int>(random() % 4);
+        options.amountTolerance = random() % 2 ? 0.25 : 0.0;
+        options.minScore = random() % 2 ? 0.6 : 0.0;
+        
+        // The ledger may come in any order; ties go to the earlier row, so
+        // the nested loop walks the same order
+        std::vector<size_t> order(rows.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), random);
+        std::vector<Transaction> shuffled;
+        std::vector<std::int32_t> shuffledDays;
+        for (size_t i : order) {
+            shuffled.push_back(rows[i]);
+            shuffledDays.push_back(rowDays[i]);
+        }
+        rows.swap(shuffled);
+        rowDays.swap(shuffledDays);
+        std::vector<const Transaction*> ledger;
+        for (const auto& row : rows) {
+            ledger.push_back(&row);
+        }
+        
+        ReconcileReport actual;
+        Reconciler(options).Match(lines, ledger, actual);
+        std::sort(actual.extra.begin(), actual.extra.end());
+        ReconcileReport expected;
+        Expected(lines, lineDays, rows, rowDays, options, expected);
+        std::sort(expected.extra.begin(), expected.extra.end());
+        CHECK(Same(actual, expected));
+        CHECK(!actual.matched.empty() && actual.matched.size() + actual.missing.size() == lines.size());
+    }
+    
+    // Through the manager: matched rows are flagged once and stay flagged
+    test::ScratchFile file("ReconcilerTest");
+    const std::string statementPath = "ReconcilerTest.statement.csv";
+    std::ofstream(statementPath) << "Date,Description,Amount\n"
+                                    "2024-03-01,POS 4411 STARBUCKS SEATTLE,-4.50\n"
+                                    "2024-03-03,ACME PAYROLL,2500.00\n"
+                                    "2024-03-04,Unknown fee,-1.00\n";
+    int coffee = 0;
+    int pay = 0;
+    int gym = 0;
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.AddTransaction("Starbucks", 4.5, "Food", TransactionType::Expense, kDefaultCurrency,
+                                     Local(DaysFromCivil(2024, 3, 1), 9), &coffee));
+        CHECK(manager.AddTransaction("Payroll ACME", 2500.0, "Income", TransactionType::Income, kDefaultCurrency,
+                                     Local(DaysFromCivil(2024, 3, 2), 9), &pay));
+        CHECK(manager.AddTransaction("Gym", 30.0, "Health", TransactionType::Expense, kDefaultCurrency,
+                                     Local(DaysFromCivil(2024, 3, 2), 18), &gym));
+        CHECK(manager.AddTransaction("Later", 30.0, "Health", TransactionType::Expense, kDefaultCurrency,
+                                     Local(DaysFromCivil(2024, 4, 2), 18)));
+        
+        ReconcileReport report;
+        CHECK(manager.ReconcileStatement(statementPath, report));
+        CHECK(report.lines.size() == 3 && report.marked == 2);
+        CHECK(report.matched.size() == 2);
+        if (report.matched.size() == 2) {
+            CHECK(report.matched[0].line == 0 && report.matched[0].id == coffee);
+            CHECK(report.matched[1].line == 1 && report.matched[1].id == pay);
+        }
+        CHECK(report.missing == std::vector<size_t>{2});
+        CHECK(report.extra == std::vector<int>{gym});
+    }
+    {
+        TransactionManager manager(file.Path());
+        for (const auto& row : manager.GetTransactions()) {
+            CHECK(row.reconciled == (row.id == coffee || row.id == pay));
+        }
+        
+        // A second pass still matches but flags nothing new
+        ReconcileReport report;
+        CHECK(manager.ReconcileStatement(statementPath, report));
+        CHECK(report.matched.size() == 2 && report.marked == 0);
+        
+        CHECK(manager.SetReconciled({coffee}, false));
+        ReconcileReport dryRun;
+        CHECK(manager.ReconcileStatement(statementPath, dryRun, ReconcileOptions(), false));
+        CHECK(dryRun.marked == 0);
+    }
+    {
+        TransactionManager manager(file.Path());
+        for (const auto& row : manager.GetTransactions()) {
+            CHECK(row.reconciled == (row.id == pay));
+        }
+    }
+    std::remove(statementPath.c_str());
+    
+    return test::Result();
+}
\ No newline at end of file
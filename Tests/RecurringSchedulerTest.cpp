@@ -0,0 +1,134 @@
+// Recurring rules: occurrence arithmetic (month-end clamping and return,
+// intervals, first occurrence from a start date), the due-date heap with
+// removed and rescheduled rules, and catch-up through the manager that
+// survives a reopen without writing anything twice.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+
+namespace {
+    std::time_t Local(int year, int month, int day) {
+        std::tm calendar{};
+        calendar.tm_year = year - 1900;
+        calendar.tm_mon = month - 1;
+        calendar.tm_mday = day;
+        calendar.tm_isdst = -1;
+        return std::mktime(&calendar);
+    }
+    
+    RecurringRule Rule(int id, RecurrenceUnit unit, int interval, std::time_t nextDue, std::time_t endDate = 0) {
+        RecurringRule rule;
+        rule.id = id;
+        rule.description = "Rule " + std::to_string(id);
+        rule.amount = 10.0 + id;
+        rule.category = "Bills";
+        rule.unit = unit;
+        rule.interval = interval;
+        rule.dayOfMonth = 1;
+        rule.nextDue = nextDue;
+        rule.endDate = endDate;
+        return rule;
+    }
+}
+
+int main() {
+    // Month ends clamp to short months and come back afterwards
+    RecurringRule monthEnd = Rule(1, RecurrenceUnit::Month, 1, 0);
+    monthEnd.dayOfMonth = 31;
+    std::time_t due = RecurringScheduler::FirstOccurrence(monthEnd, Local(2024, 1, 15));
+    CHECK(due == Local(2024, 1, 31));
+    const std::time_t expected[] = {Local(2024, 2, 29), Local(2024, 3, 31), Local(2024, 4, 30), Local(2024, 5, 31)};
+    for (std::time_t next : expected) {
+        due = RecurringScheduler::NextOccurrence(monthEnd, due);
+        CHECK(due == next);
+    }
+    
+    // Past the rule's day in the start month means next month
+    RecurringRule fifth = Rule(2, RecurrenceUnit::Month, 3, 0);
+    fifth.dayOfMonth = 5;
+    CHECK(RecurringScheduler::FirstOccurrence(fifth, Local(2024, 11, 20)) == Local(2024, 12, 5));
+    CHECK(RecurringScheduler::NextOccurrence(fifth, Local(2024, 12, 5)) == Local(2025, 3, 5));
+    
+    // Days and weeks start on the start day and cross month and year ends
+    RecurringRule fortnightly = Rule(3, RecurrenceUnit::Week, 2, 0);
+    CHECK(RecurringScheduler::FirstOccurrence(fortnightly, Local(2024, 12, 25) + 3600) == Local(2024, 12, 25));
+    CHECK(RecurringScheduler::NextOccurrence(fortnightly, Local(2024, 12, 25)) == Local(2025, 1, 8));
+    RecurringRule everyThirdDay = Rule(4, RecurrenceUnit::Day, 3, 0);
+    CHECK(RecurringScheduler::NextOccurrence(everyThirdDay, Local(2024, 2, 28)) == Local(2024, 3, 2));
+    
+    // The heap hands out everything due, oldest first, and skips entries
+    // for rules removed or rescheduled since they were pushed
+    {
+        RecurringScheduler scheduler;
+        scheduler.Build({
+            Rule(1, RecurrenceUnit::Day, 1, Local(2024, 1, 1)),
+            Rule(2, RecurrenceUnit::Week, 1, Local(2024, 1, 2), Local(2024, 1, 10)),
+            Rule(3, RecurrenceUnit::Month, 1, Local(2024, 1, 3)),
+            Rule(4, RecurrenceUnit::Day, 1, Local(2024, 1, 1)),
+            Rule(5, RecurrenceUnit::Day, 1, Local(2024, 1, 1), Local(2023, 12, 31)),  // Already finished
+        });
+        scheduler.Remove(4);
+        RecurringRule later = Rule(3, RecurrenceUnit::Month, 1, Local(2024, 1, 4));
+        scheduler.Add(later);
+        
+        std::vector<std::pair<int, std::time_t>> advanced;
+        std::vector<Transaction> occurrences = scheduler.CollectDue(Local(2024, 1, 10), advanced);
+        // Rule 1: ten days; rule 2: the 2nd and 9th; rule 3: the 4th only
+        CHECK(occurrences.size() == 13);
+        for (size_t i = 1; i < occurrences.size(); ++i) {
+            CHECK(occurrences[i - 1].date <= occurrences[i].date);
+        }
+        size_t rule3 = 0;
+        for (const auto& occurrence : occurrences) {
+            rule3 += occurrence.description == "Rule 3" ? 1 : 0;
+            CHECK(occurrence.description != "Rule 4" && occurrence.description != "Rule 5");
+        }
+        CHECK(rule3 == 1);
+        CHECK((advanced == std::vector<std::pair<int, std::time_t>>{
+            {1, Local(2024, 1, 11)}, {2, Local(2024, 1, 16)}, {3, Local(2024, 2, 1)}}));
+        
+        // Nothing more until the next due date; rule 2 has ended
+        CHECK(scheduler.CollectDue(Local(2024, 1, 10), advanced).empty() && advanced.empty());
+        CHECK(scheduler.CollectDue(Local(2024, 1, 20), advanced).size() == 10);
+        CHECK(scheduler.GetRules().size() == 4);
+    }
+    
+    // Through the manager: adding a rule catches up at once, the rows and
+    // the advanced schedule are stored together, and reopening adds nothing
+    test::ScratchFile file("RecurringSchedulerTest");
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.IsInitialized());
+        RecurringRule rent = Rule(0, RecurrenceUnit::Month, 1, 0, Local(2024, 6, 30));
+        rent.dayOfMonth = 31;
+        size_t created = 0;
+        CHECK(manager.AddRecurringRule(rent, Local(2024, 1, 1), &created));
+        CHECK(created == 6);
+        CHECK(manager.GetTransactions().size() == 6);
+        CHECK(manager.GetRecurringRules().size() == 1);
+        CHECK(manager.GetRecurringRules().front().nextDue == Local(2024, 7, 31));
+        
+        // A rule that is not due yet creates nothing
+        RecurringRule future = Rule(0, RecurrenceUnit::Week, 1, 0);
+        CHECK(manager.AddRecurringRule(future, std::time(nullptr) + 30 * 86400, &created));
+        CHECK(created == 0);
+        
+        RecurringRule invalid = Rule(0, RecurrenceUnit::Month, 0, 0);
+        CHECK(!manager.AddRecurringRule(invalid, Local(2024, 1, 1)));
+    }
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.GetRecurringRules().size() == 2);
+        CHECK(manager.MaterializeRecurring() == 0);
+        CHECK(manager.GetTransactions().size() == 6);
+        
+        int futureId = 0;
+        for (const auto& rule : manager.GetRecurringRules()) {
+            futureId = rule.unit == RecurrenceUnit::Week ? rule.id : futureId;
+        }
+        CHECK(manager.DeleteRecurringRule(futureId));
+        CHECK(manager.MaterializeRecurring(std::time(nullptr) + 400 * 86400) == 0);
+        CHECK(manager.GetRecurringRules().size() == 1);
+    }
+    
+    return test::Result();
+}
\ No newline at end of file
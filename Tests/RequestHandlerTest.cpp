@@ -0,0 +1,252 @@
+// Query-server requests handled directly, without a socket: list pages and
+// date ranges, search pages and totals in either currency are checked
+// against a plain filter over the rows the test added, then the writes and
+// the error reply for each kind of bad input, malformed requests included.
+#include "Check.h"
+#include "Server/RequestHandler.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+namespace {
+    const CurrencyCode kEuro = MakeCurrency('E', 'U', 'R');
+    const char* const kDescriptions[] = {"Coffee shop", "COFFEE beans", "Train ticket", "Salary", "Rent", "Book"};
+    
+    JsonValue Call(RequestHandler& handler, const std::string& method, const JsonValue& params) {
+        JsonValue request = JsonValue::MakeObject();
+        request.Set("id", 7);
+        request.Set("method", method);
+        request.Set("params", params);
+        JsonValue response = handler.Handle(request);
+        CHECK(response["id"].AsNumber() == 7);
+        CHECK(response.Has("result") != response.Has("error"));
+        return response;
+    }
+    
+    // An object from name and value pairs
+    JsonValue Params(std::initializer_list<std::pair<const char*, JsonValue>> members) {
+        JsonValue params = JsonValue::MakeObject();
+        for (const auto& member : members) {
+            params.Set(member.first, member.second);
+        }
+        return params;
+    }
+    
+    std::vector<int> ItemIds(const JsonValue& result) {
+        std::vector<int> ids;
+        for (const JsonValue& item : result["items"].Items()) {
+            ids.push_back(static_cast<int>(item["id"].AsNumber()));
+        }
+        return ids;
+    }
+    
+    bool Failed(const JsonValue& response, const std::string& error) {
+        return !response.Has("result") && response["error"].AsString() == error;
+    }
+    
+    std::string Lower(std::string text) {
+        for (char& c : text) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return text;
+    }
+    
+    bool Near(double a, double b) {
+        return std::fabs(a - b) < 0.01;
+    }
+}
+
+int main() {
+    test::ScratchFile file("RequestHandlerTest");
+    const std::string ratesPath = "RequestHandlerTest.rates.csv";
+    std::ofstream(ratesPath) << "2024-03-01,EUR,USD,1.25\n";
+    
+    TransactionManager manager(file.Path());
+    CHECK(manager.IsInitialized());
+    ImportReport imported;
+    CHECK(manager.ImportExchangeRates(ratesPath, imported));
+    std::remove(ratesPath.c_str());
+    RequestHandler handler(manager);
+    
+    // Rows in random date order, many sharing a second, in both currencies
+    std::mt19937 random(36);
+    const std::time_t base = 1709251200;
+    std::vector<Transaction> rows;
+    for (int i = 0; i < 400; ++i) {
+        std::string description = std::string(kDescriptions[random() % 6]) + " " + std::to_string(i);
+        double amount = (1 + random() % 2000) * 0.25;
+        TransactionType type = random() % 4 ? TransactionType::Expense : TransactionType::Income;
+        CurrencyCode currency = random() % 3 ? kDefaultCurrency : kEuro;
+        std::time_t date = base + static_cast<std::time_t>(random() % 200) * 3600;
+        int id = 0;
+        CHECK(manager.AddTransaction(description, amount, "Cat" + std::to_string(i % 5), type, currency, date, &id));
+        rows.emplace_back(id, description, amount, "Cat" + std::to_string(i % 5), type, date);
+        rows.back().currency = currency;
+    }
+    std::sort(rows.begin(), rows.end(), [](const Transaction& a, const Transaction& b) {
+        return a.date != b.date ? a.date > b.date : a.id > b.id;
+    });
+    
+    // list: the window's order, paged, within [from, to)
+    for (int round = 0; round < 60; ++round) {
+        std::time_t from = round % 4 == 0 ? 0 : base + static_cast<std::time_t>(random() % 220) * 3600;
+        std::time_t to = round % 5 == 0 ? 0 : base + static_cast<std::time_t>(random() % 220) * 3600;
+        long long offset = random() % 120;
+        long long limit = 1 + random() % 80;
+        std::vector<int> expected;
+        for (const auto& row : rows) {
+            if ((!from || row.date >= from) && (!to || row.date < to)) {
+                expected.push_back(row.id);
+            }
+        }
+        size_t total = expected.size();
+        size_t begin = std::min(total, static_cast<size_t>(offset));
+        size_t end = std::min(total, begin + static_cast<size_t>(limit));
+        expected = std::vector<int>(expected.begin() + static_cast<std::ptrdiff_t>(begin),
+                                    expected.begin() + static_cast<std::ptrdiff_t>(end));
+        
+        JsonValue params = Params({{"offset", offset}, {"limit", limit}});
+        if (from) {
+            params.Set("from", static_cast<long long>(from));
+        }
+        if (to) {
+            params.Set("to", static_cast<long long>(to));
+        }
+        JsonValue response = Call(handler, "list", params);
+        CHECK(response["result"]["total"].AsNumber() == static_cast<double>(total));
+        CHECK(ItemIds(response["result"]) == expected);
+    }
+    JsonValue firstPage = Call(handler, "list", JsonValue());
+    CHECK(firstPage["result"]["items"].Items().size() == 50);
+    const JsonValue& newest = firstPage["result"]["items"].Items().front();
+    CHECK(newest["id"].AsNumber() == rows.front().id && newest["description"].AsString() == rows.front().description);
+    CHECK(newest["date"].AsNumber() == static_cast<double>(rows.front().date));
+    CHECK(newest["currency"].AsString() == CurrencyToString(rows.front().currency));
+    
+    // search: case-insensitive, highest id first, paged
+    for (const char* text : {"coffee", "TICKET", "1", "salary 3", "nothing like it"}) {
+        std::vector<int> expected;
+        for (const auto& row : rows) {
+            if (Lower(row.description).find(Lower(text)) != std::string::npos) {
+                expected.push_back(row.id);
+            }
+        }
+        std::sort(expected.rbegin(), expected.rend());
+        for (long long offset : {0LL, 3LL, 1000LL}) {
+            JsonValue response = Call(handler, "search", Params({{"text", text}, {"offset", offset}, {"limit", 20LL}}));
+            size_t begin = std::min(expected.size(), static_cast<size_t>(offset));
+            std::vector<int> page(expected.begin() + static_cast<std::ptrdiff_t>(begin),
+                                  expected.begin() + static_cast<std::ptrdiff_t>(std::min(expected.size(), begin + 20)));
+            CHECK(response["result"]["total"].AsNumber() == static_cast<double>(expected.size()));
+            CHECK(ItemIds(response["result"]) == page);
+        }
+    }
+    
+    // totals: converted at 1 EUR = 1.25 USD, all time and within [from, to)
+    for (int round = 0; round < 30; ++round) {
+        CurrencyCode currency = round % 2 ? kEuro : kDefaultCurrency;
+        std::time_t from = round < 2 ? 0 : base + static_cast<std::time_t>(random() % 220) * 3600;
+        std::time_t to = round < 2 ? 0 : from + static_cast<std::time_t>(random() % 100) * 3600;
+        double income = 0.0;
+        double expenses = 0.0;
+        size_t count = 0;
+        for (const auto& row : rows) {
+            if ((!from || row.date >= from) && (!to || row.date < to)) {
+                double factor = row.currency == currency ? 1.0 : (currency == kEuro ? 0.8 : 1.25);
+                (row.type == TransactionType::Income ? income : expenses) += row.amount * factor;
+                ++count;
+            }
+        }
+        
+        JsonValue params = Params({{"currency", CurrencyToString(currency)}});
+        if (from) {
+            params.Set("from", static_cast<long long>(from));
+            params.Set("to", static_cast<long long>(to));
+        }
+        JsonValue totals = Call(handler, "totals", params)["result"];
+        CHECK(totals["currency"].AsString() == CurrencyToString(currency));
+        CHECK(totals["count"].AsNumber() == static_cast<double>(count) && totals["unconverted"].AsNumber() == 0);
+        CHECK(Near(totals["income"].AsNumber(), income) && Near(totals["expenses"].AsNumber(), expenses));
+        CHECK(Near(totals["balance"].AsNumber(), income - expenses));
+    }
+    CHECK(Call(handler, "totals", JsonValue())["result"]["currency"].AsString() == "USD");
+    
+    // add, get, update and delete, with the currency kept when not given
+    JsonValue added = Call(handler, "add", Params({{"description", "Lunch"}, {"amount", 12.5}, {"category", "Food"},
+                                                   {"type", "expense"}, {"currency", "EUR"}, {"date", 1710000000LL}}));
+    int id = static_cast<int>(added["result"]["id"].AsNumber());
+    CHECK(id > 0);
+    JsonValue got = Call(handler, "get", Params({{"id", id}}))["result"];
+    CHECK(got["description"].AsString() == "Lunch" && got["amount"].AsNumber() == 12.5);
+    CHECK(got["category"].AsString() == "Food" && got["type"].AsString() == "expense");
+    CHECK(got["currency"].AsString() == "EUR" && got["date"].AsNumber() == 1710000000);
+    
+    CHECK(Call(handler, "update", Params({{"id", id}, {"description", "Dinner"}, {"amount", 30.0},
+                                          {"category", "Food"}, {"type", "income"}}))["result"]["id"].AsNumber() == id);
+    got = Call(handler, "get", Params({{"id", id}}))["result"];
+    CHECK(got["description"].AsString() == "Dinner" && got["type"].AsString() == "income");
+    CHECK(got["currency"].AsString() == "EUR");
+    Transaction stored;
+    CHECK(manager.GetTransaction(id, stored) && stored.amount == 30.0);
+    
+    CHECK(Call(handler, "delete", Params({{"id", id}}))["result"]["id"].AsNumber() == id);
+    CHECK(!manager.GetTransaction(id, stored));
+    const std::string missing = "No transaction with id " + std::to_string(id);
+    CHECK(Failed(Call(handler, "get", Params({{"id", id}})), missing));
+    CHECK(Failed(Call(handler, "delete", Params({{"id", id}})), missing));
+    CHECK(Failed(Call(handler, "update", Params({{"id", id}, {"description", "Dinner"}, {"amount", 30.0},
+                                                 {"category", "Food"}, {"type", "income"}})), missing));
+    
+    // Bad fields are refused before anything is written
+    const size_t count = manager.GetTransactions().size();
+    const std::string fields = "\"description\" and \"category\" must be non-empty strings";
+    const std::string positive = "\"amount\" must be a positive number";
+    const std::string kind = "\"type\" must be \"income\" or \"expense\"";
+    CHECK(Failed(Call(handler, "add", Params({{"amount", 1.0}, {"category", "Food"}, {"type", "expense"}})), fields));
+    CHECK(Failed(Call(handler, "add", Params({{"description", "x"}, {"amount", -1.0}, {"category", "Food"},
+                                              {"type", "expense"}})), positive));
+    CHECK(Failed(Call(handler, "add", Params({{"description", "x"}, {"amount", "12"}, {"category", "Food"},
+                                              {"type", "expense"}})), positive));
+    CHECK(Failed(Call(handler, "add", Params({{"description", "x"}, {"amount", 1.0}, {"category", "Food"},
+                                              {"type", "gift"}})), kind));
+    CHECK(Failed(Call(handler, "add", Params({{"description", "x"}, {"amount", 1.0}, {"category", "Food"},
+                                              {"type", "expense"}, {"currency", "EU"}})),
+                 "\"currency\" must be a three-letter currency code"));
+    CHECK(Failed(Call(handler, "add", Params({{"description", "x"}, {"amount", 1.0}, {"category", "Food"},
+                                              {"type", "expense"}, {"date", 1.5}})),
+                 "\"date\" must be a whole number from 0 to 253402300799"));
+    CHECK(Failed(Call(handler, "update", Params({{"id", rows[0].id}, {"description", "x"}, {"amount", 1.0},
+                                                 {"category", "Food"}, {"type", "expense"}, {"currency", 5}})),
+                 "\"currency\" must be a three-letter currency code"));
+    CHECK(Failed(Call(handler, "delete", JsonValue()), "\"id\" is required"));
+    CHECK(Failed(Call(handler, "get", Params({{"id", 0}})), "\"id\" must be a whole number from 1 to 2147483647"));
+    CHECK(Failed(Call(handler, "get", Params({{"id", "1"}})), "\"id\" must be a whole number from 1 to 2147483647"));
+    CHECK(Failed(Call(handler, "list", Params({{"limit", 0}})), "\"limit\" must be a whole number from 1 to 1000"));
+    CHECK(Failed(Call(handler, "list", Params({{"limit", 1001}})), "\"limit\" must be a whole number from 1 to 1000"));
+    CHECK(Failed(Call(handler, "list", Params({{"offset", -1}})),
+                 "\"offset\" must be a whole number from 0 to 2147483647"));
+    CHECK(Failed(Call(handler, "list", Params({{"from", "yesterday"}})),
+                 "\"from\" must be a whole number from 0 to 253402300799"));
+    CHECK(Failed(Call(handler, "search", Params({{"text", ""}})), "\"text\" must be a non-empty string"));
+    CHECK(Failed(Call(handler, "totals", Params({{"currency", "usd dollars"}})),
+                 "\"currency\" must be a three-letter currency code"));
+    CHECK(manager.GetTransactions().size() == count);
+    
+    // Requests that are not requests
+    CHECK(Failed(Call(handler, "rename", JsonValue()), "Unknown method \"rename\""));
+    CHECK(Failed(Call(handler, "list", JsonValue::MakeArray()), "\"params\" must be an object"));
+    const std::string shape = "A request must be an object with a \"method\" string";
+    CHECK(Failed(handler.Handle(JsonValue::MakeArray()), shape));
+    CHECK(Failed(handler.Handle(Params({{"id", "a"}, {"method", 3}})), shape));
+    CHECK(handler.Handle(Params({{"id", "a"}}))["id"].AsString() == "a");
+    JsonValue parsed;
+    std::string error;
+    CHECK(JsonValue::Parse(R"({"id": 1, "method": "list", "params": {"limit": 2}})", parsed, error));
+    CHECK(handler.Handle(parsed)["result"]["items"].Items().size() == 2);
+    CHECK(!JsonValue::Parse(R"({"id": 1, "method": "list")", parsed, error) && !error.empty());
+    CHECK(!JsonValue::Parse(R"({"id": 1} trailing)", parsed, error));
+    
+    return test::Result();
+}
\ No newline at end of file
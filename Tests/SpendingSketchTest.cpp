@@ -0,0 +1,165 @@
+// The spending sketches against exact answers: quantile ranks within the
+// KLL error bound, alone and merged, heavy-hitter bounds that hold for
+// every key and never miss a heavy one, and per-month summaries combined
+// over a span of months.
+#include "Check.h"
+#include "ViewModel/SpendingStats.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+
+namespace {
+    // Fraction of 1..n at or below value, for sketches fed a shuffled 1..n
+    double Rank(double value, double n) {
+        return value / n;
+    }
+    
+    bool RanksWithin(const QuantileSketch& sketch, double n, double tolerance) {
+        for (double q = 0.05; q < 1.0; q += 0.05) {
+            if (std::fabs(Rank(sketch.Quantile(q), n) - q) > tolerance) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    // Exact while small
+    QuantileSketch small;
+    CHECK(small.Empty() && small.Quantile(0.5) == 0.0);
+    for (int value = 100; value >= 1; --value) {
+        small.Add(value);
+    }
+    CHECK(small.Quantile(0.5) == 50.0);
+    CHECK(small.Quantile(0.9) == 90.0);
+    CHECK(small.Quantile(0.0) == 1.0 && small.Quantile(1.0) == 100.0);
+    CHECK((small.Quantiles({0.25, 0.75}) == std::vector<double>{25.0, 75.0}));
+    
+    // A long stream: ranks within a few percent, a bounded number kept, and
+    // count, min and max exact
+    std::mt19937 random(17);
+    const int n = 200000;
+    std::vector<double> values(n);
+    for (int i = 0; i < n; ++i) {
+        values[i] = i + 1;
+    }
+    std::shuffle(values.begin(), values.end(), random);
+    
+    QuantileSketch whole;
+    QuantileSketch firstHalf;
+    QuantileSketch secondHalf;
+    for (int i = 0; i < n; ++i) {
+        whole.Add(values[i]);
+        (i < n / 2 ? firstHalf : secondHalf).Add(values[i]);
+    }
+    CHECK(whole.Count() == static_cast<std::uint64_t>(n));
+    CHECK(whole.Min() == 1.0 && whole.Max() == n);
+    CHECK(whole.Retained() < 20 * QuantileSketch::kDefaultK);
+    CHECK(RanksWithin(whole, n, 0.03));
+    
+    firstHalf.Merge(secondHalf);
+    CHECK(firstHalf.Count() == static_cast<std::uint64_t>(n));
+    CHECK(firstHalf.Min() == 1.0 && firstHalf.Max() == n);
+    CHECK(firstHalf.Retained() < 20 * QuantileSketch::kDefaultK);
+    CHECK(RanksWithin(firstHalf, n, 0.03));
+    
+    QuantileSketch empty;
+    empty.Merge(QuantileSketch());
+    CHECK(empty.Empty());
+    empty.Merge(whole);
+    CHECK(empty.Count() == whole.Count() && empty.Quantile(0.5) == whole.Quantile(0.5));
+    
+    // Heavy hitters: a few heavy keys in a long tail of light ones
+    HeavyHitters hitters(64);
+    HeavyHitters left(64);
+    HeavyHitters right(64);
+    std::map<std::string, double> truth;
+    double total = 0.0;
+    for (int i = 0; i < 50000; ++i) {
+        std::string key = random() % 4 == 0 ? "heavy " + std::to_string(random() % 5)
+                                            : "light " + std::to_string(random() % 5000);
+        double weight = 1.0 + random() % 100;
+        hitters.Add(key, weight);
+        (i % 2 ? left : right).Add(key, weight);
+        truth[key] += weight;
+        total += weight;
+    }
+    CHECK(hitters.GetTotalWeight() == total);
+    left.Merge(right);
+    CHECK(left.GetTotalWeight() == total);
+    
+    // The same guarantees for one pass and for two halves merged
+    for (const HeavyHitters* summary : {&hitters, &left}) {
+        std::vector<HeavyHitters::Entry> top = summary->Top(64);
+        CHECK(top.size() == 64);
+        for (size_t i = 0; i < top.size(); ++i) {
+            double exact = truth[top[i].key];
+            CHECK(top[i].weight >= exact - 1e-6);
+            CHECK(top[i].weight - top[i].error <= exact + 1e-6);
+            CHECK(i == 0 || top[i - 1].weight >= top[i].weight);
+        }
+        // Every key above total / capacity has a counter; here that is the heavy ones
+        for (const auto& entry : truth) {
+            if (entry.second > total / 64) {
+                bool found = std::any_of(top.begin(), top.end(),
+                                         [&](const HeavyHitters::Entry& e) { return e.key == entry.first; });
+                CHECK(found);
+            }
+        }
+        std::vector<HeavyHitters::Entry> five = summary->Top(5);
+        for (const auto& entry : five) {
+            CHECK(entry.key.compare(0, 6, "heavy ") == 0);
+        }
+    }
+    
+    // Spending stats per category and month, combined over spans
+    CHECK(SpendingStats::NormalizeMerchant("UBER *TRIP 7XK2") == "uber trip");
+    CHECK(SpendingStats::NormalizeMerchant("Uber Trip") == "uber trip");
+    CHECK(SpendingStats::NormalizeMerchant("TRADER JOE'S #552") == "trader joe's");
+    CHECK(SpendingStats::NormalizeMerchant("12345").empty());
+    
+    SpendingStats stats;
+    const SpendingStats::Month march = MonthIndex(2024, 3);
+    const SpendingStats::Month april = MonthIndex(2024, 4);
+    for (int i = 1; i <= 10; ++i) {
+        Transaction row(i, "Corner Shop 0" + std::to_string(i), i, "Food", TransactionType::Expense, 0);
+        stats.Add(row, row.amount, march);
+        row.description = "Big Market";
+        stats.Add(row, row.amount * 10, april);
+    }
+    stats.Add(Transaction(50, "Salary", 5000.0, "Income", TransactionType::Income, 0), 5000.0, march);
+    stats.Add(Transaction(51, "Landlord", 900.0, "Rent", TransactionType::Expense, 0), 900.0, april);
+    
+    std::vector<CategorySpread> spread = stats.GetCategorySpread();
+    CHECK(spread.size() == 2);  // Income is not spending
+    if (spread.size() == 2) {
+        CHECK(spread[0].category == "Food" && spread[0].count == 20);
+        CHECK(spread[0].largest == 100.0);
+        CHECK(spread[1].category == "Rent" && spread[1].median == 900.0);
+    }
+    spread = stats.GetCategorySpread(march, march);
+    CHECK(spread.size() == 1);
+    if (spread.size() == 1) {
+        CHECK(spread[0].count == 10 && spread[0].median == 5.0 && spread[0].p90 == 9.0 && spread[0].largest == 10.0);
+    }
+    
+    std::vector<MerchantSpend> merchants = stats.GetTopMerchants(2);
+    CHECK(merchants.size() == 2);
+    if (merchants.size() == 2) {
+        CHECK(merchants[0].merchant == "landlord" && merchants[0].amount == 900.0);
+        CHECK(merchants[1].merchant == "big market" && merchants[1].amount == 550.0);
+    }
+    merchants = stats.GetTopMerchants(5, march, march);
+    CHECK(merchants.size() == 1);
+    if (merchants.size() == 1) {
+        CHECK(merchants[0].merchant == "corner shop" && merchants[0].amount == 55.0);
+        CHECK(merchants[0].transactions == 10 && merchants[0].error == 0.0);
+    }
+    
+    stats.Clear();
+    CHECK(stats.GetCategorySpread().empty() && stats.GetTopMerchants(5).empty());
+    
+    return test::Result();
+}
\ No newline at end of file
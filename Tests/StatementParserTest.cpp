@@ -0,0 +1,215 @@
+// The statement importer's field parsers and both formats: amount and date
+// spellings, CSV headers, quoting, delimiters and line endings, OFX with
+// and without closing tags, rejected rows with their line numbers, and
+// chunked delivery with early stops.
+#include "Check.h"
+#include "Import/StatementParser.h"
+#include <cstring>
+
+namespace {
+    std::int64_t Cents(const char* text) {
+        std::int64_t cents = 0;
+        return StatementParser::ParseCents(text, cents) ? cents : 999999999;
+    }
+    
+    bool Date(const char* text, int year, int month, int day) {
+        int y = 0, m = 0, d = 0;
+        return StatementParser::ParseDate(text, y, m, d) && y == year && m == month && d == day;
+    }
+    
+    bool NoDate(const char* text) {
+        int y, m, d;
+        return !StatementParser::ParseDate(text, y, m, d);
+    }
+    
+    std::time_t Midnight(int year, int month, int day) {
+        std::tm calendar{};
+        calendar.tm_year = year - 1900;
+        calendar.tm_mon = month - 1;
+        calendar.tm_mday = day;
+        calendar.tm_isdst = -1;
+        return std::mktime(&calendar);
+    }
+    
+    std::vector<Transaction> Parse(const std::string& text, StatementFormat format, ImportReport& report) {
+        std::vector<Transaction> rows;
+        StatementParser parser;
+        parser.Parse(text.data(), text.size(), format, [&](std::vector<Transaction>& chunk) {
+            rows.insert(rows.end(), chunk.begin(), chunk.end());
+            return true;
+        }, report);
+        return rows;
+    }
+}
+
+int main() {
+    // Amounts
+    CHECK(Cents("12.34") == 1234);
+    CHECK(Cents(" -12.34 ") == -1234);
+    CHECK(Cents("(12.34)") == -1234);
+    CHECK(Cents("12.34-") == -1234);
+    CHECK(Cents("$1,234.56") == 123456);
+    CHECK(Cents("-$5") == -500);
+    CHECK(Cents("1.234,56") == 123456);
+    CHECK(Cents("1 234,56") == 123456);
+    CHECK(Cents("1'234.50") == 123450);
+    CHECK(Cents("12,5") == 1250);
+    CHECK(Cents("1,234") == 123400);
+    CHECK(Cents(".5") == 50);
+    CHECK(Cents("0.005") == 1);
+    CHECK(Cents("12.34 EUR") == 1234);
+    CHECK(Cents("abc") == 999999999);
+    CHECK(Cents("") == 999999999);
+    CHECK(Cents("12.34 X2") == 999999999);
+    CHECK(Cents("1234567890123456") == 999999999);
+    
+    // Dates
+    CHECK(Date("2024-02-29", 2024, 2, 29));
+    CHECK(Date("2024/1/5", 2024, 1, 5));
+    CHECK(Date("01/13/2024", 2024, 1, 13));
+    CHECK(Date("13/01/2024", 2024, 1, 13));
+    CHECK(Date("05.04.2024", 2024, 4, 5));
+    CHECK(Date("20240315120000[-5:EST]", 2024, 3, 15));
+    CHECK(NoDate("2023-02-29"));
+    CHECK(NoDate("2024-13-01"));
+    CHECK(NoDate("24-01-05"));
+    CHECK(NoDate("1899-12-31"));
+    CHECK(NoDate("2024-01-01234"));
+    CHECK(NoDate("yesterday"));
+    
+    // CSV with a byte order mark, semicolons, CRLF, quoted fields holding
+    // the delimiter, escaped quotes and a line break, and columns found by name
+    {
+        std::string csv = "\xEF\xBB\xBF" "Booked;Payee;Category;Amount;Currency\r\n"
+                          "2024-03-01;\"Cafe; \"\"Blue\"\"\";Food;-3,50;EUR\r\n"
+                          "2024-03-02;\"Two\nlines\";;1.000,00;\r\n"
+                          "\r\n"
+                          "not a date;Bad;Food;1;EUR\r\n"
+                          "2024-03-03;Nothing;Food;0,00;EUR\r\n"
+                          "2024-03-04;;Food;1,00;EUR\r\n"
+                          "2024-03-05;Odd money;Food;1,00;XX\r\n"
+                          "2024-03-06;Last;Food;2,00;usd";
+        ImportReport report;
+        std::vector<Transaction> rows = Parse(csv, StatementFormat::Csv, report);
+        CHECK(rows.size() == 3);
+        CHECK(report.rowsParsed == 3);
+        CHECK(report.rowsRejected == 4);
+        if (rows.size() == 3) {
+            CHECK(rows[0].description == "Cafe; \"Blue\"");
+            CHECK(rows[0].amount == 3.5 && rows[0].type == TransactionType::Expense);
+            CHECK(rows[0].category == "Food");
+            CHECK(rows[0].currency == MakeCurrency('E', 'U', 'R'));
+            CHECK(rows[0].date == Midnight(2024, 3, 1));
+            CHECK(rows[1].description == "Two\nlines");
+            CHECK(rows[1].amount == 1000.0 && rows[1].type == TransactionType::Income);
+            CHECK(rows[1].currency == kDefaultCurrency);
+            CHECK(rows[2].currency == kDefaultCurrency);
+        }
+        // Line numbers count the line break inside the quoted field
+        CHECK(report.errors.size() == 4);
+        if (report.errors.size() == 4) {
+            CHECK(report.errors[0].line == 6);
+            CHECK(report.errors[0].message.find("date") != std::string::npos);
+            CHECK(report.errors[1].line == 7);
+            CHECK(report.errors[2].line == 8);
+            CHECK(report.errors[3].line == 9);
+        }
+    }
+    
+    // Debit and credit columns, and an explicit type column
+    {
+        std::string csv = "Date,Description,Debit Amount,Credit Amount,Type\n"
+                          "03/01/2024,Groceries,12.00,,\n"
+                          "03/02/2024,Refund,,4.50,\n"
+                          "03/03/2024,Both blank,,,\n"
+                          "03/04/2024,Marked income,7.00,,credit\n";
+        ImportReport report;
+        std::vector<Transaction> rows = Parse(csv, StatementFormat::Csv, report);
+        CHECK(rows.size() == 3 && report.rowsRejected == 1);
+        if (rows.size() == 3) {
+            CHECK(rows[0].amount == 12.0 && rows[0].type == TransactionType::Expense);
+            CHECK(rows[1].amount == 4.5 && rows[1].type == TransactionType::Income);
+            CHECK(rows[2].amount == 7.0 && rows[2].type == TransactionType::Income);
+        }
+    }
+    
+    // No header: date, description, amount; tabs as the delimiter
+    {
+        ImportReport report;
+        std::vector<Transaction> rows = Parse("2024-01-01\tSalary\t2500\n2024-01-02\tRent\t-900\n",
+                                              StatementFormat::Csv, report);
+        CHECK(rows.size() == 2 && report.rowsRejected == 0);
+        if (rows.size() == 2) {
+            CHECK(rows[0].description == "Salary" && rows[0].type == TransactionType::Income);
+            CHECK(rows[1].amount == 900.0 && rows[1].type == TransactionType::Expense);
+        }
+    }
+    
+    // OFX: SGML without closing tags, then XML with them; CURDEF applies to
+    // the transactions after it, entities are decoded, MEMO stands in for NAME
+    {
+        std::string ofx = "OFXHEADER:100\nDATA:OFXSGML\n<OFX><BANKMSGSRSV1><STMTRS><CURDEF>GBP\n<BANKTRANLIST>\n"
+                          "<STMTTRN><TRNTYPE>DEBIT<DTPOSTED>20240105<TRNAMT>-20.00<NAME>Tom &amp; Jerry's\n"
+                          "<STMTTRN><TRNTYPE>CREDIT<DTPOSTED>20240106120000<TRNAMT>100<MEMO>Interest\n"
+                          "<STMTTRN><DTPOSTED>20240107<TRNAMT>ten<NAME>Broken\n"
+                          "</BANKTRANLIST></STMTRS>\n"
+                          "<STMTRS><CURDEF>EUR</CURDEF><BANKTRANLIST>\n"
+                          "<STMTTRN><DTPOSTED>20240108</DTPOSTED><TRNAMT>-1.5</TRNAMT><NAME>Kiosk</NAME></STMTTRN>\n"
+                          "<STMTTRN><DTPOSTED>20240109</DTPOSTED><TRNAMT>-2</TRNAMT></STMTTRN>\n"
+                          "</BANKTRANLIST></STMTRS></BANKMSGSRSV1></OFX>\n";
+        CHECK(StatementParser::DetectFormat("statement.dat", ofx.data(), ofx.size()) == StatementFormat::Ofx);
+        CHECK(StatementParser::DetectFormat("statement.QFX", "", 0) == StatementFormat::Ofx);
+        CHECK(StatementParser::DetectFormat("statement.csv", ofx.data(), ofx.size()) == StatementFormat::Csv);
+        
+        ImportReport report;
+        std::vector<Transaction> rows = Parse(ofx, StatementFormat::Ofx, report);
+        CHECK(rows.size() == 3 && report.rowsRejected == 2);
+        if (rows.size() == 3) {
+            CHECK(rows[0].description == "Tom & Jerry's");
+            CHECK(rows[0].amount == 20.0 && rows[0].type == TransactionType::Expense);
+            CHECK(rows[0].currency == MakeCurrency('G', 'B', 'P'));
+            CHECK(rows[1].description == "Interest" && rows[1].type == TransactionType::Income);
+            CHECK(rows[1].date == Midnight(2024, 1, 6));
+            CHECK(rows[2].description == "Kiosk" && rows[2].amount == 1.5);
+            CHECK(rows[2].currency == MakeCurrency('E', 'U', 'R'));
+        }
+        if (report.errors.size() == 2) {
+            CHECK(report.errors[0].line == 7);
+            CHECK(report.errors[1].line == 11);
+        }
+    }
+    
+    // Rows arrive in chunks; a sink or progress callback returning false stops the parse
+    {
+        std::string csv;
+        for (int day = 1; day <= 25; ++day) {
+            csv += "2024-01-" + std::string(day < 10 ? "0" : "") + std::to_string(day) + ",Row,1\n";
+        }
+        StatementParser parser;
+        parser.SetChunkRows(10);
+        std::vector<size_t> chunks;
+        ImportReport report;
+        CHECK(parser.Parse(csv.data(), csv.size(), StatementFormat::Csv, [&](std::vector<Transaction>& chunk) {
+            chunks.push_back(chunk.size());
+            return true;
+        }, report));
+        CHECK((chunks == std::vector<size_t>{10, 10, 5}));
+        
+        chunks.clear();
+        ImportReport stopped;
+        CHECK(!parser.Parse(csv.data(), csv.size(), StatementFormat::Csv, [&](std::vector<Transaction>& chunk) {
+            chunks.push_back(chunk.size());
+            return false;
+        }, stopped));
+        CHECK(chunks.size() == 1 && !stopped.cancelled);
+        
+        ImportReport cancelled;
+        parser.SetProgress([](size_t done, size_t total) { return done < total / 2; });
+        CHECK(!parser.Parse(csv.data(), csv.size(), StatementFormat::Csv, [](std::vector<Transaction>&) {
+            return true;
+        }, cancelled));
+        CHECK(cancelled.cancelled && cancelled.rowsParsed < 25);
+    }
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+// Roaring bitmaps against std::set through adds, removes and set operations
+// while chunks switch between array and bitset form, tag queries against a
+// brute-force check, and tags kept in the ledger through the manager.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <sqlite3.h>
+
+namespace {
+    std::vector<std::uint32_t> Values(const std::set<std::uint32_t>& set) {
+        return std::vector<std::uint32_t>(set.begin(), set.end());
+    }
+    
+    bool Same(const RoaringBitmap& bitmap, const std::set<std::uint32_t>& set) {
+        std::vector<std::uint32_t> visited;
+        bitmap.ForEach([&](std::uint32_t value) { visited.push_back(value); });
+        return bitmap.Cardinality() == set.size() && bitmap.Empty() == set.empty() &&
+               bitmap.ToVector() == Values(set) && visited == Values(set);
+    }
+    
+    // Values bunched into a few chunks, so some pass the array limit
+    std::uint32_t RandomValue(std::mt19937& random, std::uint32_t density) {
+        static const std::uint32_t chunks[] = {0, 1, 7, 65535};
+        return chunks[random() % 4] << 16 | static_cast<std::uint32_t>(random() % density);
+    }
+    
+    template <typename Operation>
+    std::set<std::uint32_t> Apply(const std::set<std::uint32_t>& left, const std::set<std::uint32_t>& right,
+                                  Operation operation) {
+        std::set<std::uint32_t> result;
+        operation(left.begin(), left.end(), right.begin(), right.end(), std::inserter(result, result.end()));
+        return result;
+    }
+}
+
+int main() {
+    std::mt19937 random(41);
+    
+    // Grow past the array limit, then shrink back under it
+    RoaringBitmap bitmap;
+    std::set<std::uint32_t> set;
+    for (int i = 0; i < 40000; ++i) {
+        std::uint32_t value = RandomValue(random, 12000);
+        bitmap.Add(value);
+        set.insert(value);
+    }
+    CHECK(Same(bitmap, set));
+    size_t denseBytes = bitmap.GetMemoryUsage();
+    for (int i = 0; i < 60000; ++i) {
+        std::uint32_t value = RandomValue(random, 12000);
+        bitmap.Remove(value);
+        set.erase(value);
+    }
+    CHECK(Same(bitmap, set));
+    CHECK(bitmap.GetMemoryUsage() <= denseBytes);
+    RoaringBitmap rebuilt;
+    for (std::uint32_t value : set) {
+        rebuilt.Add(value);
+    }
+    CHECK(rebuilt.GetMemoryUsage() < denseBytes);
+    for (int probe = 0; probe < 5000; ++probe) {
+        std::uint32_t value = RandomValue(random, 20000);
+        CHECK(bitmap.Contains(value) == (set.count(value) != 0));
+    }
+    bitmap.Remove(12345678);
+    CHECK(Same(bitmap, set));
+    
+    // Set operations across every mix of array and bitset chunks
+    for (std::uint32_t leftDensity : {3000u, 60000u}) {
+        for (std::uint32_t rightDensity : {3000u, 60000u}) {
+            RoaringBitmap left;
+            RoaringBitmap right;
+            std::set<std::uint32_t> leftSet;
+            std::set<std::uint32_t> rightSet;
+            for (int i = 0; i < 20000; ++i) {
+                std::uint32_t value = RandomValue(random, leftDensity);
+                left.Add(value);
+                leftSet.insert(value);
+                value = RandomValue(random, rightDensity);
+                right.Add(value);
+                rightSet.insert(value);
+            }
+            auto intersection = [](auto... args) { return std::set_intersection(args...); };
+            auto setUnion = [](auto... args) { return std::set_union(args...); };
+            auto difference = [](auto... args) { return std::set_difference(args...); };
+            CHECK(Same(RoaringBitmap::And(left, right), Apply(leftSet, rightSet, intersection)));
+            CHECK(Same(RoaringBitmap::Or(left, right), Apply(leftSet, rightSet, setUnion)));
+            CHECK(Same(RoaringBitmap::AndNot(left, right), Apply(leftSet, rightSet, difference)));
+            CHECK(Same(RoaringBitmap::AndNot(left, left), {}));
+        }
+    }
+    CHECK(RoaringBitmap::And(RoaringBitmap(), bitmap).Empty());
+    CHECK(Same(RoaringBitmap::Or(RoaringBitmap(), bitmap), set));
+    
+    // Tag queries against checking every id's tags
+    const char* const names[] = {"trip", "work", "gift", "tax"};
+    std::vector<std::pair<int, std::string>> assignments;
+    std::map<int, std::set<std::string>> tagsOf;
+    RoaringBitmap allIds;
+    for (int id = 1; id <= 3000; ++id) {
+        allIds.Add(static_cast<std::uint32_t>(id));
+        for (const char* name : names) {
+            if (random() % 3 == 0) {
+                assignments.emplace_back(id, name);
+                tagsOf[id].insert(name);
+            }
+        }
+    }
+    TagIndex index;
+    index.Build(assignments);
+    index.Add(5, "new");
+    tagsOf[5].insert("new");
+    index.Remove(6, "trip");
+    tagsOf[6].erase("trip");
+    index.RemoveTransaction(7);
+    tagsOf.erase(7);
+    CHECK(index.GetTags(5) == std::vector<std::string>(tagsOf[5].begin(), tagsOf[5].end()));
+    CHECK(index.GetTags(7).empty());
+    CHECK((index.GetTags() == std::vector<std::string>{"gift", "new", "tax", "trip", "work"}));
+    
+    for (int round = 0; round < 200; ++round) {
+        TagQuery query;
+        for (const char* name : names) {
+            switch (random() % 5) {
+                case 0: query.all.push_back(name); break;
+                case 1: query.any.push_back(name); break;
+                case 2: query.none.push_back(name); break;
+                default: break;
+            }
+        }
+        std::set<std::uint32_t> expected;
+        for (int id = 1; id <= 3000; ++id) {
+            const std::set<std::string>& tags = tagsOf[id];
+            auto has = [&](const std::string& name) { return tags.count(name) != 0; };
+            bool matches = std::all_of(query.all.begin(), query.all.end(), has) &&
+                           (query.any.empty() || std::any_of(query.any.begin(), query.any.end(), has)) &&
+                           std::none_of(query.none.begin(), query.none.end(), has);
+            if (matches) {
+                expected.insert(static_cast<std::uint32_t>(id));
+            }
+        }
+        CHECK(Same(index.Find(query, allIds), expected));
+    }
+    
+    // Through the manager: tags are stored, trimmed, skip unknown ids and follow deletes
+    test::ScratchFile file("TagIndexTest");
+    int coffee = 0;
+    int train = 0;
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.AddTransaction("Coffee", 3.0, "Food", TransactionType::Expense, kDefaultCurrency, 1700000000, &coffee));
+        CHECK(manager.AddTransaction("Train", 40.0, "Travel", TransactionType::Expense, kDefaultCurrency, 1700003600, &train));
+        CHECK(manager.TagTransactions({coffee, train, 99999}, " trip "));
+        CHECK(manager.AddTag(train, "work"));
+        CHECK(manager.GetTags(99999).empty());
+    }
+    {
+        TransactionManager manager(file.Path());
+        CHECK((manager.GetTags() == std::vector<std::string>{"trip", "work"}));
+        TagQuery tripNotWork;
+        tripNotWork.all = {"trip"};
+        tripNotWork.none = {"work"};
+        CHECK(manager.FindTagged(tripNotWork) == std::vector<int>{coffee});
+        CHECK(manager.GetTaggedTotals(TagQuery{{"trip"}, {}, {}}).expenses == 43.0);
+        
+        CHECK(manager.DeleteTransaction(train));
+        CHECK(manager.GetTags(train).empty());
+        CHECK(manager.FindTagged(TagQuery{{"work"}, {}, {}}).empty());
+        CHECK(manager.RemoveTag(coffee, "trip"));
+        CHECK(manager.GetTags(coffee).empty());
+    }
+    
+    // An id at the top of the range costs no more than a small one
+    {
+        sqlite3* db = nullptr;
+        CHECK(sqlite3_open(file.Path().c_str(), &db) == SQLITE_OK);
+        CHECK(sqlite3_exec(db, "INSERT INTO transactions (id, description, amount, category, type, date) "
+                               "VALUES (2147483647, 'Top', 5.0, 'Other', 0, 1700007200);", nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(db);
+        
+        TransactionManager manager(file.Path());
+        CHECK(manager.AddTag(2147483647, "top"));
+        CHECK(manager.FindTagged(TagQuery{{}, {}, {"trip"}}) == (std::vector<int>{coffee, 2147483647}));
+        CHECK(manager.GetTaggedTotals(TagQuery{{"top"}, {}, {}}).income == 5.0);
+    }
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+// Random filter trees answered three ways: Matches() over every row, the
+// manager's date-bounded scan of its cache, and the SQL that
+// DatabaseHandler::QueryTransactions() compiles. All three must return the
+// same rows, whatever the nesting, bounds, case or LIKE wildcards.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <sqlite3.h>
+
+namespace {
+    const char* const kDescriptions[] = {"Coffee", "COFFEE beans", "100% juice", "a_b", "back\\slash", "Rent", "rent"};
+    const char* const kCategories[] = {"Food", "food", "Housing", "Other"};
+    const char* const kTexts[] = {"coffee", "%", "_", "\\", "0% j", "RENT", "", "zzz"};
+    
+    std::vector<int> Ids(const std::vector<Transaction>& rows) {
+        std::vector<int> ids;
+        for (const auto& row : rows) {
+            ids.push_back(row.id);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+    
+    TransactionFilter RandomFilter(std::mt19937& random, int depth) {
+        const std::time_t base = 1700000000;
+        unsigned kind = random() % (depth > 0 ? 10 : 7);
+        switch (kind) {
+            case 0:
+                return TransactionFilter::Category(kCategories[random() % 4]);
+            case 1:
+                return TransactionFilter::Type(random() % 2 ? TransactionType::Expense : TransactionType::Income);
+            case 2:
+                return TransactionFilter::Currency(random() % 2 ? kDefaultCurrency : MakeCurrency('E', 'U', 'R'));
+            case 3: {
+                std::time_t from = random() % 3 ? base + static_cast<std::time_t>(random() % 100) * 86400 : 0;
+                std::time_t to = random() % 3 ? base + static_cast<std::time_t>(random() % 100) * 86400 : 0;
+                return TransactionFilter::DateRange(from, to);
+            }
+            case 4: {
+                // Bounds on stored amounts test that both ends are inclusive
+                double min = random() % 4 ? (random() % 40) * 2.5 : -std::numeric_limits<double>::infinity();
+                double max = random() % 4 ? (random() % 40) * 2.5 : std::numeric_limits<double>::infinity();
+                return TransactionFilter::AmountRange(min, max);
+            }
+            case 5:
+                return TransactionFilter::Text(kTexts[random() % 8]);
+            case 6:
+                return TransactionFilter();
+            case 7:
+                return RandomFilter(random, depth - 1) && RandomFilter(random, depth - 1);
+            case 8:
+                return RandomFilter(random, depth - 1) || RandomFilter(random, depth - 1);
+            default:
+                return !RandomFilter(random, depth - 1);
+        }
+    }
+}
+
+int main() {
+    test::ScratchFile file("TransactionFilterTest");
+    {
+        TransactionManager creator(file.Path());  // Lays down the schema
+    }
+    std::mt19937 random(31);
+    std::vector<Transaction> rows;
+    {
+        sqlite3* db = nullptr;
+        sqlite3_stmt* insert = nullptr;
+        CHECK(sqlite3_open(file.Path().c_str(), &db) == SQLITE_OK);
+        CHECK(sqlite3_prepare_v2(db, "INSERT INTO transactions (id, description, amount, category, type, date, currency) "
+                                     "VALUES (?, ?, ?, ?, ?, ?, ?);", -1, &insert, nullptr) == SQLITE_OK);
+        sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+        for (int id = 1; id <= 1500; ++id) {
+            Transaction row(id, kDescriptions[random() % 7], (random() % 40) * 2.5, kCategories[random() % 4],
+                            random() % 2 ? TransactionType::Expense : TransactionType::Income,
+                            1700000000 + static_cast<std::time_t>(random() % (100 * 86400)));
+            row.currency = random() % 4 ? kDefaultCurrency : MakeCurrency('E', 'U', 'R');
+            sqlite3_bind_int(insert, 1, row.id);
+            sqlite3_bind_text(insert, 2, row.description.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_double(insert, 3, row.amount);
+            sqlite3_bind_text(insert, 4, row.category.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(insert, 5, static_cast<int>(row.type));
+            sqlite3_bind_int64(insert, 6, row.date);
+            sqlite3_bind_text(insert, 7, CurrencyToString(row.currency).c_str(), -1, SQLITE_TRANSIENT);
+            CHECK(sqlite3_step(insert) == SQLITE_DONE);
+            sqlite3_reset(insert);
+            rows.push_back(row);
+        }
+        sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+        sqlite3_finalize(insert);
+        sqlite3_close(db);
+    }
+    
+    TransactionManager manager(file.Path());
+    DatabaseHandler storage(file.Path());
+    CHECK(storage.Initialize());
+    CHECK(manager.GetTransactions().size() == rows.size());
+    
+    for (int round = 0; round < 400; ++round) {
+        TransactionFilter filter = RandomFilter(random, 3);
+        std::vector<Transaction> expected;
+        for (const auto& row : rows) {
+            if (filter.Matches(row)) {
+                expected.push_back(row);
+            }
+        }
+        std::vector<int> expectedIds = Ids(expected);
+        
+        TransactionManager::TransactionList cached = manager.FindTransactions(filter);
+        CHECK(Ids(cached) == expectedIds);
+        for (size_t i = 1; i < cached.size(); ++i) {
+            CHECK(cached[i - 1].date > cached[i].date ||
+                  (cached[i - 1].date == cached[i].date && cached[i - 1].id > cached[i].id));
+        }
+        CHECK(Ids(storage.QueryTransactions(filter)) == expectedIds);
+        
+        // Every match lies within the date bounds the filter reports
+        std::time_t from, to;
+        filter.DateBounds(from, to);
+        for (const auto& row : expected) {
+            CHECK((from == 0 || row.date >= from) && (to == 0 || row.date < to));
+        }
+    }
+    
+    // Operators flatten chains, drop All where they can and cancel double negation
+    TransactionFilter food = TransactionFilter::Category("Food");
+    TransactionFilter rent = TransactionFilter::Text("rent");
+    CHECK((food && TransactionFilter()).GetKind() == TransactionFilter::Kind::Category);
+    CHECK((food || TransactionFilter()).GetKind() == TransactionFilter::Kind::All);
+    CHECK(((food && rent) && food).GetChildren().size() == 3);
+    CHECK((!!food).GetKind() == TransactionFilter::Kind::Category);
+    CHECK(storage.QueryTransactions(!TransactionFilter()).empty());
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+// Copy-on-write snapshots against a plain vector: every edit yields a new
+// version in date DESC, id DESC order as chunks fill, split and empty, and
+// the version it was made from stays exactly as it was.
+#include "Check.h"
+#include "ViewModel/TransactionSnapshot.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+    bool Newer(const Transaction& a, const Transaction& b) {
+        return a.date != b.date ? a.date > b.date : a.id > b.id;
+    }
+    
+    bool Matches(const TransactionSnapshot& snapshot, const std::vector<Transaction>& rows) {
+        if (snapshot.size() != rows.size()) {
+            return false;
+        }
+        size_t row = 0;
+        for (const auto& transaction : snapshot) {
+            if (transaction.id != rows[row].id || transaction.amount != rows[row].amount ||
+                &snapshot[row] != &transaction) {
+                return false;
+            }
+            ++row;
+        }
+        return row == rows.size();
+    }
+    
+    size_t Position(const std::vector<Transaction>& rows, const Transaction& transaction) {
+        return static_cast<size_t>(std::lower_bound(rows.begin(), rows.end(), transaction, Newer) - rows.begin());
+    }
+}
+
+int main() {
+    std::mt19937 random(11);
+    std::vector<Transaction> rows;
+    for (int id = 1; id <= 3000; ++id) {
+        rows.emplace_back(id, "row", id, "Food", TransactionType::Expense,
+                          1700000000 + static_cast<std::time_t>(random() % 400) * 86400);
+    }
+    std::sort(rows.begin(), rows.end(), Newer);
+    
+    TransactionSnapshot::Ptr current = TransactionSnapshot::Create(rows, 1);
+    CHECK(current->GetVersion() == 1);
+    CHECK(Matches(*current, rows));
+    
+    // Keep every tenth version with the rows it had, and check them all at
+    // the end: later edits must not reach into chunks they share
+    std::vector<std::pair<TransactionSnapshot::Ptr, std::vector<Transaction>>> kept;
+    int nextId = 3001;
+    for (int step = 0; step < 3000; ++step) {
+        unsigned kind = random() % 3;
+        TransactionSnapshot::Ptr next;
+        if (kind == 0 || rows.empty()) {
+            // Mostly bunched near the top so chunks there grow and split
+            std::time_t day = random() % 8 == 0 ? random() % 400 : 399;
+            std::time_t date = 1700000000 + day * 86400;
+            Transaction added(nextId++, "added", 1.0, "Food", TransactionType::Income, date);
+            size_t at = Position(rows, added);
+            next = current->WithInserted(at, added);
+            rows.insert(rows.begin() + static_cast<std::ptrdiff_t>(at), added);
+        } else if (kind == 1) {
+            size_t at = random() % rows.size();
+            Transaction changed = rows[at];
+            changed.amount += 0.5;
+            next = current->WithReplaced(at, changed);
+            rows[at] = changed;
+        } else {
+            size_t at = random() % rows.size();
+            next = current->WithErased(at);
+            rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(at));
+        }
+        CHECK(next->GetVersion() == current->GetVersion() + 1);
+        current = next;
+        if (step % 10 == 0) {
+            kept.emplace_back(current, rows);
+        }
+    }
+    CHECK(Matches(*current, rows));
+    for (const auto& version : kept) {
+        CHECK(Matches(*version.first, version.second));
+    }
+    
+    // Positions by (date, id) and by date
+    for (int probe = 0; probe < 200; ++probe) {
+        const Transaction& target = rows[random() % rows.size()];
+        size_t at = current->LowerBound(target.date, target.id);
+        CHECK(at == Position(rows, target));
+        CHECK((*current)[at].id == target.id);
+        CHECK(current->IteratorAt(at)->id == target.id);
+        
+        size_t before = current->FirstBefore(target.date);
+        CHECK(before > at);
+        CHECK(before == rows.size() || rows[before].date < target.date);
+        CHECK(rows[before - 1].date >= target.date);
+    }
+    CHECK(current->LowerBound(0, 0) == rows.size());
+    CHECK(current->IteratorAt(rows.size()) == current->end());
+    
+    // Emptying a snapshot and starting again
+    TransactionSnapshot::Ptr empty = TransactionSnapshot::Create({}, 7);
+    CHECK(empty->empty() && empty->begin() == empty->end());
+    Transaction only(1, "only", 1.0, "Food", TransactionType::Expense, 1700000000);
+    TransactionSnapshot::Ptr one = empty->WithInserted(0, only);
+    CHECK(one->size() == 1 && (*one)[0].id == 1 && empty->empty());
+    CHECK(one->WithErased(0)->empty());
+    CHECK(one->size() == 1);
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+// The radix sorter against std::stable_sort with an ordinary comparator,
+// for single and multi-key sorts in both directions, and across snapshot
+// versions so stale cached keys would show.
+#include "Check.h"
+#include "ViewModel/TransactionSorter.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <random>
+
+namespace {
+    std::string Folded(const std::string& text) {
+        std::string folded = text;
+        for (char& c : folded) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return folded;
+    }
+    
+    // -1, 0 or 1 for a against b on one column, ascending
+    int Compare(const Transaction& a, const Transaction& b, SortColumn column) {
+        auto order = [](auto x, auto y) { return x < y ? -1 : (y < x ? 1 : 0); };
+        switch (column) {
+            case SortColumn::Id:
+                return order(a.id, b.id);
+            case SortColumn::Date:
+                return order(a.date, b.date);
+            case SortColumn::Description:
+                return order(Folded(a.description), Folded(b.description));
+            case SortColumn::Category:
+                return order(Folded(a.category), Folded(b.category));
+            case SortColumn::Type:
+                return order(static_cast<int>(a.type), static_cast<int>(b.type));
+            case SortColumn::Amount:
+                return order(std::llround(a.amount * 100.0), std::llround(b.amount * 100.0));
+        }
+        return 0;
+    }
+    
+    std::vector<std::uint32_t> Expected(const TransactionSnapshot& rows, const std::vector<SortKey>& keys) {
+        std::vector<std::uint32_t> order(rows.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = static_cast<std::uint32_t>(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            for (const auto& key : keys) {
+                int result = Compare(rows[a], rows[b], key.column);
+                if (result != 0) {
+                    return key.ascending ? result < 0 : result > 0;
+                }
+            }
+            return false;
+        });
+        return order;
+    }
+    
+    std::vector<Transaction> RandomRows(size_t count, std::mt19937& random) {
+        const char* descriptions[] = {"Coffee", "coffee", "Rent", "rent payment", "Zoo", "apple", "", "Bank fee"};
+        const char* categories[] = {"Food", "food", "Housing", "Fees", "Other"};
+        std::vector<Transaction> rows;
+        for (size_t i = 0; i < count; ++i) {
+            // Negative ids and dates before 1970 exercise the sign flip
+            int id = static_cast<int>(random() % 200000) - 100000;
+            std::time_t date = static_cast<std::time_t>(random() % 40) * 86400 - 10 * 86400;
+            rows.emplace_back(id, descriptions[random() % 8], (random() % 100000) / 100.0, categories[random() % 5],
+                              random() % 2 ? TransactionType::Expense : TransactionType::Income, date);
+        }
+        return rows;
+    }
+}
+
+int main() {
+    std::mt19937 random(5);
+    const std::vector<std::vector<SortKey>> sorts = {
+        {{SortColumn::Date, false}},
+        {{SortColumn::Id, true}},
+        {{SortColumn::Amount, false}},
+        {{SortColumn::Description, true}},
+        {{SortColumn::Category, true}, {SortColumn::Date, false}},
+        {{SortColumn::Type, true}, {SortColumn::Amount, true}, {SortColumn::Id, false}},
+        {{SortColumn::Description, false}, {SortColumn::Category, false}, {SortColumn::Date, true}},
+        {},
+    };
+    
+    TransactionSorter sorter;
+    TransactionSnapshot::Ptr rows = TransactionSnapshot::Create(RandomRows(5000, random), 1);
+    for (const auto& keys : sorts) {
+        CHECK(sorter.Sort(*rows, keys) == Expected(*rows, keys));
+    }
+    
+    // A new version with changed rows must not reuse the old keys
+    for (int i = 0; i < 200; ++i) {
+        size_t at = random() % rows->size();
+        Transaction changed = (*rows)[at];
+        changed.amount = (random() % 100000) / 100.0;
+        changed.description = random() % 2 ? "aardvark" : "ZZZ";
+        rows = rows->WithReplaced(at, changed);
+    }
+    for (const auto& keys : sorts) {
+        CHECK(sorter.Sort(*rows, keys) == Expected(*rows, keys));
+    }
+    
+    // Large enough to split the counting and scatter passes across threads
+    TransactionSnapshot::Ptr large = TransactionSnapshot::Create(RandomRows(70000, random), 1);
+    for (const auto& keys : {sorts[0], sorts[4], sorts[5]}) {
+        CHECK(sorter.Sort(*large, keys) == Expected(*large, keys));
+    }
+    
+    // Nothing and one row
+    TransactionSnapshot::Ptr none = TransactionSnapshot::Create({}, 1);
+    CHECK(sorter.Sort(*none, sorts[0]).empty());
+    TransactionSnapshot::Ptr one = TransactionSnapshot::Create(RandomRows(1, random), 9);
+    CHECK(sorter.Sort(*one, sorts[5]) == std::vector<std::uint32_t>{0});
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Substring search from the trigram index against a linear scan of the
+// same descriptions, before and after adds, edits and removals, for
+// queries shorter than a gram and ones whose grams all match but not in
+// sequence.
+#include "Check.h"
+#include "ViewModel/TrigramIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <random>
+
+namespace {
+    std::string Folded(const std::string& text) {
+        std::string folded = text;
+        for (char& c : folded) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return folded;
+    }
+    
+    std::vector<int> Scan(const std::map<int, std::string>& texts, const std::string& query) {
+        std::vector<int> ids;
+        for (const auto& entry : texts) {
+            if (Folded(entry.second).find(Folded(query)) != std::string::npos) {
+                ids.push_back(entry.first);
+            }
+        }
+        return ids;
+    }
+    
+    std::string RandomText(std::mt19937& random) {
+        const char* words[] = {"Coffee", "SHOP", "rent", "Bank", "fee", "cof", "ee", "abab", "ba", "Grocery", "Café"};
+        std::string text;
+        for (unsigned count = random() % 4; count > 0; --count) {
+            text += words[random() % 11];
+            text += random() % 2 ? " " : "";
+        }
+        return text;
+    }
+    
+    const std::vector<std::string> kQueries = {
+        "", "c", "ee", "COF", "coffee", "offee s", "bab", "abab", "ababab", "bank fee", "shoprent", "é", "caf",
+        "zzz", "ee ee", "Grocery Coffee",
+    };
+    
+    void CheckAgainstScan(const TrigramIndex& index, const std::map<int, std::string>& texts) {
+        CHECK(index.Size() == texts.size());
+        for (const auto& query : kQueries) {
+            CHECK(index.Search(query) == Scan(texts, query));
+        }
+    }
+}
+
+int main() {
+    std::mt19937 random(3);
+    std::vector<Transaction> rows;
+    std::map<int, std::string> texts;
+    for (int id = 2000; id >= 1; --id) {
+        rows.emplace_back(id, RandomText(random), 1.0, "Food", TransactionType::Expense, 1700000000);
+        texts[id] = rows.back().description;
+    }
+    
+    TrigramIndex index;
+    index.Build(rows);
+    CheckAgainstScan(index, texts);
+    
+    // Keep it current without a rebuild
+    for (int i = 0; i < 500; ++i) {
+        int id = 1 + static_cast<int>(random() % 2500);
+        if (random() % 3 == 0) {
+            index.Remove(id);
+            texts.erase(id);
+        } else {
+            std::string text = RandomText(random);
+            if (random() % 2) {
+                index.Update(id, text);
+            } else {
+                index.Add(id, text);  // Adding an id again replaces its text
+            }
+            texts[id] = text;
+        }
+    }
+    CheckAgainstScan(index, texts);
+    index.Remove(100000);
+    index.Remove(-1);
+    CHECK(index.Size() == texts.size());
+    
+    // Ids far apart cost no more than ids close together
+    index.Add(std::numeric_limits<int>::max(), "Coffee far away");
+    texts[std::numeric_limits<int>::max()] = "Coffee far away";
+    CheckAgainstScan(index, texts);
+    
+    // Refine narrows an earlier result as the query grows
+    std::vector<int> previous = index.Search("co");
+    for (const char* query : {"cof", "coff", "coffee", "coffee shop"}) {
+        std::vector<int> refined = index.Refine(previous, query);
+        CHECK(refined == Scan(texts, query));
+        previous = refined;
+    }
+    
+    index.Clear();
+    CHECK(index.Size() == 0);
+    CHECK(index.Search("coffee").empty());
+    CHECK(index.Search("").empty());
+    
+    return test::Result();
+}
\ No newline at end of file
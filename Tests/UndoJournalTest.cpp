@@ -0,0 +1,166 @@
+// Undo and redo through the manager: a random run of adds, edits, deletes,
+// imports and reconciles is undone step by step back to an empty ledger and
+// redone to the end, and every state must equal the one recorded when it was
+// first reached, in the cache and after a reopen. Also labels, tags brought
+// back with a deleted row, redo dropped by a new step, and the step limit.
+#include "Check.h"
+#include "ViewModel/TransactionManager.h"
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <tuple>
+
+namespace {
+    using Row = std::tuple<int, std::string, double, std::string, int, std::time_t, CurrencyCode, bool>;
+    
+    std::vector<Row> State(const TransactionManager& manager) {
+        std::vector<Row> rows;
+        for (const auto& row : manager.GetTransactions()) {
+            rows.emplace_back(row.id, row.description, row.amount, row.category, static_cast<int>(row.type), row.date,
+                              row.currency, row.reconciled);
+        }
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+    
+    std::vector<int> Ids(const TransactionManager& manager) {
+        std::vector<int> ids;
+        for (const auto& row : manager.GetTransactions()) {
+            ids.push_back(row.id);
+        }
+        return ids;
+    }
+}
+
+int main() {
+    test::ScratchFile file("UndoJournalTest");
+    const std::string statementPath = "UndoJournalTest.statement.csv";
+    const std::time_t base = 1700000000;
+    std::mt19937 random(47);
+    
+    std::vector<std::vector<Row>> states;  // states[k] is the ledger after k steps
+    std::vector<std::string> labels;       // labels[k] undoes step k + 1
+    {
+        TransactionManager manager(file.Path());
+        CHECK(!manager.CanUndo() && !manager.CanRedo() && !manager.Undo() && !manager.Redo());
+        CHECK(manager.GetUndoLabel().empty() && manager.GetRedoLabel().empty());
+        states.push_back(State(manager));
+        
+        int imports = 0;
+        for (int step = 0; step < 40; ++step) {
+            std::vector<int> ids = Ids(manager);
+            int id = ids.empty() ? 0 : ids[random() % ids.size()];
+            std::string description = "Row " + std::to_string(step);
+            std::time_t date = base + static_cast<std::time_t>(random() % 60) * 86400;
+            double amount = 1 + random() % 500;
+            unsigned kind = ids.size() < 3 ? 0 : random() % 5;
+            if (kind == 0) {
+                CHECK(manager.AddTransaction(description, amount, "Food", TransactionType::Expense, kDefaultCurrency, date));
+                labels.push_back("Add");
+            } else if (kind == 1) {
+                CHECK(manager.UpdateTransaction(id, description, amount, "Travel", TransactionType::Income,
+                                                MakeCurrency('E', 'U', 'R'), date));
+                labels.push_back("Edit");
+            } else if (kind == 2) {
+                CHECK(manager.DeleteTransaction(id));
+                labels.push_back("Delete");
+            } else if (kind == 3) {
+                std::ofstream statement(statementPath, std::ios::trunc);
+                statement << "Date,Description,Amount\n";
+                for (int line = 0; line < 5; ++line) {
+                    statement << "2024-01-1" << line << ",Import " << imports << '-' << line << ",-" << (line + 1)
+                              << ".25\n";
+                }
+                statement.close();
+                ++imports;
+                ImportReport report;
+                CHECK(manager.ImportStatement(statementPath, report));
+                CHECK(report.rowsImported == 5);
+                labels.push_back("Import");
+            } else {
+                std::vector<int> some(ids.begin(), ids.begin() + static_cast<std::ptrdiff_t>(1 + random() % ids.size()));
+                bool reconciled = random() % 2 == 0;
+                CHECK(manager.SetReconciled(some, reconciled));
+                if (State(manager) == states.back()) {
+                    continue;  // Nothing flipped, so nothing was journaled
+                }
+                labels.push_back(reconciled ? "Reconcile" : "Unreconcile");
+            }
+            states.push_back(State(manager));
+            CHECK(manager.GetUndoLabel() == labels.back() && !manager.CanRedo());
+        }
+        std::remove(statementPath.c_str());
+        CHECK(labels.size() + 1 == states.size());
+        
+        // Back to the start, one step at a time, then half way forward again
+        for (size_t step = labels.size(); step > 0; --step) {
+            CHECK(manager.GetUndoLabel() == labels[step - 1]);
+            CHECK(manager.Undo());
+            CHECK(State(manager) == states[step - 1]);
+            CHECK(manager.GetRedoLabel() == labels[step - 1]);
+        }
+        CHECK(!manager.CanUndo() && !manager.Undo());
+        for (size_t step = 1; step <= labels.size() / 2; ++step) {
+            CHECK(manager.Redo());
+            CHECK(State(manager) == states[step]);
+        }
+    }
+    
+    // The journal lives in the ledger, so a reopen picks up where it left off
+    {
+        TransactionManager manager(file.Path());
+        size_t step = labels.size() / 2;
+        CHECK(State(manager) == states[step]);
+        CHECK(manager.GetUndoLabel() == labels[step - 1] && manager.GetRedoLabel() == labels[step]);
+        for (; step < labels.size(); ++step) {
+            CHECK(manager.Redo());
+            CHECK(State(manager) == states[step + 1]);
+        }
+        CHECK(!manager.CanRedo() && !manager.Redo());
+        
+        // A new step drops what was undone
+        CHECK(manager.Undo() && manager.Undo());
+        CHECK(manager.AddTransaction("Fresh", 9.0, "Food", TransactionType::Expense, kDefaultCurrency, base));
+        CHECK(!manager.CanRedo() && manager.GetUndoLabel() == "Add");
+        CHECK(manager.Undo());
+        CHECK(State(manager) == states[labels.size() - 2]);
+    }
+    {
+        TransactionManager manager(file.Path());
+        CHECK(State(manager) == states[labels.size() - 2]);
+        CHECK(manager.GetRedoLabel() == "Add");
+    }
+    
+    // A deleted row comes back with its tags
+    {
+        TransactionManager manager(file.Path());
+        int id = 0;
+        CHECK(manager.AddTransaction("Tagged", 12.0, "Food", TransactionType::Expense, kDefaultCurrency, base, &id));
+        CHECK(manager.AddTag(id, "trip") && manager.AddTag(id, "work"));
+        CHECK(manager.DeleteTransaction(id));
+        CHECK(manager.GetTags(id).empty());
+        CHECK(manager.Undo());
+        CHECK((manager.GetTags(id) == std::vector<std::string>{"trip", "work"}));
+        CHECK(manager.Redo());
+        CHECK(manager.GetTags(id).empty());
+        CHECK(manager.Undo());
+    }
+    {
+        TransactionManager manager(file.Path());
+        CHECK(manager.GetTags().size() == 2);
+        
+        // Only the newest steps are kept
+        for (int i = 0; i < 120; ++i) {
+            CHECK(manager.AddTransaction("Many " + std::to_string(i), 1.0, "Food", TransactionType::Expense,
+                                         kDefaultCurrency, base));
+        }
+        size_t undone = 0;
+        while (manager.Undo()) {
+            ++undone;
+        }
+        CHECK(undone == 100);
+        CHECK(manager.GetTransactions().size() == states[labels.size() - 2].size() + 1 + 20);
+    }
+    
+    return test::Result();
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+// Accuracy and throughput benchmark for the transaction categorizer.
+//
+// Usage: CategorizerBenchmark [ledger.db] [synthetic-rows]
+//
+// With a ledger, its own description/category pairs are used; otherwise a
+// synthetic ledger is generated. Every fifth row is held out for testing.
+#include "Database/DatabaseHandler.h"
+#include "ViewModel/Categorizer.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    
+    double Seconds(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    
+    std::vector<Transaction> SyntheticLedger(size_t rows) {
+        struct Merchant {
+            const char* name;
+            const char* category;
+        };
+        static const Merchant merchants[] = {
+            {"Whole Foods Market", "Food"}, {"Trader Joes", "Food"}, {"Starbucks Coffee", "Food"},
+            {"Chipotle Mexican Grill", "Food"}, {"Uber Trip", "Transportation"}, {"Shell Oil", "Transportation"},
+            {"Metro Transit Pass", "Transportation"}, {"Netflix Subscription", "Entertainment"},
+            {"AMC Theatres", "Entertainment"}, {"Spotify Premium", "Entertainment"}, {"City Water Utility", "Utilities"},
+            {"Pacific Gas Electric", "Utilities"}, {"Comcast Internet", "Utilities"}, {"CVS Pharmacy", "Healthcare"},
+            {"Dental Care Associates", "Healthcare"}, {"Amazon Marketplace", "Shopping"}, {"Target Store", "Shopping"},
+            {"Best Buy Electronics", "Shopping"}, {"ACME Corp Payroll", "Salary"}, {"Direct Deposit Salary", "Salary"},
+            {"Vanguard Dividend", "Investment"}, {"Brokerage Interest", "Investment"}, {"Misc Transfer", "Other"}
+        };
+        static const char* noise[] = {"POS", "DEBIT", "CARD", "PURCHASE", "ONLINE", "REF", "ACH"};
+        
+        std::mt19937 random(42);
+        std::vector<Transaction> ledger;
+        ledger.reserve(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            const Merchant& merchant = merchants[random() % (sizeof(merchants) / sizeof(merchants[0]))];
+            std::string description = std::string(noise[random() % 7]) + " " + merchant.name + " #" +
+                                      std::to_string(random() % 100000);
+            ledger.emplace_back(static_cast<int>(i + 1), description, 1.0, merchant.category, TransactionType::Expense);
+        }
+        return ledger;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<Transaction> ledger;
+    if (argc > 1) {
+        DatabaseHandler database(argv[1]);
+        if (!database.Initialize()) {
+            return 1;
+        }
+        ledger = database.GetAllTransactions();
+    }
+    if (ledger.empty()) {
+        size_t rows = argc > 2 ? std::stoul(argv[2]) : 200000;
+        ledger = SyntheticLedger(rows);
+        std::cout << "Using synthetic ledger of " << rows << " rows" << std::endl;
+    }
+    
+    std::vector<Transaction> training;
+    std::vector<Transaction> testing;
+    for (size_t i = 0; i < ledger.size(); ++i) {
+        (i % 5 == 4 ? testing : training).push_back(ledger[i]);
+    }
+    
+    Categorizer categorizer;
+    auto start = Clock::now();
+    categorizer.Build(training);
+    double buildSeconds = Seconds(start);
+    
+    std::vector<std::string> descriptions;
+    for (const auto& transaction : testing) {
+        descriptions.push_back(transaction.description);
+    }
+    
+    // Accuracy on held-out rows
+    std::vector<CategoryPrediction> predictions = categorizer.ClassifyBatch(descriptions);
+    size_t correct = 0;
+    for (size_t i = 0; i < testing.size(); ++i) {
+        if (predictions[i].category == testing[i].category) {
+            ++correct;
+        }
+    }
+    
+    // Throughput: repeat the test set until the batch has at least 200k rows
+    std::vector<std::string> batch;
+    while (!descriptions.empty() && batch.size() < 200000) {
+        batch.insert(batch.end(), descriptions.begin(), descriptions.end());
+    }
+    
+    start = Clock::now();
+    categorizer.ClassifyBatch(batch);
+    double batchSeconds = Seconds(start);
+    
+    start = Clock::now();
+    for (const auto& description : batch) {
+        categorizer.Classify(description);
+    }
+    double serialSeconds = Seconds(start);
+    
+    // Incremental updates, as issued on every edit: untrain + train
+    start = Clock::now();
+    for (const auto& transaction : testing) {
+        categorizer.Untrain(transaction.description, transaction.category);
+        categorizer.Train(transaction.description, transaction.category);
+    }
+    double updateSeconds = Seconds(start);
+    
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Categories:            " << categorizer.GetCategoryCount() << std::endl;
+    std::cout << "Training rows:         " << training.size() << " in " << buildSeconds * 1000.0 << " ms" << std::endl;
+    std::cout << "Held-out accuracy:     " << (testing.empty() ? 0.0 : 100.0 * correct / testing.size())
+              << "% (" << correct << "/" << testing.size() << ")" << std::endl;
+    std::cout << std::setprecision(0);
+    std::cout << "Batch throughput:      " << batch.size() / batchSeconds << " descriptions/s" << std::endl;
+    std::cout << "Serial throughput:     " << batch.size() / serialSeconds << " descriptions/s" << std::endl;
+    std::cout << "Incremental updates:   " << testing.size() / updateSeconds << " edits/s" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+// Parse and insert throughput benchmark for the statement importer.
+//
+// Usage: ImportBenchmark [synthetic-rows] [statement-file]
+//
+// Generates synthetic CSV and OFX statements (or uses the given file), then
+// times parsing alone, parsing plus batched inserts into an in-memory
+// database, and a re-import that checks every row for a duplicate.
+#include "Database/DatabaseHandler.h"
+#include "Import/MappedFile.h"
+#include "Import/StatementParser.h"
+#include "ViewModel/DuplicateIndex.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+    const char* const kMerchants[] = {
+        "Whole Foods Market", "Starbucks Coffee", "Uber Trip", "Shell Oil", "Netflix Subscription",
+        "City Water Utility", "CVS Pharmacy", "Amazon Marketplace", "ACME Corp Payroll", "Vanguard Dividend"
+    };
+    
+    void WriteCsv(const std::string& path, size_t rows) {
+        std::mt19937 random(7);
+        std::ofstream out(path, std::ios::binary);
+        out << "Date,Description,Amount,Balance\n";
+        for (size_t i = 0; i < rows; ++i) {
+            int day = static_cast<int>(i * 28 / rows) + 1;
+            long cents = static_cast<long>(random() % 200000) - 150000;
+            out << "2024-03-" << std::setw(2) << std::setfill('0') << day << ",\"POS "
+                << kMerchants[random() % 10] << " #" << random() % 100000 << "\"," << (cents < 0 ? "-" : "")
+                << std::labs(cents) / 100 << '.' << std::setw(2) << std::labs(cents) % 100 << ",0.00\n";
+        }
+    }
+    
+    void WriteOfx(const std::string& path, size_t rows) {
+        std::mt19937 random(7);
+        std::ofstream out(path, std::ios::binary);
+        out << "OFXHEADER:100\nDATA:OFXSGML\n\n<OFX><BANKMSGSRSV1><STMTTRNRS><STMTRS><BANKTRANLIST>\n";
+        for (size_t i = 0; i < rows; ++i) {
+            int day = static_cast<int>(i * 28 / rows) + 1;
+            long cents = static_cast<long>(random() % 200000) - 150000;
+            out << "<STMTTRN>\n<TRNTYPE>" << (cents < 0 ? "DEBIT" : "CREDIT") << "\n<DTPOSTED>202403"
+                << std::setw(2) << std::setfill('0') << day << "120000\n<TRNAMT>" << (cents < 0 ? "-" : "")
+                << std::labs(cents) / 100 << '.' << std::setw(2) << std::labs(cents) % 100 << "\n<FITID>" << i
+                << "\n<NAME>" << kMerchants[random() % 10] << "\n</STMTTRN>\n";
+        }
+        out << "</BANKTRANLIST></STMTRS></STMTTRNRS></BANKMSGSRSV1></OFX>\n";
+    }
+    
+    void Run(const std::string& path) {
+        MappedFile file;
+        if (!file.Open(path)) {
+            std::cerr << file.GetError() << std::endl;
+            return;
+        }
+        StatementFormat format = StatementParser::DetectFormat(path, file.GetData(), file.GetSize());
+        double megabytes = static_cast<double>(file.GetSize()) / (1024.0 * 1024.0);
+        
+        StatementParser parser;
+        ImportReport parseReport;
+        size_t seen = 0;
+        parser.Parse(file.GetData(), file.GetSize(), format, [&](std::vector<Transaction>& rows) {
+            seen += rows.size();
+            return true;
+        }, parseReport);
+        
+        DatabaseHandler database(":memory:");
+        database.Initialize();
+        ImportReport insertReport;
+        parser.Parse(file.GetData(), file.GetSize(), format, [&](std::vector<Transaction>& rows) {
+            return database.AddTransactions(rows);
+        }, insertReport);
+        
+        // Re-importing the same file should find every row already stored
+        DuplicateIndex duplicates;
+        DuplicateIndex::Batch backfill(duplicates);
+        std::vector<Transaction> stored = database.GetAllTransactions();
+        for (auto it = stored.rbegin(); it != stored.rend(); ++it) {
+            backfill.IsDuplicate(*it);
+        }
+        duplicates.Build(stored);
+        
+        ImportReport dedupReport;
+        DuplicateIndex::Batch batch(duplicates);
+        size_t duplicateRows = 0;
+        parser.Parse(file.GetData(), file.GetSize(), format, [&](std::vector<Transaction>& rows) {
+            for (auto& row : rows) {
+                duplicateRows += batch.IsDuplicate(row) ? 1 : 0;
+            }
+            return true;
+        }, dedupReport);
+        
+        std::cout << path << " (" << (format == StatementFormat::Ofx ? "OFX" : "CSV") << ", " << std::fixed
+                  << std::setprecision(1) << megabytes << " MB)\n"
+                  << "  rows parsed:     " << seen << " (" << parseReport.rowsRejected << " rejected)\n"
+                  << "  parse only:      " << std::setprecision(0) << seen / parseReport.seconds << " rows/s, "
+                  << std::setprecision(1) << megabytes / parseReport.seconds << " MB/s\n"
+                  << "  parse + insert:  " << std::setprecision(0) << seen / insertReport.seconds << " rows/s\n"
+                  << "  parse + dedup:   " << seen / dedupReport.seconds << " rows/s, " << duplicateRows
+                  << " duplicates found" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    if (argc > 2) {
+        Run(argv[2]);
+        return 0;
+    }
+    
+    const std::string csvPath = "import_benchmark.csv";
+    const std::string ofxPath = "import_benchmark.ofx";
+    WriteCsv(csvPath, rows);
+    WriteOfx(ofxPath, rows);
+    Run(csvPath);
+    Run(ofxPath);
+    std::remove(csvPath.c_str());
+    std::remove(ofxPath.c_str());
+    return 0;
+}
\ No newline at end of file
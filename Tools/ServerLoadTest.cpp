@@ -0,0 +1,193 @@
+// Load generator for the headless query server.
+//
+// Usage: ServerLoadTest [socket-path] [connections] [seconds] [write-percent]
+//
+// Each connection runs a closed loop: send one request, wait for its answer,
+// send the next. The mix is paged lists, searches and totals, plus the given
+// share of writes (alternately adding a row and deleting the one it added,
+// so the ledger ends as it started). Reports throughput and latency
+// percentiles over all requests.
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    
+    const char* const kSearchTerms[] = { "coffee", "uber", "rent", "market", "payroll", "netflix", "shell", "pharmacy" };
+    
+    struct ClientStats {
+        std::vector<double> latencies;  // Microseconds
+        size_t errors = 0;
+        bool connected = false;
+    };
+    
+    int Connect(const std::string& path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+    
+    bool SendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t written = write(fd, data.data() + sent, data.size() - sent);
+            if (written <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(written);
+        }
+        return true;
+    }
+    
+    // Reads one response line; buffer keeps whatever arrived past it
+    bool ReceiveLine(int fd, std::string& buffer, std::string& line) {
+        size_t newline;
+        while ((newline = buffer.find('\n')) == std::string::npos) {
+            char chunk[16 * 1024];
+            ssize_t received = read(fd, chunk, sizeof(chunk));
+            if (received <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+        line.assign(buffer, 0, newline);
+        buffer.erase(0, newline + 1);
+        return true;
+    }
+    
+    // Pulls the number after "id": in an add result; enough for this client
+    long ResultId(const std::string& line) {
+        size_t result = line.find("\"result\"");
+        size_t id = result == std::string::npos ? std::string::npos : line.find("\"id\":", result);
+        return id == std::string::npos ? 0 : std::strtol(line.c_str() + id + 5, nullptr, 10);
+    }
+    
+    void RunClient(const std::string& path, unsigned seed, int writePercent, Clock::time_point deadline,
+                   ClientStats& stats) {
+        int fd = Connect(path);
+        if (fd < 0) {
+            return;
+        }
+        stats.connected = true;
+        
+        std::mt19937 random(seed);
+        std::string buffer;
+        std::string line;
+        long addedId = 0;
+        long next = 0;
+        
+        while (Clock::now() < deadline) {
+            std::string request = "{\"id\":" + std::to_string(++next) + ",";
+            int roll = static_cast<int>(random() % 100);
+            bool adding = false;
+            if (roll < writePercent) {
+                if (addedId > 0) {
+                    request += "\"method\":\"delete\",\"params\":{\"id\":" + std::to_string(addedId) + "}}\n";
+                    addedId = 0;
+                } else {
+                    request += "\"method\":\"add\",\"params\":{\"description\":\"Load test\",\"amount\":1.25,"
+                               "\"category\":\"Other\",\"type\":\"expense\"}}\n";
+                    adding = true;
+                }
+            } else if (roll < writePercent + (100 - writePercent) / 2) {
+                request += "\"method\":\"list\",\"params\":{\"offset\":" + std::to_string(random() % 2000) +
+                           ",\"limit\":50}}\n";
+            } else if (roll % 4 == 0) {
+                request += "\"method\":\"totals\"}\n";
+            } else {
+                request += "\"method\":\"search\",\"params\":{\"text\":\"" + std::string(kSearchTerms[random() % 8]) +
+                           "\",\"limit\":20}}\n";
+            }
+            
+            Clock::time_point sentAt = Clock::now();
+            if (!SendAll(fd, request) || !ReceiveLine(fd, buffer, line)) {
+                ++stats.errors;
+                break;
+            }
+            stats.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sentAt).count());
+            
+            if (line.find("\"error\"") != std::string::npos) {
+                ++stats.errors;
+            } else if (adding) {
+                addedId = ResultId(line);
+            }
+        }
+        
+        // Leave the ledger as it was found
+        if (addedId > 0) {
+            SendAll(fd, "{\"id\":0,\"method\":\"delete\",\"params\":{\"id\":" + std::to_string(addedId) + "}}\n");
+            ReceiveLine(fd, buffer, line);
+        }
+        close(fd);
+    }
+    
+    double Percentile(const std::vector<double>& sorted, double fraction) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "finance_tracker.sock";
+    size_t connections = argc > 2 ? std::stoul(argv[2]) : 8;
+    double seconds = argc > 3 ? std::stod(argv[3]) : 5.0;
+    int writePercent = argc > 4 ? std::clamp(std::stoi(argv[4]), 0, 100) : 10;
+    
+    std::vector<ClientStats> stats(connections);
+    std::vector<std::thread> clients;
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    for (size_t i = 0; i < connections; ++i) {
+        clients.emplace_back(RunClient, path, static_cast<unsigned>(i + 1), writePercent, deadline, std::ref(stats[i]));
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    
+    std::vector<double> latencies;
+    size_t errors = 0;
+    size_t connected = 0;
+    for (const auto& client : stats) {
+        latencies.insert(latencies.end(), client.latencies.begin(), client.latencies.end());
+        errors += client.errors;
+        connected += client.connected ? 1 : 0;
+    }
+    if (connected == 0) {
+        std::cerr << "Cannot connect to " << path << std::endl;
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    
+    std::cout << connected << " connections, " << writePercent << "% writes, " << std::fixed << std::setprecision(1)
+              << elapsed << " s\n"
+              << "  requests:    " << latencies.size() << " (" << errors << " errors)\n"
+              << "  throughput:  " << std::setprecision(0) << latencies.size() / elapsed << " req/s\n"
+              << "  latency us:  p50 " << Percentile(latencies, 0.50) << ", p90 " << Percentile(latencies, 0.90)
+              << ", p99 " << Percentile(latencies, 0.99) << ", p99.9 " << Percentile(latencies, 0.999) << ", max "
+              << (latencies.empty() ? 0.0 : latencies.back()) << std::endl;
+    return errors == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,301 @@
+#include "ChartPanel.h"
+#include "Palette.h"
+#include "../Model/Calendar.h"
+#include <wx/dcbuffer.h>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace {
+    const int kAxisWidth = 96;    // Money labels left of the plot
+    const int kMargin = 8;
+    const int kDateAxisHeight = 20;
+    const double kMinDaysPerPixel = 1.0 / 48.0;  // Zoomed in: a day is 48 pixels wide
+    const wxColour kExpenseRed(231, 76, 60);
+    
+    std::int32_t MonthOfDay(double day) {
+        int year, month, dayOfMonth;
+        CivilFromDays(static_cast<std::int32_t>(std::floor(day)), year, month, dayOfMonth);
+        return MonthIndex(year, month);
+    }
+    
+    std::int32_t MonthStartDay(std::int32_t month) {
+        std::int32_t year = month >= 0 ? month / 12 : (month - 11) / 12;
+        return DaysFromCivil(1970 + year, static_cast<int>(month - year * 12) + 1, 1);
+    }
+    
+    std::int32_t Today() {
+        DayCursor dayOf;
+        return dayOf(std::time(nullptr));
+    }
+}
+
+wxBEGIN_EVENT_TABLE(ChartPanel, wxPanel)
+    EVT_PAINT(ChartPanel::OnPaint)
+    EVT_SIZE(ChartPanel::OnSize)
+    EVT_MOUSEWHEEL(ChartPanel::OnMouseWheel)
+    EVT_LEFT_DOWN(ChartPanel::OnLeftDown)
+    EVT_LEFT_UP(ChartPanel::OnLeftUp)
+    EVT_MOTION(ChartPanel::OnMotion)
+    EVT_LEFT_DCLICK(ChartPanel::OnDoubleClick)
+    EVT_MOUSE_CAPTURE_LOST(ChartPanel::OnCaptureLost)
+wxEND_EVENT_TABLE()
+
+ChartPanel::ChartPanel(wxWindow* parent, wxWindowID id, TransactionManager& manager)
+    : wxPanel(parent, id, wxDefaultPosition, wxDefaultSize, wxFULL_REPAINT_ON_RESIZE)
+    , manager_(&manager)
+    , firstDay_(0.0)
+    , daysPerPixel_(1.0)
+    , fitted_(false)
+    , dragging_(false)
+    , dragX_(0) {
+    
+    // Painted in full every time; a buffered DC keeps panning flicker-free
+    SetBackgroundStyle(wxBG_STYLE_PAINT);
+    SetMinSize(wxSize(-1, 220));
+    SetToolTip("Scroll to zoom, drag to pan, double-click to see everything");
+}
+
+void ChartPanel::RefreshData() {
+    series_ = manager_->GetChartSeries();
+    Refresh();
+}
+
+void ChartPanel::SetManager(TransactionManager& manager) {
+    manager_ = &manager;
+    series_.reset();
+    fitted_ = false;
+}
+
+void ChartPanel::FitAll() {
+    int width = PlotWidth();
+    if (width <= 0) {
+        return;
+    }
+    
+    double first = Today() - 30;
+    double last = Today() + 1;
+    if (series_ && !series_->Empty()) {
+        first = series_->GetFirstDay();
+        last = series_->GetLastDay() + 1;
+    }
+    daysPerPixel_ = std::max((last - first) / width, kMinDaysPerPixel);
+    firstDay_ = first;
+    fitted_ = true;
+}
+
+void ChartPanel::ZoomAt(int x, double factor) {
+    // Keep the day under the pointer where it is
+    double offset = std::min(std::max(x - kAxisWidth, 0), PlotWidth());
+    double anchor = firstDay_ + offset * daysPerPixel_;
+    
+    double maxDaysPerPixel = 1.0;
+    if (series_ && !series_->Empty() && PlotWidth() > 0) {
+        maxDaysPerPixel = 4.0 * (series_->GetLastDay() - series_->GetFirstDay() + 1) / PlotWidth();
+    }
+    daysPerPixel_ = std::min(std::max(daysPerPixel_ * factor, kMinDaysPerPixel), std::max(maxDaysPerPixel, 1.0));
+    firstDay_ = anchor - offset * daysPerPixel_;
+}
+
+int ChartPanel::PlotWidth() const {
+    return GetClientSize().GetWidth() - kAxisWidth - kMargin;
+}
+
+void ChartPanel::OnPaint(wxPaintEvent& event) {
+    wxAutoBufferedPaintDC dc(this);
+    dc.SetBackground(wxBrush(PURE_WHITE));
+    dc.Clear();
+    
+    if (!series_) {
+        series_ = manager_->GetChartSeries();
+    }
+    if (!fitted_) {
+        FitAll();
+    }
+    
+    wxSize size = GetClientSize();
+    int width = PlotWidth();
+    int height = size.GetHeight() - 2 * kMargin - kDateAxisHeight;
+    if (width <= 0 || height <= 40) {
+        return;
+    }
+    
+    dc.SetFont(wxFontInfo(9).FaceName("Segoe UI"));
+    if (series_->Empty()) {
+        dc.SetTextForeground(SLATE_GRAY);
+        dc.DrawText("No transactions to chart yet", kAxisWidth, kMargin);
+        return;
+    }
+    
+    // Balance on top, monthly flows below, one date axis under both
+    int balanceHeight = height * 3 / 5;
+    wxRect balanceArea(kAxisWidth, kMargin, width, balanceHeight);
+    wxRect flowArea(kAxisWidth, kMargin + balanceHeight + kMargin, width, height - balanceHeight - kMargin);
+    DrawBalance(dc, balanceArea);
+    DrawFlows(dc, flowArea);
+    DrawDateAxis(dc, wxRect(kAxisWidth, flowArea.y + flowArea.height, width, kDateAxisHeight));
+}
+
+void ChartPanel::DrawBalance(wxDC& dc, const wxRect& area) {
+    std::vector<BalanceBucket> buckets = series_->GetBalance(firstDay_, daysPerPixel_, static_cast<size_t>(area.width));
+    
+    double low = 0.0;
+    double high = 0.0;
+    bool any = false;
+    for (const auto& bucket : buckets) {
+        if (!bucket.empty) {
+            low = any ? std::min(low, bucket.low) : bucket.low;
+            high = any ? std::max(high, bucket.high) : bucket.high;
+            any = true;
+        }
+    }
+    if (!any) {
+        return;
+    }
+    if (high - low < 0.01) {
+        low -= 1.0;
+        high += 1.0;
+    }
+    
+    auto yOf = [&](double value) {
+        return area.y + area.height - 1 - static_cast<int>((value - low) / (high - low) * (area.height - 1) + 0.5);
+    };
+    
+    CurrencyCode currency = series_->GetCurrency();
+    dc.SetTextForeground(SLATE_GRAY);
+    dc.DrawText(wxString::FromUTF8(FormatMoney(high, currency)), kMargin, area.y);
+    dc.DrawText(wxString::FromUTF8(FormatMoney(low, currency)), kMargin, area.y + area.height - 14);
+    
+    if (low < 0.0 && high > 0.0) {
+        dc.SetPen(wxPen(SLATE_GRAY));
+        dc.DrawLine(area.x, yOf(0.0), area.x + area.width, yOf(0.0));
+    }
+    
+    // Each column's low-high span, then the closing balances joined up
+    std::vector<wxPoint> closes;
+    closes.reserve(buckets.size());
+    dc.SetPen(wxPen(SKY_BLUE));
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        const BalanceBucket& bucket = buckets[i];
+        if (bucket.empty) {
+            continue;
+        }
+        int x = area.x + static_cast<int>(i);
+        int top = yOf(bucket.high);
+        int bottom = yOf(bucket.low);
+        if (bottom > top) {
+            dc.DrawLine(x, bottom, x, top - 1);
+        }
+        closes.emplace_back(x, yOf(bucket.close));
+    }
+    
+    dc.SetPen(wxPen(MIDNIGHT_BLUE, 2));
+    if (closes.size() > 1) {
+        dc.DrawLines(static_cast<int>(closes.size()), closes.data());
+    }
+}
+
+void ChartPanel::DrawFlows(wxDC& dc, const wxRect& area) {
+    std::int32_t firstMonth = MonthOfDay(firstDay_);
+    std::int32_t lastMonth = MonthOfDay(firstDay_ + area.width * daysPerPixel_);
+    std::vector<FlowBucket> bars = series_->GetFlows(firstMonth, lastMonth, std::max(area.width / 6, 1));
+    
+    double largest = 0.0;
+    for (const auto& bar : bars) {
+        largest = std::max({largest, bar.income, bar.expenses});
+    }
+    if (largest <= 0.0) {
+        return;
+    }
+    
+    // Income grows up from the middle line, expenses down from it
+    int middle = area.y + area.height / 2;
+    int reach = area.height / 2 - 1;
+    auto xOf = [&](std::int32_t day) {
+        double x = area.x + (day - firstDay_) / daysPerPixel_;
+        return static_cast<int>(std::min(std::max(x, static_cast<double>(area.x)), static_cast<double>(area.x + area.width)));
+    };
+    
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    for (const auto& bar : bars) {
+        int left = xOf(MonthStartDay(bar.firstMonth));
+        int right = xOf(MonthStartDay(bar.firstMonth + bar.months));
+        int barWidth = std::max(right - left - 1, 1);  // A pixel of gap between bars when there is room
+        int up = static_cast<int>(bar.income / largest * reach + 0.5);
+        int down = static_cast<int>(bar.expenses / largest * reach + 0.5);
+        if (up > 0) {
+            dc.SetBrush(wxBrush(EMERALD_GREEN));
+            dc.DrawRectangle(left, middle - up, barWidth, up);
+        }
+        if (down > 0) {
+            dc.SetBrush(wxBrush(kExpenseRed));
+            dc.DrawRectangle(left, middle, barWidth, down);
+        }
+    }
+    
+    dc.SetPen(wxPen(SLATE_GRAY));
+    dc.DrawLine(area.x, middle, area.x + area.width, middle);
+    
+    CurrencyCode currency = series_->GetCurrency();
+    int months = bars.empty() ? 1 : bars.front().months;
+    dc.SetTextForeground(SLATE_GRAY);
+    dc.DrawText(months == 1 ? wxString("In / out per month") : wxString::Format("In / out per %d months", months),
+                kMargin, area.y);
+    dc.DrawText(wxString::FromUTF8(FormatMoney(largest, currency)), kMargin, area.y + 14);
+}
+
+void ChartPanel::DrawDateAxis(wxDC& dc, const wxRect& area) {
+    // A label about every 120 pixels, to the day once days are wide enough to matter
+    const int spacing = 120;
+    dc.SetTextForeground(SLATE_GRAY);
+    for (int offset = 0; offset + 70 <= area.width; offset += spacing) {
+        int year, month, day;
+        CivilFromDays(static_cast<std::int32_t>(std::floor(firstDay_ + offset * daysPerPixel_)), year, month, day);
+        wxString label = daysPerPixel_ * spacing < 60.0 ? wxString::Format("%04d-%02d-%02d", year, month, day)
+                                                        : wxString::Format("%04d-%02d", year, month);
+        dc.DrawText(label, area.x + offset, area.y + 3);
+    }
+}
+
+void ChartPanel::OnSize(wxSizeEvent& event) {
+    Refresh();
+    event.Skip();
+}
+
+void ChartPanel::OnMouseWheel(wxMouseEvent& event) {
+    double steps = static_cast<double>(event.GetWheelRotation()) / event.GetWheelDelta();
+    ZoomAt(event.GetX(), std::pow(0.8, steps));
+    Refresh();
+}
+
+void ChartPanel::OnLeftDown(wxMouseEvent& event) {
+    dragging_ = true;
+    dragX_ = event.GetX();
+    CaptureMouse();
+}
+
+void ChartPanel::OnLeftUp(wxMouseEvent& event) {
+    if (dragging_) {
+        dragging_ = false;
+        ReleaseMouse();
+    }
+}
+
+void ChartPanel::OnMotion(wxMouseEvent& event) {
+    if (!dragging_ || !event.LeftIsDown()) {
+        return;
+    }
+    
+    firstDay_ -= (event.GetX() - dragX_) * daysPerPixel_;
+    dragX_ = event.GetX();
+    Refresh();
+}
+
+void ChartPanel::OnDoubleClick(wxMouseEvent& event) {
+    FitAll();
+    Refresh();
+}
+
+void ChartPanel::OnCaptureLost(wxMouseCaptureLostEvent& event) {
+    dragging_ = false;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <wx/wx.h>
+#include "../ViewModel/TransactionManager.h"
+
+// Balance over time above monthly income and expense bars, on a shared date
+// axis. Each paint asks the manager's ChartSeries for one min/max bucket per
+// pixel column, so drawing costs the same for a hundred rows as for ten
+// million. The wheel zooms around the pointer, dragging pans, and a double
+// click shows the whole ledger again.
+class ChartPanel : public wxPanel {
+public:
+    ChartPanel(wxWindow* parent, wxWindowID id, TransactionManager& manager);
+    
+    // Picks up the manager's current data; keeps the visible range unless
+    // there was none yet
+    void RefreshData();
+    
+    // Shows another ledger, fitted to its whole range; call RefreshData() afterwards
+    void SetManager(TransactionManager& manager);
+
+private:
+    TransactionManager* manager_;
+    ChartSeries::Ptr series_;
+    double firstDay_;      // Day at the left edge of the plot, fractional when zoomed in
+    double daysPerPixel_;
+    bool fitted_;
+    bool dragging_;
+    int dragX_;
+    
+    void FitAll();
+    void ZoomAt(int x, double factor);
+    int PlotWidth() const;
+    
+    void DrawBalance(wxDC& dc, const wxRect& area);
+    void DrawFlows(wxDC& dc, const wxRect& area);
+    void DrawDateAxis(wxDC& dc, const wxRect& area);
+    
+    void OnPaint(wxPaintEvent& event);
+    void OnSize(wxSizeEvent& event);
+    void OnMouseWheel(wxMouseEvent& event);
+    void OnLeftDown(wxMouseEvent& event);
+    void OnLeftUp(wxMouseEvent& event);
+    void OnMotion(wxMouseEvent& event);
+    void OnDoubleClick(wxMouseEvent& event);
+    void OnCaptureLost(wxMouseCaptureLostEvent& event);
+    
+    wxDECLARE_EVENT_TABLE();
+};
\ No newline at end of file
@@ -1,43 +1,137 @@
 #include "MainWindow.h"
+#include "Palette.h"
 #include <wx/sizer.h>
 #include <wx/stattext.h>
 #include <wx/msgdlg.h>
 #include <wx/menu.h>
 #include <wx/statusbr.h>
 #include <wx/font.h>
+#include <wx/filedlg.h>
+#include <wx/progdlg.h>
+#include <wx/choicdlg.h>
+#include <wx/textdlg.h>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <filesystem>
 
-// Financial Freedom Color Palette
-const wxColour EMERALD_GREEN(46, 204, 113);    // #2ECC71 - Growth, prosperity, wealth
-const wxColour MIDNIGHT_BLUE(44, 62, 80);      // #2C3E50 - Trust, stability, financial control
-const wxColour SKY_BLUE(93, 173, 226);         // #5DADE2 - Clarity, planning, peace of mind
-const wxColour SUNSHINE_YELLOW(244, 208, 63);  // #F4D03F - Optimism, energy, positive outlook
-const wxColour SOFT_MINT(169, 223, 191);       // #A9DFBF - Calm, balance, budgeting peace
-const wxColour SLATE_GRAY(149, 165, 166);      // #95A5A6 - Neutrality, professionalism
-const wxColour PURE_WHITE(255, 255, 255);      // #FFFFFF - Simplicity, cleanliness, minimalism
-const wxColour BLACK_CHARCOAL(28, 28, 28);     // #1C1C1C - Focus, strength, modern elegance
+namespace {
+    // Offered in the currency list alongside those the ledger already uses
+    const char* const kCommonCurrencies[] = {"USD", "EUR", "GBP", "JPY", "CHF", "CAD", "AUD", "CNY", "INR"};
+    
+    struct Schedule {
+        const char* label;
+        RecurrenceUnit unit;
+        int interval;
+    };
+    
+    const Schedule kSchedules[] = {
+        {"Weekly", RecurrenceUnit::Week, 1},
+        {"Every 2 weeks", RecurrenceUnit::Week, 2},
+        {"Monthly", RecurrenceUnit::Month, 1},
+        {"Quarterly", RecurrenceUnit::Month, 3},
+        {"Yearly", RecurrenceUnit::Month, 12}
+    };
+    
+    // Picker entries; each preset is whole calendar months ending monthsBack
+    // months ago, spanning months of them
+    struct PeriodPreset {
+        const char* label;
+        int monthsBack;
+        int months;
+    };
+    
+    const PeriodPreset kPeriods[] = {
+        {"All time", 0, 0},
+        {"This month", 0, 1},
+        {"Last month", 1, 1},
+        {"Last 3 months", 0, 3},
+        {"Last 12 months", 0, 12},
+        {"Custom", 0, 0}
+    };
+    const int kCustomPeriod = 5;
+    
+    wxString DescribeStorage(const StorageStats& stats) {
+        return wxString::Format("%.1f MB, %lld pages of %lld bytes, %lld free", stats.GetBytes() / (1024.0 * 1024.0),
+                                static_cast<long long>(stats.pages), static_cast<long long>(stats.pageSize),
+                                static_cast<long long>(stats.freePages));
+    }
+    
+    wxString DescribeRule(const RecurringRule& rule) {
+        std::string every = "Every " + std::to_string(rule.interval) +
+                         (rule.unit == RecurrenceUnit::Day ? " days" : rule.unit == RecurrenceUnit::Week ? " weeks" : " months");
+        for (const auto& schedule : kSchedules) {
+            if (schedule.unit == rule.unit && schedule.interval == rule.interval) {
+                every = schedule.label;
+            }
+        }
+        
+        Transaction next(0, rule.description, rule.amount, rule.category, rule.type, rule.nextDue);
+        std::ostringstream text;
+        text << rule.description << " - " << FormatMoney(rule.amount, rule.currency) << ", " << every
+             << (rule.IsFinished() ? ", finished" : ", next " + next.GetDateString());
+        return wxString::FromUTF8(text.str());
+    }
+}
 
 wxBEGIN_EVENT_TABLE(MainWindow, wxFrame)
     EVT_BUTTON(ID_ADD_TRANSACTION, MainWindow::OnAddTransaction)
     EVT_BUTTON(ID_EDIT_TRANSACTION, MainWindow::OnEditTransaction)
     EVT_BUTTON(ID_DELETE_TRANSACTION, MainWindow::OnDeleteTransaction)
     EVT_BUTTON(ID_REFRESH, MainWindow::OnRefresh)
+    EVT_MENU(wxID_UNDO, MainWindow::OnUndo)
+    EVT_MENU(wxID_REDO, MainWindow::OnRedo)
+    EVT_MENU(ID_IMPORT_STATEMENT, MainWindow::OnImportStatement)
+    EVT_MENU(ID_RECONCILE_STATEMENT, MainWindow::OnReconcileStatement)
+    EVT_MENU(ID_MAKE_RECURRING, MainWindow::OnMakeRecurring)
+    EVT_MENU(ID_STOP_RECURRING, MainWindow::OnStopRecurring)
+    EVT_MENU(ID_BACKUP_NOW, MainWindow::OnBackupNow)
+    EVT_MENU(ID_RESTORE_BACKUP, MainWindow::OnRestoreBackup)
+    EVT_MENU(ID_COMPACT_DATABASE, MainWindow::OnCompactDatabase)
+    EVT_MENU(ID_SPENDING_SPREAD, MainWindow::OnSpendingSpread)
+    EVT_MENU(ID_TOP_MERCHANTS, MainWindow::OnTopMerchants)
+    EVT_MENU(ID_FORECAST, MainWindow::OnForecast)
+    EVT_MENU(ID_IMPORT_RATES, MainWindow::OnImportRates)
+    EVT_MENU(ID_REPORTING_CURRENCY, MainWindow::OnReportingCurrency)
+    EVT_MENU_RANGE(ID_LEDGER_FIRST, ID_LEDGER_LAST, MainWindow::OnSwitchLedger)
+    EVT_MENU(ID_ADD_LEDGER, MainWindow::OnAddLedger)
+    EVT_MENU(ID_REMOVE_LEDGER, MainWindow::OnRemoveLedger)
     EVT_MENU(wxID_EXIT, MainWindow::OnExit)
     EVT_MENU(wxID_ABOUT, MainWindow::OnAbout)
     EVT_LIST_ITEM_SELECTED(ID_TRANSACTION_LIST, MainWindow::OnTransactionSelected)
+    EVT_LIST_COL_CLICK(ID_TRANSACTION_LIST, MainWindow::OnColumnClick)
+    EVT_TEXT(ID_FILTER_TEXT, MainWindow::OnFilterChanged)
+    EVT_TEXT(ID_DESCRIPTION_TEXT, MainWindow::OnDescriptionChanged)
+    EVT_CHOICE(ID_CATEGORY_CHOICE, MainWindow::OnCategoryChosen)
+    EVT_CHOICE(ID_PERIOD_CHOICE, MainWindow::OnPeriodChosen)
+    EVT_DATE_CHANGED(ID_PERIOD_FROM, MainWindow::OnPeriodDateChanged)
+    EVT_DATE_CHANGED(ID_PERIOD_TO, MainWindow::OnPeriodDateChanged)
+    EVT_TIMER(ID_POLL_TIMER, MainWindow::OnPollTimer)
 wxEND_EVENT_TABLE()
 
-MainWindow::MainWindow(TransactionManager& manager)
+MainWindow::MainWindow(LedgerRegistry& ledgers)
     : wxFrame(nullptr, wxID_ANY, "Personal Finance Tracker", wxDefaultPosition, wxSize(1000, 700))
-    , manager_(manager)
+    , ledgers_(ledgers)
+    , manager_(ledgers.GetCurrent())
+    , observerToken_(0)
     , selectedTransactionId_(-1)
+    , categoryChosenByUser_(false)
+    , pollTimer_(this, ID_POLL_TIMER)
+    , editMenu_(nullptr)
+    , ledgerMenu_(nullptr)
+    , ledgerItems_(0)
     , transactionList_(nullptr)
+    , chartPanel_(nullptr)
     , descriptionText_(nullptr)
     , amountText_(nullptr)
     , categoryChoice_(nullptr)
     , typeChoice_(nullptr)
+    , currencyChoice_(nullptr)
     , datePicker_(nullptr)
+    , filterText_(nullptr)
+    , periodChoice_(nullptr)
+    , periodFromPicker_(nullptr)
+    , periodToPicker_(nullptr)
     , addButton_(nullptr)
     , editButton_(nullptr)
     , deleteButton_(nullptr)
@@ -49,16 +143,13 @@ MainWindow::MainWindow(TransactionManager& manager)
     // Set window background to Pure White
     SetBackgroundColour(PURE_WHITE);
     
-    // Register as observer (using the correct method name)
-    manager_.RegisterObserver([this]() {
-        RefreshTransactionList();
-        RefreshSummary();
-    });
+    ObserveManager();
     
     CreateMenuBar();
     CreateControls();
     CreateStatusBar();
     SetStatusText("Ready");
+    UpdateTitle();
     
     // Center the window
     Center();
@@ -66,6 +157,10 @@ MainWindow::MainWindow(TransactionManager& manager)
     // Initial data load
     RefreshTransactionList();
     RefreshSummary();
+    
+    // Pick up rows written by other programs without waiting for REFRESH,
+    // and run scheduled backups
+    pollTimer_.Start(2000);
 }
 
 void MainWindow::CreateMenuBar() {
@@ -73,15 +168,58 @@ void MainWindow::CreateMenuBar() {
     
     // File menu
     wxMenu* fileMenu = new wxMenu;
+    fileMenu->Append(ID_IMPORT_STATEMENT, "&Import Statement...\tCtrl-I", "Import a CSV or OFX bank statement");
+    fileMenu->Append(ID_RECONCILE_STATEMENT, "Re&concile Statement...",
+                     "Check the ledger against a bank statement and mark the rows that match");
     fileMenu->Append(ID_REFRESH, "&Refresh\tF5", "Refresh the transaction list");
     fileMenu->AppendSeparator();
+    fileMenu->Append(ID_BACKUP_NOW, "&Back Up Now...", "Save a copy of the database while you keep working");
+    fileMenu->Append(ID_RESTORE_BACKUP, "Re&store From Backup...", "Replace all data with a backup");
+    fileMenu->Append(ID_COMPACT_DATABASE, "Co&mpact Database...", "Rewrite the database file to take less space");
+    fileMenu->AppendSeparator();
     fileMenu->Append(wxID_EXIT, "E&xit\tAlt-X", "Quit this program");
     
+    // Recurring menu
+    wxMenu* recurringMenu = new wxMenu;
+    recurringMenu->Append(ID_MAKE_RECURRING, "&Make Recurring...\tCtrl-R", "Repeat the transaction in the form on a schedule");
+    recurringMenu->Append(ID_STOP_RECURRING, "&Stop Recurring...", "Stop a recurring transaction");
+    
+    // Edit menu: labels follow the journal, see UpdateUndoMenu()
+    editMenu_ = new wxMenu;
+    editMenu_->Append(wxID_UNDO, "&Undo\tCtrl-Z", "Undo the last change to the ledger");
+    editMenu_->Append(wxID_REDO, "&Redo\tCtrl-Y", "Redo the last change undone");
+    UpdateUndoMenu();
+    
+    // Ledger menu: one radio item per listed ledger, filled in by RebuildLedgerMenu()
+    ledgerMenu_ = new wxMenu;
+    ledgerMenu_->AppendSeparator();
+    ledgerMenu_->Append(ID_ADD_LEDGER, "&Add Ledger...\tCtrl-L", "Open or create another ledger database");
+    ledgerMenu_->Append(ID_REMOVE_LEDGER, "&Remove Ledger...", "Take a ledger off this list; its file is kept");
+    RebuildLedgerMenu();
+    
+    // Reports menu
+    wxMenu* reportsMenu = new wxMenu;
+    reportsMenu->Append(ID_SPENDING_SPREAD, "&Spending by Category...",
+                        "Typical and large expenses in each category for a period");
+    reportsMenu->Append(ID_TOP_MERCHANTS, "&Top Merchants...", "Where the most money went in a period");
+    reportsMenu->Append(ID_FORECAST, "Cash-Flow &Forecast...", "Where the balance is likely to be in the months ahead");
+    
+    // Currency menu
+    wxMenu* currencyMenu = new wxMenu;
+    currencyMenu->Append(ID_IMPORT_RATES, "&Import Exchange Rates...",
+                         "Load daily rates from a CSV file of date, base, quote, rate");
+    currencyMenu->Append(ID_REPORTING_CURRENCY, "&Reporting Currency...", "Choose the currency totals are shown in");
+    
     // Help menu
     wxMenu* helpMenu = new wxMenu;
     helpMenu->Append(wxID_ABOUT, "&About\tF1", "Show about dialog");
     
     menuBar->Append(fileMenu, "&File");
+    menuBar->Append(editMenu_, "&Edit");
+    menuBar->Append(ledgerMenu_, "&Ledger");
+    menuBar->Append(recurringMenu, "&Recurring");
+    menuBar->Append(reportsMenu, "Re&ports");
+    menuBar->Append(currencyMenu, "&Currency");
     menuBar->Append(helpMenu, "&Help");
     
     SetMenuBar(menuBar);
@@ -95,11 +233,13 @@ void MainWindow::CreateControls() {
     
     // Create panels
     wxPanel* summaryPanel = CreateSummaryPanel(mainPanel);
+    chartPanel_ = new ChartPanel(mainPanel, wxID_ANY, *manager_);
     wxPanel* inputPanel = CreateInputPanel(mainPanel);
     wxPanel* listPanel = CreateListPanel(mainPanel);
     
     // Add panels to main sizer
     mainSizer->Add(summaryPanel, 0, wxEXPAND | wxALL, 10);
+    mainSizer->Add(chartPanel_, 0, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 10);
     mainSizer->Add(inputPanel, 0, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 10);
     mainSizer->Add(listPanel, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 10);
     
@@ -200,7 +340,7 @@ wxPanel* MainWindow::CreateInputPanel(wxWindow* parent) {
     wxStaticText* descLabel = new wxStaticText(panel, wxID_ANY, "Description:");
     descLabel->SetFont(labelFont);
     descLabel->SetForegroundColour(PURE_WHITE);
-    descriptionText_ = new wxTextCtrl(panel, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, 0);
+    descriptionText_ = new wxTextCtrl(panel, ID_DESCRIPTION_TEXT, "", wxDefaultPosition, wxDefaultSize, 0);
     descriptionText_->SetFont(inputFont);
     descriptionText_->SetBackgroundColour(SOFT_MINT);
     descriptionText_->SetForegroundColour(BLACK_CHARCOAL);
@@ -218,7 +358,7 @@ wxPanel* MainWindow::CreateInputPanel(wxWindow* parent) {
     wxStaticText* categoryLabel = new wxStaticText(panel, wxID_ANY, "Category:");
     categoryLabel->SetFont(labelFont);
     categoryLabel->SetForegroundColour(PURE_WHITE);
-    categoryChoice_ = new wxChoice(panel, wxID_ANY);
+    categoryChoice_ = new wxChoice(panel, ID_CATEGORY_CHOICE);
     categoryChoice_->SetFont(inputFont);
     categoryChoice_->SetBackgroundColour(SOFT_MINT);
     categoryChoice_->SetForegroundColour(BLACK_CHARCOAL);
@@ -245,6 +385,16 @@ wxPanel* MainWindow::CreateInputPanel(wxWindow* parent) {
     typeChoice_->Append("Expense");
     typeChoice_->SetSelection(1);
     
+    // Currency
+    wxStaticText* currencyLabel = new wxStaticText(panel, wxID_ANY, "Currency:");
+    currencyLabel->SetFont(labelFont);
+    currencyLabel->SetForegroundColour(PURE_WHITE);
+    currencyChoice_ = new wxChoice(panel, wxID_ANY);
+    currencyChoice_->SetFont(inputFont);
+    currencyChoice_->SetBackgroundColour(SOFT_MINT);
+    currencyChoice_->SetForegroundColour(BLACK_CHARCOAL);
+    RefreshCurrencyChoices();
+    
     // Date
     wxStaticText* dateLabel = new wxStaticText(panel, wxID_ANY, "Date:");
     dateLabel->SetFont(labelFont);
@@ -262,6 +412,8 @@ wxPanel* MainWindow::CreateInputPanel(wxWindow* parent) {
     gridSizer->Add(categoryChoice_, 1, wxEXPAND);
     gridSizer->Add(typeLabel, 0, wxALIGN_CENTER_VERTICAL);
     gridSizer->Add(typeChoice_, 1, wxEXPAND);
+    gridSizer->Add(currencyLabel, 0, wxALIGN_CENTER_VERTICAL);
+    gridSizer->Add(currencyChoice_, 1, wxEXPAND);
     gridSizer->Add(dateLabel, 0, wxALIGN_CENTER_VERTICAL);
     gridSizer->Add(datePicker_, 1, wxEXPAND);
     
@@ -318,9 +470,42 @@ wxPanel* MainWindow::CreateListPanel(wxWindow* parent) {
     headerLabel->SetForegroundColour(BLACK_CHARCOAL);
     sizer->Add(headerLabel, 0, wxALIGN_CENTER | wxALL, 10);
     
-    // Transaction list
-    transactionList_ = new wxListCtrl(panel, ID_TRANSACTION_LIST, wxDefaultPosition, wxDefaultSize, 
-                                     wxLC_REPORT | wxLC_SINGLE_SEL);
+    // Search-as-you-type filter over descriptions
+    wxBoxSizer* filterSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* filterLabel = new wxStaticText(panel, wxID_ANY, "Search:");
+    filterLabel->SetFont(wxFontInfo(14).Bold().FaceName("Segoe UI"));
+    filterLabel->SetForegroundColour(BLACK_CHARCOAL);
+    filterText_ = new wxTextCtrl(panel, ID_FILTER_TEXT, "", wxDefaultPosition, wxDefaultSize, 0);
+    filterText_->SetFont(wxFontInfo(14).FaceName("Segoe UI"));
+    filterText_->SetBackgroundColour(SOFT_MINT);
+    filterText_->SetForegroundColour(BLACK_CHARCOAL);
+    filterText_->SetHint("Filter by description");
+    filterSizer->Add(filterLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    filterSizer->Add(filterText_, 1, wxEXPAND);
+    
+    // Period the list and summary cover
+    wxStaticText* periodLabel = new wxStaticText(panel, wxID_ANY, "Period:");
+    periodLabel->SetFont(wxFontInfo(14).Bold().FaceName("Segoe UI"));
+    periodLabel->SetForegroundColour(BLACK_CHARCOAL);
+    periodChoice_ = new wxChoice(panel, ID_PERIOD_CHOICE);
+    for (const auto& period : kPeriods) {
+        periodChoice_->Append(period.label);
+    }
+    periodChoice_->SetSelection(0);
+    periodChoice_->SetFont(wxFontInfo(14).FaceName("Segoe UI"));
+    periodFromPicker_ = new wxDatePickerCtrl(panel, ID_PERIOD_FROM);
+    periodToPicker_ = new wxDatePickerCtrl(panel, ID_PERIOD_TO);
+    periodFromPicker_->Enable(false);
+    periodToPicker_->Enable(false);
+    filterSizer->Add(periodLabel, 0, wxALIGN_CENTER_VERTICAL | wxLEFT | wxRIGHT, 10);
+    filterSizer->Add(periodChoice_, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+    filterSizer->Add(periodFromPicker_, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    filterSizer->Add(new wxStaticText(panel, wxID_ANY, "to"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+    filterSizer->Add(periodToPicker_, 0, wxALIGN_CENTER_VERTICAL);
+    sizer->Add(filterSizer, 0, wxEXPAND | wxLEFT | wxRIGHT, 10);
+    
+    // Transaction list (virtual: rows are drawn from the manager on demand)
+    transactionList_ = new TransactionListCtrl(panel, ID_TRANSACTION_LIST, *manager_);
     
     // Create font for list
     wxFont listFont = wxFontInfo(14).FaceName("Segoe UI");
@@ -335,6 +520,7 @@ wxPanel* MainWindow::CreateListPanel(wxWindow* parent) {
     transactionList_->AppendColumn("Category", wxLIST_FORMAT_LEFT, 120);
     transactionList_->AppendColumn("Type", wxLIST_FORMAT_LEFT, 80);
     transactionList_->AppendColumn("Amount", wxLIST_FORMAT_RIGHT, 100);
+    transactionList_->AppendColumn("Balance", wxLIST_FORMAT_RIGHT, 110);
     
     sizer->Add(transactionList_, 1, wxEXPAND | wxALL, 10);
     
@@ -361,7 +547,8 @@ void MainWindow::OnAddTransaction(wxCommandEvent& event) {
     TransactionType type = (typeChoice_->GetSelection() == 0) ? TransactionType::Income : TransactionType::Expense;
     
     // Use the correct method signature
-    if (manager_.AddTransaction(description.ToStdString(), amount, category, type)) {
+    if (manager_->AddTransaction(description.ToStdString(), amount, category, type, GetSelectedCurrency(),
+                                 GetSelectedDate(0))) {
         ShowNotification("Transaction added successfully!");
         ClearInputFields();
     } else {
@@ -392,8 +579,15 @@ void MainWindow::OnEditTransaction(wxCommandEvent& event) {
     std::string category = categoryChoice_->GetStringSelection().ToStdString();
     TransactionType type = (typeChoice_->GetSelection() == 0) ? TransactionType::Income : TransactionType::Expense;
     
+    Transaction current;
+    std::time_t date = 0;
+    if (manager_->GetTransaction(selectedTransactionId_, current)) {
+        date = GetSelectedDate(current.date);
+    }
+    
     // Use the correct method signature
-    if (manager_.UpdateTransaction(selectedTransactionId_, description.ToStdString(), amount, category, type)) {
+    if (manager_->UpdateTransaction(selectedTransactionId_, description.ToStdString(), amount, category, type,
+                                    GetSelectedCurrency(), date)) {
         ShowNotification("Transaction updated successfully!");
         ClearInputFields();
         selectedTransactionId_ = -1;
@@ -414,7 +608,7 @@ void MainWindow::OnDeleteTransaction(wxCommandEvent& event) {
                              "Confirm Delete", wxYES_NO | wxICON_QUESTION);
     
     if (result == wxYES) {
-        if (manager_.DeleteTransaction(selectedTransactionId_)) {
+        if (manager_->DeleteTransaction(selectedTransactionId_)) {
             ShowNotification("Transaction deleted successfully!");
             ClearInputFields();
             selectedTransactionId_ = -1;
@@ -426,11 +620,653 @@ void MainWindow::OnDeleteTransaction(wxCommandEvent& event) {
     }
 }
 
+void MainWindow::OnUndo(wxCommandEvent& event) {
+    std::string label = manager_->GetUndoLabel();
+    if (!manager_->Undo()) {
+        ShowNotification("Nothing could be undone", false);
+        return;
+    }
+    
+    // The form may be showing a row the undo took away
+    Transaction selected;
+    if (selectedTransactionId_ != -1 && !manager_->GetTransaction(selectedTransactionId_, selected)) {
+        ClearInputFields();
+        selectedTransactionId_ = -1;
+        editButton_->Enable(false);
+        deleteButton_->Enable(false);
+    }
+    SetStatusText("Undid " + wxString::FromUTF8(label));
+}
+
+void MainWindow::OnRedo(wxCommandEvent& event) {
+    std::string label = manager_->GetRedoLabel();
+    if (!manager_->Redo()) {
+        ShowNotification("Nothing could be redone", false);
+        return;
+    }
+    
+    Transaction selected;
+    if (selectedTransactionId_ != -1 && !manager_->GetTransaction(selectedTransactionId_, selected)) {
+        ClearInputFields();
+        selectedTransactionId_ = -1;
+        editButton_->Enable(false);
+        deleteButton_->Enable(false);
+    }
+    SetStatusText("Redid " + wxString::FromUTF8(label));
+}
+
 void MainWindow::OnRefresh(wxCommandEvent& event) {
-    manager_.RefreshData();
+    manager_->RefreshData();
     ShowNotification("Data refreshed!");
 }
 
+void MainWindow::OnImportStatement(wxCommandEvent& event) {
+    wxFileDialog dialog(this, "Import Bank Statement", "", "",
+                        "Bank statements (*.csv;*.ofx;*.qfx)|*.csv;*.ofx;*.qfx|All files (*.*)|*.*",
+                        wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    const int progressRange = 1000;
+    wxProgressDialog progress("Import Bank Statement", "Importing " + dialog.GetPath(), progressRange, this,
+                              wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME);
+    
+    ImportReport report;
+    bool imported = manager_->ImportStatement(dialog.GetPath().ToStdString(), report,
+        [&](size_t bytesDone, size_t bytesTotal) {
+            // Held short of the end so the dialog stays up until the list is rebuilt
+            int value = bytesTotal > 0 ? static_cast<int>(bytesDone * (progressRange - 1) / bytesTotal) : 0;
+            return progress.Update(value);
+        });
+    progress.Update(progressRange);
+    
+    std::ostringstream summary;
+    summary << (report.cancelled ? "Import cancelled. " : "") << "Imported " << report.rowsImported << " of "
+            << report.rowsParsed + report.rowsRejected << " transactions in " << std::fixed << std::setprecision(2)
+            << report.seconds << " s.";
+    if (report.rowsSkipped > 0 || report.rowsMerged > 0) {
+        summary << "\n\n" << report.rowsSkipped << " duplicates were skipped and " << report.rowsMerged
+                << " merged into existing transactions.";
+    }
+    if (report.rowsRejected > 0) {
+        summary << "\n\n" << report.rowsRejected << " rows could not be read:";
+    }
+    
+    const size_t errorsShown = 10;
+    for (size_t i = 0; i < report.errors.size() && i < errorsShown; ++i) {
+        summary << "\n";
+        if (report.errors[i].line > 0) {
+            summary << "Line " << report.errors[i].line << ": ";
+        }
+        summary << report.errors[i].message;
+    }
+    if (report.errors.size() > errorsShown) {
+        summary << "\n...";
+    }
+    
+    bool clean = imported && report.errors.empty();
+    wxMessageBox(summary.str(), "Import Bank Statement", wxOK | (clean ? wxICON_INFORMATION : wxICON_WARNING));
+    SetStatusText(wxString::Format("Imported %lu transactions", static_cast<unsigned long>(report.rowsImported)));
+}
+
+void MainWindow::OnReconcileStatement(wxCommandEvent& event) {
+    wxFileDialog dialog(this, "Reconcile Bank Statement", "", "",
+                        "Bank statements (*.csv;*.ofx;*.qfx)|*.csv;*.ofx;*.qfx|All files (*.*)|*.*",
+                        wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    wxBusyCursor busy;
+    ReconcileReport report;
+    bool reconciled = manager_->ReconcileStatement(dialog.GetPath().ToStdString(), report);
+    
+    std::ostringstream summary;
+    summary << "Matched " << report.matched.size() << " of " << report.lines.size() << " statement lines in "
+            << std::fixed << std::setprecision(2) << report.seconds << " s; " << report.marked
+            << " transactions are newly marked reconciled.";
+    
+    // A few of each kind, enough to start looking
+    const size_t rowsShown = 10;
+    if (!report.missing.empty()) {
+        summary << "\n\n" << report.missing.size() << " statement lines have no transaction:";
+        for (size_t i = 0; i < report.missing.size() && i < rowsShown; ++i) {
+            const Transaction& line = report.lines[report.missing[i]];
+            summary << "\n" << line.GetDateString() << "  " << line.description << "  "
+                    << (line.type == TransactionType::Expense ? "-" : "") << FormatMoney(line.amount, line.currency);
+        }
+        if (report.missing.size() > rowsShown) {
+            summary << "\n...";
+        }
+    }
+    if (!report.extra.empty()) {
+        summary << "\n\n" << report.extra.size() << " transactions on the statement's dates are not on it:";
+        for (size_t i = 0; i < report.extra.size() && i < rowsShown; ++i) {
+            Transaction transaction;
+            if (manager_->GetTransaction(report.extra[i], transaction)) {
+                summary << "\n" << transaction.GetDateString() << "  " << transaction.description << "  "
+                        << (transaction.type == TransactionType::Expense ? "-" : "")
+                        << FormatMoney(transaction.amount, transaction.currency);
+            }
+        }
+        if (report.extra.size() > rowsShown) {
+            summary << "\n...";
+        }
+    }
+    if (report.parsing.rowsRejected > 0) {
+        summary << "\n\n" << report.parsing.rowsRejected << " statement rows could not be read.";
+    }
+    
+    bool clean = reconciled && report.missing.empty() && report.extra.empty() && report.parsing.errors.empty();
+    wxMessageBox(wxString::FromUTF8(summary.str()), "Reconcile Bank Statement",
+                 wxOK | (clean ? wxICON_INFORMATION : wxICON_WARNING));
+    SetStatusText(wxString::Format("Reconciled %lu of %lu statement lines", static_cast<unsigned long>(report.matched.size()),
+                                   static_cast<unsigned long>(report.lines.size())));
+}
+
+bool MainWindow::ChooseReportPeriod(const wxString& title, std::time_t& from, std::time_t& to) {
+    wxArrayString labels;
+    labels.Add("This month");
+    labels.Add("Last 3 months");
+    labels.Add("Last 12 months");
+    labels.Add("All time");
+    
+    wxSingleChoiceDialog dialog(this, "Which period?", title, labels);
+    if (dialog.ShowModal() != wxID_OK) {
+        return false;
+    }
+    
+    // Whole calendar months, ending with the current one
+    const int months[] = {1, 3, 12, 0};
+    int span = months[dialog.GetSelection()];
+    from = 0;
+    to = 0;
+    if (span > 0) {
+        wxDateTime start = wxDateTime::Today();
+        start.SetDay(1);
+        start -= wxDateSpan::Months(span - 1);
+        from = start.GetTicks();
+        to = wxDateTime::Now().GetTicks();
+    }
+    return true;
+}
+
+void MainWindow::OnSpendingSpread(wxCommandEvent& event) {
+    std::time_t from;
+    std::time_t to;
+    if (!ChooseReportPeriod("Spending by Category", from, to)) {
+        return;
+    }
+    
+    std::vector<CategorySpread> spreads = manager_->GetCategorySpread(from, to);
+    if (spreads.empty()) {
+        wxMessageBox("There are no expenses in this period.", "Spending by Category", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    
+    std::sort(spreads.begin(), spreads.end(),
+              [](const CategorySpread& a, const CategorySpread& b) { return a.count > b.count; });
+    
+    CurrencyCode currency = manager_->GetReportingCurrency();
+    std::ostringstream text;
+    text << "Typical (median) and large (90th percentile) expenses:\n";
+    for (const auto& spread : spreads) {
+        text << "\n" << spread.category << ": " << FormatMoney(spread.median, currency) << " typical, "
+             << FormatMoney(spread.p90, currency) << " large, " << FormatMoney(spread.largest, currency)
+             << " largest (" << spread.count << (spread.count == 1 ? " expense)" : " expenses)");
+    }
+    wxMessageBox(wxString::FromUTF8(text.str()), "Spending by Category", wxOK | wxICON_INFORMATION);
+}
+
+void MainWindow::OnTopMerchants(wxCommandEvent& event) {
+    std::time_t from;
+    std::time_t to;
+    if (!ChooseReportPeriod("Top Merchants", from, to)) {
+        return;
+    }
+    
+    const size_t merchantsShown = 20;
+    std::vector<MerchantSpend> merchants = manager_->GetTopMerchants(merchantsShown, from, to);
+    if (merchants.empty()) {
+        wxMessageBox("There are no expenses in this period.", "Top Merchants", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    
+    CurrencyCode currency = manager_->GetReportingCurrency();
+    std::ostringstream text;
+    for (size_t i = 0; i < merchants.size(); ++i) {
+        const MerchantSpend& merchant = merchants[i];
+        text << (i > 0 ? "\n" : "") << i + 1 << ". " << merchant.merchant << ": "
+             << (merchant.error > 0 ? "about " : "") << FormatMoney(merchant.amount - merchant.error / 2, currency);
+    }
+    wxMessageBox(wxString::FromUTF8(text.str()), "Top Merchants", wxOK | wxICON_INFORMATION);
+}
+
+void MainWindow::OnForecast(wxCommandEvent& event) {
+    wxArrayString labels;
+    labels.Add("3 months");
+    labels.Add("6 months");
+    labels.Add("12 months");
+    
+    wxSingleChoiceDialog dialog(this, "How far ahead?", "Cash-Flow Forecast", labels);
+    dialog.SetSelection(2);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    const int horizons[] = {3, 6, 12};
+    ForecastOptions options;
+    options.months = horizons[dialog.GetSelection()];
+    
+    wxBusyCursor busy;
+    CashFlowForecast::Ptr forecast = manager_->GetForecast(options);
+    std::vector<ForecastDay> monthEnds = forecast->GetMonthEnds();
+    if (monthEnds.empty()) {
+        wxMessageBox("There is not enough history to forecast from yet.", "Cash-Flow Forecast", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    
+    // The current month's end first, then one line per month ahead
+    CurrencyCode currency = manager_->GetReportingCurrency();
+    std::ostringstream text;
+    text << "Balance at the end of each month: most likely, then the range it stays within "
+         << "half the time and 9 times in 10 (" << forecast->GetPaths() << " simulated futures):\n";
+    for (const ForecastDay& point : monthEnds) {
+        int year, month, day;
+        CivilFromDays(point.day, year, month, day);
+        text << "\n" << year << "-" << (month < 10 ? "0" : "") << month << ": " << FormatMoney(point.median, currency) << "  (" << FormatMoney(point.p25, currency)
+             << " to " << FormatMoney(point.p75, currency) << "; " << FormatMoney(point.p5, currency) << " to "
+             << FormatMoney(point.p95, currency) << ")";
+    }
+    wxMessageBox(wxString::FromUTF8(text.str()), "Cash-Flow Forecast", wxOK | wxICON_INFORMATION);
+}
+
+void MainWindow::OnImportRates(wxCommandEvent& event) {
+    wxFileDialog dialog(this, "Import Exchange Rates", "", "",
+                        "Exchange rates (*.csv;*.txt)|*.csv;*.txt|All files (*.*)|*.*",
+                        wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    wxBusyCursor busy;
+    ImportReport report;
+    bool imported = manager_->ImportExchangeRates(dialog.GetPath().ToStdString(), report);
+    RefreshCurrencyChoices();
+    
+    std::ostringstream summary;
+    summary << "Imported " << report.rowsImported << " of " << report.rowsParsed << " exchange rates.";
+    if (report.rowsRejected > 0) {
+        summary << "\n\n" << report.rowsRejected << " lines could not be read:";
+    }
+    
+    const size_t errorsShown = 10;
+    for (size_t i = 0; i < report.errors.size() && i < errorsShown; ++i) {
+        summary << "\n";
+        if (report.errors[i].line > 0) {
+            summary << "Line " << report.errors[i].line << ": ";
+        }
+        summary << report.errors[i].message;
+    }
+    if (report.errors.size() > errorsShown) {
+        summary << "\n...";
+    }
+    
+    bool clean = imported && report.errors.empty();
+    wxMessageBox(summary.str(), "Import Exchange Rates", wxOK | (clean ? wxICON_INFORMATION : wxICON_WARNING));
+}
+
+void MainWindow::OnReportingCurrency(wxCommandEvent& event) {
+    wxString current = CurrencyToString(manager_->GetReportingCurrency());
+    wxString code = wxGetTextFromUser("Show totals in which currency? (three-letter code, e.g. EUR)",
+                                      "Reporting Currency", current, this).Trim().Trim(false);
+    if (code.IsEmpty() || code == current) {
+        return;
+    }
+    
+    CurrencyCode currency;
+    if (!ParseCurrency(code.ToStdString(), currency)) {
+        ShowNotification("Please enter a three-letter currency code", false);
+        return;
+    }
+    
+    if (manager_->SetReportingCurrency(currency)) {
+        RefreshCurrencyChoices();
+        ShowNotification("Totals are now shown in " + wxString(CurrencyToString(currency)));
+    } else {
+        ShowNotification("Failed to save the reporting currency", false);
+    }
+}
+
+void MainWindow::OnBackupNow(wxCommandEvent& event) {
+    if (manager_->GetBackups().IsRunning()) {
+        ShowNotification("A backup is already running", false);
+        return;
+    }
+    
+    wxFileDialog dialog(this, "Back Up Database", "", wxDateTime::Now().Format("finance_tracker-%Y%m%d.db"),
+                        "Database files (*.db)|*.db|All files (*.*)|*.*", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    // Runs in the background; the poll timer reports progress and the outcome
+    manager_->GetBackups().Start(dialog.GetPath().ToStdString());
+    SetStatusText("Backing up...");
+}
+
+void MainWindow::OnRestoreBackup(wxCommandEvent& event) {
+    if (manager_->GetBackups().IsRunning()) {
+        ShowNotification("Please wait for the running backup to finish", false);
+        return;
+    }
+    
+    wxFileDialog dialog(this, "Restore From Backup", "", "", "Database files (*.db)|*.db|All files (*.*)|*.*",
+                        wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    if (wxMessageBox("Replace all current transactions and recurring rules with the contents of this backup?",
+                     "Restore From Backup", wxYES_NO | wxICON_WARNING) != wxYES) {
+        return;
+    }
+    
+    // The database must not be touched between restore steps
+    pollTimer_.Stop();
+    
+    const int progressRange = 1000;
+    wxProgressDialog progress("Restore From Backup", "Restoring " + dialog.GetPath(), progressRange, this,
+                              wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT);
+    bool restored = manager_->RestoreBackup(dialog.GetPath().ToStdString(), [&](int remaining, int total) {
+        // Held short of the end so the dialog stays up until the reload is done
+        long long done = total - remaining;
+        return progress.Update(total > 0 ? static_cast<int>(done * (progressRange - 1) / total) : 0);
+    });
+    progress.Update(progressRange);
+    pollTimer_.Start(2000);
+    
+    if (restored) {
+        selectedTransactionId_ = -1;
+        ClearInputFields();
+        ShowNotification("Backup restored");
+    } else {
+        ShowNotification("The backup was not restored; your data is unchanged", false);
+    }
+}
+
+void MainWindow::OnCompactDatabase(wxCommandEvent& event) {
+    if (manager_->GetBackups().IsRunning()) {
+        ShowNotification("Please wait for the running backup to finish", false);
+        return;
+    }
+    
+    StorageStats current = manager_->GetStorageStats();
+    wxString question = "Rewrite the database file in its compact form?\n\nNow: " + DescribeStorage(current);
+    if (!current.strict) {
+        question += "\n\nOther programs using SQLite older than 3.37 will no longer open it.";
+    }
+    if (wxMessageBox(question, "Compact Database", wxYES_NO | wxICON_QUESTION) != wxYES) {
+        return;
+    }
+    
+    StorageStats before, after;
+    bool compacted;
+    {
+        wxBusyCursor busy;
+        compacted = manager_->CompactStorage(before, after);
+    }
+    
+    if (compacted) {
+        wxMessageBox("Before: " + DescribeStorage(before) + "\nAfter: " + DescribeStorage(after),
+                     "Compact Database", wxOK | wxICON_INFORMATION);
+        double saved = (before.GetBytes() - after.GetBytes()) / (1024.0 * 1024.0);
+        SetStatusText(after.GetBytes() < before.GetBytes()
+                      ? wxString::Format("Database compacted, %.1f MB saved", saved)
+                      : wxString("Database compacted; there was no free space to give back"));
+    } else {
+        ShowNotification("The database was not compacted; your data is unchanged", false);
+    }
+}
+
+void MainWindow::OnMakeRecurring(wxCommandEvent& event) {
+    wxString description = descriptionText_->GetValue().Trim();
+    wxString amountStr = amountText_->GetValue().Trim();
+    
+    if (description.IsEmpty() || amountStr.IsEmpty()) {
+        ShowNotification("Please fill in all fields", false);
+        return;
+    }
+    
+    double amount;
+    if (!amountStr.ToDouble(&amount) || amount <= 0) {
+        ShowNotification("Please enter a valid positive amount", false);
+        return;
+    }
+    
+    wxArrayString labels;
+    for (const auto& schedule : kSchedules) {
+        labels.Add(schedule.label);
+    }
+    
+    wxSingleChoiceDialog scheduleDialog(this, "How often does \"" + description + "\" repeat?", "Make Recurring", labels);
+    if (scheduleDialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    wxTextEntryDialog endDialog(this, "Last date (YYYY-MM-DD), or leave blank to repeat indefinitely:", "Make Recurring");
+    if (endDialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    RecurringRule rule;
+    wxString endText = endDialog.GetValue().Trim();
+    wxDateTime endDate;
+    if (!endText.IsEmpty()) {
+        if (!endDate.ParseISODate(endText)) {
+            ShowNotification("Please enter the last date as YYYY-MM-DD", false);
+            return;
+        }
+        rule.endDate = endDate.GetTicks();
+    }
+    
+    const Schedule& schedule = kSchedules[scheduleDialog.GetSelection()];
+    wxDateTime start = datePicker_->GetValue();
+    rule.description = description.ToStdString();
+    rule.amount = amount;
+    rule.category = categoryChoice_->GetStringSelection().ToStdString();
+    rule.type = (typeChoice_->GetSelection() == 0) ? TransactionType::Income : TransactionType::Expense;
+    rule.currency = GetSelectedCurrency();
+    rule.unit = schedule.unit;
+    rule.interval = schedule.interval;
+    rule.dayOfMonth = start.GetDay();
+    
+    size_t created = 0;
+    if (manager_->AddRecurringRule(rule, start.GetTicks(), &created)) {
+        ShowNotification(wxString::Format("Recurring transaction saved; %lu added so far",
+                                          static_cast<unsigned long>(created)));
+        ClearInputFields();
+    } else {
+        ShowNotification("Failed to save recurring transaction", false);
+    }
+}
+
+void MainWindow::OnStopRecurring(wxCommandEvent& event) {
+    std::vector<RecurringRule> rules = manager_->GetRecurringRules();
+    if (rules.empty()) {
+        wxMessageBox("There are no recurring transactions.", "Stop Recurring", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    
+    wxArrayString labels;
+    for (const auto& rule : rules) {
+        labels.Add(DescribeRule(rule));
+    }
+    
+    wxSingleChoiceDialog dialog(this, "Stop which recurring transaction? Transactions it already added are kept.",
+                                "Stop Recurring", labels);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    if (manager_->DeleteRecurringRule(rules[dialog.GetSelection()].id)) {
+        ShowNotification("Recurring transaction stopped");
+    } else {
+        ShowNotification("Failed to stop recurring transaction", false);
+    }
+}
+
+void MainWindow::OnSwitchLedger(wxCommandEvent& event) {
+    std::vector<LedgerRegistry::Ledger> ledgers = ledgers_.GetLedgers();
+    size_t index = static_cast<size_t>(event.GetId() - ID_LEDGER_FIRST);
+    if (index < ledgers.size()) {
+        SwitchLedger(ledgers[index].name);
+    }
+}
+
+void MainWindow::OnAddLedger(wxCommandEvent& event) {
+    if (ledgers_.GetLedgers().size() > static_cast<size_t>(ID_LEDGER_LAST - ID_LEDGER_FIRST)) {
+        ShowNotification("No more ledgers can be listed; remove one first", false);
+        return;
+    }
+    
+    // An existing file is opened as it is; a new name starts an empty ledger
+    wxFileDialog dialog(this, "Add Ledger", "", "ledger.db", "Database files (*.db)|*.db|All files (*.*)|*.*",
+                        wxFD_SAVE);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    std::string path = dialog.GetPath().ToStdString();
+    wxString name = wxGetTextFromUser("Name for this ledger:", "Add Ledger",
+                                      std::filesystem::path(path).stem().string(), this).Trim().Trim(false);
+    if (name.empty()) {
+        return;
+    }
+    
+    if (!ledgers_.AddLedger(name.ToStdString(), path)) {
+        ShowNotification("A ledger with that name or file is already listed", false);
+        return;
+    }
+    if (!SwitchLedger(name.ToStdString())) {
+        ledgers_.RemoveLedger(name.ToStdString());
+        RebuildLedgerMenu();
+        return;
+    }
+    ledgers_.Save();
+}
+
+void MainWindow::OnRemoveLedger(wxCommandEvent& event) {
+    wxArrayString names;
+    for (const auto& ledger : ledgers_.GetLedgers()) {
+        if (ledger.name != ledgers_.GetCurrentName()) {
+            names.Add(ledger.name);
+        }
+    }
+    if (names.GetCount() == 0) {
+        wxMessageBox("Only the ledger you are using is listed.", "Remove Ledger", wxOK | wxICON_INFORMATION);
+        return;
+    }
+    
+    wxSingleChoiceDialog dialog(this, "Remove which ledger from the list? Its database file is kept.",
+                                "Remove Ledger", names);
+    if (dialog.ShowModal() != wxID_OK) {
+        return;
+    }
+    
+    if (ledgers_.RemoveLedger(dialog.GetStringSelection().ToStdString())) {
+        ledgers_.Save();
+        RebuildLedgerMenu();
+        ShowNotification("Ledger removed from the list");
+    }
+}
+
+bool MainWindow::SwitchLedger(const std::string& name) {
+    if (name == ledgers_.GetCurrentName()) {
+        return true;
+    }
+    
+    // Opening may close the ledger being left to stay within the memory
+    // budget, so take what is needed from it and stop observing it first
+    std::vector<SortKey> sortKeys = manager_->GetSortKeys();
+    std::time_t previousFrom = manager_->GetPeriodFrom();
+    std::time_t previousTo = manager_->GetPeriodTo();
+    manager_->UnregisterObserver(observerToken_);
+    
+    bool wasOpen = ledgers_.IsOpen(name);
+    size_t recurringAdded = 0;
+    TransactionManager* next = ledgers_.Open(name, &recurringAdded);
+    if (!next) {
+        ObserveManager();
+        RebuildLedgerMenu();
+        ShowNotification("Could not open the ledger " + wxString(name), false);
+        return false;
+    }
+    
+    manager_ = next;
+    ObserveManager();
+    
+    // A ledger kept open only needs what other programs wrote since
+    if (wasOpen) {
+        manager_->CheckExternalChanges();
+    }
+    manager_->SetSortKeys(sortKeys);
+    manager_->SetFilterText(filterText_->GetValue().ToStdString());
+    manager_->SetPeriod(previousFrom, previousTo);
+    transactionList_->SetManager(*manager_);
+    chartPanel_->SetManager(*manager_);
+    
+    selectedTransactionId_ = -1;
+    RefreshCurrencyChoices();
+    ClearInputFields();
+    RefreshTransactionList();
+    RefreshSummary();
+    RebuildLedgerMenu();
+    UpdateUndoMenu();
+    UpdateTitle();
+    
+    if (recurringAdded > 0) {
+        SetStatusText(wxString::Format("Opened %s and added %lu recurring transactions", wxString(name),
+                                       static_cast<unsigned long>(recurringAdded)));
+    } else {
+        SetStatusText((wasOpen ? "Switched to " : "Opened ") + wxString(name));
+    }
+    return true;
+}
+
+void MainWindow::ObserveManager() {
+    observerToken_ = manager_->RegisterObserver([this]() {
+        RefreshTransactionList();
+        RefreshSummary();
+        UpdateUndoMenu();
+    });
+}
+
+void MainWindow::RebuildLedgerMenu() {
+    for (size_t i = 0; i < ledgerItems_; ++i) {
+        ledgerMenu_->Delete(ID_LEDGER_FIRST + static_cast<int>(i));
+    }
+    
+    std::vector<LedgerRegistry::Ledger> ledgers = ledgers_.GetLedgers();
+    ledgerItems_ = std::min(ledgers.size(), static_cast<size_t>(ID_LEDGER_LAST - ID_LEDGER_FIRST + 1));
+    for (size_t i = 0; i < ledgerItems_; ++i) {
+        int id = ID_LEDGER_FIRST + static_cast<int>(i);
+        wxString label = ledgers[i].name;
+        if (i < 9) {
+            label += wxString::Format("\tCtrl-%d", static_cast<int>(i + 1));
+        }
+        ledgerMenu_->InsertRadioItem(i, id, label, ledgers[i].path);
+        if (ledgers[i].name == ledgers_.GetCurrentName()) {
+            ledgerMenu_->Check(id, true);
+        }
+    }
+}
+
+void MainWindow::UpdateTitle() {
+    SetTitle("Personal Finance Tracker - " + wxString(ledgers_.GetCurrentName()));
+}
+
 void MainWindow::OnExit(wxCommandEvent& event) {
     Close(true);
 }
@@ -441,79 +1277,186 @@ void MainWindow::OnAbout(wxCommandEvent& event) {
 }
 
 void MainWindow::OnTransactionSelected(wxListEvent& event) {
-    long selectedIndex = event.GetIndex();
-    if (selectedIndex >= 0) {
-        wxString idStr = transactionList_->GetItemText(selectedIndex, 0);
-        long id;
-        if (idStr.ToLong(&id)) {
-            selectedTransactionId_ = static_cast<int>(id);
-            
-            // Get transaction details and populate fields
-            const auto& transactions = manager_.GetTransactions();
-            for (const auto& transaction : transactions) {
-                if (transaction.id == selectedTransactionId_) {
-                    PopulateInputFields(transaction);
-                    editButton_->Enable(true);
-                    deleteButton_->Enable(true);
-                    break;
-                }
-            }
+    const Transaction* transaction = transactionList_->GetTransactionAt(event.GetIndex());
+    if (transaction) {
+        selectedTransactionId_ = transaction->id;
+        PopulateInputFields(*transaction);
+        editButton_->Enable(true);
+        deleteButton_->Enable(true);
+    }
+}
+
+void MainWindow::OnColumnClick(wxListEvent& event) {
+    static const SortColumn columns[] = {
+        SortColumn::Id, SortColumn::Date, SortColumn::Description,
+        SortColumn::Category, SortColumn::Type, SortColumn::Amount
+    };
+    
+    int column = event.GetColumn();
+    if (column < 0 || column >= static_cast<int>(sizeof(columns) / sizeof(columns[0]))) {
+        return; // Balance follows date order and is not sortable on its own
+    }
+    
+    // Clicking the primary column flips its direction; any other column becomes
+    // the primary key and earlier keys are kept as tie-breakers
+    std::vector<SortKey> keys = manager_->GetSortKeys();
+    if (!keys.empty() && keys.front().column == columns[column]) {
+        keys.front().ascending = !keys.front().ascending;
+    } else {
+        keys.erase(std::remove_if(keys.begin(), keys.end(),
+                                  [&](const SortKey& key) { return key.column == columns[column]; }),
+                   keys.end());
+        keys.insert(keys.begin(), SortKey{columns[column], true});
+        if (keys.size() > 3) {
+            keys.resize(3);
         }
     }
+    
+    manager_->SetSortKeys(keys);
+    transactionList_->ShowSortIndicator(column, keys.front().ascending);
+    RefreshTransactionList();
 }
 
-void MainWindow::RefreshTransactionList() {
-    if (!transactionList_) return;
+void MainWindow::OnFilterChanged(wxCommandEvent& event) {
+    manager_->SetFilterText(filterText_->GetValue().ToStdString());
+    RefreshTransactionList();
+    
+    if (manager_->GetFilterText().empty()) {
+        SetStatusText("Ready");
+    } else {
+        SetStatusText(wxString::Format("%zu matching transactions", manager_->GetViewRows().size()));
+    }
+}
+
+void MainWindow::OnPeriodChosen(wxCommandEvent& event) {
+    int choice = periodChoice_->GetSelection();
+    bool custom = choice == kCustomPeriod;
+    periodFromPicker_->Enable(custom);
+    periodToPicker_->Enable(custom);
+    
+    const PeriodPreset& preset = kPeriods[choice];
+    if (preset.months > 0) {
+        wxDateTime from = wxDateTime::Today();
+        from.SetDay(1);
+        from -= wxDateSpan::Months(preset.monthsBack);
+        wxDateTime to = from;
+        from -= wxDateSpan::Months(preset.months - 1);
+        to.SetToLastMonthDay(to.GetMonth(), to.GetYear());
+        periodFromPicker_->SetValue(from);
+        periodToPicker_->SetValue(to);
+    }
+    ApplyPeriod();
+}
+
+void MainWindow::OnPeriodDateChanged(wxDateEvent& event) {
+    if (periodChoice_->GetSelection() != kCustomPeriod) {
+        periodChoice_->SetSelection(kCustomPeriod);
+    }
+    ApplyPeriod();
+}
+
+void MainWindow::ApplyPeriod() {
+    // Whole local days, the last one included
+    std::time_t from = 0;
+    std::time_t to = 0;
+    if (periodChoice_->GetSelection() > 0) {
+        wxDateTime first = periodFromPicker_->GetValue().GetDateOnly();
+        wxDateTime last = periodToPicker_->GetValue().GetDateOnly();
+        if (last < first) {
+            std::swap(first, last);
+        }
+        last += wxDateSpan::Day();
+        from = first.GetTicks();
+        to = last.GetTicks();
+    }
     
-    transactionList_->DeleteAllItems();
+    manager_->SetPeriod(from, to);
+    RefreshTransactionList();
+    RefreshSummary();
     
-    const auto& transactions = manager_.GetTransactions();
+    if (manager_->HasPeriod()) {
+        SetStatusText(wxString::Format("%zu transactions in period", manager_->GetViewRows().size()));
+    } else {
+        SetStatusText("Ready");
+    }
+}
+
+void MainWindow::OnPollTimer(wxTimerEvent& event) {
+    if (manager_->CheckExternalChanges()) {
+        SetStatusText("Updated with changes made outside the app");
+    }
     
-    for (size_t i = 0; i < transactions.size(); ++i) {
-        const auto& transaction = transactions[i];
-        
-        long index = transactionList_->InsertItem(i, wxString::Format("%d", transaction.id));
-        transactionList_->SetItem(index, 1, transaction.GetDateString());
-        transactionList_->SetItem(index, 2, transaction.description);
-        transactionList_->SetItem(index, 3, transaction.category);
-        transactionList_->SetItem(index, 4, transaction.GetTypeString());
-        transactionList_->SetItem(index, 5, wxString::Format("$%.2f", transaction.amount));
-        
-        // Color coding for transaction types
-        if (transaction.type == TransactionType::Income) {
-            transactionList_->SetItemTextColour(index, EMERALD_GREEN);
+    manager_->RunMaintenance(std::time(nullptr));
+    
+    BackupService& backups = manager_->GetBackups();
+    backups.RunIfDue(std::time(nullptr));
+    
+    BackupService::Result result;
+    if (backups.TakeResult(result)) {
+        if (result.succeeded) {
+            SetStatusText("Backup saved to " + wxString(result.path));
+        } else if (result.cancelled) {
+            SetStatusText("Backup cancelled");
         } else {
-            transactionList_->SetItemTextColour(index, BLACK_CHARCOAL);
-        }
-        
-        // Alternating row colors
-        if (i % 2 == 1) {
-            transactionList_->SetItemBackgroundColour(index, wxColour(248, 249, 250));
+            SetStatusText("Backup failed");
+            if (!result.scheduled) {
+                ShowNotification("Could not save the backup to " + wxString(result.path), false);
+            }
         }
+    } else if (backups.IsRunning()) {
+        SetStatusText(wxString::Format("Backing up... %d%%", static_cast<int>(backups.GetProgress() * 100)));
+    }
+}
+
+void MainWindow::OnDescriptionChanged(wxCommandEvent& event) {
+    // Suggest a category as the description is typed, until the user picks one
+    if (categoryChosenByUser_ || !descriptionText_ || !categoryChoice_) {
+        return;
     }
     
-    // Refresh the list control
-    transactionList_->Refresh();
+    wxString description = descriptionText_->GetValue().Trim();
+    if (description.IsEmpty()) {
+        return;
+    }
+    
+    CategoryPrediction suggestion = manager_->SuggestCategory(description.ToStdString());
+    int categoryIndex = categoryChoice_->FindString(suggestion.category);
+    if (categoryIndex != wxNOT_FOUND) {
+        categoryChoice_->SetSelection(categoryIndex);
+    }
+}
+
+void MainWindow::OnCategoryChosen(wxCommandEvent& event) {
+    categoryChosenByUser_ = true;
+}
+
+void MainWindow::RefreshTransactionList() {
+    if (!transactionList_) return;
+    
+    transactionList_->RefreshRows();
 }
 
 void MainWindow::RefreshSummary() {
     if (!totalIncomeLabel_ || !totalExpensesLabel_ || !balanceLabel_) return;
     
-    // Use the individual methods instead of GetAnalytics()
-    double totalIncome = manager_.GetTotalIncome();
-    double totalExpenses = manager_.GetTotalExpenses();
-    double balance = manager_.GetBalance();
+    // Flows within the chosen period, and the balance at its end
+    const CurrencyConverter::Totals& totals = manager_->GetPeriodTotals();
+    double totalIncome = totals.income;
+    double totalExpenses = totals.expenses;
+    double balance = manager_->GetPeriodClosingBalance();
+    
+    CurrencyCode currency = manager_->GetReportingCurrency();
     
     // Update income label
-    totalIncomeLabel_->SetLabel(wxString::Format("$%.2f", totalIncome));
+    totalIncomeLabel_->SetLabel(wxString::FromUTF8(FormatMoney(totalIncome, currency)));
     totalIncomeLabel_->Refresh();
     
     // Update expenses label  
-    totalExpensesLabel_->SetLabel(wxString::Format("$%.2f", totalExpenses));
+    totalExpensesLabel_->SetLabel(wxString::FromUTF8(FormatMoney(totalExpenses, currency)));
     totalExpensesLabel_->Refresh();
     
     // Update balance label with dynamic coloring
-    balanceLabel_->SetLabel(wxString::Format("$%.2f", balance));
+    balanceLabel_->SetLabel(wxString::FromUTF8(FormatMoney(balance, currency)));
     
     if (balance >= 0) {
         balanceLabel_->SetForegroundColour(EMERALD_GREEN);
@@ -521,6 +1464,72 @@ void MainWindow::RefreshSummary() {
         balanceLabel_->SetForegroundColour(wxColour(231, 76, 60)); // Red for negative balance
     }
     balanceLabel_->Refresh();
+    
+    size_t unconverted = totals.unconverted;
+    if (unconverted > 0) {
+        SetStatusText(wxString::Format("%lu transactions have no exchange rate to %s and are left out of the totals",
+                                       static_cast<unsigned long>(unconverted), wxString(CurrencyToString(currency))));
+    }
+    
+    if (chartPanel_) {
+        chartPanel_->RefreshData();
+    }
+}
+
+void MainWindow::RefreshCurrencyChoices() {
+    if (!currencyChoice_) return;
+    
+    CurrencyCode selected = currencyChoice_->GetSelection() != wxNOT_FOUND ? GetSelectedCurrency()
+                                                                           : manager_->GetReportingCurrency();
+    
+    std::vector<CurrencyCode> currencies = manager_->GetCurrencies();
+    for (const char* code : kCommonCurrencies) {
+        CurrencyCode currency;
+        if (ParseCurrency(code, currency) &&
+            std::find(currencies.begin(), currencies.end(), currency) == currencies.end()) {
+            currencies.push_back(currency);
+        }
+    }
+    std::sort(currencies.begin(), currencies.end());
+    
+    currencyChoice_->Clear();
+    for (CurrencyCode currency : currencies) {
+        currencyChoice_->Append(CurrencyToString(currency));
+    }
+    SelectCurrency(selected);
+}
+
+void MainWindow::SelectCurrency(CurrencyCode currency) {
+    if (!currencyChoice_) return;
+    
+    int index = currencyChoice_->FindString(CurrencyToString(currency));
+    if (index == wxNOT_FOUND) {
+        index = currencyChoice_->Append(CurrencyToString(currency));
+    }
+    currencyChoice_->SetSelection(index);
+}
+
+std::time_t MainWindow::GetSelectedDate(std::time_t current) const {
+    // 0 while the picker still shows the current day, so an add is stamped
+    // with the time it happens and an edit keeps its time of day
+    if (!datePicker_) {
+        return 0;
+    }
+    
+    wxDateTime picked = datePicker_->GetValue();
+    wxDateTime shown = current ? wxDateTime(static_cast<time_t>(current)) : wxDateTime::Now();
+    if (picked.IsSameDate(shown)) {
+        return 0;
+    }
+    return picked.GetDateOnly().SetHour(12).GetTicks();
+}
+
+CurrencyCode MainWindow::GetSelectedCurrency() const {
+    CurrencyCode currency = manager_->GetReportingCurrency();
+    if (currencyChoice_) {
+        ParseCurrency(currencyChoice_->GetStringSelection().ToStdString(), currency);
+    }
+    return currency;
 }
 
 void MainWindow::ClearInputFields() {
@@ -528,7 +1537,9 @@ void MainWindow::ClearInputFields() {
     if (amountText_) amountText_->Clear();
     if (categoryChoice_) categoryChoice_->SetSelection(0);
     if (typeChoice_) typeChoice_->SetSelection(1); // Default to Expense
+    SelectCurrency(manager_->GetReportingCurrency());
     if (datePicker_) datePicker_->SetValue(wxDateTime::Now());
+    categoryChosenByUser_ = false;
 }
 
 void MainWindow::PopulateInputFields(const Transaction& transaction) {
@@ -546,6 +1557,8 @@ void MainWindow::PopulateInputFields(const Transaction& transaction) {
         typeChoice_->SetSelection(transaction.type == TransactionType::Income ? 0 : 1);
     }
     
+    SelectCurrency(transaction.currency);
+    
     if (datePicker_) {
         wxDateTime date;
         date.Set(static_cast<time_t>(transaction.date));
@@ -553,6 +1566,15 @@ void MainWindow::PopulateInputFields(const Transaction& transaction) {
     }
 }
 
+void MainWindow::UpdateUndoMenu() {
+    std::string undo = manager_->GetUndoLabel();
+    std::string redo = manager_->GetRedoLabel();
+    editMenu_->SetLabel(wxID_UNDO, (undo.empty() ? wxString("&Undo") : "&Undo " + wxString::FromUTF8(undo)) + "\tCtrl-Z");
+    editMenu_->SetLabel(wxID_REDO, (redo.empty() ? wxString("&Redo") : "&Redo " + wxString::FromUTF8(redo)) + "\tCtrl-Y");
+    editMenu_->Enable(wxID_UNDO, !undo.empty());
+    editMenu_->Enable(wxID_REDO, !redo.empty());
+}
+
 void MainWindow::ShowNotification(const wxString& message, bool isSuccess) {
     if (isSuccess) {
         SetStatusText(message);
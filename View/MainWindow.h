@@ -4,28 +4,71 @@
 #include <wx/choice.h>
 #include <wx/datectrl.h>
 #include <wx/dateevt.h>
+#include <wx/timer.h>
 #include "../ViewModel/TransactionManager.h"
+#include "../ViewModel/LedgerRegistry.h"
+#include "TransactionListCtrl.h"
+#include "ChartPanel.h"
 
+// Shows the registry's current ledger; the Ledger menu switches to another
+// one in place, keeping the filter and sort order.
 class MainWindow : public wxFrame {
 public:
-    explicit MainWindow(TransactionManager& manager);
+    explicit MainWindow(LedgerRegistry& ledgers);
 
 private:
     // Event handlers
     void OnAddTransaction(wxCommandEvent& event);
     void OnEditTransaction(wxCommandEvent& event);
     void OnDeleteTransaction(wxCommandEvent& event);
+    void OnUndo(wxCommandEvent& event);
+    void OnRedo(wxCommandEvent& event);
     void OnRefresh(wxCommandEvent& event);
+    void OnImportStatement(wxCommandEvent& event);
+    void OnReconcileStatement(wxCommandEvent& event);
+    void OnMakeRecurring(wxCommandEvent& event);
+    void OnStopRecurring(wxCommandEvent& event);
+    void OnBackupNow(wxCommandEvent& event);
+    void OnRestoreBackup(wxCommandEvent& event);
+    void OnCompactDatabase(wxCommandEvent& event);
+    void OnSpendingSpread(wxCommandEvent& event);
+    void OnTopMerchants(wxCommandEvent& event);
+    void OnForecast(wxCommandEvent& event);
+    void OnImportRates(wxCommandEvent& event);
+    void OnReportingCurrency(wxCommandEvent& event);
+    void OnSwitchLedger(wxCommandEvent& event);
+    void OnAddLedger(wxCommandEvent& event);
+    void OnRemoveLedger(wxCommandEvent& event);
     void OnExit(wxCommandEvent& event);
     void OnAbout(wxCommandEvent& event);
     void OnTransactionSelected(wxListEvent& event);
+    void OnColumnClick(wxListEvent& event);
+    void OnFilterChanged(wxCommandEvent& event);
+    void OnDescriptionChanged(wxCommandEvent& event);
+    void OnCategoryChosen(wxCommandEvent& event);
+    void OnPeriodChosen(wxCommandEvent& event);
+    void OnPeriodDateChanged(wxDateEvent& event);
+    void OnPollTimer(wxTimerEvent& event);
     
     // UI update methods
     void RefreshTransactionList();
     void RefreshSummary();
     void ClearInputFields();
     void PopulateInputFields(const Transaction& transaction);
+    void RefreshCurrencyChoices();
+    void SelectCurrency(CurrencyCode currency);
+    CurrencyCode GetSelectedCurrency() const;
+    std::time_t GetSelectedDate(std::time_t current) const;
+    void ApplyPeriod();
+    void UpdateUndoMenu();
     void ShowNotification(const wxString& message, bool isSuccess = true);
+    bool ChooseReportPeriod(const wxString& title, std::time_t& from, std::time_t& to);
+    
+    // Ledger switching
+    bool SwitchLedger(const std::string& name);
+    void ObserveManager();
+    void RebuildLedgerMenu();
+    void UpdateTitle();
     
     // UI Creation methods
     void CreateMenuBar();
@@ -35,16 +78,29 @@ private:
     wxPanel* CreateListPanel(wxWindow* parent);
     
     // Member variables
-    TransactionManager& manager_;
+    LedgerRegistry& ledgers_;
+    TransactionManager* manager_;  // The current ledger's
+    int observerToken_;
     int selectedTransactionId_;
+    bool categoryChosenByUser_;
+    wxTimer pollTimer_;
+    wxMenu* editMenu_;
+    wxMenu* ledgerMenu_;
+    size_t ledgerItems_;  // Radio items at the top of ledgerMenu_
     
     // UI Controls
-    wxListCtrl* transactionList_;
+    TransactionListCtrl* transactionList_;
+    ChartPanel* chartPanel_;
     wxTextCtrl* descriptionText_;
     wxTextCtrl* amountText_;
     wxChoice* categoryChoice_;
     wxChoice* typeChoice_;
+    wxChoice* currencyChoice_;
     wxDatePickerCtrl* datePicker_;
+    wxTextCtrl* filterText_;
+    wxChoice* periodChoice_;
+    wxDatePickerCtrl* periodFromPicker_;
+    wxDatePickerCtrl* periodToPicker_;
     
     wxButton* addButton_;
     wxButton* editButton_;
@@ -62,8 +118,31 @@ private:
         ID_EDIT_TRANSACTION,
         ID_DELETE_TRANSACTION,
         ID_REFRESH,
-        ID_TRANSACTION_LIST
+        ID_TRANSACTION_LIST,
+        ID_FILTER_TEXT,
+        ID_DESCRIPTION_TEXT,
+        ID_CATEGORY_CHOICE,
+        ID_IMPORT_STATEMENT,
+        ID_RECONCILE_STATEMENT,
+        ID_MAKE_RECURRING,
+        ID_STOP_RECURRING,
+        ID_BACKUP_NOW,
+        ID_RESTORE_BACKUP,
+        ID_COMPACT_DATABASE,
+        ID_POLL_TIMER,
+        ID_ADD_LEDGER,
+        ID_REMOVE_LEDGER,
+        ID_SPENDING_SPREAD,
+        ID_TOP_MERCHANTS,
+        ID_FORECAST,
+        ID_IMPORT_RATES,
+        ID_REPORTING_CURRENCY,
+        ID_PERIOD_CHOICE,
+        ID_PERIOD_FROM,
+        ID_PERIOD_TO,
+        ID_LEDGER_FIRST,
+        ID_LEDGER_LAST = ID_LEDGER_FIRST + 31  // One per listed ledger
     };
     
     wxDECLARE_EVENT_TABLE();
-}; 
\ No newline at end of file
+};
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <wx/colour.h>
+
+// Financial Freedom Color Palette
+const wxColour EMERALD_GREEN(46, 204, 113);    // #2ECC71 - Growth, prosperity, wealth
+const wxColour MIDNIGHT_BLUE(44, 62, 80);      // #2C3E50 - Trust, stability, financial control
+const wxColour SKY_BLUE(93, 173, 226);         // #5DADE2 - Clarity, planning, peace of mind
+const wxColour SUNSHINE_YELLOW(244, 208, 63);  // #F4D03F - Optimism, energy, positive outlook
+const wxColour SOFT_MINT(169, 223, 191);       // #A9DFBF - Calm, balance, budgeting peace
+const wxColour SLATE_GRAY(149, 165, 166);      // #95A5A6 - Neutrality, professionalism
+const wxColour PURE_WHITE(255, 255, 255);      // #FFFFFF - Simplicity, cleanliness, minimalism
+const wxColour BLACK_CHARCOAL(28, 28, 28);     // #1C1C1C - Focus, strength, modern elegance
\ No newline at end of file
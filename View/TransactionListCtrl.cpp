@@ -0,0 +1,81 @@
+#include "TransactionListCtrl.h"
+#include "Palette.h"
+
+TransactionListCtrl::TransactionListCtrl(wxWindow* parent, wxWindowID id, TransactionManager& manager)
+    : wxListCtrl(parent, id, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_SINGLE_SEL | wxLC_VIRTUAL)
+    , manager_(&manager) {
+    
+    const wxColour alternateRow(248, 249, 250);
+    
+    incomeAttr_.SetTextColour(EMERALD_GREEN);
+    expenseAttr_.SetTextColour(BLACK_CHARCOAL);
+    incomeAltAttr_.SetTextColour(EMERALD_GREEN);
+    incomeAltAttr_.SetBackgroundColour(alternateRow);
+    expenseAltAttr_.SetTextColour(BLACK_CHARCOAL);
+    expenseAltAttr_.SetBackgroundColour(alternateRow);
+}
+
+void TransactionListCtrl::RefreshRows() {
+    // Positions now point at different transactions, so drop the stale selection
+    long selected = GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+    if (selected != -1) {
+        SetItemState(selected, 0, wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+    }
+    
+    long count = static_cast<long>(manager_->GetViewRows().size());
+    SetItemCount(count);
+    if (count > 0) {
+        RefreshItems(0, count - 1);
+    }
+    Refresh();
+}
+
+const Transaction* TransactionListCtrl::GetTransactionAt(long item) {
+    size_t row = SnapshotRow(item);
+    if (row == TransactionSnapshot::npos) {
+        return nullptr;
+    }
+    
+    return &manager_->GetTransactions()[row];
+}
+
+wxString TransactionListCtrl::OnGetItemText(long item, long column) const {
+    size_t row = SnapshotRow(item);
+    if (row == TransactionSnapshot::npos) {
+        return wxString();
+    }
+    
+    const Transaction& transaction = manager_->GetTransactions()[row];
+    switch (column) {
+        case 0: return wxString::Format("%d", transaction.id);
+        case 1: return transaction.reconciled ? transaction.GetDateString() + wxString::FromUTF8(" \xE2\x9C\x93")
+                                              : wxString(transaction.GetDateString());
+        case 2: return transaction.description;
+        case 3: return transaction.category;
+        case 4: return transaction.GetTypeString();
+        case 5: return wxString::FromUTF8(FormatMoney(transaction.amount, transaction.currency));
+        case 6: return wxString::FromUTF8(FormatMoney(manager_->GetRunningBalance(row), manager_->GetReportingCurrency()));
+        default: return wxString();
+    }
+}
+
+wxListItemAttr* TransactionListCtrl::OnGetItemAttr(long item) const {
+    size_t row = SnapshotRow(item);
+    bool isIncome = row != TransactionSnapshot::npos &&
+                    manager_->GetTransactions()[row].type == TransactionType::Income;
+    bool isAlternate = item % 2 == 1;
+    
+    if (isIncome) {
+        return isAlternate ? &incomeAltAttr_ : &incomeAttr_;
+    }
+    return isAlternate ? &expenseAltAttr_ : &expenseAttr_;
+}
+
+size_t TransactionListCtrl::SnapshotRow(long item) const {
+    const auto& rows = manager_->GetViewRows();
+    if (item < 0 || static_cast<size_t>(item) >= rows.size()) {
+        return TransactionSnapshot::npos;
+    }
+    
+    return rows[static_cast<size_t>(item)];
+}
\ No newline at end of file
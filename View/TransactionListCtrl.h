@@ -0,0 +1,35 @@
+#pragma once
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include "../ViewModel/TransactionManager.h"
+
+// Virtual report list over the manager's view rows. Items are rendered on
+// demand, so refreshing or re-sorting costs the same for 100 rows as for 1M.
+class TransactionListCtrl : public wxListCtrl {
+public:
+    TransactionListCtrl(wxWindow* parent, wxWindowID id, TransactionManager& manager);
+    
+    // Re-reads the row count and repaints the visible items
+    void RefreshRows();
+    
+    // Shows another ledger's rows; call RefreshRows() afterwards
+    void SetManager(TransactionManager& manager) { manager_ = &manager; }
+    
+    // Transaction shown at a list position, or nullptr when out of range
+    const Transaction* GetTransactionAt(long item);
+
+protected:
+    wxString OnGetItemText(long item, long column) const override;
+    wxListItemAttr* OnGetItemAttr(long item) const override;
+
+private:
+    TransactionManager* manager_;
+    
+    // Row styles: income/expense text colour, with and without the alternating background
+    mutable wxListItemAttr incomeAttr_;
+    mutable wxListItemAttr expenseAttr_;
+    mutable wxListItemAttr incomeAltAttr_;
+    mutable wxListItemAttr expenseAltAttr_;
+    
+    size_t SnapshotRow(long item) const;
+};
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "BackupService.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // Exactly <prefix>-YYYYMMDD-HHMMSS.db, so another program's files, or a
+    // ledger whose name merely starts the same way, are never rotated away
+    bool IsBackupName(const std::string& name, const std::string& prefix) {
+        static const char kShape[] = "-########-######.db";
+        if (name.size() != prefix.size() + sizeof(kShape) - 1 || name.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+        for (size_t i = 0; kShape[i]; ++i) {
+            char c = name[prefix.size() + i];
+            if (kShape[i] == '#' ? !std::isdigit(static_cast<unsigned char>(c)) : c != kShape[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+BackupService::BackupService(DatabaseHandler& database)
+    : database_(database)
+    , running_(false)
+    , cancel_(false)
+    , remainingPages_(0)
+    , totalPages_(0)
+    , resultReady_(false)
+    , interval_(0)
+    , keep_(0)
+    , lastScheduled_(0) {
+}
+
+BackupService::~BackupService() {
+    Cancel();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool BackupService::Start(const std::string& path) {
+    return Launch(path, false);
+}
+
+void BackupService::Cancel() {
+    cancel_ = true;
+}
+
+double BackupService::GetProgress() const {
+    int total = totalPages_;
+    return total > 0 ? static_cast<double>(total - remainingPages_) / total : 0.0;
+}
+
+bool BackupService::TakeResult(Result& result) {
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    if (!resultReady_) {
+        return false;
+    }
+    
+    result = result_;
+    resultReady_ = false;
+    return true;
+}
+
+void BackupService::SetSchedule(const std::string& directory, const std::string& prefix, std::time_t interval,
+                                size_t keep) {
+    // The worker reads the schedule when it rotates
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    
+    directory_ = directory;
+    prefix_ = prefix;
+    interval_ = interval;
+    keep_ = std::max<size_t>(1, keep);
+    
+    // The newest existing backup sets the clock, so restarting the app does not reset it
+    std::vector<std::string> backups = ListBackups();
+    lastScheduled_ = backups.empty() ? 0 : ParseTimestamp(backups.front());
+}
+
+bool BackupService::RunIfDue(std::time_t now) {
+    if (directory_.empty() || interval_ <= 0 || running_ || now - lastScheduled_ < interval_) {
+        return false;
+    }
+    
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+    
+    // A failed attempt also waits a full interval rather than retrying every tick
+    lastScheduled_ = now;
+    std::error_code error;
+    fs::create_directories(directory_, error);
+    return Launch((fs::path(directory_) / (prefix_ + "-" + stamp + ".db")).string(), true);
+}
+
+std::vector<std::string> BackupService::ListBackups() const {
+    std::vector<std::string> backups;
+    std::error_code error;
+    if (directory_.empty() || !fs::is_directory(directory_, error)) {
+        return backups;
+    }
+    
+    for (fs::directory_iterator it(directory_, error), end; !error && it != end; it.increment(error)) {
+        if (IsBackupName(it->path().filename().string(), prefix_)) {
+            backups.push_back(it->path().string());
+        }
+    }
+    
+    // Timestamps in the names sort chronologically
+    std::sort(backups.rbegin(), backups.rend());
+    return backups;
+}
+
+bool BackupService::Launch(const std::string& path, bool scheduled) {
+    if (running_) {
+        return false;
+    }
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    
+    running_ = true;
+    cancel_ = false;
+    remainingPages_ = 0;
+    totalPages_ = 0;
+    worker_ = std::thread(&BackupService::Run, this, path, scheduled);
+    return true;
+}
+
+void BackupService::Run(std::string path, bool scheduled) {
+    std::string partial = path + ".partial";
+    std::error_code error;
+    fs::remove(partial, error);
+    
+    bool copied = database_.BackupTo(partial, [this](int remaining, int total) {
+        remainingPages_ = remaining;
+        totalPages_ = total;
+        return !cancel_;
+    });
+    
+    if (copied) {
+        fs::rename(partial, path, error);
+        if (error) {
+            std::cerr << "Cannot move backup into place: " << error.message() << std::endl;
+            copied = false;
+        }
+    }
+    if (!copied) {
+        fs::remove(partial, error);
+    }
+    if (copied && scheduled) {
+        Rotate();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(resultMutex_);
+        result_.path = path;
+        result_.succeeded = copied;
+        result_.cancelled = cancel_;
+        result_.scheduled = scheduled;
+        resultReady_ = true;
+    }
+    running_ = false;
+}
+
+void BackupService::Rotate() const {
+    std::vector<std::string> backups = ListBackups();
+    std::error_code error;
+    for (size_t i = keep_; i < backups.size(); ++i) {
+        fs::remove(backups[i], error);
+    }
+}
+
+std::time_t BackupService::ParseTimestamp(const std::string& path) const {
+    std::string name = fs::path(path).filename().string();
+    std::tm time = {};
+    if (std::sscanf(name.c_str() + prefix_.size() + 1, "%4d%2d%2d-%2d%2d%2d", &time.tm_year, &time.tm_mon,
+                    &time.tm_mday, &time.tm_hour, &time.tm_min, &time.tm_sec) != 6) {
+        return 0;
+    }
+    
+    time.tm_year -= 1900;
+    time.tm_mon -= 1;
+    time.tm_isdst = -1;
+    return std::mktime(&time);
+}
\ No newline at end of file
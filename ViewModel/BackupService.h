@@ -0,0 +1,71 @@
+#pragma once
+#include "../Database/DatabaseHandler.h"
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Backs up the open ledger on a worker thread while the app keeps working,
+// plus scheduled backups into a directory that keeps only the newest few.
+// A backup is written next to its destination and renamed into place once
+// complete, so a file with the final name is always a whole database.
+// Everything here is called from the owning thread, which polls progress and
+// collects the outcome.
+class BackupService {
+public:
+    struct Result {
+        std::string path;
+        bool succeeded = false;
+        bool cancelled = false;
+        bool scheduled = false;
+    };
+    
+    explicit BackupService(DatabaseHandler& database);
+    ~BackupService();
+    
+    // Disable copy constructor and assignment operator
+    BackupService(const BackupService&) = delete;
+    BackupService& operator=(const BackupService&) = delete;
+    
+    // Returns false if a backup is already running
+    bool Start(const std::string& path);
+    void Cancel();
+    bool IsRunning() const { return running_; }
+    double GetProgress() const;
+    
+    // The outcome of the last backup, reported once after it finishes
+    bool TakeResult(Result& result);
+    
+    // Scheduled backups are named <prefix>-YYYYMMDD-HHMMSS.db in directory,
+    // one every interval seconds; after each, only the newest keep remain.
+    // Only files of exactly that shape count, so other names are left alone.
+    // RunIfDue() is cheap enough to call from a UI timer.
+    void SetSchedule(const std::string& directory, const std::string& prefix, std::time_t interval, size_t keep);
+    bool RunIfDue(std::time_t now);
+    std::vector<std::string> ListBackups() const;
+
+private:
+    DatabaseHandler& database_;
+    std::thread worker_;
+    std::atomic<bool> running_;
+    std::atomic<bool> cancel_;
+    std::atomic<int> remainingPages_;
+    std::atomic<int> totalPages_;
+    
+    std::mutex resultMutex_;
+    Result result_;
+    bool resultReady_;
+    
+    std::string directory_;
+    std::string prefix_;
+    std::time_t interval_;
+    size_t keep_;
+    std::time_t lastScheduled_;
+    
+    bool Launch(const std::string& path, bool scheduled);
+    void Run(std::string path, bool scheduled);
+    void Rotate() const;
+    std::time_t ParseTimestamp(const std::string& path) const;
+};
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "BalanceIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    size_t LowBit(size_t i) {
+        return i & (~i + 1);
+    }
+}
+
+void BalanceIndex::BuildFrom(std::vector<const Transaction*>& ordered, const CurrencyConverter::Conversion& conversion) {
+    Clear();
+    
+    std::sort(ordered.begin(), ordered.end(), [](const Transaction* a, const Transaction* b) {
+        return a->date != b->date ? a->date < b->date : a->id < b->id;
+    });
+    
+    values_.reserve(ordered.size());
+    keys_.reserve(ordered.size());
+    slotById_.reserve(ordered.size());
+    for (const Transaction* transaction : ordered) {
+        slotById_[transaction->id] = values_.size();
+        values_.push_back(SignedCents(*transaction, conversion));
+        keys_.push_back({transaction->date, transaction->id});
+    }
+    
+    // Linear-time Fenwick construction: push each node into its parent once
+    tree_.assign(values_.size() + 1, 0);
+    for (size_t i = 1; i < tree_.size(); ++i) {
+        tree_[i] += values_[i - 1];
+        size_t parent = i + LowBit(i);
+        if (parent < tree_.size()) {
+            tree_[parent] += tree_[i];
+        }
+    }
+}
+
+void BalanceIndex::Clear() {
+    tree_.assign(1, 0);
+    values_.clear();
+    keys_.clear();
+    slotById_.clear();
+}
+
+bool BalanceIndex::Append(const Transaction& transaction, const CurrencyConverter::Conversion& conversion) {
+    if (slotById_.count(transaction.id)) {
+        return false;
+    }
+    
+    if (!keys_.empty()) {
+        const SlotKey& last = keys_.back();
+        if (transaction.date < last.date || (transaction.date == last.date && transaction.id < last.id)) {
+            return false;
+        }
+    }
+    
+    if (tree_.empty()) {
+        tree_.assign(1, 0);
+    }
+    
+    std::int64_t value = SignedCents(transaction, conversion);
+    size_t i = tree_.size();
+    
+    // Node i covers slots (i - lowbit(i), i]; everything before slot i is already in the tree
+    tree_.push_back(value + Prefix(i - 1) - Prefix(i - LowBit(i)));
+    
+    slotById_[transaction.id] = values_.size();
+    values_.push_back(value);
+    keys_.push_back({transaction.date, transaction.id});
+    return true;
+}
+
+bool BalanceIndex::Update(const Transaction& transaction, const CurrencyConverter::Conversion& conversion) {
+    auto it = slotById_.find(transaction.id);
+    if (it == slotById_.end() || keys_[it->second].date != transaction.date) {
+        return false;
+    }
+    
+    size_t slot = it->second;
+    std::int64_t value = SignedCents(transaction, conversion);
+    AddToSlot(slot, value - values_[slot]);
+    values_[slot] = value;
+    return true;
+}
+
+bool BalanceIndex::Remove(int id) {
+    auto it = slotById_.find(id);
+    if (it == slotById_.end()) {
+        return false;
+    }
+    
+    // Leave a zero-valued tombstone so later slots keep their positions
+    size_t slot = it->second;
+    AddToSlot(slot, -values_[slot]);
+    values_[slot] = 0;
+    slotById_.erase(it);
+    return true;
+}
+
+bool BalanceIndex::LookupDate(int id, std::time_t& date) const {
+    auto it = slotById_.find(id);
+    if (it == slotById_.end()) {
+        return false;
+    }
+    
+    date = keys_[it->second].date;
+    return true;
+}
+
+double BalanceIndex::GetBalanceAfter(int id) const {
+    auto it = slotById_.find(id);
+    if (it == slotById_.end()) {
+        return 0.0;
+    }
+    
+    return static_cast<double>(Prefix(it->second + 1)) / 100.0;
+}
+
+double BalanceIndex::GetBalanceAsOf(std::time_t date) const {
+    auto end = std::upper_bound(keys_.begin(), keys_.end(), date,
+                                [](std::time_t value, const SlotKey& key) { return value < key.date; });
+    return static_cast<double>(Prefix(static_cast<size_t>(end - keys_.begin()))) / 100.0;
+}
+
+double BalanceIndex::GetTotal() const {
+    return static_cast<double>(Prefix(values_.size())) / 100.0;
+}
+
+std::int64_t BalanceIndex::SignedCents(const Transaction& transaction, const CurrencyConverter::Conversion& conversion) {
+    double amount;
+    if (!conversion.Convert(transaction.amount, transaction.currency, dayOf_(transaction.date), amount)) {
+        return 0;  // Left out, as in the converted totals
+    }
+    
+    std::int64_t cents = std::llround(amount * 100.0);
+    return transaction.type == TransactionType::Income ? cents : -cents;
+}
+
+void BalanceIndex::AddToSlot(size_t slot, std::int64_t delta) {
+    for (size_t i = slot + 1; i < tree_.size(); i += LowBit(i)) {
+        tree_[i] += delta;
+    }
+}
+
+std::int64_t BalanceIndex::Prefix(size_t count) const {
+    std::int64_t sum = 0;
+    for (size_t i = count; i > 0; i -= LowBit(i)) {
+        sum += tree_[i];
+    }
+    return sum;
+}
\ No newline at end of file
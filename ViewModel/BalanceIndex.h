@@ -0,0 +1,59 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include "../Model/Calendar.h"
+#include "CurrencyConverter.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <ctime>
+
+// Running-balance index over transactions in ascending (date, id) order.
+// Backed by a Fenwick tree, so point edits and prefix queries are O(log n).
+// Amounts are converted into one currency on the way in, left out when no
+// rate reaches it, and kept in integer cents to avoid drift from repeated
+// deltas. A different conversion means building the index again.
+class BalanceIndex {
+public:
+    template <typename Range>
+    void Build(const Range& transactions, const CurrencyConverter::Conversion& conversion) {
+        std::vector<const Transaction*> ordered;
+        for (const auto& transaction : transactions) {
+            ordered.push_back(&transaction);
+        }
+        BuildFrom(ordered, conversion);
+    }
+    void Clear();
+    
+    // Incremental maintenance, with the conversion the index was built with.
+    // Each returns false when the change cannot be applied in place
+    // (out-of-order append, date change); the caller should rebuild the
+    // index in that case.
+    bool Append(const Transaction& transaction, const CurrencyConverter::Conversion& conversion);
+    bool Update(const Transaction& transaction, const CurrencyConverter::Conversion& conversion);
+    bool Remove(int id);
+    
+    // Queries
+    double GetBalanceAfter(int id) const;
+    double GetBalanceAsOf(std::time_t date) const;
+    double GetTotal() const;
+    bool Contains(int id) const { return slotById_.count(id) != 0; }
+    bool LookupDate(int id, std::time_t& date) const;
+    size_t Size() const { return slotById_.size(); }
+
+private:
+    struct SlotKey {
+        std::time_t date;
+        int id;
+    };
+    
+    std::vector<std::int64_t> tree_;    // 1-based Fenwick tree over slots
+    std::vector<std::int64_t> values_;  // Signed amount per slot (0 once removed)
+    std::vector<SlotKey> keys_;         // Ascending (date, id) per slot
+    std::unordered_map<int, size_t> slotById_;
+    DayCursor dayOf_;
+    
+    void BuildFrom(std::vector<const Transaction*>& ordered, const CurrencyConverter::Conversion& conversion);
+    std::int64_t SignedCents(const Transaction& transaction, const CurrencyConverter::Conversion& conversion);
+    void AddToSlot(size_t slot, std::int64_t delta);
+    std::int64_t Prefix(size_t count) const;
+};
\ No newline at end of file
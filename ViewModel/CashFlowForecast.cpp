@@ -0,0 +1,212 @@
+#include "CashFlowForecast.h"
+#include "../Model/Calendar.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+    // SplitMix64: one word of state, so every path gets its own stream
+    std::uint64_t NextRandom(std::uint64_t& state) {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    
+    // Uniform in [0, count)
+    size_t RandomIndex(std::uint64_t& state, size_t count) {
+        return static_cast<size_t>(((NextRandom(state) >> 32) * count) >> 32);
+    }
+    
+    int CalendarMonth(MonthlyFlows::Month month) {
+        return static_cast<int>(((month % 12) + 12) % 12);
+    }
+    
+    std::int32_t FirstDayOf(MonthlyFlows::Month month) {
+        return DaysFromCivil(1970 + static_cast<int>((month - CalendarMonth(month)) / 12), CalendarMonth(month) + 1, 1);
+    }
+    
+    // Runs body(part) for part in [0, parts), one thread per part
+    template <typename Body>
+    void ParallelFor(size_t parts, Body body) {
+        std::vector<std::thread> workers;
+        workers.reserve(parts > 0 ? parts - 1 : 0);
+        for (size_t part = 1; part < parts; ++part) {
+            workers.emplace_back(body, part);
+        }
+        if (parts > 0) {
+            body(0);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    // Paths per thread below which another thread costs more than it saves
+    constexpr size_t kPathsPerThread = 128;
+}
+
+CashFlowForecast::Ptr CashFlowForecast::Build(const MonthlyFlows& flows, double balance, std::int32_t today,
+                                              const ForecastOptions& options) {
+    auto forecast = std::make_shared<CashFlowForecast>();
+    int year, month, dayOfMonth;
+    CivilFromDays(today, year, month, dayOfMonth);
+    const MonthlyFlows::Month current = MonthIndex(year, month);
+    const int months = std::max(0, std::min(options.months, 120));
+    const size_t paths = std::max<size_t>(1, options.paths);
+    
+    // The current month is still running, so profiles stop before it
+    std::vector<Profile> profiles;
+    for (const auto& category : flows.GetCategories()) {
+        Profile profile = Fit(category.second, current, options.historyMonths);
+        if (!profile.leftovers.empty()) {
+            profiles.push_back(std::move(profile));
+        }
+    }
+    
+    // Per month of the horizon and category: the expected net and the share
+    // of the month's flow landing on each of its days still to come
+    const size_t dayCount = static_cast<size_t>(FirstDayOf(current + months + 1) - today);
+    std::vector<size_t> monthStart(static_cast<size_t>(months) + 1);  // Index into the days of its first day
+    std::vector<std::vector<double>> expected(monthStart.size(), std::vector<double>(profiles.size()));
+    std::vector<std::vector<double>> shares(monthStart.size());      // [category * 31 + day]
+    for (size_t k = 0; k < monthStart.size(); ++k) {
+        MonthlyFlows::Month target = current + static_cast<MonthlyFlows::Month>(k);
+        std::int32_t first = FirstDayOf(target);
+        int length = FirstDayOf(target + 1) - first;
+        monthStart[k] = static_cast<size_t>(std::max(first - today, 0));
+        shares[k].assign(profiles.size() * 31, 0.0);
+        for (size_t c = 0; c < profiles.size(); ++c) {
+            const Profile& profile = profiles[c];
+            expected[k][c] = profile.level + profile.seasonal[CalendarMonth(target)];
+            for (int d = 0; d < length; ++d) {
+                // Days past a short month's end fold into its last day
+                double upTo = d + 1 == length ? 1.0 : profile.dayShare[d];
+                double before = d > 0 ? profile.dayShare[d - 1] : 0.0;
+                if (k > 0 || d + 1 > dayOfMonth) {
+                    shares[k][c * 31 + static_cast<size_t>(d)] = upTo - before;
+                }
+            }
+        }
+    }
+    
+    // Balances laid out day-major, so each day's paths sit together for the percentiles
+    std::vector<double> grid(dayCount * paths);
+    size_t threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, paths / kPathsPerThread));
+    
+    ParallelFor(threads, [&](size_t part) {
+        std::vector<double> totals(profiles.size());
+        for (size_t path = paths * part / threads, end = paths * (part + 1) / threads; path < end; ++path) {
+            std::uint64_t state = options.seed ^ ((path + 1) * 0xD1B54A32D192ED03ULL);
+            double running = balance;
+            grid[path] = running;
+            for (size_t k = 0; k < monthStart.size(); ++k) {
+                for (size_t c = 0; c < profiles.size(); ++c) {
+                    const std::vector<double>& leftovers = profiles[c].leftovers;
+                    totals[c] = expected[k][c] + leftovers[RandomIndex(state, leftovers.size())];
+                }
+                size_t first = k == 0 ? 1 : monthStart[k];
+                size_t last = k + 1 < monthStart.size() ? monthStart[k + 1] : dayCount;
+                size_t offset = k == 0 ? static_cast<size_t>(dayOfMonth) : 0;  // Day of month at first
+                for (size_t day = first; day < last; ++day) {
+                    const double* share = shares[k].data() + (day - first + offset);
+                    for (size_t c = 0; c < profiles.size(); ++c) {
+                        running += totals[c] * share[c * 31];
+                    }
+                    grid[day * paths + path] = running;
+                }
+            }
+        }
+    });
+    
+    forecast->days_.resize(dayCount);
+    forecast->paths_ = paths;
+    size_t dayThreads = std::max<size_t>(1, std::min(threads, dayCount / 32));
+    ParallelFor(dayThreads, [&](size_t part) {
+        for (size_t day = dayCount * part / dayThreads, end = dayCount * (part + 1) / dayThreads; day < end; ++day) {
+            // Rising ranks, so each selection only searches above the last
+            double* first = grid.data() + day * paths;
+            double* last = first + paths;
+            double* at = first;
+            auto percentile = [&](double p) {
+                double* nth = first + static_cast<size_t>(p * static_cast<double>(paths - 1) + 0.5);
+                std::nth_element(at, nth, last);
+                at = nth;
+                return *nth;
+            };
+            ForecastDay& point = forecast->days_[day];
+            point.day = today + static_cast<std::int32_t>(day);
+            point.p5 = percentile(0.05);
+            point.p25 = percentile(0.25);
+            point.median = percentile(0.5);
+            point.p75 = percentile(0.75);
+            point.p95 = percentile(0.95);
+        }
+    });
+    
+    return forecast;
+}
+
+std::vector<ForecastDay> CashFlowForecast::GetMonthEnds() const {
+    std::vector<ForecastDay> ends;
+    for (const ForecastDay& point : days_) {
+        int year, month, day;
+        CivilFromDays(point.day + 1, year, month, day);
+        if (day == 1) {
+            ends.push_back(point);
+        }
+    }
+    return ends;
+}
+
+CashFlowForecast::Profile CashFlowForecast::Fit(const MonthlyFlows::Category& category, MonthlyFlows::Month end,
+                                                size_t historyMonths) {
+    // Months before the category's first row are not zero months: it did not exist yet
+    Profile profile;
+    MonthlyFlows::Month start = std::max(end - static_cast<MonthlyFlows::Month>(historyMonths), category.firstMonth);
+    if (start >= end) {
+        return profile;
+    }
+    
+    std::vector<double> nets;
+    for (MonthlyFlows::Month month = start; month < end; ++month) {
+        nets.push_back(MonthlyFlows::NetIn(category, month));
+    }
+    for (double net : nets) {
+        profile.level += net;
+    }
+    profile.level /= static_cast<double>(nets.size());
+    
+    // Seasonal offsets are shrunk toward zero by how few years back them
+    if (nets.size() >= 24) {
+        double sums[12] = {};
+        int counts[12] = {};
+        for (size_t i = 0; i < nets.size(); ++i) {
+            int calendar = CalendarMonth(start + static_cast<MonthlyFlows::Month>(i));
+            sums[calendar] += nets[i] - profile.level;
+            ++counts[calendar];
+        }
+        for (int calendar = 0; calendar < 12; ++calendar) {
+            if (counts[calendar] > 0) {
+                profile.seasonal[calendar] = sums[calendar] / (counts[calendar] + 1);
+            }
+        }
+    }
+    
+    profile.leftovers.reserve(nets.size());
+    for (size_t i = 0; i < nets.size(); ++i) {
+        int calendar = CalendarMonth(start + static_cast<MonthlyFlows::Month>(i));
+        profile.leftovers.push_back(nets[i] - profile.level - profile.seasonal[calendar]);
+    }
+    
+    double total = 0.0;
+    for (double weight : category.dayWeight) {
+        total += std::max(weight, 0.0);
+    }
+    double sum = 0.0;
+    for (size_t d = 0; d < 31; ++d) {
+        sum += std::max(category.dayWeight[d], 0.0);
+        profile.dayShare[d] = total > 0.0 ? sum / total : (d + 1) / 31.0;
+    }
+    return profile;
+}
\ No newline at end of file
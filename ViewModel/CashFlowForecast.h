@@ -0,0 +1,62 @@
+#pragma once
+#include "MonthlyFlows.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+struct ForecastOptions {
+    int months = 12;              // Whole months after the current one
+    size_t paths = 2000;          // Simulated futures
+    size_t historyMonths = 36;    // Most recent complete months the profiles are fitted to
+    std::uint64_t seed = 20240601;
+    size_t threads = 0;           // 0 for one per hardware thread
+};
+
+// Projected balance at the end of one day: percentiles across the paths
+struct ForecastDay {
+    std::int32_t day;  // Days since 1970-01-01
+    double p5;
+    double p25;
+    double median;
+    double p75;
+    double p95;
+};
+
+// Balance forecast from the ledger's own history. Each category gets a
+// profile from its recent monthly nets: a level (the mean), a seasonal
+// offset per calendar month once there are two years to compare, and the
+// months' leftovers after both. A simulated month draws a leftover at
+// random for each category, which keeps the lumps and skew of real
+// spending, and spreads the total over the days the way that category's
+// money has moved before. Paths are split across worker threads, each path
+// seeded from its number, so results do not depend on the thread count.
+class CashFlowForecast {
+public:
+    using Ptr = std::shared_ptr<const CashFlowForecast>;
+    
+    // balance is where the ledger stands at the end of today
+    static Ptr Build(const MonthlyFlows& flows, double balance, std::int32_t today, const ForecastOptions& options);
+    
+    // today first, then every day to the end of the horizon
+    const std::vector<ForecastDay>& GetDays() const { return days_; }
+    
+    // The last day of each month in the horizon
+    std::vector<ForecastDay> GetMonthEnds() const;
+    
+    size_t GetPaths() const { return paths_; }
+
+private:
+    // Fitted to one category's history
+    struct Profile {
+        double level = 0.0;
+        double seasonal[12] = {};
+        std::vector<double> leftovers;
+        double dayShare[31] = {};  // Cumulative share of a month's flow by the end of each day
+    };
+    
+    std::vector<ForecastDay> days_;
+    size_t paths_ = 0;
+    
+    static Profile Fit(const MonthlyFlows::Category& category, MonthlyFlows::Month end, size_t historyMonths);
+};
\ No newline at end of file
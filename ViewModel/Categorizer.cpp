@@ -0,0 +1,199 @@
+#include "Categorizer.h"
+#include <algorithm>
+#include <thread>
+#include <cctype>
+#include <cmath>
+
+namespace {
+    constexpr double kAlpha = 0.5;
+    constexpr size_t kInitialStride = 16;
+    constexpr size_t kParallelThreshold = 4096;
+    
+    // Calls visit(feature) for each alphanumeric token, case-folded and hashed
+    // with FNV-1a. Pure numbers (cheque numbers, store ids) are skipped.
+    template <typename Visit>
+    void ForEachFeature(const std::string& text, Visit visit) {
+        std::uint64_t hash = 14695981039346656037ULL;
+        size_t length = 0;
+        bool digitsOnly = true;
+        
+        for (size_t i = 0; i <= text.size(); ++i) {
+            unsigned char c = i < text.size() ? static_cast<unsigned char>(text[i]) : ' ';
+            if (std::isalnum(c)) {
+                hash = (hash ^ static_cast<unsigned char>(std::tolower(c))) * 1099511628211ULL;
+                digitsOnly = digitsOnly && std::isdigit(c);
+                ++length;
+            } else if (length > 0) {
+                if (!digitsOnly) {
+                    visit(static_cast<size_t>((hash ^ (hash >> 32)) & (Categorizer::kFeatureCount - 1)));
+                }
+                hash = 14695981039346656037ULL;
+                length = 0;
+                digitsOnly = true;
+            }
+        }
+    }
+}
+
+Categorizer::Categorizer() {
+    Clear();
+}
+
+void Categorizer::Clear() {
+    categories_.clear();
+    categoryIds_.clear();
+    stride_ = kInitialStride;
+    counts_.assign(kFeatureCount * stride_, 0);
+    weights_.assign(kFeatureCount * stride_, static_cast<float>(std::log(kAlpha)));
+    classTokens_.clear();
+    classDocuments_.clear();
+    logDenominator_.clear();
+    logPrior_.clear();
+    totalDocuments_ = 0;
+}
+
+void Categorizer::Train(const std::string& description, const std::string& category) {
+    Learn(description, category);
+    RefreshClassTerms();
+}
+
+void Categorizer::Untrain(const std::string& description, const std::string& category) {
+    auto it = categoryIds_.find(category);
+    if (it == categoryIds_.end() || classDocuments_[it->second] == 0) {
+        return;
+    }
+    
+    --classDocuments_[it->second];
+    --totalDocuments_;
+    Adjust(description, it->second, -1);
+    RefreshClassTerms();
+}
+
+CategoryPrediction Categorizer::Classify(const std::string& description) const {
+    const size_t classes = categories_.size();
+    if (totalDocuments_ == 0) {
+        return {std::string(), 0.0};
+    }
+    
+    // Scores start from the prior; each token adds its per-class log likelihood
+    std::vector<double> score(logPrior_);
+    size_t tokens = 0;
+    ForEachFeature(description, [&](size_t feature) {
+        const float* row = &weights_[feature * stride_];
+        for (size_t c = 0; c < classes; ++c) {
+            score[c] += row[c];
+        }
+        ++tokens;
+    });
+    
+    size_t best = classes;
+    for (size_t c = 0; c < classes; ++c) {
+        if (classDocuments_[c] == 0) {
+            continue;
+        }
+        score[c] -= static_cast<double>(tokens) * logDenominator_[c];
+        if (best == classes || score[c] > score[best]) {
+            best = c;
+        }
+    }
+    
+    // Posterior of the winner: 1 / sum(exp(score - best))
+    double sum = 0.0;
+    for (size_t c = 0; c < classes; ++c) {
+        if (classDocuments_[c] != 0) {
+            sum += std::exp(score[c] - score[best]);
+        }
+    }
+    
+    return {categories_[best], 1.0 / sum};
+}
+
+std::vector<CategoryPrediction> Categorizer::ClassifyBatch(const std::vector<std::string>& descriptions) const {
+    std::vector<CategoryPrediction> predictions(descriptions.size());
+    
+    size_t parts = 1;
+    if (descriptions.size() >= kParallelThreshold) {
+        parts = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    
+    auto classifyPart = [&](size_t part) {
+        size_t end = descriptions.size() * (part + 1) / parts;
+        for (size_t i = descriptions.size() * part / parts; i < end; ++i) {
+            predictions[i] = Classify(descriptions[i]);
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for (size_t part = 1; part < parts; ++part) {
+        workers.emplace_back(classifyPart, part);
+    }
+    classifyPart(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    return predictions;
+}
+
+void Categorizer::Learn(const std::string& description, const std::string& category) {
+    if (category.empty()) {
+        return;
+    }
+    
+    size_t id = CategoryId(category);
+    ++classDocuments_[id];
+    ++totalDocuments_;
+    Adjust(description, id, 1);
+}
+
+size_t Categorizer::CategoryId(const std::string& category) {
+    auto it = categoryIds_.find(category);
+    if (it != categoryIds_.end()) {
+        return it->second;
+    }
+    
+    size_t id = categories_.size();
+    if (id == stride_) {
+        // Out of class slots: widen every feature row, keeping existing counts
+        size_t wider = stride_ * 2;
+        std::vector<std::uint32_t> counts(kFeatureCount * wider, 0);
+        std::vector<float> weights(kFeatureCount * wider, static_cast<float>(std::log(kAlpha)));
+        for (size_t feature = 0; feature < kFeatureCount; ++feature) {
+            std::copy_n(&counts_[feature * stride_], stride_, &counts[feature * wider]);
+            std::copy_n(&weights_[feature * stride_], stride_, &weights[feature * wider]);
+        }
+        counts_.swap(counts);
+        weights_.swap(weights);
+        stride_ = wider;
+    }
+    
+    categories_.push_back(category);
+    categoryIds_.emplace(category, id);
+    classTokens_.push_back(0);
+    classDocuments_.push_back(0);
+    logDenominator_.push_back(0.0);
+    logPrior_.push_back(0.0);
+    return id;
+}
+
+void Categorizer::Adjust(const std::string& description, size_t category, int delta) {
+    ForEachFeature(description, [&](size_t feature) {
+        std::uint32_t& count = counts_[feature * stride_ + category];
+        if (delta < 0 && count == 0) {
+            return;
+        }
+        
+        count = static_cast<std::uint32_t>(static_cast<std::int64_t>(count) + delta);
+        classTokens_[category] = static_cast<std::uint64_t>(static_cast<std::int64_t>(classTokens_[category]) + delta);
+        weights_[feature * stride_ + category] = static_cast<float>(std::log(count + kAlpha));
+    });
+}
+
+void Categorizer::RefreshClassTerms() {
+    const double classes = static_cast<double>(categories_.size());
+    for (size_t c = 0; c < categories_.size(); ++c) {
+        logDenominator_[c] = std::log(static_cast<double>(classTokens_[c]) + kAlpha * kFeatureCount);
+        logPrior_[c] = std::log((static_cast<double>(classDocuments_[c]) + 1.0) /
+                                (static_cast<double>(totalDocuments_) + classes));
+    }
+}
\ No newline at end of file
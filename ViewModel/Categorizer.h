@@ -0,0 +1,62 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+struct CategoryPrediction {
+    std::string category;   // Empty when nothing has been learned yet
+    double confidence;      // Posterior probability of the chosen category
+};
+
+// Multinomial naive Bayes over hashed description tokens. Each training
+// pair only touches the weights of its own tokens, so the model follows
+// every add, edit and delete without retraining. Weights are stored
+// feature-major so scoring a token reads one contiguous run of classes.
+class Categorizer {
+public:
+    static constexpr unsigned kFeatureBits = 16;
+    static constexpr size_t kFeatureCount = size_t(1) << kFeatureBits;
+    
+    Categorizer();
+    
+    template <typename Range>
+    void Build(const Range& transactions) {
+        Clear();
+        for (const auto& transaction : transactions) {
+            Learn(transaction.description, transaction.category);
+        }
+        RefreshClassTerms();
+    }
+    void Clear();
+    
+    // Incremental updates
+    void Train(const std::string& description, const std::string& category);
+    void Untrain(const std::string& description, const std::string& category);
+    
+    // Classification. Batches are split across threads when large.
+    CategoryPrediction Classify(const std::string& description) const;
+    std::vector<CategoryPrediction> ClassifyBatch(const std::vector<std::string>& descriptions) const;
+    
+    size_t GetCategoryCount() const { return categories_.size(); }
+    std::uint64_t GetTrainingCount() const { return totalDocuments_; }
+
+private:
+    std::vector<std::string> categories_;
+    std::unordered_map<std::string, size_t> categoryIds_;
+    size_t stride_;                          // Class slots per feature
+    
+    std::vector<std::uint32_t> counts_;      // [feature * stride_ + class]
+    std::vector<float> weights_;             // log(count + alpha), same layout
+    std::vector<std::uint64_t> classTokens_;
+    std::vector<std::uint64_t> classDocuments_;
+    std::vector<double> logDenominator_;     // log(tokens + alpha * features) per class
+    std::vector<double> logPrior_;
+    std::uint64_t totalDocuments_;
+    
+    size_t CategoryId(const std::string& category);
+    void Learn(const std::string& description, const std::string& category);
+    void Adjust(const std::string& description, size_t category, int delta);
+    void RefreshClassTerms();
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "ChartSeries.h"
+#include "../Model/Calendar.h"
+#include <algorithm>
+
+ChartSeries::Ptr ChartSeries::Build(const TransactionSnapshot& rows, const CurrencyConverter::Conversion& conversion) {
+    auto series = std::make_shared<ChartSeries>();
+    series->currency_ = conversion.GetTarget();
+    
+    // Rows come newest first, so the balance is walked backwards from a
+    // closing balance of zero and shifted once the total is known
+    struct MonthTotal {
+        std::int32_t month;
+        double income;
+        double expenses;
+    };
+    std::vector<Extent> extents;
+    std::vector<MonthTotal> months;
+    DayCursor dayOf;
+    CurrencyCode currency = conversion.GetTarget();
+    const double* factors = conversion.Factors(currency);
+    std::int32_t lastDay = 0;
+    std::int32_t lastMonth = 0;
+    double balance = 0.0;
+    for (const auto& transaction : rows) {
+        if (transaction.currency != currency) {
+            currency = transaction.currency;
+            factors = conversion.Factors(currency);
+        }
+        if (!factors) {
+            continue;
+        }
+        
+        std::int32_t day = dayOf(transaction.date);
+        double amount = currency == conversion.GetTarget()
+                        ? transaction.amount : transaction.amount * factors[conversion.Index(day)];
+        
+        if (series->days_.empty() || day != lastDay) {
+            series->days_.push_back(day);
+            series->close_.push_back(balance);
+            extents.push_back({balance, balance});
+            lastDay = day;
+            
+            int year, month, dayOfMonth;
+            CivilFromDays(day, year, month, dayOfMonth);
+            std::int32_t monthIndex = MonthIndex(year, month);
+            if (months.empty() || monthIndex != lastMonth) {
+                months.push_back({monthIndex, 0.0, 0.0});
+                lastMonth = monthIndex;
+            }
+        }
+        
+        if (transaction.type == TransactionType::Income) {
+            months.back().income += amount;
+            balance -= amount;
+        } else {
+            months.back().expenses += amount;
+            balance += amount;
+        }
+        
+        // The balance before the row; for the day's first row that is the
+        // previous close, which keeps consecutive days' ranges joined up
+        Extent& extent = extents.back();
+        extent.low = std::min(extent.low, balance);
+        extent.high = std::max(extent.high, balance);
+    }
+    
+    if (series->days_.empty()) {
+        return series;
+    }
+    
+    // The walk ended on minus the total: the ledger's opening balance of
+    // zero, measured from the close
+    double shift = -balance;
+    std::reverse(series->days_.begin(), series->days_.end());
+    std::reverse(series->close_.begin(), series->close_.end());
+    std::reverse(extents.begin(), extents.end());
+    for (size_t i = 0; i < series->days_.size(); ++i) {
+        series->close_[i] += shift;
+        extents[i].low += shift;
+        extents[i].high += shift;
+    }
+    
+    // Level 0 holds each day's range; each level above summarizes
+    // kFanOut entries of the one below
+    series->levels_.push_back(std::move(extents));
+    while (series->levels_.back().size() > kFanOut) {
+        const std::vector<Extent>& below = series->levels_.back();
+        std::vector<Extent> level((below.size() + kFanOut - 1) / kFanOut);
+        for (size_t i = 0; i < below.size(); ++i) {
+            Extent& extent = level[i / kFanOut];
+            if (i % kFanOut == 0) {
+                extent = below[i];
+            } else {
+                extent.low = std::min(extent.low, below[i].low);
+                extent.high = std::max(extent.high, below[i].high);
+            }
+        }
+        series->levels_.push_back(std::move(level));
+    }
+    
+    // Dense prefix sums over every month from the first to the last
+    std::reverse(months.begin(), months.end());
+    series->firstMonth_ = months.front().month;
+    size_t span = static_cast<size_t>(months.back().month - months.front().month) + 1;
+    series->incomeBefore_.assign(span + 1, 0.0);
+    series->expensesBefore_.assign(span + 1, 0.0);
+    size_t next = 0;
+    for (size_t i = 0; i < span; ++i) {
+        double income = 0.0;
+        double expenses = 0.0;
+        if (next < months.size() && months[next].month == series->firstMonth_ + static_cast<std::int32_t>(i)) {
+            income = months[next].income;
+            expenses = months[next].expenses;
+            ++next;
+        }
+        series->incomeBefore_[i + 1] = series->incomeBefore_[i] + income;
+        series->expensesBefore_[i + 1] = series->expensesBefore_[i] + expenses;
+    }
+    return series;
+}
+
+std::vector<BalanceBucket> ChartSeries::GetBalance(double firstDay, double daysPerSlot, size_t slots) const {
+    std::vector<BalanceBucket> buckets(slots, BalanceBucket{0.0, 0.0, 0.0, true});
+    if (days_.empty() || !(daysPerSlot > 0.0)) {
+        return buckets;
+    }
+    
+    size_t first = DayIndex(firstDay);
+    for (size_t slot = 0; slot < slots; ++slot) {
+        size_t last = DayIndex(firstDay + static_cast<double>(slot + 1) * daysPerSlot);
+        BalanceBucket& bucket = buckets[slot];
+        if (first < last) {
+            Extent extent = Range(first, last);
+            bucket = {extent.low, extent.high, close_[last - 1], false};
+        } else if (first > 0) {
+            double carried = close_[first - 1];
+            bucket = {carried, carried, carried, false};
+        }
+        first = last;
+    }
+    return buckets;
+}
+
+std::vector<FlowBucket> ChartSeries::GetFlows(std::int32_t firstMonth, std::int32_t lastMonth, size_t maxBars) const {
+    std::vector<FlowBucket> bars;
+    if (days_.empty() || lastMonth < firstMonth || maxBars == 0) {
+        return bars;
+    }
+    
+    std::int64_t span = static_cast<std::int64_t>(lastMonth) - firstMonth + 1;
+    std::int64_t group = (span + static_cast<std::int64_t>(maxBars) - 1) / static_cast<std::int64_t>(maxBars);
+    
+    // Align to the group size relative to January 1970, rounding down
+    std::int64_t start = firstMonth;
+    start -= ((start % group) + group) % group;
+    
+    std::int64_t stored = static_cast<std::int64_t>(incomeBefore_.size()) - 1;
+    auto clamp = [&](std::int64_t month) {
+        return static_cast<size_t>(std::min(std::max(month - firstMonth_, std::int64_t(0)), stored));
+    };
+    for (std::int64_t month = start; month <= lastMonth; month += group) {
+        size_t from = clamp(month);
+        size_t to = clamp(month + group);
+        if (from == to) {
+            continue;
+        }
+        bars.push_back({static_cast<std::int32_t>(month), static_cast<std::int32_t>(group),
+                        incomeBefore_[to] - incomeBefore_[from], expensesBefore_[to] - expensesBefore_[from]});
+    }
+    return bars;
+}
+
+ChartSeries::Extent ChartSeries::Range(size_t first, size_t last) const {
+    Extent extent = levels_[0][first];
+    auto take = [&](const Extent& other) {
+        extent.low = std::min(extent.low, other.low);
+        extent.high = std::max(extent.high, other.high);
+    };
+    
+    // Peel off the unaligned ends at each level, then go up one
+    for (size_t level = 0; first < last; ++level) {
+        const std::vector<Extent>& entries = levels_[level];
+        if (level + 1 == levels_.size()) {
+            for (; first < last; ++first) {
+                take(entries[first]);
+            }
+            break;
+        }
+        for (; first < last && first % kFanOut != 0; ++first) {
+            take(entries[first]);
+        }
+        for (; first < last && last % kFanOut != 0; --last) {
+            take(entries[last - 1]);
+        }
+        first /= kFanOut;
+        last /= kFanOut;
+    }
+    return extent;
+}
+
+size_t ChartSeries::DayIndex(double day) const {
+    return static_cast<size_t>(std::lower_bound(days_.begin(), days_.end(), day,
+                                                [](std::int32_t stored, double value) { return stored < value; })
+                               - days_.begin());
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include "TransactionSnapshot.h"
+#include "CurrencyConverter.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Balance for one horizontal slot of a chart: its range over the slot and
+// where it ended. Slots with no transactions carry the previous close.
+struct BalanceBucket {
+    double low;
+    double high;
+    double close;
+    bool empty;  // Before the first transaction
+};
+
+// Money in and out over a run of whole months
+struct FlowBucket {
+    std::int32_t firstMonth;  // MonthIndex()
+    std::int32_t months;
+    double income;
+    double expenses;
+};
+
+// Chart data for a ledger: the running balance per local day, kept with
+// each day's intraday low and high, and income and expenses per month, all
+// in one currency. Built in one pass over a snapshot; afterwards a query
+// for any range and number of slots costs O(slots * log days), whatever
+// the row count, so a chart can redraw on every pan or zoom step.
+class ChartSeries {
+public:
+    using Ptr = std::shared_ptr<const ChartSeries>;
+    
+    // Rows with no rate into the conversion's target are left out
+    static Ptr Build(const TransactionSnapshot& rows, const CurrencyConverter::Conversion& conversion);
+    
+    bool Empty() const { return days_.empty(); }
+    std::int32_t GetFirstDay() const { return days_.empty() ? 0 : days_.front(); }
+    std::int32_t GetLastDay() const { return days_.empty() ? 0 : days_.back(); }
+    CurrencyCode GetCurrency() const { return currency_; }
+    
+    // Min/max downsampling: slot i covers days
+    // [firstDay + i * daysPerSlot, firstDay + (i + 1) * daysPerSlot)
+    std::vector<BalanceBucket> GetBalance(double firstDay, double daysPerSlot, size_t slots) const;
+    
+    // Monthly flows over [firstMonth, lastMonth], months grouped so that
+    // at most maxBars come back. Groups start at multiples of their size,
+    // so bars keep their place while the range moves.
+    std::vector<FlowBucket> GetFlows(std::int32_t firstMonth, std::int32_t lastMonth, size_t maxBars) const;
+
+private:
+    struct Extent {
+        double low;
+        double high;
+    };
+    
+    static constexpr size_t kFanOut = 16;
+    
+    CurrencyCode currency_ = kDefaultCurrency;
+    std::vector<std::int32_t> days_;          // Ascending, one per day with rows
+    std::vector<double> close_;               // Balance at the end of each day
+    std::vector<std::vector<Extent>> levels_; // levels_[0] per day, each next one per kFanOut of the last
+    
+    std::int32_t firstMonth_ = 0;
+    std::vector<double> incomeBefore_;        // Prefix sums per month from firstMonth_
+    std::vector<double> expensesBefore_;
+    
+    Extent Range(size_t first, size_t last) const;  // Over days [first, last)
+    size_t DayIndex(double day) const;              // First day at or after
+};
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "CurrencyConverter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+void CurrencyConverter::Build(const std::vector<ExchangeRate>& rates) {
+    pivot_ = kDefaultCurrency;
+    firstDay_ = 0;
+    days_ = 0;
+    currencies_.clear();
+    values_.clear();
+    
+    auto usable = [](const ExchangeRate& rate) {
+        return rate.base != rate.quote && rate.rate > 0.0 && std::isfinite(rate.rate);
+    };
+    
+    std::unordered_map<CurrencyCode, size_t> quotes;
+    std::int32_t lastDay = std::numeric_limits<std::int32_t>::min();
+    firstDay_ = std::numeric_limits<std::int32_t>::max();
+    for (const auto& rate : rates) {
+        if (usable(rate)) {
+            ++quotes[rate.base];
+            ++quotes[rate.quote];
+            firstDay_ = std::min(firstDay_, rate.day);
+            lastDay = std::max(lastDay, rate.day);
+        }
+    }
+    if (quotes.empty()) {
+        firstDay_ = 0;
+        return;
+    }
+    
+    // Ties go to the lower code so the same quotes always pick the same pivot
+    size_t mostQuotes = 0;
+    for (const auto& entry : quotes) {
+        if (entry.second > mostQuotes || (entry.second == mostQuotes && entry.first < pivot_)) {
+            pivot_ = entry.first;
+            mostQuotes = entry.second;
+        }
+    }
+    
+    days_ = static_cast<size_t>(static_cast<std::int64_t>(lastDay) - firstDay_ + 1);
+    std::unordered_map<CurrencyCode, size_t> slots{{pivot_, 0}};
+    std::vector<CurrencyCode> bySlot{pivot_};
+    values_.assign(days_, 1.0);
+    
+    // Each round values every currency quoted against one valued in an
+    // earlier round. Its rate against that parent is filled across the days
+    // and then multiplied by the parent's own series, so a parent moving
+    // carries through to the days its child was not quoted.
+    using Points = std::vector<std::pair<std::int32_t, double>>;
+    bool valuedMore = true;
+    while (valuedMore) {
+        std::unordered_map<CurrencyCode, std::unordered_map<CurrencyCode, Points>> candidates;
+        for (const auto& rate : rates) {
+            if (!usable(rate)) {
+                continue;
+            }
+            bool baseValued = slots.count(rate.base) != 0;
+            bool quoteValued = slots.count(rate.quote) != 0;
+            if (!baseValued && quoteValued) {
+                candidates[rate.base][rate.quote].emplace_back(rate.day, rate.rate);
+            } else if (baseValued && !quoteValued) {
+                candidates[rate.quote][rate.base].emplace_back(rate.day, 1.0 / rate.rate);
+            }
+        }
+        
+        valuedMore = !candidates.empty();
+        for (auto& entry : candidates) {
+            // The parent with the most quotes; ties to the lower code
+            CurrencyCode parent = 0;
+            Points* known = nullptr;
+            for (auto& option : entry.second) {
+                if (!known || option.second.size() > known->size() ||
+                    (option.second.size() == known->size() && option.first < parent)) {
+                    parent = option.first;
+                    known = &option.second;
+                }
+            }
+            std::stable_sort(known->begin(), known->end(),
+                             [](const std::pair<std::int32_t, double>& a, const std::pair<std::int32_t, double>& b) {
+                                 return a.first < b.first;
+                             });
+            
+            size_t parentStart = slots[parent] * days_;
+            size_t start = values_.size();
+            values_.resize(start + days_);
+            double current = known->front().second;
+            size_t next = 0;
+            for (size_t day = 0; day < days_; ++day) {
+                while (next < known->size() && static_cast<size_t>((*known)[next].first - firstDay_) == day) {
+                    current = (*known)[next++].second;
+                }
+                values_[start + day] = current * values_[parentStart + day];
+            }
+            
+            slots.emplace(entry.first, bySlot.size());
+            bySlot.push_back(entry.first);
+        }
+    }
+    
+    // Store the series in code order for binary search
+    std::vector<size_t> order(bySlot.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return bySlot[a] < bySlot[b]; });
+    
+    std::vector<double> sorted;
+    sorted.reserve(values_.size());
+    for (size_t slot : order) {
+        currencies_.push_back(bySlot[slot]);
+        sorted.insert(sorted.end(), values_.begin() + slot * days_, values_.begin() + (slot + 1) * days_);
+    }
+    values_ = std::move(sorted);
+}
+
+const double* CurrencyConverter::Series(CurrencyCode currency) const {
+    auto found = std::lower_bound(currencies_.begin(), currencies_.end(), currency);
+    if (found == currencies_.end() || *found != currency) {
+        return nullptr;
+    }
+    return values_.data() + (found - currencies_.begin()) * days_;
+}
+
+CurrencyConverter::Conversion CurrencyConverter::To(CurrencyCode target) const {
+    Conversion conversion;
+    conversion.target_ = target;
+    conversion.firstDay_ = firstDay_;
+    conversion.days_ = days_;
+    conversion.identity_.assign(std::max<size_t>(days_, 1), 1.0);
+    
+    const double* targetValues = Series(target);
+    if (!targetValues) {
+        return conversion;  // Only amounts already in the target convert
+    }
+    
+    conversion.factors_.reserve((currencies_.size() - 1) * days_);
+    for (size_t i = 0; i < currencies_.size(); ++i) {
+        if (currencies_[i] == target) {
+            continue;
+        }
+        const double* values = values_.data() + i * days_;
+        conversion.currencies_.push_back(currencies_[i]);
+        for (size_t day = 0; day < days_; ++day) {
+            conversion.factors_.push_back(values[day] / targetValues[day]);
+        }
+    }
+    return conversion;
+}
+
+const double* CurrencyConverter::Conversion::Factors(CurrencyCode from) const {
+    if (from == target_) {
+        return identity_.data();
+    }
+    
+    auto found = std::lower_bound(currencies_.begin(), currencies_.end(), from);
+    if (found == currencies_.end() || *found != from) {
+        return nullptr;
+    }
+    return factors_.data() + (found - currencies_.begin()) * days_;
+}
+
+bool CurrencyConverter::Conversion::Convert(double amount, CurrencyCode from, std::int32_t day,
+                                            double& converted) const {
+    const double* factors = Factors(from);
+    if (!factors) {
+        return false;
+    }
+    converted = amount * factors[Index(day)];
+    return true;
+}
+
+CurrencyConverter::Totals CurrencyConverter::Summarize(const TransactionSnapshot& rows, CurrencyCode target,
+                                                      size_t first, size_t last) const {
+    last = std::min(last, rows.size());
+    first = std::min(first, last);
+    
+    Totals totals;
+    totals.currency = target;
+    totals.rows = last - first;
+    
+    Conversion conversion = To(target);
+    DayCursor dayOf;
+    
+    // Ledgers are mostly one currency, and rows of a day sit together, so
+    // both lookups are usually answered from the previous row
+    CurrencyCode currency = target;
+    const double* factors = conversion.Factors(target);
+    std::string lastCategory;
+    double* categoryTotal = nullptr;
+    auto end = rows.IteratorAt(last);
+    for (auto row = rows.IteratorAt(first); row != end; ++row) {
+        const Transaction& transaction = *row;
+        if (transaction.currency != currency) {
+            currency = transaction.currency;
+            factors = conversion.Factors(currency);
+        }
+        if (!factors) {
+            ++totals.unconverted;
+            continue;
+        }
+        
+        double amount = currency == target ? transaction.amount
+                                           : transaction.amount * factors[conversion.Index(dayOf(transaction.date))];
+        if (transaction.type == TransactionType::Income) {
+            totals.income += amount;
+        } else {
+            totals.expenses += amount;
+        }
+        
+        if (!categoryTotal || transaction.category != lastCategory) {
+            lastCategory = transaction.category;
+            categoryTotal = &totals.byCategory[lastCategory];
+        }
+        *categoryTotal += amount;
+    }
+    return totals;
+}
+
+void CurrencyConverter::ConvertAmounts(const TransactionSnapshot& rows, CurrencyCode target,
+                                       std::vector<double>& amounts) const {
+    Conversion conversion = To(target);
+    DayCursor dayOf;
+    
+    amounts.resize(rows.size());
+    double* out = amounts.data();
+    CurrencyCode currency = target;
+    const double* factors = conversion.Factors(target);
+    for (const auto& transaction : rows) {
+        if (transaction.currency != currency) {
+            currency = transaction.currency;
+            factors = conversion.Factors(currency);
+        }
+        
+        double amount = transaction.type == TransactionType::Income ? transaction.amount : -transaction.amount;
+        if (!factors) {
+            *out++ = std::numeric_limits<double>::quiet_NaN();
+        } else {
+            *out++ = currency == target ? amount : amount * factors[conversion.Index(dayOf(transaction.date))];
+        }
+    }
+}
\ No newline at end of file
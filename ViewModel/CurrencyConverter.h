@@ -0,0 +1,88 @@
+#pragma once
+#include "../Model/Currency.h"
+#include "TransactionSnapshot.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <ctime>
+
+// In-memory exchange rate cache. The stored quotes are turned into one dense
+// daily series per currency, valued in a common pivot currency (the one
+// quoted most often) and covering every day from the first quote to the last:
+// gaps take the previous day's rate, days before the first quote take the
+// first one and days after the last take the last one. Currencies quoted only
+// against each other are chained to the pivot through whichever neighbour is
+// already valued. A conversion to a target then precomputes a factor per
+// currency and day, so converting a row costs an index and a multiply.
+class CurrencyConverter {
+public:
+    using Ptr = std::shared_ptr<const CurrencyConverter>;
+    
+    // Factors into one target currency. Immutable once made; any number of
+    // threads may use it.
+    class Conversion {
+    public:
+        CurrencyCode GetTarget() const { return target_; }
+        
+        // Factor series for amounts in from, or nullptr when no rate links it
+        // to the target. Index it with Index(day).
+        const double* Factors(CurrencyCode from) const;
+        size_t Index(std::int32_t day) const {
+            if (day <= firstDay_ || days_ == 0) {
+                return 0;
+            }
+            size_t index = static_cast<size_t>(day - firstDay_);
+            return index < days_ ? index : days_ - 1;
+        }
+        
+        bool Convert(double amount, CurrencyCode from, std::int32_t day, double& converted) const;
+    
+    private:
+        friend class CurrencyConverter;
+        
+        CurrencyCode target_ = kDefaultCurrency;
+        std::int32_t firstDay_ = 0;
+        size_t days_ = 0;
+        std::vector<CurrencyCode> currencies_;
+        std::vector<double> factors_;   // days_ per currency, in currencies_ order
+        std::vector<double> identity_;  // The target's own series: all ones
+    };
+    
+    // Totals of a snapshot in one currency. Rows in a currency no rate links
+    // to the target are left out and counted.
+    struct Totals {
+        CurrencyCode currency = kDefaultCurrency;
+        double income = 0.0;
+        double expenses = 0.0;
+        std::unordered_map<std::string, double> byCategory;  // Income and expenses alike
+        size_t rows = 0;
+        size_t unconverted = 0;
+    };
+    
+    void Build(const std::vector<ExchangeRate>& rates);
+    
+    // Currencies with a series, sorted
+    const std::vector<CurrencyCode>& GetCurrencies() const { return currencies_; }
+    bool HasRates() const { return days_ > 0; }
+    
+    Conversion To(CurrencyCode target) const;
+    
+    // Batch kernels: one pass over the rows, no lookups beyond the factor
+    // tables. Summarize() covers snapshot rows [first, last); ConvertAmounts()
+    // writes each row's signed amount in the target, or NaN when it cannot be
+    // converted.
+    Totals Summarize(const TransactionSnapshot& rows, CurrencyCode target,
+                     size_t first = 0, size_t last = TransactionSnapshot::npos) const;
+    void ConvertAmounts(const TransactionSnapshot& rows, CurrencyCode target, std::vector<double>& amounts) const;
+
+private:
+    CurrencyCode pivot_ = kDefaultCurrency;
+    std::int32_t firstDay_ = 0;
+    size_t days_ = 0;
+    std::vector<CurrencyCode> currencies_;
+    std::vector<double> values_;  // Value in the pivot, days_ per currency
+    
+    const double* Series(CurrencyCode currency) const;
+};
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "DuplicateIndex.h"
+
+void DuplicateIndex::Add(std::uint64_t fingerprint) {
+    if (fingerprint != 0) {
+        fingerprints_.insert(fingerprint);
+    }
+}
+
+void DuplicateIndex::Remove(std::uint64_t fingerprint) {
+    fingerprints_.erase(fingerprint);
+}
+
+std::uint64_t DuplicateIndex::Assign(const Transaction& transaction) const {
+    std::uint64_t base = BaseFingerprint(transaction);
+    std::uint32_t ordinal = 0;
+    while (Contains(Fingerprint(base, ordinal))) {
+        ++ordinal;
+    }
+    return Fingerprint(base, ordinal);
+}
+
+bool DuplicateIndex::Batch::IsDuplicate(Transaction& transaction) {
+    std::uint64_t base = BaseFingerprint(transaction);
+    transaction.fingerprint = Fingerprint(base, ordinals_[base]++);
+    return index_.Contains(transaction.fingerprint);
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include "../Model/Fingerprint.h"
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+// In-memory set of every stored fingerprint, so an incoming row is checked
+// for a duplicate in O(1) instead of against the whole ledger. The database
+// keeps a unique index on the same column as the final word.
+class DuplicateIndex {
+public:
+    template <typename Range>
+    void Build(const Range& transactions) {
+        fingerprints_.clear();
+        for (const auto& transaction : transactions) {
+            if (transaction.fingerprint != 0) {
+                fingerprints_.insert(transaction.fingerprint);
+            }
+        }
+    }
+    
+    bool Contains(std::uint64_t fingerprint) const { return fingerprints_.count(fingerprint) > 0; }
+    void Add(std::uint64_t fingerprint);
+    void Remove(std::uint64_t fingerprint);
+    size_t Size() const { return fingerprints_.size(); }
+    
+    // Fingerprint for a hand-entered row: the first ordinal of its group that
+    // is not taken yet, so deliberate repeats are never rejected
+    std::uint64_t Assign(const Transaction& transaction) const;
+    
+    // Statement rows: the n-th row of a group in one import gets ordinal n,
+    // which matches the n-th stored copy when the statement is imported again
+    class Batch {
+    public:
+        explicit Batch(const DuplicateIndex& index) : index_(index) {}
+        
+        // Sets transaction.fingerprint and returns true if it is already stored
+        bool IsDuplicate(Transaction& transaction);
+    
+    private:
+        const DuplicateIndex& index_;
+        std::unordered_map<std::uint64_t, std::uint32_t> ordinals_;
+    };
+
+private:
+    std::unordered_set<std::uint64_t> fingerprints_;
+};
\ No newline at end of file
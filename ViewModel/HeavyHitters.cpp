@@ -0,0 +1,138 @@
+#include "HeavyHitters.h"
+#include <algorithm>
+#include <utility>
+
+HeavyHitters::HeavyHitters(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1))
+    , totalWeight_(0.0) {
+}
+
+void HeavyHitters::Add(const std::string& key, double weight) {
+    totalWeight_ += weight;
+    
+    auto found = slots_.find(key);
+    if (found != slots_.end()) {
+        size_t position = found->second;
+        entries_[position].weight += weight;
+        ++entries_[position].count;
+        SiftDown(position);
+        return;
+    }
+    
+    if (entries_.size() < capacity_) {
+        entries_.push_back({key, weight, 0.0, 1});
+        slots_[key] = entries_.size() - 1;
+        SiftUp(entries_.size() - 1);
+        return;
+    }
+    
+    // Replace the lightest counter; its weight may all have been this key's
+    Entry& lightest = entries_[0];
+    slots_.erase(lightest.key);
+    lightest.error = lightest.weight;
+    lightest.weight += weight;
+    lightest.count += 1;
+    lightest.key = key;
+    slots_[key] = 0;
+    SiftDown(0);
+}
+
+void HeavyHitters::Merge(const HeavyHitters& other) {
+    double missingHere = MinWeight();
+    double missingThere = other.MinWeight();
+    
+    std::unordered_map<std::string, Entry> combined;
+    combined.reserve(entries_.size() + other.entries_.size());
+    for (const auto& entry : entries_) {
+        combined.emplace(entry.key, entry);
+    }
+    for (const auto& entry : other.entries_) {
+        auto inserted = combined.emplace(entry.key, entry);
+        if (inserted.second) {
+            inserted.first->second.weight += missingHere;
+            inserted.first->second.error += missingHere;
+        } else {
+            Entry& both = inserted.first->second;
+            both.weight += entry.weight;
+            both.error += entry.error;
+            both.count += entry.count;
+        }
+    }
+    for (auto& entry : combined) {
+        if (other.slots_.count(entry.first) == 0) {
+            entry.second.weight += missingThere;
+            entry.second.error += missingThere;
+        }
+    }
+    
+    std::vector<Entry> merged;
+    merged.reserve(combined.size());
+    for (auto& entry : combined) {
+        merged.push_back(std::move(entry.second));
+    }
+    if (merged.size() > capacity_) {
+        std::nth_element(merged.begin(), merged.begin() + capacity_, merged.end(),
+                         [](const Entry& a, const Entry& b) { return a.weight > b.weight; });
+        merged.resize(capacity_);
+    }
+    
+    totalWeight_ += other.totalWeight_;
+    entries_ = std::move(merged);
+    slots_.clear();
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        slots_[entries_[i].key] = i;
+    }
+    for (size_t i = entries_.size() / 2; i-- > 0;) {
+        SiftDown(i);
+    }
+}
+
+std::vector<HeavyHitters::Entry> HeavyHitters::Top(size_t count) const {
+    std::vector<Entry> top(entries_);
+    auto heavier = [](const Entry& a, const Entry& b) {
+        return a.weight != b.weight ? a.weight > b.weight : a.key < b.key;
+    };
+    if (count < top.size()) {
+        std::partial_sort(top.begin(), top.begin() + count, top.end(), heavier);
+        top.resize(count);
+    } else {
+        std::sort(top.begin(), top.end(), heavier);
+    }
+    return top;
+}
+
+void HeavyHitters::SiftUp(size_t position) {
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (entries_[parent].weight <= entries_[position].weight) {
+            break;
+        }
+        Swap(parent, position);
+        position = parent;
+    }
+}
+
+void HeavyHitters::SiftDown(size_t position) {
+    for (;;) {
+        size_t lightest = position;
+        size_t left = 2 * position + 1;
+        size_t right = left + 1;
+        if (left < entries_.size() && entries_[left].weight < entries_[lightest].weight) {
+            lightest = left;
+        }
+        if (right < entries_.size() && entries_[right].weight < entries_[lightest].weight) {
+            lightest = right;
+        }
+        if (lightest == position) {
+            return;
+        }
+        Swap(position, lightest);
+        position = lightest;
+    }
+}
+
+void HeavyHitters::Swap(size_t a, size_t b) {
+    std::swap(entries_[a], entries_[b]);
+    slots_[entries_[a].key] = a;
+    slots_[entries_[b].key] = b;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+// Weighted Space-Saving (Metwally, Agrawal, El Abbadi) for the keys carrying
+// the most weight in a stream. A fixed number of counters is kept; a key
+// without one takes over the lightest, inheriting its weight as the key's
+// possible overcount. Any key whose true weight exceeds total / capacity is
+// guaranteed a counter. The counters sit in a min-heap, so an update is
+// O(log capacity).
+class HeavyHitters {
+public:
+    static constexpr size_t kDefaultCapacity = 256;
+    
+    struct Entry {
+        std::string key;
+        double weight;   // Upper bound on the key's true weight
+        double error;    // weight - error is a lower bound
+        size_t count;    // Items counted for the key, also an overcount
+    };
+    
+    explicit HeavyHitters(size_t capacity = kDefaultCapacity);
+    
+    void Add(const std::string& key, double weight);
+    
+    // Combines two summaries: keys in both add up, and a key missing from a
+    // full summary may have had up to that summary's lightest weight
+    void Merge(const HeavyHitters& other);
+    
+    // Heaviest first
+    std::vector<Entry> Top(size_t count) const;
+    
+    double GetTotalWeight() const { return totalWeight_; }
+    bool Empty() const { return entries_.empty(); }
+
+private:
+    size_t capacity_;
+    double totalWeight_;
+    std::vector<Entry> entries_;                    // Min-heap on weight
+    std::unordered_map<std::string, size_t> slots_; // Key -> heap position
+    
+    double MinWeight() const { return entries_.size() < capacity_ || entries_.empty() ? 0.0 : entries_[0].weight; }
+    void SiftUp(size_t position);
+    void SiftDown(size_t position);
+    void Swap(size_t a, size_t b);
+};
\ No newline at end of file
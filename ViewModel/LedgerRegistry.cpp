@@ -0,0 +1,241 @@
+#include "LedgerRegistry.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    // Same schedule as a single-ledger install
+    constexpr std::time_t kBackupInterval = 24 * 60 * 60;
+    constexpr size_t kBackupsKept = 7;
+    
+    std::string NormalizePath(const std::string& path) {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(path, error);
+        return error ? path : absolute.lexically_normal().string();
+    }
+    
+    // Every ledger's backups share one directory. The file's stem keeps the
+    // names readable; a hash of its full path keeps two ledgers with the
+    // same stem, in different folders, out of each other's rotation.
+    std::string BackupPrefix(const std::string& path) {
+        std::uint32_t hash = 2166136261u;  // FNV-1a
+        for (unsigned char c : NormalizePath(path)) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "-%08x", static_cast<unsigned>(hash));
+        return std::filesystem::path(path).stem().string() + suffix;
+    }
+}
+
+LedgerRegistry::LedgerRegistry(std::string configPath)
+    : configPath_(std::move(configPath))
+    , memoryBudget_(kDefaultMemoryBudget)
+    , useClock_(0) {
+}
+
+bool LedgerRegistry::Load() {
+    std::ifstream in(configPath_);
+    if (!in) {
+        return false;
+    }
+    
+    std::string current;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "Ignoring malformed line in " << configPath_ << ": " << line << std::endl;
+            continue;
+        }
+        std::string key = line.substr(0, equals);
+        std::string value = line.substr(equals + 1);
+        
+        if (key == "memory_budget_mb") {
+            SetMemoryBudget(static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10)) << 20);
+        } else if (key == "current") {
+            current = value;
+        } else if (key == "ledger") {
+            size_t tab = value.find('\t');
+            if (tab == std::string::npos || !AddLedger(value.substr(0, tab), value.substr(tab + 1))) {
+                std::cerr << "Ignoring ledger entry in " << configPath_ << ": " << value << std::endl;
+            }
+        }
+    }
+    
+    // The ledger opened last; it is opened for real on the first Open()
+    if (Find(current)) {
+        currentName_ = current;
+    }
+    return !entries_.empty();
+}
+
+bool LedgerRegistry::Save() const {
+    std::ofstream out(configPath_, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to write " << configPath_ << std::endl;
+        return false;
+    }
+    
+    out << "memory_budget_mb=" << (memoryBudget_ >> 20) << '\n';
+    if (!currentName_.empty()) {
+        out << "current=" << currentName_ << '\n';
+    }
+    for (const auto& entry : entries_) {
+        out << "ledger=" << entry.name << '\t' << entry.path << '\n';
+    }
+    return static_cast<bool>(out.flush());
+}
+
+bool LedgerRegistry::AddLedger(const std::string& name, const std::string& path) {
+    if (name.empty() || path.empty() || name.find_first_of("\t\n") != std::string::npos ||
+        path.find('\n') != std::string::npos || Find(name)) {
+        return false;
+    }
+    
+    std::string normalized = NormalizePath(path);
+    for (const auto& entry : entries_) {
+        if (NormalizePath(entry.path) == normalized) {
+            return false;
+        }
+    }
+    
+    entries_.push_back({name, path, nullptr, 0, 0, 0});
+    return true;
+}
+
+bool LedgerRegistry::RemoveLedger(const std::string& name) {
+    if (name == currentName_) {
+        return false;
+    }
+    
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->name == name) {
+            entries_.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<LedgerRegistry::Ledger> LedgerRegistry::GetLedgers() const {
+    std::vector<Ledger> ledgers;
+    for (const auto& entry : entries_) {
+        ledgers.push_back({entry.name, entry.path, entry.manager != nullptr, entry.manager ? entry.memoryUsage : 0});
+    }
+    return ledgers;
+}
+
+TransactionManager* LedgerRegistry::Open(const std::string& name, size_t* recurringAdded) {
+    if (recurringAdded) {
+        *recurringAdded = 0;
+    }
+    
+    Entry* entry = Find(name);
+    if (!entry) {
+        return nullptr;
+    }
+    
+    if (!entry->manager) {
+        auto manager = std::make_unique<TransactionManager>(entry->path);
+        if (!manager->IsInitialized()) {
+            std::cerr << "Failed to open ledger " << name << " at " << entry->path << std::endl;
+            return nullptr;
+        }
+        
+        manager->GetBackups().SetSchedule("backups", BackupPrefix(entry->path), kBackupInterval, kBackupsKept);
+        size_t added = manager->MaterializeRecurring();
+        if (recurringAdded) {
+            *recurringAdded = added;
+        }
+        entry->manager = std::move(manager);
+        entry->measuredVersion = static_cast<std::uint64_t>(-1);
+    }
+    
+    // The ledger being left may have grown while it was current
+    if (Entry* previous = Find(currentName_)) {
+        if (previous->manager && previous != entry) {
+            Measure(*previous);
+        }
+    }
+    
+    entry->lastUsed = ++useClock_;
+    currentName_ = name;
+    Measure(*entry);
+    CloseOverBudget();
+    return entry->manager.get();
+}
+
+TransactionManager* LedgerRegistry::GetCurrent() {
+    Entry* entry = Find(currentName_);
+    return entry ? entry->manager.get() : nullptr;
+}
+
+bool LedgerRegistry::IsOpen(const std::string& name) const {
+    const Entry* entry = Find(name);
+    return entry && entry->manager;
+}
+
+void LedgerRegistry::SetMemoryBudget(size_t bytes) {
+    memoryBudget_ = bytes;
+    CloseOverBudget();
+}
+
+size_t LedgerRegistry::GetMemoryUsage() const {
+    size_t total = 0;
+    for (const auto& entry : entries_) {
+        if (entry.manager) {
+            total += entry.memoryUsage;
+        }
+    }
+    return total;
+}
+
+LedgerRegistry::Entry* LedgerRegistry::Find(const std::string& name) {
+    for (auto& entry : entries_) {
+        if (entry.name == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const LedgerRegistry::Entry* LedgerRegistry::Find(const std::string& name) const {
+    return const_cast<LedgerRegistry*>(this)->Find(name);
+}
+
+void LedgerRegistry::Measure(Entry& entry) {
+    // Walking the cache is the costly part; skip it while nothing changed
+    if (entry.measuredVersion != entry.manager->GetVersion()) {
+        entry.memoryUsage = entry.manager->GetMemoryUsage();
+        entry.measuredVersion = entry.manager->GetVersion();
+    }
+}
+
+void LedgerRegistry::CloseOverBudget() {
+    while (GetMemoryUsage() > memoryBudget_) {
+        // Least recently used first. One running a backup is skipped, since
+        // closing it would cancel the backup.
+        Entry* victim = nullptr;
+        for (auto& entry : entries_) {
+            if (entry.manager && entry.name != currentName_ && !entry.manager->GetBackups().IsRunning() &&
+                (!victim || entry.lastUsed < victim->lastUsed)) {
+                victim = &entry;
+            }
+        }
+        if (!victim) {
+            return;
+        }
+        victim->manager.reset();
+        victim->memoryUsage = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include "TransactionManager.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The ledgers the app knows about, each in its own database file, and open
+// TransactionManagers for the recently used ones. Switching back to an open
+// ledger reuses its cache and indexes instead of reloading them. When the
+// estimated memory of the open ledgers exceeds the budget, the least recently
+// used ones are closed; the current ledger always stays open.
+//
+// The list, the budget and the last ledger used are kept in a small text file:
+//     memory_budget_mb=512
+//     current=Household
+//     ledger=Household<TAB>finance_tracker.db
+class LedgerRegistry {
+public:
+    struct Ledger {
+        std::string name;
+        std::string path;
+        bool open;
+        size_t memoryUsage;  // Estimate, 0 while closed
+    };
+    
+    static constexpr size_t kDefaultMemoryBudget = size_t(512) << 20;
+    
+    explicit LedgerRegistry(std::string configPath);
+    
+    // Disable copy constructor and assignment operator
+    LedgerRegistry(const LedgerRegistry&) = delete;
+    LedgerRegistry& operator=(const LedgerRegistry&) = delete;
+    
+    // Load() returns false when the file is missing or lists no ledgers
+    bool Load();
+    bool Save() const;
+    
+    // Names must be unique and a file can only be registered once.
+    // The current ledger cannot be removed.
+    bool AddLedger(const std::string& name, const std::string& path);
+    bool RemoveLedger(const std::string& name);
+    std::vector<Ledger> GetLedgers() const;
+    
+    // Makes name the current ledger, opening it if it is closed, and returns
+    // its manager; nullptr if it is unknown or cannot be opened, leaving the
+    // current ledger unchanged. Opening catches up on recurring transactions,
+    // counted in recurringAdded. Other ledgers' managers may be closed to
+    // stay within the budget, so callers must drop pointers to them first.
+    TransactionManager* Open(const std::string& name, size_t* recurringAdded = nullptr);
+    TransactionManager* GetCurrent();
+    const std::string& GetCurrentName() const { return currentName_; }
+    bool IsOpen(const std::string& name) const;
+    
+    void SetMemoryBudget(size_t bytes);
+    size_t GetMemoryBudget() const { return memoryBudget_; }
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string path;
+        std::unique_ptr<TransactionManager> manager;
+        std::uint64_t lastUsed;
+        size_t memoryUsage;
+        std::uint64_t measuredVersion;  // Cache version memoryUsage was taken at
+    };
+    
+    std::string configPath_;
+    std::vector<Entry> entries_;  // Registration order, as listed in the menu
+    std::string currentName_;
+    size_t memoryBudget_;
+    std::uint64_t useClock_;
+    
+    Entry* Find(const std::string& name);
+    const Entry* Find(const std::string& name) const;
+    void Measure(Entry& entry);
+    void CloseOverBudget();
+};
\ No newline at end of file
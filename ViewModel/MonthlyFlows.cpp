@@ -0,0 +1,77 @@
+#include "MonthlyFlows.h"
+#include "../Model/Calendar.h"
+#include <algorithm>
+
+void MonthlyFlows::Add(const Transaction& transaction, double amount, std::int32_t day) {
+    Apply(transaction, amount, day, 1);
+}
+
+void MonthlyFlows::Remove(const Transaction& transaction, double amount, std::int32_t day) {
+    Apply(transaction, amount, day, -1);
+}
+
+double MonthlyFlows::NetIn(const Category& category, Month month) {
+    if (month < category.firstMonth || month >= category.firstMonth + static_cast<Month>(category.net.size())) {
+        return 0.0;
+    }
+    return category.net[static_cast<size_t>(month - category.firstMonth)];
+}
+
+void MonthlyFlows::Apply(const Transaction& transaction, double amount, std::int32_t day, int sign) {
+    int year, month, dayOfMonth;
+    CivilFromDays(day, year, month, dayOfMonth);
+    Month index = MonthIndex(year, month);
+    
+    auto found = categories_.find(transaction.category);
+    if (found == categories_.end()) {
+        if (sign < 0) {
+            return;  // Never added
+        }
+        found = categories_.emplace(transaction.category, Category()).first;
+        found->second.firstMonth = index;
+    }
+    
+    // Months are filled in on demand either side; a load walks newest
+    // first, so most growth is at the front, a month at a time
+    Category& category = found->second;
+    if (sign > 0 && index < category.firstMonth) {
+        size_t gap = static_cast<size_t>(category.firstMonth - index);
+        category.net.insert(category.net.begin(), gap, 0.0);
+        category.monthRows.insert(category.monthRows.begin(), gap, 0);
+        category.firstMonth = index;
+    }
+    size_t slot = static_cast<size_t>(index - category.firstMonth);
+    if (sign > 0 && slot >= category.net.size()) {
+        category.net.resize(slot + 1, 0.0);
+        category.monthRows.resize(slot + 1, 0);
+    }
+    if (index < category.firstMonth || slot >= category.net.size() || (sign < 0 && category.monthRows[slot] == 0)) {
+        return;  // Never added
+    }
+    
+    double signedAmount = transaction.type == TransactionType::Income ? amount : -amount;
+    category.net[slot] += sign * signedAmount;
+    category.dayWeight[static_cast<size_t>(dayOfMonth - 1)] += sign * amount;
+    
+    if (sign > 0) {
+        ++category.rows;
+        ++category.monthRows[slot];
+    } else if (--category.rows == 0) {
+        categories_.erase(found);
+    } else if (--category.monthRows[slot] == 0) {
+        // An emptied month holds nothing, and one at either end goes, so the
+        // history starts and ends where a rebuild from the rows left would
+        category.net[slot] = 0.0;
+        auto filled = [](size_t rows) { return rows > 0; };
+        size_t back = static_cast<size_t>(
+            std::find_if(category.monthRows.rbegin(), category.monthRows.rend(), filled).base() -
+            category.monthRows.begin());
+        category.net.resize(back);
+        category.monthRows.resize(back);
+        auto front = std::find_if(category.monthRows.begin(), category.monthRows.end(), filled) -
+                     category.monthRows.begin();
+        category.net.erase(category.net.begin(), category.net.begin() + front);
+        category.monthRows.erase(category.monthRows.begin(), category.monthRows.begin() + front);
+        category.firstMonth += static_cast<Month>(front);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// Net flow (income minus expenses) per category and calendar month, and
+// how each category's money spreads over the days of a month. Plain sums,
+// so a row comes back out as exactly as it went in: edits and deletes
+// adjust the figures rather than costing a pass over every row. Amounts
+// are whatever the caller passes in, normally the reporting currency.
+class MonthlyFlows {
+public:
+    using Month = std::int32_t;  // MonthIndex()
+    
+    struct Category {
+        Month firstMonth = 0;
+        std::vector<double> net;            // Per month from firstMonth
+        std::vector<size_t> monthRows;      // Rows behind each net; the first and last month have some
+        std::array<double, 31> dayWeight{}; // Money moved on each day of the month, either way
+        size_t rows = 0;
+    };
+    
+    void Clear() { categories_.clear(); }
+    
+    // day is the row's local calendar day (days since 1970-01-01)
+    void Add(const Transaction& transaction, double amount, std::int32_t day);
+    void Remove(const Transaction& transaction, double amount, std::int32_t day);
+    
+    const std::map<std::string, Category>& GetCategories() const { return categories_; }
+    
+    // Net of one category in one month; 0 outside its history
+    static double NetIn(const Category& category, Month month);
+
+private:
+    std::map<std::string, Category> categories_;
+    
+    void Apply(const Transaction& transaction, double amount, std::int32_t day, int sign);
+};
\ No newline at end of file
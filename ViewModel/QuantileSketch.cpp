@@ -0,0 +1,155 @@
+#include "QuantileSketch.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+QuantileSketch::QuantileSketch(int k)
+    : k_(std::max(k, 8))
+    , count_(0)
+    , min_(0.0)
+    , max_(0.0)
+    , random_(0x9E3779B97F4A7C15ull)
+    , levels_(1) {
+}
+
+void QuantileSketch::Add(double value) {
+    if (count_ == 0) {
+        min_ = max_ = value;
+    } else {
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+    ++count_;
+    
+    levels_[0].push_back(value);
+    if (levels_[0].size() >= Capacity(0)) {
+        Compress();
+    }
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        min_ = other.min_;
+        max_ = other.max_;
+    } else {
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+    count_ += other.count_;
+    
+    if (levels_.size() < other.levels_.size()) {
+        levels_.resize(other.levels_.size());
+    }
+    for (size_t level = 0; level < other.levels_.size(); ++level) {
+        levels_[level].insert(levels_[level].end(), other.levels_[level].begin(), other.levels_[level].end());
+    }
+    Compress();
+}
+
+double QuantileSketch::Quantile(double q) const {
+    return Quantiles({q}).front();
+}
+
+std::vector<double> QuantileSketch::Quantiles(const std::vector<double>& ranks) const {
+    std::vector<double> values(ranks.size(), 0.0);
+    if (count_ == 0) {
+        return values;
+    }
+    
+    // Every retained value with its weight, in value order
+    std::vector<std::pair<double, std::uint64_t>> weighted;
+    weighted.reserve(Retained());
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        for (double value : levels_[level]) {
+            weighted.emplace_back(value, std::uint64_t(1) << level);
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+    
+    std::uint64_t total = 0;
+    for (const auto& entry : weighted) {
+        total += entry.second;
+    }
+    
+    for (size_t i = 0; i < ranks.size(); ++i) {
+        double q = ranks[i];
+        if (!(q > 0.0)) {
+            values[i] = min_;
+            continue;
+        }
+        if (q >= 1.0) {
+            values[i] = max_;
+            continue;
+        }
+        
+        // Smallest value whose cumulative weight reaches the rank
+        double target = q * static_cast<double>(total);
+        std::uint64_t cumulative = 0;
+        values[i] = weighted.back().first;
+        for (const auto& entry : weighted) {
+            cumulative += entry.second;
+            if (static_cast<double>(cumulative) >= target) {
+                values[i] = entry.first;
+                break;
+            }
+        }
+    }
+    return values;
+}
+
+size_t QuantileSketch::Retained() const {
+    size_t retained = 0;
+    for (const auto& level : levels_) {
+        retained += level.size();
+    }
+    return retained;
+}
+
+size_t QuantileSketch::Capacity(size_t level) const {
+    // Lower levels shrink geometrically below the top one, which keeps k
+    size_t depth = levels_.size() - level - 1;
+    double capacity = std::ceil(k_ * std::pow(2.0 / 3.0, static_cast<double>(depth)));
+    return std::max<size_t>(2, static_cast<size_t>(capacity));
+}
+
+void QuantileSketch::Compress() {
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        if (levels_[level].size() >= Capacity(level)) {
+            CompactLevel(level);
+        }
+    }
+}
+
+void QuantileSketch::CompactLevel(size_t level) {
+    if (level + 1 == levels_.size()) {
+        levels_.emplace_back();
+    }
+    std::vector<double>& items = levels_[level];
+    std::vector<double>& above = levels_[level + 1];
+    std::sort(items.begin(), items.end());
+    
+    // An odd value out stays behind at full weight
+    double leftover = 0.0;
+    bool hasLeftover = items.size() % 2 == 1;
+    if (hasLeftover) {
+        leftover = items.back();
+        items.pop_back();
+    }
+    
+    // xorshift64: a fair coin per compaction is all the sketch needs
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 7;
+    random_ ^= random_ << 17;
+    size_t offset = random_ & 1;
+    for (size_t i = offset; i < items.size(); i += 2) {
+        above.push_back(items[i]);
+    }
+    
+    items.clear();
+    if (hasLeftover) {
+        items.push_back(leftover);
+    }
+}
\ No newline at end of file
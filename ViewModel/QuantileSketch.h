@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// KLL quantile sketch (Karnin, Lang, Liberty). Values pass through a stack
+// of compactors: when a level fills up it is sorted and every other value,
+// starting at a random offset, moves up a level with twice the weight. With
+// k = 200 a rank is within about 1.3% of the truth, using a few k values no
+// matter how many were added. Two sketches merge into one that summarizes
+// both streams, so sketches of days or months combine into any range.
+class QuantileSketch {
+public:
+    static constexpr int kDefaultK = 200;
+    
+    explicit QuantileSketch(int k = kDefaultK);
+    
+    void Add(double value);
+    void Merge(const QuantileSketch& other);
+    
+    // Value at rank q in [0, 1] (0.5 is the median); 0 when empty.
+    // Exact while fewer than k values have been added.
+    double Quantile(double q) const;
+    std::vector<double> Quantiles(const std::vector<double>& ranks) const;
+    
+    std::uint64_t Count() const { return count_; }
+    bool Empty() const { return count_ == 0; }
+    double Min() const { return min_; }
+    double Max() const { return max_; }
+    size_t Retained() const;
+
+private:
+    int k_;
+    std::uint64_t count_;
+    double min_;
+    double max_;
+    std::uint64_t random_;
+    std::vector<std::vector<double>> levels_;  // Values on level h weigh 2^h
+    
+    size_t Capacity(size_t level) const;
+    void Compress();
+    void CompactLevel(size_t level);
+};
\ No newline at end of file
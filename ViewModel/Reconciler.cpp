@@ -0,0 +1,224 @@
+#include "Reconciler.h"
+#include "SpendingStats.h"
+#include "../Model/Calendar.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    // Sort key of one side's row; index points back into that side
+    struct Entry {
+        CurrencyCode currency;
+        std::int32_t day;
+        std::int64_t cents;
+        std::uint32_t index;
+    };
+    
+    bool operator<(const Entry& a, const Entry& b) {
+        if (a.currency != b.currency) {
+            return a.currency < b.currency;
+        }
+        if (a.day != b.day) {
+            return a.day < b.day;
+        }
+        return a.cents != b.cents ? a.cents < b.cents : a.index < b.index;
+    }
+    
+    // Ledger entries of one currency and day: [begin, end)
+    struct Block {
+        CurrencyCode currency;
+        std::int32_t day;
+        size_t begin;
+        size_t end;
+    };
+    
+    struct Candidate {
+        double score;
+        std::uint32_t line;
+        std::uint32_t row;
+    };
+    
+    std::int64_t SignedCents(const Transaction& transaction) {
+        std::int64_t cents = std::llround(transaction.amount * 100.0);
+        return transaction.type == TransactionType::Expense ? -cents : cents;
+    }
+    
+    template <typename Rows, typename Get>
+    std::vector<Entry> SortedEntries(const Rows& rows, Get get) {
+        std::vector<Entry> entries;
+        entries.reserve(rows.size());
+        DayCursor days;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const Transaction& transaction = get(rows[i]);
+            entries.push_back({transaction.currency, days(transaction.date), SignedCents(transaction),
+                               static_cast<std::uint32_t>(i)});
+        }
+        std::sort(entries.begin(), entries.end());
+        return entries;
+    }
+}
+
+void Reconciler::Match(const std::vector<Transaction>& lines, const std::vector<const Transaction*>& ledger,
+                       ReconcileReport& report) const {
+    report.matched.clear();
+    report.missing.clear();
+    report.extra.clear();
+    
+    std::vector<Entry> lineEntries = SortedEntries(lines, [](const Transaction& line) -> const Transaction& {
+        return line;
+    });
+    std::vector<Entry> rowEntries = SortedEntries(ledger, [](const Transaction* row) -> const Transaction& {
+        return *row;
+    });
+    
+    std::vector<Block> blocks;
+    for (size_t i = 0; i < rowEntries.size(); ++i) {
+        if (blocks.empty() || blocks.back().currency != rowEntries[i].currency || blocks.back().day != rowEntries[i].day) {
+            blocks.push_back({rowEntries[i].currency, rowEntries[i].day, i, i});
+        }
+        blocks.back().end = i + 1;
+    }
+    
+    // Descriptions are broken into grams only once a pair needs them
+    std::vector<std::vector<std::uint32_t>> lineGrams(lines.size());
+    std::vector<std::vector<std::uint32_t>> rowGrams(ledger.size());
+    std::vector<bool> lineGrammed(lines.size());
+    std::vector<bool> rowGrammed(ledger.size());
+    
+    const int dayTolerance = std::max(options_.dayTolerance, 0);
+    const std::int64_t centsTolerance = std::llround(std::max(options_.amountTolerance, 0.0) * 100.0);
+    
+    // Lines come in (currency, day) order, so the first block a line can
+    // reach only ever moves forward
+    std::vector<Candidate> candidates;
+    size_t firstBlock = 0;
+    for (const Entry& line : lineEntries) {
+        while (firstBlock < blocks.size() &&
+               (blocks[firstBlock].currency < line.currency ||
+                (blocks[firstBlock].currency == line.currency && blocks[firstBlock].day < line.day - dayTolerance))) {
+            ++firstBlock;
+        }
+        
+        for (size_t b = firstBlock; b < blocks.size() && blocks[b].currency == line.currency &&
+                                    blocks[b].day <= line.day + dayTolerance; ++b) {
+            auto first = rowEntries.begin() + static_cast<std::ptrdiff_t>(blocks[b].begin);
+            auto last = rowEntries.begin() + static_cast<std::ptrdiff_t>(blocks[b].end);
+            auto row = std::lower_bound(first, last, line.cents - centsTolerance,
+                                        [](const Entry& entry, std::int64_t cents) { return entry.cents < cents; });
+            for (; row != last && row->cents <= line.cents + centsTolerance; ++row) {
+                if (!lineGrammed[line.index]) {
+                    lineGrams[line.index] = Grams(lines[line.index].description);
+                    lineGrammed[line.index] = true;
+                }
+                if (!rowGrammed[row->index]) {
+                    rowGrams[row->index] = Grams(ledger[row->index]->description);
+                    rowGrammed[row->index] = true;
+                }
+                
+                // Description counts most; the gaps break ties between look-alikes
+                double likeness = Overlap(lineGrams[line.index], rowGrams[row->index]);
+                double dayFit = 1.0 - std::abs(line.day - row->day) / (dayTolerance + 1.0);
+                double amountFit = 1.0 - static_cast<double>(std::llabs(line.cents - row->cents)) / (centsTolerance + 1.0);
+                double score = 0.5 * likeness + 0.3 * dayFit + 0.2 * amountFit;
+                if (score >= options_.minScore) {
+                    candidates.push_back({score, line.index, row->index});
+                }
+            }
+        }
+    }
+    
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        return a.line != b.line ? a.line < b.line : a.row < b.row;
+    });
+    
+    std::vector<bool> lineUsed(lines.size());
+    std::vector<bool> rowUsed(ledger.size());
+    for (const Candidate& candidate : candidates) {
+        if (!lineUsed[candidate.line] && !rowUsed[candidate.row]) {
+            lineUsed[candidate.line] = true;
+            rowUsed[candidate.row] = true;
+            report.matched.push_back({candidate.line, ledger[candidate.row]->id, candidate.score});
+        }
+    }
+    std::sort(report.matched.begin(), report.matched.end(), [](const ReconcileMatch& a, const ReconcileMatch& b) {
+        return a.line < b.line;
+    });
+    
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (!lineUsed[i]) {
+            report.missing.push_back(i);
+        }
+    }
+    
+    // Only the days the statement covers; rows outside it belong to other statements
+    if (!lineEntries.empty()) {
+        std::int32_t firstDay = lineEntries.front().day;
+        std::int32_t lastDay = lineEntries.front().day;
+        for (const Entry& line : lineEntries) {
+            firstDay = std::min(firstDay, line.day);
+            lastDay = std::max(lastDay, line.day);
+        }
+        std::vector<std::int32_t> rowDays(ledger.size());
+        for (const Entry& row : rowEntries) {
+            rowDays[row.index] = row.day;
+        }
+        for (size_t i = 0; i < ledger.size(); ++i) {
+            if (!rowUsed[i] && !ledger[i]->reconciled && rowDays[i] >= firstDay && rowDays[i] <= lastDay) {
+                report.extra.push_back(ledger[i]->id);
+            }
+        }
+    }
+}
+
+double Reconciler::Likeness(const std::string& a, const std::string& b) {
+    return Overlap(Grams(a), Grams(b));
+}
+
+std::vector<std::uint32_t> Reconciler::Grams(const std::string& description) {
+    std::string text = SpendingStats::NormalizeMerchant(description);
+    std::vector<std::uint32_t> grams;
+    if (text.size() < 3) {
+        // Too short for a trigram: the whole text stands as one
+        if (!text.empty()) {
+            std::uint32_t gram = 0;
+            for (unsigned char c : text) {
+                gram = gram << 8 | c;
+            }
+            grams.push_back(gram);
+        }
+        return grams;
+    }
+    
+    grams.reserve(text.size() - 2);
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        grams.push_back(static_cast<std::uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                        static_cast<std::uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                        static_cast<unsigned char>(text[i + 2]));
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+double Reconciler::Overlap(const std::vector<std::uint32_t>& a, const std::vector<std::uint32_t>& b) {
+    if (a.empty() || b.empty()) {
+        return 0.0;
+    }
+    
+    size_t shared = 0;
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            ++shared;
+            ++i;
+            ++j;
+        }
+    }
+    return static_cast<double>(shared) / std::min(a.size(), b.size());
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include "../Import/StatementParser.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct ReconcileOptions {
+    int dayTolerance = 3;          // Days either side of the statement date
+    double amountTolerance = 0.0;  // Either side, in the line's currency
+    double minScore = 0.0;         // Pairs scoring lower are never matched
+};
+
+struct ReconcileMatch {
+    size_t line;   // Index into ReconcileReport::lines
+    int id;        // Ledger transaction
+    double score;  // 0 to 1; 1 is same day, same amount, same description
+};
+
+struct ReconcileReport {
+    std::vector<Transaction> lines;        // The statement as parsed
+    std::vector<ReconcileMatch> matched;   // By line
+    std::vector<size_t> missing;           // Lines with no ledger row
+    std::vector<int> extra;                // Unreconciled ledger rows on the statement's days that no line matched
+    size_t marked = 0;                     // Rows newly flagged as reconciled
+    ImportReport parsing;
+    double seconds = 0.0;
+};
+
+// Pairs bank statement lines with ledger rows. Both sides are keyed by
+// (currency, day, signed cents) and sorted, then merge-joined: each line
+// looks only at the ledger rows of the days within the tolerance, and within
+// each day binary-searches the amount window, so the work is the sort plus
+// the candidates rather than lines times rows. Candidates are scored on
+// description likeness, day gap and amount gap, and taken best first so
+// each side is used at most once.
+class Reconciler {
+public:
+    explicit Reconciler(const ReconcileOptions& options = ReconcileOptions()) : options_(options) {}
+    
+    // Fills matched, missing and extra. Ledger rows may come in any order;
+    // rows reconciled before can still be matched but never count as extra.
+    void Match(const std::vector<Transaction>& lines, const std::vector<const Transaction*>& ledger,
+               ReconcileReport& report) const;
+    
+    // Likeness of two descriptions, 0 to 1: the share of the shorter one's
+    // letter trigrams found in the other, after dropping store numbers and
+    // punctuation, so "POS 4411 STARBUCKS SEATTLE" and "Starbucks" score 1
+    static double Likeness(const std::string& a, const std::string& b);
+
+private:
+    ReconcileOptions options_;
+    
+    static std::vector<std::uint32_t> Grams(const std::string& description);
+    static double Overlap(const std::vector<std::uint32_t>& a, const std::vector<std::uint32_t>& b);
+};
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "RecurringScheduler.h"
+#include <algorithm>
+
+namespace {
+    int DaysInMonth(int year, int month) {
+        static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        return month == 2 && leap ? 29 : days[month - 1];
+    }
+    
+    std::tm LocalDay(std::time_t time) {
+        std::tm calendar = *std::localtime(&time);
+        calendar.tm_hour = 0;
+        calendar.tm_min = 0;
+        calendar.tm_sec = 0;
+        calendar.tm_isdst = -1;
+        return calendar;
+    }
+}
+
+void RecurringScheduler::Build(const std::vector<RecurringRule>& rules) {
+    rules_.clear();
+    queue_ = {};
+    for (const auto& rule : rules) {
+        Add(rule);
+    }
+}
+
+void RecurringScheduler::Add(const RecurringRule& rule) {
+    rules_[rule.id] = rule;
+    if (!rule.IsFinished()) {
+        queue_.emplace(rule.nextDue, rule.id);
+    }
+}
+
+void RecurringScheduler::Remove(int ruleId) {
+    rules_.erase(ruleId); // Its heap entries go stale
+}
+
+std::vector<RecurringRule> RecurringScheduler::GetRules() const {
+    std::vector<RecurringRule> rules;
+    rules.reserve(rules_.size());
+    for (const auto& entry : rules_) {
+        rules.push_back(entry.second);
+    }
+    return rules;
+}
+
+std::vector<Transaction> RecurringScheduler::CollectDue(std::time_t now, std::vector<std::pair<int, std::time_t>>& advanced) {
+    std::vector<Transaction> occurrences;
+    std::map<int, std::time_t> nextDue;
+    
+    while (!queue_.empty() && queue_.top().first <= now) {
+        Entry entry = queue_.top();
+        queue_.pop();
+        
+        auto found = rules_.find(entry.second);
+        if (found == rules_.end() || found->second.nextDue != entry.first) {
+            continue; // Removed or rescheduled since this entry was pushed
+        }
+        
+        RecurringRule& rule = found->second;
+        occurrences.emplace_back(0, rule.description, rule.amount, rule.category, rule.type, rule.nextDue);
+        occurrences.back().currency = rule.currency;
+        rule.nextDue = NextOccurrence(rule, rule.nextDue);
+        nextDue[rule.id] = rule.nextDue;
+        
+        if (!rule.IsFinished()) {
+            queue_.emplace(rule.nextDue, rule.id);
+        }
+    }
+    
+    advanced.assign(nextDue.begin(), nextDue.end());
+    return occurrences;
+}
+
+std::time_t RecurringScheduler::FirstOccurrence(const RecurringRule& rule, std::time_t start) {
+    std::tm calendar = LocalDay(start);
+    if (rule.unit != RecurrenceUnit::Month) {
+        return std::mktime(&calendar);
+    }
+    
+    // The rule's day in the start month, or in the month after if already past
+    int startDay = calendar.tm_mday;
+    calendar.tm_mday = std::min(rule.dayOfMonth, DaysInMonth(calendar.tm_year + 1900, calendar.tm_mon + 1));
+    if (calendar.tm_mday < startDay) {
+        calendar.tm_mon += 1;
+        calendar.tm_year += calendar.tm_mon / 12;
+        calendar.tm_mon %= 12;
+        calendar.tm_mday = std::min(rule.dayOfMonth, DaysInMonth(calendar.tm_year + 1900, calendar.tm_mon + 1));
+    }
+    return std::mktime(&calendar);
+}
+
+std::time_t RecurringScheduler::NextOccurrence(const RecurringRule& rule, std::time_t due) {
+    std::tm calendar = LocalDay(due);
+    int interval = std::max(rule.interval, 1);
+    
+    switch (rule.unit) {
+        case RecurrenceUnit::Day:
+            calendar.tm_mday += interval;
+            break;
+        case RecurrenceUnit::Week:
+            calendar.tm_mday += 7 * interval;
+            break;
+        case RecurrenceUnit::Month: {
+            int month = calendar.tm_mon + interval;
+            calendar.tm_year += month / 12;
+            calendar.tm_mon = month % 12;
+            calendar.tm_mday = std::min(rule.dayOfMonth, DaysInMonth(calendar.tm_year + 1900, calendar.tm_mon + 1));
+            break;
+        }
+    }
+    
+    // mktime normalizes day overflow into the following months
+    return std::mktime(&calendar);
+}
\ No newline at end of file
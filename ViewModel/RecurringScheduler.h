@@ -0,0 +1,33 @@
+#pragma once
+#include "../Model/RecurringRule.h"
+#include <vector>
+#include <map>
+#include <queue>
+#include <utility>
+#include <functional>
+
+// Keeps recurring rules in a min-heap on their next due date, so collecting
+// what is due costs O(due occurrences * log rules) no matter how many rules
+// or how much history there is. Heap entries are never updated in place: an
+// entry whose date no longer matches its rule is stale and skipped.
+class RecurringScheduler {
+public:
+    void Build(const std::vector<RecurringRule>& rules);
+    void Add(const RecurringRule& rule);
+    void Remove(int ruleId);
+    std::vector<RecurringRule> GetRules() const;
+    
+    // Every occurrence due at or before now, oldest first. Each rule that
+    // fired is advanced past now and reported in advanced as (id, nextDue).
+    std::vector<Transaction> CollectDue(std::time_t now, std::vector<std::pair<int, std::time_t>>& advanced);
+    
+    // Occurrence arithmetic in local time; months keep dayOfMonth where it fits
+    static std::time_t FirstOccurrence(const RecurringRule& rule, std::time_t start);
+    static std::time_t NextOccurrence(const RecurringRule& rule, std::time_t due);
+
+private:
+    using Entry = std::pair<std::time_t, int>; // (due, rule id)
+    
+    std::map<int, RecurringRule> rules_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue_;
+};
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "RoaringBitmap.h"
+#include <algorithm>
+#include <iterator>
+
+void RoaringBitmap::Add(std::uint32_t value) {
+    std::uint16_t key = static_cast<std::uint16_t>(value >> 16);
+    std::uint16_t low = static_cast<std::uint16_t>(value & 0xFFFF);
+    
+    // Ascending adds land in the last chunk, so check it before searching
+    size_t index = !chunks_.empty() && chunks_.back().key <= key
+                   ? chunks_.size() - (chunks_.back().key == key ? 1 : 0) : FindChunk(key);
+    if (index == chunks_.size() || chunks_[index].key != key) {
+        Chunk chunk{key, 0, {}, {}};
+        chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(index), std::move(chunk));
+    }
+    
+    Chunk& chunk = chunks_[index];
+    if (!chunk.bits.empty()) {
+        std::uint64_t& word = chunk.bits[low / 64];
+        std::uint64_t bit = std::uint64_t(1) << (low % 64);
+        if (!(word & bit)) {
+            word |= bit;
+            ++chunk.cardinality;
+        }
+        return;
+    }
+    
+    auto position = chunk.values.empty() || chunk.values.back() < low
+                    ? chunk.values.end() : std::lower_bound(chunk.values.begin(), chunk.values.end(), low);
+    if (position != chunk.values.end() && *position == low) {
+        return;
+    }
+    chunk.values.insert(position, low);
+    ++chunk.cardinality;
+    if (chunk.cardinality > kMaxArray) {
+        ToBits(chunk);
+    }
+}
+
+void RoaringBitmap::Remove(std::uint32_t value) {
+    std::uint16_t key = static_cast<std::uint16_t>(value >> 16);
+    std::uint16_t low = static_cast<std::uint16_t>(value & 0xFFFF);
+    size_t index = FindChunk(key);
+    if (index == chunks_.size() || chunks_[index].key != key) {
+        return;
+    }
+    
+    Chunk& chunk = chunks_[index];
+    if (!chunk.bits.empty()) {
+        std::uint64_t& word = chunk.bits[low / 64];
+        std::uint64_t bit = std::uint64_t(1) << (low % 64);
+        if (!(word & bit)) {
+            return;
+        }
+        word &= ~bit;
+        --chunk.cardinality;
+    } else {
+        auto position = std::lower_bound(chunk.values.begin(), chunk.values.end(), low);
+        if (position == chunk.values.end() || *position != low) {
+            return;
+        }
+        chunk.values.erase(position);
+        --chunk.cardinality;
+    }
+    
+    Normalize(chunk);
+    if (chunk.cardinality == 0) {
+        chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+}
+
+bool RoaringBitmap::Contains(std::uint32_t value) const {
+    std::uint16_t key = static_cast<std::uint16_t>(value >> 16);
+    std::uint16_t low = static_cast<std::uint16_t>(value & 0xFFFF);
+    size_t index = FindChunk(key);
+    if (index == chunks_.size() || chunks_[index].key != key) {
+        return false;
+    }
+    
+    const Chunk& chunk = chunks_[index];
+    if (!chunk.bits.empty()) {
+        return (chunk.bits[low / 64] >> (low % 64)) & 1;
+    }
+    return std::binary_search(chunk.values.begin(), chunk.values.end(), low);
+}
+
+size_t RoaringBitmap::Cardinality() const {
+    size_t count = 0;
+    for (const Chunk& chunk : chunks_) {
+        count += chunk.cardinality;
+    }
+    return count;
+}
+
+RoaringBitmap RoaringBitmap::And(const RoaringBitmap& left, const RoaringBitmap& right) {
+    RoaringBitmap result;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < left.chunks_.size() && j < right.chunks_.size()) {
+        if (left.chunks_[i].key < right.chunks_[j].key) {
+            ++i;
+        } else if (right.chunks_[j].key < left.chunks_[i].key) {
+            ++j;
+        } else {
+            Chunk chunk = Combine(left.chunks_[i++], right.chunks_[j++], Operation::And);
+            if (chunk.cardinality > 0) {
+                result.chunks_.push_back(std::move(chunk));
+            }
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::Or(const RoaringBitmap& left, const RoaringBitmap& right) {
+    RoaringBitmap result;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < left.chunks_.size() || j < right.chunks_.size()) {
+        if (j == right.chunks_.size() || (i < left.chunks_.size() && left.chunks_[i].key < right.chunks_[j].key)) {
+            result.chunks_.push_back(left.chunks_[i++]);
+        } else if (i == left.chunks_.size() || right.chunks_[j].key < left.chunks_[i].key) {
+            result.chunks_.push_back(right.chunks_[j++]);
+        } else {
+            result.chunks_.push_back(Combine(left.chunks_[i++], right.chunks_[j++], Operation::Or));
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::AndNot(const RoaringBitmap& left, const RoaringBitmap& right) {
+    RoaringBitmap result;
+    size_t j = 0;
+    for (const Chunk& chunk : left.chunks_) {
+        while (j < right.chunks_.size() && right.chunks_[j].key < chunk.key) {
+            ++j;
+        }
+        if (j == right.chunks_.size() || right.chunks_[j].key != chunk.key) {
+            result.chunks_.push_back(chunk);
+            continue;
+        }
+        Chunk remaining = Combine(chunk, right.chunks_[j], Operation::AndNot);
+        if (remaining.cardinality > 0) {
+            result.chunks_.push_back(std::move(remaining));
+        }
+    }
+    return result;
+}
+
+std::vector<std::uint32_t> RoaringBitmap::ToVector() const {
+    std::vector<std::uint32_t> values;
+    values.reserve(Cardinality());
+    ForEach([&](std::uint32_t value) { values.push_back(value); });
+    return values;
+}
+
+size_t RoaringBitmap::GetMemoryUsage() const {
+    size_t bytes = chunks_.capacity() * sizeof(Chunk);
+    for (const Chunk& chunk : chunks_) {
+        bytes += chunk.values.capacity() * sizeof(std::uint16_t) + chunk.bits.capacity() * sizeof(std::uint64_t);
+    }
+    return bytes;
+}
+
+void RoaringBitmap::ToBits(Chunk& chunk) {
+    chunk.bits.assign(kWords, 0);
+    for (std::uint16_t low : chunk.values) {
+        chunk.bits[low / 64] |= std::uint64_t(1) << (low % 64);
+    }
+    std::vector<std::uint16_t>().swap(chunk.values);
+}
+
+void RoaringBitmap::ToArray(Chunk& chunk) {
+    chunk.values.clear();
+    chunk.values.reserve(chunk.cardinality);
+    for (size_t word = 0; word < kWords; ++word) {
+        for (std::uint64_t bits = chunk.bits[word]; bits != 0; bits &= bits - 1) {
+            chunk.values.push_back(static_cast<std::uint16_t>(word * 64 + CountTrailingZeros(bits)));
+        }
+    }
+    std::vector<std::uint64_t>().swap(chunk.bits);
+}
+
+void RoaringBitmap::Normalize(Chunk& chunk) {
+    if (!chunk.bits.empty() && chunk.cardinality <= kMaxArray) {
+        ToArray(chunk);
+    } else if (chunk.bits.empty() && chunk.cardinality > kMaxArray) {
+        ToBits(chunk);
+    }
+}
+
+size_t RoaringBitmap::FindChunk(std::uint16_t key) const {
+    auto found = std::lower_bound(chunks_.begin(), chunks_.end(), key,
+                                  [](const Chunk& chunk, std::uint16_t wanted) { return chunk.key < wanted; });
+    return static_cast<size_t>(found - chunks_.begin());
+}
+
+RoaringBitmap::Chunk RoaringBitmap::Combine(const Chunk& left, const Chunk& right, Operation operation) {
+    Chunk result{left.key, 0, {}, {}};
+    bool leftBits = !left.bits.empty();
+    bool rightBits = !right.bits.empty();
+    
+    if (!leftBits && !rightBits) {
+        // Two arrays: a sorted merge
+        auto out = std::back_inserter(result.values);
+        const auto& a = left.values;
+        const auto& b = right.values;
+        if (operation == Operation::And) {
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), out);
+        } else if (operation == Operation::Or) {
+            std::set_union(a.begin(), a.end(), b.begin(), b.end(), out);
+        } else {
+            std::set_difference(a.begin(), a.end(), b.begin(), b.end(), out);
+        }
+        result.cardinality = static_cast<std::uint32_t>(result.values.size());
+        Normalize(result);
+        return result;
+    }
+    
+    auto has = [](const Chunk& chunk, std::uint16_t low) { return (chunk.bits[low / 64] >> (low % 64)) & 1; };
+    if (operation != Operation::Or && !leftBits) {
+        // A short array against a bitset: probe each value
+        for (std::uint16_t low : left.values) {
+            if (has(right, low) == (operation == Operation::And)) {
+                result.values.push_back(low);
+            }
+        }
+        result.cardinality = static_cast<std::uint32_t>(result.values.size());
+        return result;
+    }
+    if (operation == Operation::And && !rightBits) {
+        return Combine(right, left, operation);
+    }
+    
+    // The rest work on a copy of one side's bitset
+    const Chunk& base = leftBits ? left : right;
+    const Chunk& other = leftBits ? right : left;
+    result.bits = base.bits;
+    if (!other.bits.empty()) {
+        for (size_t word = 0; word < kWords; ++word) {
+            std::uint64_t bits = other.bits[word];
+            result.bits[word] = operation == Operation::And ? result.bits[word] & bits
+                                : operation == Operation::Or ? result.bits[word] | bits : result.bits[word] & ~bits;
+        }
+    } else {
+        for (std::uint16_t low : other.values) {
+            std::uint64_t bit = std::uint64_t(1) << (low % 64);
+            result.bits[low / 64] = operation == Operation::Or ? result.bits[low / 64] | bit : result.bits[low / 64] & ~bit;
+        }
+    }
+    
+    for (std::uint64_t bits : result.bits) {
+        result.cardinality += CountBits(bits);
+    }
+    Normalize(result);
+    return result;
+}
\ No newline at end of file
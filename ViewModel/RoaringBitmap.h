@@ -0,0 +1,92 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Compressed set of 32-bit integers in the style of Roaring bitmaps. Values
+// are split by their high 16 bits into chunks of 65536; a chunk holding at
+// most 4096 values keeps them as a sorted array of their low halves, a fuller
+// one as an 8 KB bitset. Sparse sets cost about 2 bytes a value and dense ones
+// 1 bit, and set operations work a chunk at a time: merges for arrays, word
+// by word for bitsets.
+class RoaringBitmap {
+public:
+    void Add(std::uint32_t value);
+    void Remove(std::uint32_t value);
+    bool Contains(std::uint32_t value) const;
+    void Clear() { chunks_.clear(); }
+    
+    bool Empty() const { return chunks_.empty(); }
+    size_t Cardinality() const;
+    
+    static RoaringBitmap And(const RoaringBitmap& left, const RoaringBitmap& right);
+    static RoaringBitmap Or(const RoaringBitmap& left, const RoaringBitmap& right);
+    static RoaringBitmap AndNot(const RoaringBitmap& left, const RoaringBitmap& right);
+    
+    // Calls visit(value) for every value, ascending
+    template <typename Visit>
+    void ForEach(Visit visit) const {
+        for (const Chunk& chunk : chunks_) {
+            std::uint32_t high = static_cast<std::uint32_t>(chunk.key) << 16;
+            if (chunk.bits.empty()) {
+                for (std::uint16_t low : chunk.values) {
+                    visit(high | low);
+                }
+                continue;
+            }
+            for (size_t word = 0; word < kWords; ++word) {
+                for (std::uint64_t bits = chunk.bits[word]; bits != 0; bits &= bits - 1) {
+                    visit(high | static_cast<std::uint32_t>(word * 64 + CountTrailingZeros(bits)));
+                }
+            }
+        }
+    }
+    
+    std::vector<std::uint32_t> ToVector() const;
+    
+    // Heap bytes held
+    size_t GetMemoryUsage() const;
+
+private:
+    static constexpr size_t kWords = 65536 / 64;
+    static constexpr size_t kMaxArray = 4096;  // Past this a bitset is smaller
+    
+    // Either values (sorted) or bits (kWords words) is in use
+    struct Chunk {
+        std::uint16_t key;
+        std::uint32_t cardinality;
+        std::vector<std::uint16_t> values;
+        std::vector<std::uint64_t> bits;
+    };
+    
+    std::vector<Chunk> chunks_;  // Ascending by key
+    
+    static int CountTrailingZeros(std::uint64_t bits) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+    
+    static std::uint32_t CountBits(std::uint64_t bits) {
+#ifdef _MSC_VER
+        return static_cast<std::uint32_t>(__popcnt64(bits));
+#else
+        return static_cast<std::uint32_t>(__builtin_popcountll(bits));
+#endif
+    }
+    
+    static void ToBits(Chunk& chunk);
+    static void ToArray(Chunk& chunk);
+    static void Normalize(Chunk& chunk);
+    size_t FindChunk(std::uint16_t key) const;  // First chunk with a key not below
+    
+    enum class Operation { And, Or, AndNot };
+    static Chunk Combine(const Chunk& left, const Chunk& right, Operation operation);
+};
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "SpendingStats.h"
+#include <algorithm>
+
+void SpendingStats::Clear() {
+    amounts_.clear();
+    merchants_.clear();
+}
+
+void SpendingStats::Add(const Transaction& transaction, double amount, Month month) {
+    if (transaction.type != TransactionType::Expense) {
+        return;
+    }
+    
+    amounts_[{transaction.category, month}].Add(amount);
+    
+    std::string merchant = NormalizeMerchant(transaction.description);
+    if (!merchant.empty()) {
+        merchants_[month].Add(merchant, amount);
+    }
+}
+
+std::vector<CategorySpread> SpendingStats::GetCategorySpread(Month first, Month last) const {
+    std::vector<CategorySpread> spreads;
+    auto entry = amounts_.begin();
+    while (entry != amounts_.end()) {
+        const std::string& category = entry->first.first;
+        QuantileSketch combined;
+        for (; entry != amounts_.end() && entry->first.first == category; ++entry) {
+            if (InSpan(entry->first.second, first, last)) {
+                combined.Merge(entry->second);
+            }
+        }
+        
+        if (!combined.Empty()) {
+            std::vector<double> values = combined.Quantiles({0.5, 0.9});
+            spreads.push_back({category, combined.Count(), values[0], values[1], combined.Max()});
+        }
+    }
+    return spreads;
+}
+
+std::vector<MerchantSpend> SpendingStats::GetTopMerchants(size_t count, Month first, Month last) const {
+    HeavyHitters combined;
+    for (const auto& entry : merchants_) {
+        if (InSpan(entry.first, first, last)) {
+            combined.Merge(entry.second);
+        }
+    }
+    
+    std::vector<MerchantSpend> top;
+    for (auto& entry : combined.Top(count)) {
+        top.push_back({std::move(entry.key), entry.weight, entry.error, entry.count});
+    }
+    return top;
+}
+
+std::string SpendingStats::NormalizeMerchant(const std::string& description) {
+    std::string merchant;
+    std::string word;
+    bool hasDigit = false;
+    
+    auto endWord = [&]() {
+        if (!word.empty() && !hasDigit) {
+            if (!merchant.empty()) {
+                merchant += ' ';
+            }
+            merchant += word;
+        }
+        word.clear();
+        hasDigit = false;
+    };
+    
+    for (unsigned char c : description) {
+        if (c >= 'A' && c <= 'Z') {
+            word += static_cast<char>(c - 'A' + 'a');
+        } else if ((c >= 'a' && c <= 'z') || c >= 0x80) {
+            word += static_cast<char>(c);  // UTF-8 letters are kept as they are
+        } else if (c >= '0' && c <= '9') {
+            hasDigit = true;
+        } else if (c == '\'' || c == '&') {
+            word += static_cast<char>(c);  // "Trader Joe's", "AT&T"
+        } else {
+            endWord();
+        }
+    }
+    endWord();
+    return merchant;
+}
+
+bool SpendingStats::InSpan(Month month, Month first, Month last) {
+    return (first == kAllMonths || month >= first) && (last == kAllMonths || month <= last);
+}
\ No newline at end of file
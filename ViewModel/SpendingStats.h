@@ -0,0 +1,59 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include "../Model/Calendar.h"
+#include "QuantileSketch.h"
+#include "HeavyHitters.h"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+
+struct CategorySpread {
+    std::string category;
+    std::uint64_t count;
+    double median;
+    double p90;
+    double largest;
+};
+
+struct MerchantSpend {
+    std::string merchant;
+    double amount;       // May overstate by up to error
+    double error;
+    size_t transactions;
+};
+
+// Streaming summaries of spending: a quantile sketch of expense amounts per
+// category and calendar month, and a heavy-hitters sketch of merchants
+// (normalized descriptions) per month, weighted by amount. Both kinds merge,
+// so a query over any span of months combines one sketch per month and
+// category and never touches the rows. Amounts are whatever the caller
+// passes in, normally the reporting currency. Sketches cannot forget a row,
+// so after an edit or delete the owner clears them and adds every row again.
+class SpendingStats {
+public:
+    using Month = std::int32_t;  // MonthIndex()
+    
+    static constexpr Month kAllMonths = std::numeric_limits<Month>::min();
+    
+    void Clear();
+    void Add(const Transaction& transaction, double amount, Month month);
+    
+    std::vector<CategorySpread> GetCategorySpread(Month first = kAllMonths, Month last = kAllMonths) const;
+    std::vector<MerchantSpend> GetTopMerchants(size_t count, Month first = kAllMonths, Month last = kAllMonths) const;
+    
+    // Lower-cased words of a description, leaving out words with digits
+    // (store numbers, card references) and punctuation:
+    // "UBER *TRIP 7XK2" and "Uber Trip" both become "uber trip"
+    static std::string NormalizeMerchant(const std::string& description);
+
+private:
+    // Category-major, so one category's months are adjacent
+    std::map<std::pair<std::string, Month>, QuantileSketch> amounts_;
+    std::map<Month, HeavyHitters> merchants_;
+    
+    static bool InSpan(Month month, Month first, Month last);
+};
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "TagIndex.h"
+#include <algorithm>
+#include <iterator>
+
+void TagIndex::Build(const std::vector<std::pair<int, std::string>>& assignments) {
+    Clear();
+    for (const auto& assignment : assignments) {
+        Add(assignment.first, assignment.second);
+    }
+}
+
+void TagIndex::Add(int id, const std::string& tag) {
+    tags_[tag].Add(static_cast<std::uint32_t>(id));
+}
+
+void TagIndex::Remove(int id, const std::string& tag) {
+    auto found = tags_.find(tag);
+    if (found == tags_.end()) {
+        return;
+    }
+    
+    found->second.Remove(static_cast<std::uint32_t>(id));
+    if (found->second.Empty()) {
+        tags_.erase(found);
+    }
+}
+
+void TagIndex::RemoveTransaction(int id) {
+    for (auto it = tags_.begin(); it != tags_.end();) {
+        it->second.Remove(static_cast<std::uint32_t>(id));
+        it = it->second.Empty() ? tags_.erase(it) : std::next(it);
+    }
+}
+
+std::vector<std::string> TagIndex::GetTags() const {
+    std::vector<std::string> names;
+    names.reserve(tags_.size());
+    for (const auto& tag : tags_) {
+        names.push_back(tag.first);
+    }
+    return names;
+}
+
+std::vector<std::string> TagIndex::GetTags(int id) const {
+    std::vector<std::string> names;
+    for (const auto& tag : tags_) {
+        if (tag.second.Contains(static_cast<std::uint32_t>(id))) {
+            names.push_back(tag.first);
+        }
+    }
+    return names;
+}
+
+RoaringBitmap TagIndex::Find(const TagQuery& query, const RoaringBitmap& allIds) const {
+    static const RoaringBitmap kNone;
+    auto bitmapOf = [&](const std::string& tag) -> const RoaringBitmap& {
+        auto found = tags_.find(tag);
+        return found != tags_.end() ? found->second : kNone;
+    };
+    
+    // Intersect the smallest sets first: every step can only shrink
+    std::vector<const RoaringBitmap*> required;
+    for (const auto& tag : query.all) {
+        required.push_back(&bitmapOf(tag));
+    }
+    std::sort(required.begin(), required.end(), [](const RoaringBitmap* a, const RoaringBitmap* b) {
+        return a->Cardinality() < b->Cardinality();
+    });
+    
+    RoaringBitmap result;
+    if (!query.any.empty()) {
+        for (const auto& tag : query.any) {
+            result = RoaringBitmap::Or(result, bitmapOf(tag));
+        }
+        for (const RoaringBitmap* bitmap : required) {
+            result = RoaringBitmap::And(result, *bitmap);
+        }
+    } else if (!required.empty()) {
+        result = *required.front();
+        for (size_t i = 1; i < required.size(); ++i) {
+            result = RoaringBitmap::And(result, *required[i]);
+        }
+    } else {
+        result = allIds;
+    }
+    
+    for (const auto& tag : query.none) {
+        result = RoaringBitmap::AndNot(result, bitmapOf(tag));
+    }
+    return result;
+}
+
+size_t TagIndex::GetMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& tag : tags_) {
+        bytes += tag.first.capacity() + tag.second.GetMemoryUsage() + 4 * sizeof(void*);
+    }
+    return bytes;
+}
\ No newline at end of file
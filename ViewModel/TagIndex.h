@@ -0,0 +1,37 @@
+#pragma once
+#include "RoaringBitmap.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+// Which tags a query asks for: every tag in all, at least one in any (when
+// any is not empty), and none of those in none
+struct TagQuery {
+    std::vector<std::string> all;
+    std::vector<std::string> any;
+    std::vector<std::string> none;
+};
+
+// Transaction ids per tag, one compressed bitmap each. A query is a few
+// bitmap operations whatever the ledger size; the caller supplies the ids
+// of every transaction for queries that only exclude tags.
+class TagIndex {
+public:
+    void Build(const std::vector<std::pair<int, std::string>>& assignments);
+    void Add(int id, const std::string& tag);
+    void Remove(int id, const std::string& tag);
+    void RemoveTransaction(int id);
+    void Clear() { tags_.clear(); }
+    
+    // Tags in use, sorted, and those on one transaction
+    std::vector<std::string> GetTags() const;
+    std::vector<std::string> GetTags(int id) const;
+    
+    RoaringBitmap Find(const TagQuery& query, const RoaringBitmap& allIds) const;
+    
+    size_t GetMemoryUsage() const;
+
+private:
+    std::map<std::string, RoaringBitmap> tags_;
+};
\ No newline at end of file
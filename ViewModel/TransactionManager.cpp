@@ -1,49 +1,194 @@
 #include "TransactionManager.h"
+#include "../Import/MappedFile.h"
+#include "../Import/RateParser.h"
 #include <algorithm>
+#include <numeric>
+#include <cmath>
 #include <set>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <chrono>
 
-TransactionManager::TransactionManager(const std::string& dbPath) {
+namespace {
+    const char* const kReportingCurrencyKey = "reporting_currency";
+    
+    // Past this many changed rows, one reload and index rebuild is cheaper
+    // than patching the cache row by row
+    size_t ReloadThreshold(size_t cachedRows) {
+        return std::max<size_t>(512, cachedRows / 256);
+    }
+    
+    std::string Trim(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t\r\n");
+        size_t last = text.find_last_not_of(" \t\r\n");
+        return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+    }
+    
+    bool SameRow(const Transaction& a, const Transaction& b) {
+        return a.description == b.description && a.amount == b.amount && a.category == b.category &&
+               a.type == b.type && a.date == b.date && a.fingerprint == b.fingerprint && a.currency == b.currency &&
+               a.reconciled == b.reconciled;
+    }
+    
+    // Id ranges of the buckets whose change count moved
+    void AddChangedBuckets(const std::vector<BucketChanges>& before, const std::vector<BucketChanges>& after,
+                           std::vector<std::pair<std::int64_t, std::int64_t>>& ranges) {
+        auto add = [&](std::int64_t bucket) {
+            ranges.emplace_back(bucket * (std::int64_t(1) << BucketChanges::kBucketBits),
+                                bucket * (std::int64_t(1) << BucketChanges::kBucketBits) +
+                                ((std::int64_t(1) << BucketChanges::kBucketBits) - 1));
+        };
+        
+        // Both lists are ordered by bucket
+        size_t i = 0;
+        size_t j = 0;
+        while (i < before.size() || j < after.size()) {
+            if (j == after.size() || (i < before.size() && before[i].bucket < after[j].bucket)) {
+                add(before[i++].bucket);
+            } else if (i == before.size() || after[j].bucket < before[i].bucket) {
+                add(after[j++].bucket);
+            } else {
+                if (before[i].changes != after[j].changes) {
+                    add(after[j].bucket);
+                }
+                ++i;
+                ++j;
+            }
+        }
+    }
+    
+    // Calls visit(id, stored row or null) for every id in either list, in
+    // ascending order; both lists are ascending
+    template <typename Visit>
+    void WalkIds(const std::vector<Transaction>& stored, const std::vector<int>& cached, Visit visit) {
+        size_t s = 0;
+        size_t c = 0;
+        while (s < stored.size() || c < cached.size()) {
+            if (c == cached.size() || (s < stored.size() && stored[s].id < cached[c])) {
+                visit(stored[s].id, &stored[s]);
+                ++s;
+            } else if (s == stored.size() || cached[c] < stored[s].id) {
+                visit(cached[c++], nullptr);
+            } else {
+                visit(cached[c++], &stored[s]);
+                ++s;
+            }
+        }
+    }
+    
+    // Journal steps kept for undo, oldest dropped first
+    constexpr size_t kJournalSteps = 100;
+    
+    // Sorts and merges overlapping or adjacent ranges, so no id is visited twice
+    void MergeRanges(std::vector<std::pair<std::int64_t, std::int64_t>>& ranges) {
+        std::sort(ranges.begin(), ranges.end());
+        size_t kept = 0;
+        auto joins = [](const std::pair<std::int64_t, std::int64_t>& previous, std::int64_t first) {
+            return first <= previous.second ||
+                   (previous.second < std::numeric_limits<std::int64_t>::max() && first == previous.second + 1);
+        };
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (kept > 0 && joins(ranges[kept - 1], ranges[i].first)) {
+                ranges[kept - 1].second = std::max(ranges[kept - 1].second, ranges[i].second);
+            } else {
+                ranges[kept++] = ranges[i];
+            }
+        }
+        ranges.resize(kept);
+    }
+}
+
+TransactionManager::TransactionManager(const std::string& dbPath)
+    : snapshot_(TransactionSnapshot::Create({}, 0))
+    , converter_(std::make_shared<CurrencyConverter>())
+    , reportingCurrency_(kDefaultCurrency)
+    , reportVersion_(0)
+    , reportStale_(true)
+    , spendingStale_(true)
+    , flowsStale_(true)
+    , chartVersion_(0)
+    , dataVersion_(0)
+    , balanceStale_(false)
+    , knownMaxId_(0)
+    , lostBatches_(0)
+    , nextObserverToken_(1)
+    , sortedVersion_(0)
+    , sortDirty_(true)
+    , filterStale_(true)
+    , viewDirty_(true)
+    , periodFrom_(0)
+    , periodTo_(0)
+    , periodBalance_(0.0)
+    , periodVersion_(0)
+    , periodStale_(true)
+    , allIdsVersion_(0)
+    , amountsVersion_(0)
+    , amountsStale_(true) {
     dbHandler_ = std::make_unique<DatabaseHandler>(dbPath);
+    backups_ = std::make_unique<BackupService>(*dbHandler_);
     if (dbHandler_->Initialize()) {
+        LoadCurrencies();
         LoadTransactions();
+        scheduler_.Build(dbHandler_->GetRecurringRules());
+        LoadJournal();
     } else {
         std::cerr << "Failed to initialize database" << std::endl;
     }
 }
 
 bool TransactionManager::AddTransaction(const std::string& description, double amount,
-                                       const std::string& category, TransactionType type) {
+                                       const std::string& category, TransactionType type,
+                                       CurrencyCode currency, std::time_t date, int* id) {
     if (!dbHandler_ || description.empty() || category.empty() || amount <= 0) {
         return false;
     }
     
-    Transaction transaction(GetNextId(), description, amount, category, type);
+    Transaction transaction(GetNextId(), description, amount, category, type, date ? date : std::time(nullptr));
+    transaction.currency = currency;
+    transaction.fingerprint = duplicates_.Assign(transaction);
     
     if (dbHandler_->AddTransaction(transaction)) {
-        LoadTransactions(); // Refresh from database to get the actual ID
+        if (id) {
+            *id = dbHandler_->GetLastInsertId();
+        }
+        ApplyCapturedChanges("Add");
         NotifyObservers();
         return true;
     }
     
-    return false;
+    return WriteFailed();
 }
 
 bool TransactionManager::UpdateTransaction(int id, const std::string& description, double amount,
-                                         const std::string& category, TransactionType type) {
+                                         const std::string& category, TransactionType type,
+                                         CurrencyCode currency, std::time_t date) {
     if (!dbHandler_ || description.empty() || category.empty() || amount <= 0) {
         return false;
     }
     
-    Transaction transaction(id, description, amount, category, type);
+    Transaction transaction(id, description, amount, category, type, date ? date : std::time(nullptr));
+    transaction.currency = currency;
+    
+    size_t row = FindRow(id);
+    if (row != TransactionSnapshot::npos) {
+        const Transaction& previous = (*snapshot_)[row];
+        if (!date) {
+            transaction.date = previous.date; // Editing keeps the original date unless given one
+        }
+        transaction.fingerprint = BaseFingerprint(previous) == BaseFingerprint(transaction)
+                                  ? previous.fingerprint : duplicates_.Assign(transaction);
+    } else {
+        transaction.fingerprint = duplicates_.Assign(transaction);
+    }
     
     if (dbHandler_->UpdateTransaction(transaction)) {
-        LoadTransactions();
+        ApplyCapturedChanges("Edit");
         NotifyObservers();
         return true;
     }
     
-    return false;
+    return WriteFailed();
 }
 
 bool TransactionManager::DeleteTransaction(int id) {
@@ -52,44 +197,229 @@ bool TransactionManager::DeleteTransaction(int id) {
     }
     
     if (dbHandler_->DeleteTransaction(id)) {
-        LoadTransactions();
+        ApplyCapturedChanges("Delete");
         NotifyObservers();
         return true;
     }
     
-    return false;
+    return WriteFailed();
 }
 
-TransactionManager::TransactionList TransactionManager::GetTransactionsByCategory(const std::string& category) {
+bool TransactionManager::ImportStatement(const std::string& path, ImportReport& report,
+                                         StatementParser::Progress progress) {
     if (!dbHandler_) {
-        return {};
+        return false;
+    }
+    
+    MappedFile file;
+    if (!file.Open(path)) {
+        report.errors.push_back({0, file.GetError()});
+        return false;
+    }
+    
+    StatementParser parser;
+    parser.SetProgress(std::move(progress));
+    StatementFormat format = StatementParser::DetectFormat(path, file.GetData(), file.GetSize());
+    
+    // Duplicates are dropped from each chunk before it reaches the database;
+    // those carrying a category are kept aside to merge at the end
+    DuplicateIndex::Batch batch(duplicates_);
+    std::vector<std::pair<std::uint64_t, std::string>> merges;
+    
+    bool completed = parser.Parse(file.GetData(), file.GetSize(), format, [&](std::vector<Transaction>& rows) {
+        size_t kept = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (batch.IsDuplicate(rows[i])) {
+                if (rows[i].category.empty()) {
+                    ++report.rowsSkipped;
+                } else {
+                    merges.emplace_back(rows[i].fingerprint, std::move(rows[i].category));
+                }
+            } else {
+                if (kept != i) {
+                    rows[kept] = std::move(rows[i]);
+                }
+                ++kept;
+            }
+        }
+        rows.resize(kept);
+        
+        AssignCategories(rows);
+        size_t inserted = 0;
+        if (!dbHandler_->AddTransactions(rows, &inserted)) {
+            report.errors.push_back({0, "Failed to save imported transactions"});
+            return false;
+        }
+        report.rowsImported += inserted;
+        report.rowsSkipped += rows.size() - inserted; // Caught by the unique index
+        return true;
+    }, report);
+    
+    report.rowsMerged = dbHandler_->MergeCategories(merges);
+    report.rowsSkipped += merges.size() - report.rowsMerged;
+    
+    // Patches the cache with the rows written; a large import reloads it
+    // instead. The whole import is one step to undo.
+    ApplyCapturedChanges("Import");
+    if (report.rowsImported > 0 || report.rowsMerged > 0) {
+        NotifyObservers();
     }
     
-    return dbHandler_->GetTransactionsByCategory(category);
+    return completed;
 }
 
-TransactionManager::TransactionList TransactionManager::GetTransactionsByType(TransactionType type) {
+bool TransactionManager::ReconcileStatement(const std::string& path, ReconcileReport& report,
+                                            const ReconcileOptions& options, bool mark) {
     if (!dbHandler_) {
-        return {};
+        return false;
     }
     
-    return dbHandler_->GetTransactionsByType(type);
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.Open(path)) {
+        report.parsing.errors.push_back({0, file.GetError()});
+        return false;
+    }
+    
+    StatementParser parser;
+    StatementFormat format = StatementParser::DetectFormat(path, file.GetData(), file.GetSize());
+    report.lines.clear();
+    parser.Parse(file.GetData(), file.GetSize(), format, [&](std::vector<Transaction>& rows) {
+        report.lines.insert(report.lines.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+        return true;
+    }, report.parsing);
+    
+    // Cached rows from a day either side of the tolerance; the reconciler
+    // compares calendar days, so clock changes cannot push a row out
+    std::vector<const Transaction*> ledger;
+    if (!report.lines.empty()) {
+        auto span = std::minmax_element(report.lines.begin(), report.lines.end(),
+                                        [](const Transaction& a, const Transaction& b) { return a.date < b.date; });
+        std::time_t margin = static_cast<std::time_t>(std::max(options.dayTolerance, 0) + 1) * 24 * 60 * 60;
+        size_t first = 0;
+        size_t last = 0;
+        RowsInRange(span.first->date - margin, span.second->date + margin + 24 * 60 * 60, first, last);
+        ledger.reserve(last - first);
+        for (auto it = snapshot_->IteratorAt(first), end = snapshot_->IteratorAt(last); it != end; ++it) {
+            ledger.push_back(&*it);
+        }
+    }
+    
+    Reconciler(options).Match(report.lines, ledger, report);
+    
+    bool stored = true;
+    report.marked = 0;
+    if (mark) {
+        std::vector<int> ids;
+        for (const auto& match : report.matched) {
+            size_t row = FindRow(match.id);
+            if (row != TransactionSnapshot::npos && !(*snapshot_)[row].reconciled) {
+                ids.push_back(match.id);
+            }
+        }
+        stored = SetReconciled(ids, true);
+        report.marked = stored ? ids.size() : 0;
+    }
+    
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stored;
 }
 
-double TransactionManager::GetTotalIncome() const {
-    if (!dbHandler_) {
-        return 0.0;
+bool TransactionManager::SetReconciled(const std::vector<int>& ids, bool reconciled) {
+    if (!dbHandler_ || !dbHandler_->SetReconciled(ids, reconciled)) {
+        return false;
+    }
+    if (ids.empty()) {
+        return true;
+    }
+    
+    // Journaled from the cache, since the large batch below never reads back
+    std::vector<JournalImage> images;
+    for (int id : ids) {
+        size_t row = FindRow(id);
+        if (row != TransactionSnapshot::npos && (*snapshot_)[row].reconciled != reconciled) {
+            images.push_back(ImageOf(id));
+        }
+    }
+    if (!images.empty()) {
+        Journal(reconciled ? "Reconcile" : "Unreconcile", images);
+    }
+    
+    // No index looks at the flag, so a large batch is set in a copy of the
+    // cached rows rather than read back, which would rebuild every index
+    if (ids.size() > ReloadThreshold(snapshot_->size())) {
+        dbHandler_->TakeChanges();
+        std::vector<int> sorted(ids);
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<Transaction> rows;
+        rows.reserve(snapshot_->size());
+        for (const auto& transaction : *snapshot_) {
+            rows.push_back(transaction);
+            if (std::binary_search(sorted.begin(), sorted.end(), transaction.id)) {
+                rows.back().reconciled = reconciled;
+            }
+        }
+        Publish(TransactionSnapshot::Create(std::move(rows), snapshot_->GetVersion() + 1));
+        SyncChangeMarkers();
+    } else {
+        ApplyCapturedChanges();
     }
     
-    return dbHandler_->GetTotalByType(TransactionType::Income);
+    NotifyObservers();
+    return true;
 }
 
-double TransactionManager::GetTotalExpenses() const {
-    if (!dbHandler_) {
-        return 0.0;
+bool TransactionManager::GetTransaction(int id, Transaction& transaction) const {
+    size_t row = FindRow(id);
+    if (row == TransactionSnapshot::npos) {
+        return false;
     }
     
-    return dbHandler_->GetTotalByType(TransactionType::Expense);
+    transaction = (*snapshot_)[row];
+    return true;
+}
+
+TransactionManager::TransactionList TransactionManager::GetTransactionsByCategory(const std::string& category) const {
+    return FindTransactions(TransactionFilter::Category(category));
+}
+
+TransactionManager::TransactionList TransactionManager::GetTransactionsByType(TransactionType type) const {
+    return FindTransactions(TransactionFilter::Type(type));
+}
+
+TransactionManager::TransactionList TransactionManager::FindTransactions(const TransactionFilter& filter) const {
+    std::time_t from, to;
+    filter.DateBounds(from, to);
+    size_t first, last;
+    RowsInRange(from, to, first, last);
+    
+    TransactionList matches;
+    for (auto it = snapshot_->IteratorAt(first), end = snapshot_->IteratorAt(last); it != end; ++it) {
+        if (filter.Matches(*it)) {
+            matches.push_back(*it);
+        }
+    }
+    return matches;
+}
+
+TransactionManager::TransactionList TransactionManager::GetTransactionsInRange(std::time_t from, std::time_t to) const {
+    size_t first, last;
+    RowsInRange(from, to, first, last);
+    return TransactionList(snapshot_->IteratorAt(first), snapshot_->IteratorAt(last));
+}
+
+CurrencyConverter::Totals TransactionManager::GetTotalsInRange(std::time_t from, std::time_t to) const {
+    size_t first, last;
+    RowsInRange(from, to, first, last);
+    return converter_->Summarize(*snapshot_, reportingCurrency_, first, last);
+}
+
+double TransactionManager::GetTotalIncome() const {
+    return GetReportTotals().income;
+}
+
+double TransactionManager::GetTotalExpenses() const {
+    return GetReportTotals().expenses;
 }
 
 double TransactionManager::GetBalance() const {
@@ -97,31 +427,439 @@ double TransactionManager::GetBalance() const {
 }
 
 double TransactionManager::GetTotalByCategory(const std::string& category) const {
+    const auto& totals = GetReportTotals().byCategory;
+    auto found = totals.find(category);
+    return found != totals.end() ? found->second : 0.0;
+}
+
+const CurrencyConverter::Totals& TransactionManager::GetReportTotals() const {
+    if (reportStale_ || reportVersion_ != snapshot_->GetVersion()) {
+        reportTotals_ = converter_->Summarize(*snapshot_, reportingCurrency_);
+        reportVersion_ = snapshot_->GetVersion();
+        reportStale_ = false;
+    }
+    return reportTotals_;
+}
+
+CurrencyConverter::Totals TransactionManager::GetTotals(CurrencyCode target) const {
+    Snapshot snapshot = GetSnapshot();
+    return GetConverter()->Summarize(*snapshot, target);
+}
+
+bool TransactionManager::SetReportingCurrency(CurrencyCode currency) {
+    if (!dbHandler_ || !dbHandler_->SetSetting(kReportingCurrencyKey, CurrencyToString(currency))) {
+        return false;
+    }
+    
+    reportingCurrency_ = currency;
+    reportConversion_ = converter_->To(currency);
+    balanceIndex_.Build(*snapshot_, reportConversion_);
+    balanceStale_ = false;
+    reportStale_ = true;
+    spendingStale_ = true;
+    flowsStale_ = true;
+    periodStale_ = true;
+    amountsStale_ = true;
+    chart_.reset();
+    NotifyObservers();
+    return true;
+}
+
+bool TransactionManager::ImportExchangeRates(const std::string& path, ImportReport& report) {
     if (!dbHandler_) {
+        return false;
+    }
+    
+    MappedFile file;
+    if (!file.Open(path)) {
+        report.errors.push_back({0, file.GetError()});
+        return false;
+    }
+    
+    std::vector<ExchangeRate> rates;
+    RateParser::Parse(file.GetData(), file.GetSize(), rates, report);
+    if (rates.empty()) {
+        return report.rowsRejected == 0;
+    }
+    
+    if (!dbHandler_->AddExchangeRates(rates)) {
+        report.rowsImported = 0;
+        report.errors.push_back({0, "Failed to save exchange rates"});
+        return false;
+    }
+    
+    LoadCurrencies();
+    NotifyObservers();
+    return true;
+}
+
+ChartSeries::Ptr TransactionManager::GetChartSeries() const {
+    if (!chart_ || chartVersion_ != snapshot_->GetVersion()) {
+        chart_ = ChartSeries::Build(*snapshot_, reportConversion_);
+        chartVersion_ = snapshot_->GetVersion();
+    }
+    return chart_;
+}
+
+CashFlowForecast::Ptr TransactionManager::GetForecast(const ForecastOptions& options) const {
+    return CashFlowForecast::Build(GetFlows(), GetBalance(), spendingDays_(std::time(nullptr)), options);
+}
+
+std::vector<CategorySpread> TransactionManager::GetCategorySpread(std::time_t from, std::time_t to) const {
+    return GetSpending().GetCategorySpread(from ? MonthOf(from) : SpendingStats::kAllMonths,
+                                           to ? MonthOf(to) : SpendingStats::kAllMonths);
+}
+
+std::vector<MerchantSpend> TransactionManager::GetTopMerchants(size_t count, std::time_t from, std::time_t to) const {
+    return GetSpending().GetTopMerchants(count, from ? MonthOf(from) : SpendingStats::kAllMonths,
+                                         to ? MonthOf(to) : SpendingStats::kAllMonths);
+}
+
+std::vector<CurrencyCode> TransactionManager::GetCurrencies() const {
+    std::set<CurrencyCode> currencies(converter_->GetCurrencies().begin(), converter_->GetCurrencies().end());
+    currencies.insert(kDefaultCurrency);
+    currencies.insert(reportingCurrency_);
+    
+    CurrencyCode last = kDefaultCurrency;
+    for (const auto& transaction : *snapshot_) {
+        if (transaction.currency != last) {
+            last = transaction.currency;
+            currencies.insert(last);
+        }
+    }
+    
+    return std::vector<CurrencyCode>(currencies.begin(), currencies.end());
+}
+
+bool TransactionManager::AddRecurringRule(RecurringRule rule, std::time_t start, size_t* created) {
+    if (!dbHandler_ || rule.description.empty() || rule.category.empty() || rule.amount <= 0 ||
+        rule.interval < 1 || rule.dayOfMonth < 1 || rule.dayOfMonth > 31) {
+        return false;
+    }
+    
+    rule.nextDue = RecurringScheduler::FirstOccurrence(rule, start);
+    if (!dbHandler_->AddRecurringRule(rule)) {
+        return false;
+    }
+    
+    rule.id = dbHandler_->GetLastInsertId();
+    scheduler_.Add(rule);
+    
+    size_t materialized = MaterializeRecurring();
+    if (created) {
+        *created = materialized;
+    }
+    return true;
+}
+
+bool TransactionManager::DeleteRecurringRule(int id) {
+    if (!dbHandler_ || !dbHandler_->DeleteRecurringRule(id)) {
+        return false;
+    }
+    
+    // Transactions it already created stay
+    scheduler_.Remove(id);
+    return true;
+}
+
+size_t TransactionManager::MaterializeRecurring(std::time_t now) {
+    if (!dbHandler_) {
+        return 0;
+    }
+    
+    std::vector<std::pair<int, std::time_t>> advanced;
+    std::vector<Transaction> occurrences = scheduler_.CollectDue(now, advanced);
+    if (advanced.empty()) {
+        return 0;
+    }
+    
+    for (auto& occurrence : occurrences) {
+        occurrence.fingerprint = duplicates_.Assign(occurrence);
+        duplicates_.Add(occurrence.fingerprint);
+    }
+    
+    if (!dbHandler_->MaterializeRecurring(occurrences, advanced)) {
+        // Nothing was written; return to the stored schedule
+        scheduler_.Build(dbHandler_->GetRecurringRules());
+        duplicates_.Build(*snapshot_);
+        return 0;
+    }
+    
+    ApplyCapturedChanges();
+    NotifyObservers();
+    return occurrences.size();
+}
+
+bool TransactionManager::RestoreBackup(const std::string& path, DatabaseHandler::BackupProgress progress) {
+    if (!dbHandler_ || backups_->IsRunning()) {
+        return false;
+    }
+    
+    if (!dbHandler_->RestoreFrom(path, progress)) {
+        return false;
+    }
+    
+    LoadCurrencies();
+    LoadTransactions();
+    scheduler_.Build(dbHandler_->GetRecurringRules());
+    LoadJournal();
+    MaterializeRecurring();
+    NotifyObservers();
+    return true;
+}
+
+bool TransactionManager::CompactStorage(StorageStats& before, StorageStats& after) {
+    if (!IsInitialized() || backups_->IsRunning()) {
+        return false;
+    }
+    
+    return dbHandler_->CompactStorage(before, after);
+}
+
+void TransactionManager::RunMaintenance(std::time_t now) {
+    if (IsInitialized()) {
+        dbHandler_->RunMaintenance(now);
+    }
+}
+
+bool TransactionManager::CanUndo() const {
+    return !journal_.empty() && !journal_.front().undone;
+}
+
+bool TransactionManager::CanRedo() const {
+    return !journal_.empty() && journal_.back().undone;
+}
+
+std::string TransactionManager::GetUndoLabel() const {
+    auto step = std::find_if(journal_.rbegin(), journal_.rend(), [](const JournalStep& s) { return !s.undone; });
+    return step != journal_.rend() ? step->label : std::string();
+}
+
+std::string TransactionManager::GetRedoLabel() const {
+    auto step = std::find_if(journal_.begin(), journal_.end(), [](const JournalStep& s) { return s.undone; });
+    return step != journal_.end() ? step->label : std::string();
+}
+
+bool TransactionManager::Undo() {
+    return Replay(true);
+}
+
+bool TransactionManager::Redo() {
+    return Replay(false);
+}
+
+double TransactionManager::GetRunningBalance(size_t row) const {
+    if (row >= snapshot_->size()) {
         return 0.0;
     }
     
-    return dbHandler_->GetTotalByCategory(category);
+    return balanceIndex_.GetBalanceAfter((*snapshot_)[row].id);
+}
+
+double TransactionManager::GetBalanceAsOf(std::time_t date) const {
+    return balanceIndex_.GetBalanceAsOf(date);
+}
+
+void TransactionManager::SetSortKeys(std::vector<SortKey> keys) {
+    sortKeys_ = std::move(keys);
+    sortDirty_ = true;
+}
+
+void TransactionManager::SetFilterText(const std::string& text) {
+    if (text == filterText_) {
+        return;
+    }
+    
+    // Typing more characters can only remove matches, so check the previous
+    // matches rather than searching the index again
+    if (!text.empty() && !filterText_.empty() && !filterStale_ && text.find(filterText_) != std::string::npos) {
+        filterIds_ = searchIndex_.Refine(filterIds_, text);
+    } else {
+        filterStale_ = true;
+    }
+    
+    filterText_ = text;
+    viewDirty_ = true;
+}
+
+void TransactionManager::SetPeriod(std::time_t from, std::time_t to) {
+    if (from == periodFrom_ && to == periodTo_) {
+        return;
+    }
+    
+    periodFrom_ = from;
+    periodTo_ = to;
+    periodStale_ = true;
+    viewDirty_ = true;
+}
+
+const CurrencyConverter::Totals& TransactionManager::GetPeriodTotals() const {
+    if (!HasPeriod()) {
+        return GetReportTotals();
+    }
+    
+    if (periodStale_ || periodVersion_ != snapshot_->GetVersion()) {
+        size_t first, last;
+        RowsInRange(periodFrom_, periodTo_, first, last);
+        periodTotals_ = converter_->Summarize(*snapshot_, reportingCurrency_, first, last);
+        
+        // The balance at the end is everything less what came after, which
+        // for recent periods is the shorter walk
+        periodBalance_ = GetBalance();
+        if (first > 0) {
+            CurrencyConverter::Totals later = converter_->Summarize(*snapshot_, reportingCurrency_, 0, first);
+            periodBalance_ -= later.income - later.expenses;
+        }
+        periodVersion_ = snapshot_->GetVersion();
+        periodStale_ = false;
+    }
+    return periodTotals_;
+}
+
+double TransactionManager::GetPeriodClosingBalance() const {
+    if (!HasPeriod()) {
+        return GetBalance();
+    }
+    
+    GetPeriodTotals();
+    return periodBalance_;
+}
+
+const std::vector<std::uint32_t>& TransactionManager::GetViewRows() {
+    if (sortDirty_ || sortedVersion_ != snapshot_->GetVersion()) {
+        sortedRows_ = sorter_.Sort(*snapshot_, sortKeys_);
+        sortedVersion_ = snapshot_->GetVersion();
+        sortDirty_ = false;
+        viewDirty_ = true;
+    }
+    
+    if (filterText_.empty() && !HasPeriod()) {
+        return sortedRows_;
+    }
+    
+    if (!filterText_.empty() && filterStale_) {
+        filterIds_ = searchIndex_.Search(filterText_);
+        filterStale_ = false;
+        viewDirty_ = true;
+    }
+    
+    if (viewDirty_) {
+        ApplyFilter();
+        viewDirty_ = false;
+    }
+    
+    return viewRows_;
+}
+
+CategoryPrediction TransactionManager::SuggestCategory(const std::string& description) const {
+    return categorizer_.Classify(description);
+}
+
+std::vector<CategoryPrediction> TransactionManager::SuggestCategories(const std::vector<std::string>& descriptions) const {
+    return categorizer_.ClassifyBatch(descriptions);
 }
 
 std::vector<std::string> TransactionManager::GetCategories() const {
     std::set<std::string> uniqueCategories;
     
-    for (const auto& transaction : transactions_) {
+    for (const auto& transaction : *snapshot_) {
         uniqueCategories.insert(transaction.category);
     }
     
     return std::vector<std::string>(uniqueCategories.begin(), uniqueCategories.end());
 }
 
-void TransactionManager::RegisterObserver(Observer observer) {
-    observers_.push_back(observer);
+int TransactionManager::RegisterObserver(Observer observer) {
+    observers_.emplace_back(nextObserverToken_, std::move(observer));
+    return nextObserverToken_++;
 }
 
-void TransactionManager::UnregisterObserver(Observer observer) {
-    // Note: This is a simplified implementation. In a real application,
-    // you might want to use a more sophisticated approach to manage observers
-    // observers_.erase(std::remove(observers_.begin(), observers_.end(), observer), observers_.end());
+void TransactionManager::UnregisterObserver(int token) {
+    observers_.erase(std::remove_if(observers_.begin(), observers_.end(),
+                                    [token](const std::pair<int, Observer>& entry) { return entry.first == token; }),
+                     observers_.end());
+}
+
+bool TransactionManager::AddTag(int id, const std::string& tag) {
+    return TagTransactions({id}, tag);
+}
+
+bool TransactionManager::RemoveTag(int id, const std::string& tag) {
+    std::string name = Trim(tag);
+    if (!dbHandler_ || name.empty() || !dbHandler_->RemoveTag({id}, name)) {
+        return false;
+    }
+    
+    tags_.Remove(id, name);
+    return true;
+}
+
+bool TransactionManager::TagTransactions(const std::vector<int>& ids, const std::string& tag) {
+    std::string name = Trim(tag);
+    if (!dbHandler_ || name.empty() || !dbHandler_->AddTag(ids, name)) {
+        return false;
+    }
+    
+    for (int id : ids) {
+        if (FindRow(id) != TransactionSnapshot::npos) {
+            tags_.Add(id, name);
+        }
+    }
+    return true;
+}
+
+std::vector<int> TransactionManager::FindTagged(const TagQuery& query) const {
+    std::vector<int> ids;
+    FindTaggedIds(query).ForEach([&](std::uint32_t id) { ids.push_back(static_cast<int>(id)); });
+    return ids;
+}
+
+CurrencyConverter::Totals TransactionManager::GetTaggedTotals(const TagQuery& query) const {
+    if (amountsStale_ || amountsVersion_ != snapshot_->GetVersion()) {
+        // Row order to ids, so a bitmap's ids look up the column directly
+        std::vector<double> amounts;
+        converter_->ConvertAmounts(*snapshot_, reportingCurrency_, amounts);
+        amountsById_.clear();
+        amountsById_.reserve(amounts.size());
+        size_t row = 0;
+        for (const auto& transaction : *snapshot_) {
+            amountsById_[transaction.id] = amounts[row++];
+        }
+        amountsVersion_ = snapshot_->GetVersion();
+        amountsStale_ = false;
+    }
+    
+    CurrencyConverter::Totals totals;
+    totals.currency = reportingCurrency_;
+    FindTaggedIds(query).ForEach([&](std::uint32_t id) {
+        auto found = amountsById_.find(static_cast<int>(id));
+        double amount = found != amountsById_.end() ? found->second : 0.0;
+        if (std::isnan(amount)) {
+            ++totals.unconverted;
+        } else if (amount != 0.0) {
+            (amount > 0.0 ? totals.income : totals.expenses) += std::abs(amount);
+            ++totals.rows;
+        }
+    });
+    return totals;
+}
+
+size_t TransactionManager::GetMemoryUsage() const {
+    // Balance and duplicate index entries, sorted and filtered row lists and
+    // allocator overhead; calibrated against RSS on a 200k-row ledger
+    constexpr size_t kIndexBytesPerRow = 128;
+    
+    auto heapBytes = [](const std::string& text) {
+        return text.capacity() >= sizeof(std::string) ? text.capacity() + 1 : 0;
+    };
+    
+    size_t bytes = sizeof(*this);
+    for (const auto& transaction : *snapshot_) {
+        bytes += sizeof(Transaction) + heapBytes(transaction.description) + heapBytes(transaction.category);
+        // Trigram postings (an id per gram, with vector slack) and the folded copy of the text
+        bytes += transaction.description.size() * (2 * sizeof(int) + 1);
+    }
+    return bytes + snapshot_->size() * kIndexBytesPerRow + tags_.GetMemoryUsage();
 }
 
 void TransactionManager::RefreshData() {
@@ -129,29 +867,542 @@ void TransactionManager::RefreshData() {
     NotifyObservers();
 }
 
+bool TransactionManager::CheckExternalChanges() {
+    if (!dbHandler_) {
+        return false;
+    }
+    if (ReloadIfBatchLost()) {
+        NotifyObservers();
+        return true;
+    }
+    
+    // Version first: a commit landing after it is seen on the next check
+    std::int64_t version = dbHandler_->GetDataVersion();
+    if (version == dataVersion_) {
+        return false;
+    }
+    dataVersion_ = version;
+    LoadJournal();  // Another program's steps are undone here as well
+    std::int64_t maxId = dbHandler_->GetMaxId();
+    std::vector<BucketChanges> buckets = dbHandler_->GetBucketChanges();
+    
+    std::vector<std::pair<std::int64_t, std::int64_t>> ranges;
+    AddChangedBuckets(bucketChanges_, buckets, ranges);
+    if (maxId > knownMaxId_) {
+        ranges.emplace_back(knownMaxId_ + 1, maxId);
+    }
+    bucketChanges_ = std::move(buckets);
+    knownMaxId_ = maxId;
+    if (ranges.empty()) {
+        return false;
+    }
+    
+    MergeRanges(ranges);
+    ReconcileRanges(std::move(ranges));
+    NotifyObservers();
+    return true;
+}
+
 void TransactionManager::NotifyObservers() {
     for (const auto& observer : observers_) {
-        observer();
+        observer.second();
     }
 }
 
 void TransactionManager::LoadTransactions() {
     if (dbHandler_) {
-        transactions_ = dbHandler_->GetAllTransactions();
+        // Read the markers first: a commit landing during the load shows up
+        // as a change on the next check rather than going unnoticed
+        dataVersion_ = dbHandler_->GetDataVersion();
+        knownMaxId_ = dbHandler_->GetMaxId();
+        bucketChanges_ = dbHandler_->GetBucketChanges();
+        dbHandler_->TakeChanges();
+        
+        Publish(TransactionSnapshot::Create(dbHandler_->GetAllTransactions(), snapshot_->GetVersion() + 1));
+        balanceIndex_.Build(*snapshot_, reportConversion_);
+        balanceStale_ = false;
+        searchIndex_.Build(*snapshot_);
+        categorizer_.Build(*snapshot_);
+        duplicates_.Build(*snapshot_);
+        tags_.Build(dbHandler_->GetTagAssignments());
+        filterStale_ = true;
+        spendingStale_ = true;  // Rebuilt when first asked for
+        flowsStale_ = true;
     }
 }
 
-int TransactionManager::GetNextId() const {
-    if (transactions_.empty()) {
-        return 1;
+void TransactionManager::LoadCurrencies() {
+    auto converter = std::make_shared<CurrencyConverter>();
+    converter->Build(dbHandler_->GetExchangeRates());
+    std::atomic_store(&converter_, CurrencyConverter::Ptr(std::move(converter)));
+    
+    std::string code;
+    reportingCurrency_ = kDefaultCurrency;
+    if (dbHandler_->GetSetting(kReportingCurrencyKey, code)) {
+        ParseCurrency(code, reportingCurrency_);
+    }
+    reportConversion_ = converter_->To(reportingCurrency_);
+    balanceIndex_.Build(*snapshot_, reportConversion_);
+    balanceStale_ = false;
+    reportStale_ = true;
+    spendingStale_ = true;
+    flowsStale_ = true;
+    periodStale_ = true;
+    amountsStale_ = true;
+    chart_.reset();
+}
+
+void TransactionManager::Publish(Snapshot next) {
+    // Readers on other threads pick up the new version on their next GetSnapshot()
+    std::atomic_store(&snapshot_, std::move(next));
+}
+
+size_t TransactionManager::FindRow(int id) const {
+    std::time_t date;
+    if (!balanceIndex_.LookupDate(id, date)) {
+        return TransactionSnapshot::npos;
+    }
+    
+    size_t row = snapshot_->LowerBound(date, id);
+    if (row < snapshot_->size() && (*snapshot_)[row].id == id) {
+        return row;
+    }
+    
+    return TransactionSnapshot::npos;
+}
+
+void TransactionManager::InsertIntoCache(const Transaction& transaction) {
+    // Cache mirrors the database order: date DESC, id DESC
+    Publish(snapshot_->WithInserted(snapshot_->LowerBound(transaction.date, transaction.id), transaction));
+    
+    // A row dated before the newest one cannot be appended; the balance index
+    // is rebuilt once when the whole batch of changes is in
+    if (!balanceStale_ && !balanceIndex_.Append(transaction, reportConversion_)) {
+        balanceStale_ = true;
     }
     
-    int maxId = 0;
-    for (const auto& transaction : transactions_) {
-        if (transaction.id > maxId) {
-            maxId = transaction.id;
+    searchIndex_.Add(transaction.id, transaction.description);
+    categorizer_.Train(transaction.description, transaction.category);
+    duplicates_.Add(transaction.fingerprint);
+    if (!spendingStale_) {
+        AddToSpending(transaction);
+    }
+    if (!flowsStale_) {
+        AddToFlows(transaction, true);
+    }
+    filterStale_ = true;
+}
+
+void TransactionManager::ReplaceInCache(size_t row, const Transaction& transaction) {
+    const Transaction previous = (*snapshot_)[row];
+    Publish(snapshot_->WithReplaced(row, transaction));
+    
+    if (!balanceStale_ && !balanceIndex_.Update(transaction, reportConversion_)) {
+        balanceStale_ = true;
+    }
+    
+    searchIndex_.Update(transaction.id, transaction.description);
+    categorizer_.Untrain(previous.description, previous.category);
+    categorizer_.Train(transaction.description, transaction.category);
+    duplicates_.Remove(previous.fingerprint);
+    duplicates_.Add(transaction.fingerprint);
+    spendingStale_ = true;
+    if (!flowsStale_) {
+        AddToFlows(previous, false);
+        AddToFlows(transaction, true);
+    }
+    filterStale_ = true;
+}
+
+void TransactionManager::EraseFromCache(size_t row) {
+    const Transaction previous = (*snapshot_)[row];
+    Publish(snapshot_->WithErased(row));
+    
+    if (!balanceStale_) {
+        balanceIndex_.Remove(previous.id);
+    }
+    searchIndex_.Remove(previous.id);
+    categorizer_.Untrain(previous.description, previous.category);
+    duplicates_.Remove(previous.fingerprint);
+    tags_.RemoveTransaction(previous.id);
+    spendingStale_ = true;
+    if (!flowsStale_) {
+        AddToFlows(previous, false);
+    }
+    filterStale_ = true;
+}
+
+void TransactionManager::ApplyCapturedChanges(const char* label) {
+    if (ReloadIfBatchLost()) {
+        return;
+    }
+    
+    std::vector<RowChange> changes = dbHandler_->TakeChanges();
+    std::vector<int> ids;
+    ids.reserve(changes.size());
+    for (const auto& change : changes) {
+        ids.push_back(static_cast<int>(change.rowid));
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    
+    // The cache still holds the rows as they were before the write
+    if (label && !ids.empty()) {
+        std::vector<JournalImage> images;
+        images.reserve(ids.size());
+        for (int id : ids) {
+            images.push_back(ImageOf(id));
         }
+        Journal(label, images);
     }
     
-    return maxId + 1;
-} 
\ No newline at end of file
+    // Imports and recurring batches write consecutive ids: one range each
+    std::vector<std::pair<std::int64_t, std::int64_t>> ranges;
+    for (int id : ids) {
+        if (!ranges.empty() && ranges.back().second + 1 == id) {
+            ranges.back().second = id;
+        } else {
+            ranges.emplace_back(id, id);
+        }
+    }
+    
+    ReconcileRanges(std::move(ranges));
+    SyncChangeMarkers();
+}
+
+bool TransactionManager::ReloadIfBatchLost() {
+    // The cache already holds the lost rows, and which ones is not recorded;
+    // the journal steps written with them are gone as well
+    std::uint64_t lost = dbHandler_->GetCommitStats().lostBatches;
+    if (lost == lostBatches_) {
+        return false;
+    }
+    lostBatches_ = lost;
+    LoadTransactions();
+    LoadJournal();
+    return true;
+}
+
+bool TransactionManager::WriteFailed() {
+    // A failed write can take the rest of its batch with it
+    if (ReloadIfBatchLost()) {
+        NotifyObservers();
+    }
+    return false;
+}
+
+void TransactionManager::LoadJournal() {
+    journal_ = dbHandler_->GetJournalSteps();
+}
+
+JournalImage TransactionManager::ImageOf(int id) const {
+    size_t row = FindRow(id);
+    if (row == TransactionSnapshot::npos) {
+        return {id, id, false, Transaction(), {}};
+    }
+    return {id, id, true, (*snapshot_)[row], tags_.GetTags(id)};
+}
+
+void TransactionManager::Journal(const std::string& label, const std::vector<JournalImage>& images) {
+    // The change itself is already stored, so a journal that cannot be
+    // written costs the undo step, not the edit
+    int stepId = 0;
+    if (!dbHandler_->AddJournalStep(label, images, kJournalSteps, &stepId)) {
+        std::cerr << "Failed to journal " << label << std::endl;
+        LoadJournal();
+        return;
+    }
+    
+    // As the database did it, without reading the steps back
+    journal_.erase(std::remove_if(journal_.begin(), journal_.end(), [](const JournalStep& s) { return s.undone; }),
+                   journal_.end());
+    journal_.push_back({stepId, label, false});
+    if (journal_.size() > kJournalSteps) {
+        journal_.erase(journal_.begin(), journal_.end() - kJournalSteps);
+    }
+}
+
+bool TransactionManager::Replay(bool undo) {
+    if (!dbHandler_ || (undo ? !CanUndo() : !CanRedo())) {
+        return false;
+    }
+    
+    auto step = undo ? std::find_if(journal_.rbegin(), journal_.rend(), [](const JournalStep& s) { return !s.undone; }).base() - 1
+                     : std::find_if(journal_.begin(), journal_.end(), [](const JournalStep& s) { return s.undone; });
+    std::vector<JournalImage> applied;
+    if (!dbHandler_->ReplayJournalStep(step->id, applied)) {
+        LoadJournal();
+        return false;
+    }
+    
+    // Rows put back come in through the cache patch; their tags do not
+    ApplyCapturedChanges();
+    for (const JournalImage& image : applied) {
+        if (image.present && FindRow(image.firstId) != TransactionSnapshot::npos) {
+            tags_.RemoveTransaction(image.firstId);
+            for (const std::string& tag : image.tags) {
+                tags_.Add(image.firstId, tag);
+            }
+        }
+    }
+    
+    LoadJournal();
+    NotifyObservers();
+    return true;
+}
+
+void TransactionManager::SyncChangeMarkers() {
+    // If the version has not moved since the last check, everything the
+    // markers count is our own and already in the cache; version last, so
+    // no foreign commit can slip in between
+    std::int64_t maxId = dbHandler_->GetMaxId();
+    std::vector<BucketChanges> buckets = dbHandler_->GetBucketChanges();
+    if (dbHandler_->GetDataVersion() == dataVersion_) {
+        knownMaxId_ = maxId;
+        bucketChanges_ = std::move(buckets);
+    }
+}
+
+std::vector<int> TransactionManager::CachedIds(std::int64_t first, std::int64_t last) const {
+    // Probing each id costs less than a pass over the cache only while the
+    // range is narrower than the cache is long
+    std::vector<int> ids;
+    if (last - first < static_cast<std::int64_t>(snapshot_->size())) {
+        for (std::int64_t id = first; id <= last; ++id) {
+            if (balanceIndex_.Contains(static_cast<int>(id))) {
+                ids.push_back(static_cast<int>(id));
+            }
+        }
+        return ids;
+    }
+    
+    for (const auto& transaction : *snapshot_) {
+        if (transaction.id >= first && transaction.id <= last) {
+            ids.push_back(transaction.id);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void TransactionManager::ReconcileRanges(std::vector<std::pair<std::int64_t, std::int64_t>> ranges) {
+    // The cache keys rows by int, so rowids outside it are never cached
+    size_t kept = 0;
+    for (const auto& range : ranges) {
+        std::int64_t first = std::max<std::int64_t>(range.first, std::numeric_limits<int>::min());
+        std::int64_t last = std::min<std::int64_t>(range.second, std::numeric_limits<int>::max());
+        if (first <= last) {
+            ranges[kept++] = {first, last};
+        }
+    }
+    ranges.resize(kept);
+    
+    // Walk the stored rows of each range together with the cached ids in it,
+    // both ascending: ids only cached are erased, ids only stored inserted
+    // and changed ones replaced. Gaps between ids cost nothing. Count the
+    // differences first, since patching costs per row.
+    std::vector<std::vector<Transaction>> storedByRange;
+    std::vector<std::vector<int>> cachedByRange;
+    storedByRange.reserve(ranges.size());
+    cachedByRange.reserve(ranges.size());
+    size_t differences = 0;
+    for (const auto& range : ranges) {
+        storedByRange.push_back(dbHandler_->GetTransactionsInRange(range.first, range.second));
+        cachedByRange.push_back(CachedIds(range.first, range.second));
+        WalkIds(storedByRange.back(), cachedByRange.back(), [&](int id, const Transaction* incoming) {
+            size_t row = FindRow(id);
+            if (row == TransactionSnapshot::npos ? incoming != nullptr
+                                                 : !incoming || !SameRow((*snapshot_)[row], *incoming)) {
+                ++differences;
+            }
+        });
+    }
+    
+    if (differences > ReloadThreshold(snapshot_->size())) {
+        LoadTransactions();
+        return;
+    }
+    
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        WalkIds(storedByRange[i], cachedByRange[i], [&](int id, const Transaction* incoming) {
+            size_t row = FindRow(id); // Each id is visited once, so a stale balance index still finds it
+            
+            if (row == TransactionSnapshot::npos) {
+                if (incoming) {
+                    InsertIntoCache(*incoming);
+                }
+            } else if (!incoming) {
+                EraseFromCache(row);
+            } else if ((*snapshot_)[row].date != incoming->date) {
+                // The cache is ordered by date, so a new date means a new position
+                EraseFromCache(row);
+                InsertIntoCache(*incoming);
+            } else if (!SameRow((*snapshot_)[row], *incoming)) {
+                ReplaceInCache(row, *incoming);
+            }
+        });
+    }
+    
+    if (balanceStale_) {
+        balanceIndex_.Build(*snapshot_, reportConversion_);
+        balanceStale_ = false;
+    }
+}
+
+void TransactionManager::ApplyFilter() {
+    // The period is one run of snapshot rows, which are in date order
+    size_t first, last;
+    RowsInRange(periodFrom_, periodTo_, first, last);
+    viewRows_.clear();
+    
+    if (filterText_.empty()) {
+        if (sortKeys_.empty()) {
+            // Unsorted means snapshot order, so the run is the view
+            viewRows_.resize(last - first);
+            std::iota(viewRows_.begin(), viewRows_.end(), static_cast<std::uint32_t>(first));
+            return;
+        }
+        
+        viewRows_.reserve(last - first);
+        for (std::uint32_t sortedRow : sortedRows_) {
+            if (sortedRow >= first && sortedRow < last) {
+                viewRows_.push_back(sortedRow);
+            }
+        }
+        return;
+    }
+    
+    // Matches are ascending ids; mark the rows of the run they occupy, then keep sorted order
+    std::vector<bool> matchByRow(last - first, false);
+    size_t row = 0;
+    for (auto transaction = snapshot_->IteratorAt(first); row < matchByRow.size(); ++transaction) {
+        matchByRow[row++] = std::binary_search(filterIds_.begin(), filterIds_.end(), transaction->id);
+    }
+    
+    viewRows_.reserve(std::min(filterIds_.size(), last - first));
+    for (std::uint32_t sortedRow : sortedRows_) {
+        if (sortedRow >= first && sortedRow < last && matchByRow[sortedRow - first]) {
+            viewRows_.push_back(sortedRow);
+        }
+    }
+}
+
+void TransactionManager::RowsInRange(std::time_t from, std::time_t to, size_t& first, size_t& last) const {
+    first = to ? snapshot_->FirstBefore(to) : 0;
+    last = from ? snapshot_->FirstBefore(from) : snapshot_->size();
+    last = std::max(first, last);  // from after to: nothing
+}
+
+void TransactionManager::AssignCategories(std::vector<Transaction>& rows) const {
+    std::vector<std::string> descriptions;
+    std::vector<size_t> uncategorized;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i].category.empty()) {
+            descriptions.push_back(rows[i].description);
+            uncategorized.push_back(i);
+        }
+    }
+    
+    if (descriptions.empty()) {
+        return;
+    }
+    
+    std::vector<CategoryPrediction> predictions = categorizer_.ClassifyBatch(descriptions);
+    for (size_t i = 0; i < uncategorized.size(); ++i) {
+        std::string& category = rows[uncategorized[i]].category;
+        category = predictions[i].category.empty() ? "Other" : std::move(predictions[i].category);
+    }
+}
+
+bool TransactionManager::ToReporting(const Transaction& transaction, double& amount, std::int32_t& day) const {
+    const double* factors = reportConversion_.Factors(transaction.currency);
+    if (!factors) {
+        return false;  // No rate to the reporting currency
+    }
+    
+    day = spendingDays_(transaction.date);
+    amount = transaction.currency == reportingCurrency_
+             ? transaction.amount : transaction.amount * factors[reportConversion_.Index(day)];
+    return true;
+}
+
+void TransactionManager::AddToSpending(const Transaction& transaction) const {
+    double amount;
+    std::int32_t day;
+    if (!ToReporting(transaction, amount, day)) {
+        return;
+    }
+    
+    int year, month, dayOfMonth;
+    CivilFromDays(day, year, month, dayOfMonth);
+    spending_.Add(transaction, amount, MonthIndex(year, month));
+}
+
+void TransactionManager::AddToFlows(const Transaction& transaction, bool add) const {
+    double amount;
+    std::int32_t day;
+    if (!ToReporting(transaction, amount, day)) {
+        return;
+    }
+    
+    if (add) {
+        flows_.Add(transaction, amount, day);
+    } else {
+        flows_.Remove(transaction, amount, day);
+    }
+}
+
+const MonthlyFlows& TransactionManager::GetFlows() const {
+    if (flowsStale_) {
+        flows_.Clear();
+        for (const auto& transaction : *snapshot_) {
+            AddToFlows(transaction, true);
+        }
+        flowsStale_ = false;
+    }
+    return flows_;
+}
+
+const SpendingStats& TransactionManager::GetSpending() const {
+    if (spendingStale_) {
+        spending_.Clear();
+        for (const auto& transaction : *snapshot_) {
+            AddToSpending(transaction);
+        }
+        spendingStale_ = false;
+    }
+    return spending_;
+}
+
+SpendingStats::Month TransactionManager::MonthOf(std::time_t date) const {
+    int year, month, day;
+    CivilFromDays(spendingDays_(date), year, month, day);
+    return MonthIndex(year, month);
+}
+
+RoaringBitmap TransactionManager::FindTaggedIds(const TagQuery& query) const {
+    // Every id is only needed when nothing but exclusions narrows the query
+    if (query.all.empty() && query.any.empty() && allIdsVersion_ != snapshot_->GetVersion()) {
+        // Sorted first, so every add appends
+        std::vector<std::uint32_t> ids;
+        ids.reserve(snapshot_->size());
+        for (const auto& transaction : *snapshot_) {
+            if (transaction.id >= 0) {
+                ids.push_back(static_cast<std::uint32_t>(transaction.id));
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        allIds_.Clear();
+        for (std::uint32_t id : ids) {
+            allIds_.Add(id);
+        }
+        allIdsVersion_ = snapshot_->GetVersion();
+    }
+    return tags_.Find(query, allIds_);
+}
+
+int TransactionManager::GetNextId() const {
+    // Only a placeholder until the insert assigns the real id, so the tracked
+    // maximum will do rather than a scan of the cache
+    return static_cast<int>(std::min<std::int64_t>(knownMaxId_ + 1, std::numeric_limits<int>::max()));
+}
\ No newline at end of file
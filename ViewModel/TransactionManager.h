@@ -1,55 +1,326 @@
 #pragma once
 #include "../Model/Transaction.h"
 #include "../Database/DatabaseHandler.h"
+#include "../Import/StatementParser.h"
+#include "BalanceIndex.h"
+#include "TransactionSnapshot.h"
+#include "TransactionSorter.h"
+#include "TrigramIndex.h"
+#include "Categorizer.h"
+#include "DuplicateIndex.h"
+#include "RecurringScheduler.h"
+#include "BackupService.h"
+#include "CurrencyConverter.h"
+#include "SpendingStats.h"
+#include "ChartSeries.h"
+#include "TagIndex.h"
+#include "Reconciler.h"
+#include "MonthlyFlows.h"
+#include "CashFlowForecast.h"
 #include <vector>
 #include <memory>
 #include <functional>
 #include <string>
+#include <unordered_map>
+#include <cstdint>
 
 class TransactionManager {
 public:
     using TransactionList = std::vector<Transaction>;
+    using Snapshot = TransactionSnapshot::Ptr;
     using Observer = std::function<void()>;
     
     explicit TransactionManager(const std::string& dbPath);
     ~TransactionManager() = default;
     
-    // Transaction operations
+    // Transaction operations. A zero date stamps a new transaction with the
+    // current time and leaves an edited one on its stored date.
+    // AddTransaction() reports the stored id through id when given.
     bool AddTransaction(const std::string& description, double amount, 
-                       const std::string& category, TransactionType type);
+                       const std::string& category, TransactionType type,
+                       CurrencyCode currency = kDefaultCurrency, std::time_t date = 0, int* id = nullptr);
     bool UpdateTransaction(int id, const std::string& description, double amount,
-                          const std::string& category, TransactionType type);
+                          const std::string& category, TransactionType type,
+                          CurrencyCode currency = kDefaultCurrency, std::time_t date = 0);
     bool DeleteTransaction(int id);
     
-    // Data retrieval
-    const TransactionList& GetTransactions() const { return transactions_; }
-    TransactionList GetTransactionsByCategory(const std::string& category);
-    TransactionList GetTransactionsByType(TransactionType type);
+    // Bulk import of a CSV or OFX/QFX bank statement, inserted in batches.
+    // Rows already stored (same day, amount and description) are skipped, or
+    // merged when they bring a category for a stored "Other" row. Rows without
+    // a category get the suggested one. Returns false if the file cannot be
+    // read, an insert fails or progress cancels; batches committed before
+    // that point are kept and counted in the report.
+    bool ImportStatement(const std::string& path, ImportReport& report,
+                         StatementParser::Progress progress = nullptr);
     
-    // Analytics
+    // Data retrieval. GetTransactions() is for the owning (UI) thread and is
+    // valid until the next write; other threads should hold a GetSnapshot().
+    const TransactionSnapshot& GetTransactions() const { return *snapshot_; }
+    Snapshot GetSnapshot() const { return std::atomic_load(&snapshot_); }
+    std::uint64_t GetVersion() const { return snapshot_->GetVersion(); }
+    bool GetTransaction(int id, Transaction& transaction) const;
+    TransactionList GetTransactionsByCategory(const std::string& category) const;
+    TransactionList GetTransactionsByType(TransactionType type) const;
+    
+    // Rows matching any combination of conditions, newest first. Every row
+    // is cached, so the filter runs in memory over the rows its date bounds
+    // leave, found by binary search; DatabaseHandler::QueryTransactions()
+    // answers the same filter from storage.
+    TransactionList FindTransactions(const TransactionFilter& filter) const;
+    
+    // Date ranges run from from up to but not including to; a zero bound
+    // leaves that end open. The cache is in date order, so a range is two
+    // binary searches away and costs only the rows inside it. Totals are in
+    // the reporting currency.
+    TransactionList GetTransactionsInRange(std::time_t from, std::time_t to) const;
+    CurrencyConverter::Totals GetTotalsInRange(std::time_t from, std::time_t to) const;
+    
+    // Analytics, in the reporting currency. Each row is converted at the
+    // rate of its own date; rows in a currency without rates are left out
+    // and counted in GetReportTotals().unconverted. The totals are worked out
+    // in one pass the first time they are read after a write.
     double GetTotalIncome() const;
     double GetTotalExpenses() const;
     double GetBalance() const;
     double GetTotalByCategory(const std::string& category) const;
+    const CurrencyConverter::Totals& GetReportTotals() const;
+    
+    // Spending statistics over expenses in the reporting currency: median
+    // and 90th percentile per category, and the merchants taking the most.
+    // Answered from sketches kept per category and month, which follow added
+    // rows as they arrive and are rebuilt in one pass after edits or deletes.
+    // A zero bound leaves that end of the span open.
+    std::vector<CategorySpread> GetCategorySpread(std::time_t from = 0, std::time_t to = 0) const;
+    std::vector<MerchantSpend> GetTopMerchants(size_t count, std::time_t from = 0, std::time_t to = 0) const;
+    
+    // Balance and monthly flows for charts, in the reporting currency. Built
+    // in one pass the first time it is asked for after a write; the returned
+    // series is immutable and stays valid after later writes.
+    ChartSeries::Ptr GetChartSeries() const;
+    
+    // Projected balance from today to the end of options.months months
+    // ahead, in the reporting currency, with percentile bands (see
+    // CashFlowForecast). Fitted to monthly nets per category that follow
+    // every added, edited and deleted row, so only the first forecast after
+    // a reload or a rate change walks the rows.
+    CashFlowForecast::Ptr GetForecast(const ForecastOptions& options = ForecastOptions()) const;
+    
+    // Totals in any currency, from scratch; safe on any thread
+    CurrencyConverter::Totals GetTotals(CurrencyCode target) const;
+    
+    // Currencies. The reporting currency is kept in the ledger. Importing
+    // rates (see RateParser) stores them and rebuilds the in-memory rate
+    // cache; GetConverter() hands out the current cache to any thread.
+    CurrencyCode GetReportingCurrency() const { return reportingCurrency_; }
+    bool SetReportingCurrency(CurrencyCode currency);
+    bool ImportExchangeRates(const std::string& path, ImportReport& report);
+    CurrencyConverter::Ptr GetConverter() const { return std::atomic_load(&converter_); }
+    std::vector<CurrencyCode> GetCurrencies() const;
+    
+    // Running balance in the reporting currency (O(log n) via the balance index)
+    double GetRunningBalance(size_t row) const;
+    double GetBalanceAsOf(std::time_t date) const;
+    
+    // List view: snapshot rows that pass the description filter, in the order
+    // of the current sort keys. Rebuilt lazily the first time it is read after
+    // a write. A filter that extends the previous one only narrows its matches.
+    void SetSortKeys(std::vector<SortKey> keys);
+    const std::vector<SortKey>& GetSortKeys() const { return sortKeys_; }
+    void SetFilterText(const std::string& text);
+    const std::string& GetFilterText() const { return filterText_; }
+    const std::vector<std::uint32_t>& GetViewRows();
+    
+    // Period the list view and the period totals are limited to, bounded as
+    // for GetTransactionsInRange(); (0, 0) is all time. Changing it costs
+    // the rows in the period, not the ledger.
+    void SetPeriod(std::time_t from, std::time_t to);
+    std::time_t GetPeriodFrom() const { return periodFrom_; }
+    std::time_t GetPeriodTo() const { return periodTo_; }
+    bool HasPeriod() const { return periodFrom_ != 0 || periodTo_ != 0; }
+    
+    // Totals over the period and the balance at its end, in the reporting
+    // currency; worked out the first time they are read after a change
+    const CurrencyConverter::Totals& GetPeriodTotals() const;
+    double GetPeriodClosingBalance() const;
     
-    // Categories management
+    // Tags, any number per transaction, kept in the ledger; names are
+    // trimmed and ids that are not stored are skipped. Each tag keeps a
+    // compressed bitmap of its ids, so a query is a few bitmap operations,
+    // and tagged totals add up the matching ids from a column of amounts in
+    // the reporting currency (no per-category split). Tags written by other
+    // programs are picked up on the next full reload.
+    bool AddTag(int id, const std::string& tag);
+    bool RemoveTag(int id, const std::string& tag);
+    bool TagTransactions(const std::vector<int>& ids, const std::string& tag);
+    std::vector<std::string> GetTags() const { return tags_.GetTags(); }
+    std::vector<std::string> GetTags(int id) const { return tags_.GetTags(id); }
+    std::vector<int> FindTagged(const TagQuery& query) const;  // Ascending
+    CurrencyConverter::Totals GetTaggedTotals(const TagQuery& query) const;
+    
+    // Reconciliation against a CSV or OFX/QFX bank statement. The statement
+    // is matched against the cached rows of its own dates (see Reconciler)
+    // and, when mark is set, the matched rows are flagged reconciled in the
+    // ledger. Returns false if the file cannot be read or the flags cannot
+    // be stored. SetReconciled() sets or clears the flag by hand.
+    bool ReconcileStatement(const std::string& path, ReconcileReport& report,
+                            const ReconcileOptions& options = ReconcileOptions(), bool mark = true);
+    bool SetReconciled(const std::vector<int>& ids, bool reconciled);
+    
+    // Ids of the transactions whose description contains text, ascending.
+    // Unlike the view filter this keeps no state, so any thread may call it
+    // while writes are held off.
+    std::vector<int> SearchDescriptions(const std::string& text) const { return searchIndex_.Search(text); }
+    
+    // Categories management. Suggestions come from a model that learns from
+    // every stored description/category pair as it is added or edited.
     std::vector<std::string> GetCategories() const;
+    CategoryPrediction SuggestCategory(const std::string& description) const;
+    std::vector<CategoryPrediction> SuggestCategories(const std::vector<std::string>& descriptions) const;
+    
+    // Recurring transactions. MaterializeRecurring() writes every occurrence
+    // due by now in one batch and returns how many it created; the app runs
+    // it at startup, and adding a rule catches up on it immediately.
+    bool AddRecurringRule(RecurringRule rule, std::time_t start, size_t* created = nullptr);
+    bool DeleteRecurringRule(int id);
+    std::vector<RecurringRule> GetRecurringRules() const { return scheduler_.GetRules(); }
+    size_t MaterializeRecurring(std::time_t now = std::time(nullptr));
+    
+    // Undo and redo. Adding, editing, deleting, importing and (un)reconciling
+    // each leave a step in a journal kept in the ledger, so the history
+    // survives a restart; a step holds the rows it touched as they were,
+    // tags included, and replaying it swaps them with the rows as they are.
+    // A new step drops whatever was undone. Recurring rows, tag edits and
+    // changes made by other programs are not journaled.
+    bool CanUndo() const;
+    bool CanRedo() const;
+    std::string GetUndoLabel() const;  // Empty when there is nothing to undo
+    std::string GetRedoLabel() const;
+    bool Undo();
+    bool Redo();
+    
+    // Backups copy the open database on a worker thread; see BackupService.
+    // RestoreBackup() swaps a backup in place of the open database on the
+    // calling thread, then reloads the cache, indexes and recurring rules and
+    // catches up on recurring transactions. It refuses while a backup runs.
+    BackupService& GetBackups() { return *backups_; }
+    bool RestoreBackup(const std::string& path, DatabaseHandler::BackupProgress progress = nullptr);
     
-    // Observer pattern for UI updates
-    void RegisterObserver(Observer observer);
-    void UnregisterObserver(Observer observer);
+    // Group commit (see DatabaseHandler::SetDurability()). Whatever the mode,
+    // a write is in the cache, and visible to every reader in this process,
+    // when it returns. A batch the database rolls back on commit is noticed
+    // by the next write or CheckExternalChanges(), which reload the ledger.
+    bool SetDurability(const WriteBatching& batching) { return dbHandler_ && dbHandler_->SetDurability(batching); }
+    WriteBatching GetDurability() const { return dbHandler_->GetDurability(); }
+    bool FlushWrites() { return dbHandler_ && dbHandler_->FlushWrites(); }
+    CommitStats GetCommitStats() const { return dbHandler_->GetCommitStats(); }
     
-    // Data refresh
+    // Storage upkeep (see DatabaseHandler::CompactStorage()). Compacting
+    // leaves the rows, and so the cache, as they were; it refuses while a
+    // backup runs. RunMaintenance() is meant for the same timer that polls
+    // for external changes.
+    StorageStats GetStorageStats() const { return dbHandler_->GetStorageStats(); }
+    bool CompactStorage(StorageStats& before, StorageStats& after);
+    void RunMaintenance(std::time_t now);
+    
+    // Observer pattern for UI updates. The returned token unregisters it.
+    int RegisterObserver(Observer observer);
+    void UnregisterObserver(int token);
+    
+    // Data refresh. RefreshData() reloads everything; CheckExternalChanges()
+    // is cheap enough to poll: it returns false at once unless another program
+    // has committed to the database since the last look, and then reads back
+    // only the id ranges that were written to since.
     void RefreshData();
+    bool CheckExternalChanges();
     
     bool IsInitialized() const { return dbHandler_ && dbHandler_->IsConnected(); }
+    
+    // Rough heap footprint of the cache and its indexes, from the row count
+    // and text lengths; walks every cached row
+    size_t GetMemoryUsage() const;
 
 private:
     std::unique_ptr<DatabaseHandler> dbHandler_;
-    TransactionList transactions_;
-    std::vector<Observer> observers_;
+    std::unique_ptr<BackupService> backups_; // Stops before dbHandler_ closes
+    Snapshot snapshot_;
+    BalanceIndex balanceIndex_;
+    DuplicateIndex duplicates_;
+    RecurringScheduler scheduler_;
+    CurrencyConverter::Ptr converter_;
+    CurrencyCode reportingCurrency_;
+    mutable CurrencyConverter::Totals reportTotals_;
+    mutable std::uint64_t reportVersion_;  // Snapshot version the totals are for
+    mutable bool reportStale_;
+    CurrencyConverter::Conversion reportConversion_;
+    mutable SpendingStats spending_;
+    mutable DayCursor spendingDays_;
+    mutable bool spendingStale_;
+    mutable MonthlyFlows flows_;
+    mutable bool flowsStale_;
+    mutable ChartSeries::Ptr chart_;
+    mutable std::uint64_t chartVersion_;  // Snapshot version chart_ is for
+    std::int64_t dataVersion_;
+    bool balanceStale_;
+    std::vector<BucketChanges> bucketChanges_;
+    std::int64_t knownMaxId_;
+    std::uint64_t lostBatches_;  // CommitStats::lostBatches already reloaded for
+    std::vector<std::pair<int, Observer>> observers_;
+    std::vector<JournalStep> journal_;  // Oldest first; the undone steps come last
+    int nextObserverToken_;
+    
+    TransactionSorter sorter_;
+    std::vector<SortKey> sortKeys_;
+    std::vector<std::uint32_t> sortedRows_;
+    std::uint64_t sortedVersion_;
+    bool sortDirty_;
+    
+    TrigramIndex searchIndex_;
+    Categorizer categorizer_;
+    std::string filterText_;
+    std::vector<int> filterIds_;
+    bool filterStale_;
+    std::vector<std::uint32_t> viewRows_;
+    bool viewDirty_;
+    std::time_t periodFrom_;
+    std::time_t periodTo_;
+    mutable CurrencyConverter::Totals periodTotals_;
+    mutable double periodBalance_;
+    mutable std::uint64_t periodVersion_;
+    mutable bool periodStale_;
+    TagIndex tags_;
+    mutable RoaringBitmap allIds_;             // Every cached id, for queries that only exclude tags
+    mutable std::uint64_t allIdsVersion_;
+    mutable std::unordered_map<int, double> amountsById_;  // Signed, reporting currency; NaN unconverted
+    mutable std::uint64_t amountsVersion_;
+    mutable bool amountsStale_;
     
     void NotifyObservers();
     void LoadTransactions();
+    void LoadCurrencies();
+    void Publish(Snapshot next);
+    size_t FindRow(int id) const;
+    void InsertIntoCache(const Transaction& transaction);
+    void ReplaceInCache(size_t row, const Transaction& transaction);
+    void EraseFromCache(size_t row);
+    void ApplyCapturedChanges(const char* label = nullptr);
+    bool ReloadIfBatchLost();
+    bool WriteFailed();
+    void LoadJournal();
+    JournalImage ImageOf(int id) const;
+    void Journal(const std::string& label, const std::vector<JournalImage>& images);
+    bool Replay(bool undo);
+    void SyncChangeMarkers();
+    std::vector<int> CachedIds(std::int64_t first, std::int64_t last) const;
+    void ReconcileRanges(std::vector<std::pair<std::int64_t, std::int64_t>> ranges);
+    void ApplyFilter();
+    void RowsInRange(std::time_t from, std::time_t to, size_t& first, size_t& last) const;
+    void AssignCategories(std::vector<Transaction>& rows) const;
+    bool ToReporting(const Transaction& transaction, double& amount, std::int32_t& day) const;
+    void AddToSpending(const Transaction& transaction) const;
+    void AddToFlows(const Transaction& transaction, bool add) const;
+    const MonthlyFlows& GetFlows() const;
+    const SpendingStats& GetSpending() const;
+    SpendingStats::Month MonthOf(std::time_t date) const;
     int GetNextId() const;
-}; 
\ No newline at end of file
+    RoaringBitmap FindTaggedIds(const TagQuery& query) const;
+};
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "TransactionSnapshot.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    // True when a sorts before (date, id) in date DESC, id DESC order
+    bool SortsBefore(const Transaction& a, std::time_t date, int id) {
+        return a.date != date ? a.date > date : a.id > id;
+    }
+}
+
+TransactionSnapshot::Ptr TransactionSnapshot::Create(std::vector<Transaction> rows, std::uint64_t version) {
+    auto snapshot = std::make_shared<TransactionSnapshot>();
+    snapshot->version_ = version;
+    snapshot->size_ = rows.size();
+    snapshot->chunks_.reserve((rows.size() + kChunkSize - 1) / kChunkSize);
+    
+    for (size_t begin = 0; begin < rows.size(); begin += kChunkSize) {
+        size_t end = std::min(begin + kChunkSize, rows.size());
+        snapshot->chunks_.push_back(std::make_shared<const Chunk>(
+            std::make_move_iterator(rows.begin() + begin), std::make_move_iterator(rows.begin() + end)));
+    }
+    
+    snapshot->RebuildStarts();
+    return snapshot;
+}
+
+TransactionSnapshot::Ptr TransactionSnapshot::WithInserted(size_t row, const Transaction& transaction) const {
+    auto next = std::make_shared<TransactionSnapshot>(*this);
+    next->version_ = version_ + 1;
+    next->size_ = size_ + 1;
+    
+    if (chunks_.empty()) {
+        next->chunks_.push_back(std::make_shared<const Chunk>(1, transaction));
+        next->RebuildStarts();
+        return next;
+    }
+    
+    // Appending past the end extends the last chunk
+    size_t chunk = row >= size_ ? chunks_.size() - 1 : ChunkOf(row);
+    Chunk rows = *chunks_[chunk];
+    rows.insert(rows.begin() + (std::min(row, size_) - starts_[chunk]), transaction);
+    
+    if (rows.size() > 2 * kChunkSize) {
+        auto middle = rows.begin() + rows.size() / 2;
+        next->chunks_[chunk] = std::make_shared<const Chunk>(rows.begin(), middle);
+        next->chunks_.insert(next->chunks_.begin() + chunk + 1, std::make_shared<const Chunk>(middle, rows.end()));
+    } else {
+        next->chunks_[chunk] = std::make_shared<const Chunk>(std::move(rows));
+    }
+    
+    next->RebuildStarts();
+    return next;
+}
+
+TransactionSnapshot::Ptr TransactionSnapshot::WithReplaced(size_t row, const Transaction& transaction) const {
+    size_t chunk = ChunkOf(row);
+    Chunk rows = *chunks_[chunk];
+    rows[row - starts_[chunk]] = transaction;
+    
+    auto next = std::make_shared<TransactionSnapshot>(*this);
+    next->version_ = version_ + 1;
+    next->chunks_[chunk] = std::make_shared<const Chunk>(std::move(rows));
+    return next;
+}
+
+TransactionSnapshot::Ptr TransactionSnapshot::WithErased(size_t row) const {
+    size_t chunk = ChunkOf(row);
+    auto next = std::make_shared<TransactionSnapshot>(*this);
+    next->version_ = version_ + 1;
+    next->size_ = size_ - 1;
+    
+    if (chunks_[chunk]->size() == 1) {
+        next->chunks_.erase(next->chunks_.begin() + chunk);
+    } else {
+        Chunk rows = *chunks_[chunk];
+        rows.erase(rows.begin() + (row - starts_[chunk]));
+        next->chunks_[chunk] = std::make_shared<const Chunk>(std::move(rows));
+    }
+    
+    next->RebuildStarts();
+    return next;
+}
+
+const Transaction& TransactionSnapshot::operator[](size_t row) const {
+    size_t chunk = ChunkOf(row);
+    return (*chunks_[chunk])[row - starts_[chunk]];
+}
+
+TransactionSnapshot::const_iterator TransactionSnapshot::IteratorAt(size_t row) const {
+    if (row >= size_) {
+        return end();
+    }
+    
+    size_t chunk = ChunkOf(row);
+    return const_iterator(&chunks_, chunk, row - starts_[chunk]);
+}
+
+size_t TransactionSnapshot::LowerBound(std::time_t date, int id) const {
+    // Find the first chunk whose last row does not sort before the key
+    auto chunk = std::partition_point(chunks_.begin(), chunks_.end(), [&](const ChunkPtr& rows) {
+        return SortsBefore(rows->back(), date, id);
+    });
+    if (chunk == chunks_.end()) {
+        return size_;
+    }
+    
+    auto position = std::partition_point((*chunk)->begin(), (*chunk)->end(), [&](const Transaction& transaction) {
+        return SortsBefore(transaction, date, id);
+    });
+    size_t index = static_cast<size_t>(chunk - chunks_.begin());
+    return starts_[index] + static_cast<size_t>(position - (*chunk)->begin());
+}
+
+size_t TransactionSnapshot::ChunkOf(size_t row) const {
+    if (row >= size_) {
+        throw std::out_of_range("TransactionSnapshot row out of range");
+    }
+    
+    auto it = std::upper_bound(starts_.begin(), starts_.end(), row);
+    return static_cast<size_t>(it - starts_.begin()) - 1;
+}
+
+void TransactionSnapshot::RebuildStarts() {
+    starts_.resize(chunks_.size());
+    size_t start = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        starts_[i] = start;
+        start += chunks_[i]->size();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <ctime>
+
+// Immutable, versioned view of the cached transactions (date DESC, id DESC).
+// Rows live in fixed-size chunks that are shared between versions, so a
+// write only copies the chunk it touches plus the chunk table. Readers hold
+// a shared_ptr to a version and never see it change underneath them.
+class TransactionSnapshot {
+public:
+    using Chunk = std::vector<Transaction>;
+    using ChunkPtr = std::shared_ptr<const Chunk>;
+    using Ptr = std::shared_ptr<const TransactionSnapshot>;
+    
+    static constexpr size_t kChunkSize = 512;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Transaction;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Transaction*;
+        using reference = const Transaction&;
+        
+        const_iterator(const std::vector<ChunkPtr>* chunks, size_t chunk, size_t offset)
+            : chunks_(chunks), chunk_(chunk), offset_(offset) {}
+        
+        reference operator*() const { return (*(*chunks_)[chunk_])[offset_]; }
+        pointer operator->() const { return &**this; }
+        
+        const_iterator& operator++() {
+            if (++offset_ == (*chunks_)[chunk_]->size()) {
+                ++chunk_;
+                offset_ = 0;
+            }
+            return *this;
+        }
+        
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        
+        bool operator==(const const_iterator& other) const {
+            return chunk_ == other.chunk_ && offset_ == other.offset_;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    
+    private:
+        const std::vector<ChunkPtr>* chunks_;
+        size_t chunk_;
+        size_t offset_;
+    };
+    
+    TransactionSnapshot() = default;
+    
+    // Version builders. Each returns a new snapshot with version + 1 that
+    // shares every untouched chunk with this one.
+    static Ptr Create(std::vector<Transaction> rows, std::uint64_t version);
+    Ptr WithInserted(size_t row, const Transaction& transaction) const;
+    Ptr WithReplaced(size_t row, const Transaction& transaction) const;
+    Ptr WithErased(size_t row) const;
+    
+    // Read access
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Transaction& operator[](size_t row) const;
+    const_iterator begin() const { return const_iterator(&chunks_, 0, 0); }
+    const_iterator end() const { return const_iterator(&chunks_, chunks_.size(), 0); }
+    const_iterator IteratorAt(size_t row) const;  // end() from size() on
+    std::uint64_t GetVersion() const { return version_; }
+    
+    // First row that does not sort before (date, id) in date DESC, id DESC order
+    size_t LowerBound(std::time_t date, int id) const;
+    
+    // First row dated before date. Rows dated in [from, to) are the run
+    // [FirstBefore(to), FirstBefore(from)).
+    size_t FirstBefore(std::time_t date) const { return LowerBound(date - 1, std::numeric_limits<int>::max()); }
+
+private:
+    std::vector<ChunkPtr> chunks_;
+    std::vector<size_t> starts_;  // First row index of each chunk
+    size_t size_ = 0;
+    std::uint64_t version_ = 0;
+    
+    size_t ChunkOf(size_t row) const;
+    void RebuildStarts();
+};
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "TransactionSorter.h"
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <unordered_map>
+#include <cctype>
+#include <cmath>
+
+namespace {
+    constexpr size_t kParallelThreshold = 1 << 16;
+    constexpr int kRadixBits = 8;
+    constexpr size_t kBuckets = size_t(1) << kRadixBits;
+    
+    struct Entry {
+        std::uint64_t key;
+        std::uint32_t row;
+    };
+    
+    std::uint64_t FlipSign(std::int64_t value) {
+        return static_cast<std::uint64_t>(value) ^ (std::uint64_t(1) << 63);
+    }
+    
+    char Fold(char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    
+    bool IsText(SortColumn column) {
+        return column == SortColumn::Description || column == SortColumn::Category;
+    }
+    
+    // Runs body(part) for part in [0, parts), one thread per part
+    template <typename Body>
+    void ParallelFor(size_t parts, Body body) {
+        std::vector<std::thread> workers;
+        workers.reserve(parts > 0 ? parts - 1 : 0);
+        for (size_t part = 1; part < parts; ++part) {
+            workers.emplace_back(body, part);
+        }
+        if (parts > 0) {
+            body(0);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    // Stable LSD radix sort on Entry::key. Digits where every key agrees are
+    // skipped, so narrow keys (ranks, cents, dates) take only a few passes.
+    void RadixSort(std::vector<Entry>& entries, size_t parts) {
+        const size_t count = entries.size();
+        if (count < 2) {
+            return;
+        }
+        
+        auto partBegin = [&](size_t part) { return count * part / parts; };
+        std::vector<Entry> buffer(count);
+        std::vector<std::array<size_t, kBuckets>> offsets(parts);
+        
+        // Bits that differ from the first key anywhere in the input
+        std::vector<std::uint64_t> partMasks(parts, 0);
+        ParallelFor(parts, [&](size_t part) {
+            for (size_t i = partBegin(part); i < partBegin(part + 1); ++i) {
+                partMasks[part] |= entries[i].key ^ entries[0].key;
+            }
+        });
+        std::uint64_t varying = 0;
+        for (std::uint64_t mask : partMasks) {
+            varying |= mask;
+        }
+        
+        for (int shift = 0; shift < 64; shift += kRadixBits) {
+            if (((varying >> shift) & (kBuckets - 1)) == 0) {
+                continue;
+            }
+            
+            ParallelFor(parts, [&](size_t part) {
+                offsets[part].fill(0);
+                for (size_t i = partBegin(part); i < partBegin(part + 1); ++i) {
+                    ++offsets[part][(entries[i].key >> shift) & (kBuckets - 1)];
+                }
+            });
+            
+            // Turn per-part counts into scatter offsets: bucket-major, then part
+            // order, which keeps equal digits in their current relative order
+            size_t running = 0;
+            bool trivial = false;
+            for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+                size_t bucketTotal = 0;
+                for (size_t part = 0; part < parts; ++part) {
+                    size_t bucketCount = offsets[part][bucket];
+                    offsets[part][bucket] = running;
+                    running += bucketCount;
+                    bucketTotal += bucketCount;
+                }
+                trivial = trivial || bucketTotal == count;
+            }
+            if (trivial) {
+                continue;
+            }
+            
+            ParallelFor(parts, [&](size_t part) {
+                auto& next = offsets[part];
+                for (size_t i = partBegin(part); i < partBegin(part + 1); ++i) {
+                    buffer[next[(entries[i].key >> shift) & (kBuckets - 1)]++] = entries[i];
+                }
+            });
+            entries.swap(buffer);
+        }
+    }
+}
+
+std::vector<std::uint32_t> TransactionSorter::Sort(const TransactionSnapshot& rows, const std::vector<SortKey>& keys) {
+    const size_t count = rows.size();
+    std::vector<Entry> entries(count);
+    for (size_t i = 0; i < count; ++i) {
+        entries[i] = {0, static_cast<std::uint32_t>(i)};
+    }
+    
+    size_t parts = 1;
+    if (count >= kParallelThreshold) {
+        parts = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    
+    // Least-significant key first; each stable pass preserves the earlier order among ties
+    for (auto key = keys.rbegin(); key != keys.rend(); ++key) {
+        const std::vector<std::uint64_t>& column = KeysFor(rows, key->column);
+        const bool ascending = key->ascending;
+        ParallelFor(parts, [&](size_t part) {
+            for (size_t i = count * part / parts; i < count * (part + 1) / parts; ++i) {
+                std::uint64_t value = column[entries[i].row];
+                entries[i].key = ascending ? value : ~value;
+            }
+        });
+        RadixSort(entries, parts);
+    }
+    
+    std::vector<std::uint32_t> order(count);
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = entries[i].row;
+    }
+    return order;
+}
+
+const std::vector<std::uint64_t>& TransactionSorter::KeysFor(const TransactionSnapshot& rows, SortColumn column) {
+    if (!hasCache_ || cachedVersion_ != rows.GetVersion()) {
+        keyCache_.clear();
+        cachedVersion_ = rows.GetVersion();
+        hasCache_ = true;
+    }
+    
+    auto cached = keyCache_.find(column);
+    if (cached != keyCache_.end()) {
+        return cached->second;
+    }
+    
+    std::vector<std::uint64_t> values;
+    if (IsText(column)) {
+        values = TextRanks(rows, column);
+    } else {
+        values.reserve(rows.size());
+        for (const auto& transaction : rows) {
+            values.push_back(NumericKey(transaction, column));
+        }
+    }
+    
+    return keyCache_.emplace(column, std::move(values)).first->second;
+}
+
+std::uint64_t TransactionSorter::NumericKey(const Transaction& transaction, SortColumn column) {
+    switch (column) {
+        case SortColumn::Id:
+            return FlipSign(transaction.id);
+        case SortColumn::Date:
+            return FlipSign(static_cast<std::int64_t>(transaction.date));
+        case SortColumn::Type:
+            return static_cast<std::uint64_t>(transaction.type);
+        case SortColumn::Amount:
+            return FlipSign(std::llround(transaction.amount * 100.0));
+        case SortColumn::Description:
+        case SortColumn::Category:
+            break;
+    }
+    return 0;
+}
+
+std::vector<std::uint64_t> TransactionSorter::TextRanks(const TransactionSnapshot& rows, SortColumn column) {
+    // Intern each case-folded value, sort only the distinct values, then
+    // hand every row the rank of its value
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::vector<const std::string*> distinct;
+    std::vector<std::uint32_t> rowIds;
+    rowIds.reserve(rows.size());
+    std::string folded;
+    
+    for (const auto& transaction : rows) {
+        const std::string& text = column == SortColumn::Description ? transaction.description : transaction.category;
+        folded.resize(text.size());
+        std::transform(text.begin(), text.end(), folded.begin(), Fold);
+        
+        auto it = ids.find(folded);
+        if (it == ids.end()) {
+            it = ids.emplace(folded, static_cast<std::uint32_t>(distinct.size())).first;
+            distinct.push_back(&it->first);
+        }
+        rowIds.push_back(it->second);
+    }
+    
+    std::vector<std::uint32_t> byValue(distinct.size());
+    for (size_t i = 0; i < byValue.size(); ++i) {
+        byValue[i] = static_cast<std::uint32_t>(i);
+    }
+    std::sort(byValue.begin(), byValue.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return *distinct[a] < *distinct[b];
+    });
+    
+    std::vector<std::uint64_t> rankOfId(distinct.size());
+    for (size_t rank = 0; rank < byValue.size(); ++rank) {
+        rankOfId[byValue[rank]] = rank;
+    }
+    
+    std::vector<std::uint64_t> ranks(rowIds.size());
+    for (size_t row = 0; row < rowIds.size(); ++row) {
+        ranks[row] = rankOfId[rowIds[row]];
+    }
+    return ranks;
+}
\ No newline at end of file
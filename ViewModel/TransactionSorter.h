@@ -0,0 +1,39 @@
+#pragma once
+#include "TransactionSnapshot.h"
+#include <vector>
+#include <map>
+#include <cstdint>
+
+enum class SortColumn {
+    Id,
+    Date,
+    Description,
+    Category,
+    Type,
+    Amount
+};
+
+struct SortKey {
+    SortColumn column;
+    bool ascending;
+};
+
+// Multi-key stable sort of snapshot rows into a permutation index.
+// Each column is normalized once per snapshot version into order-preserving
+// 64-bit keys (text columns become the rank of their case-folded value) and
+// cached, so re-sorting or flipping direction never touches the rows again.
+// Keys are applied least-significant first with an LSD radix sort, whose
+// counting and scatter passes are split across threads for large inputs.
+class TransactionSorter {
+public:
+    std::vector<std::uint32_t> Sort(const TransactionSnapshot& rows, const std::vector<SortKey>& keys);
+
+private:
+    std::uint64_t cachedVersion_ = 0;
+    bool hasCache_ = false;
+    std::map<SortColumn, std::vector<std::uint64_t>> keyCache_;
+    
+    const std::vector<std::uint64_t>& KeysFor(const TransactionSnapshot& rows, SortColumn column);
+    static std::uint64_t NumericKey(const Transaction& transaction, SortColumn column);
+    static std::vector<std::uint64_t> TextRanks(const TransactionSnapshot& rows, SortColumn column);
+};
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <cctype>
+
+void TrigramIndex::Clear() {
+    postings_.clear();
+    foldedById_.clear();
+}
+
+void TrigramIndex::Add(int id, const std::string& text) {
+    Remove(id);
+    const std::string& folded = foldedById_[id] = Fold(text);
+    
+    for (std::uint32_t gram : Grams(folded)) {
+        std::vector<int>& ids = postings_[gram];
+        // New ids are almost always the largest, so this is usually a push_back
+        if (ids.empty() || ids.back() < id) {
+            ids.push_back(id);
+        } else {
+            ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+        }
+    }
+}
+
+void TrigramIndex::Remove(int id) {
+    auto entry = foldedById_.find(id);
+    if (entry == foldedById_.end()) {
+        return;
+    }
+    
+    for (std::uint32_t gram : Grams(entry->second)) {
+        auto it = postings_.find(gram);
+        if (it == postings_.end()) {
+            continue;
+        }
+        
+        std::vector<int>& ids = it->second;
+        auto position = std::lower_bound(ids.begin(), ids.end(), id);
+        if (position != ids.end() && *position == id) {
+            ids.erase(position);
+        }
+        if (ids.empty()) {
+            postings_.erase(it);
+        }
+    }
+    
+    foldedById_.erase(entry);
+}
+
+void TrigramIndex::Update(int id, const std::string& text) {
+    Remove(id);
+    Add(id, text);
+}
+
+std::vector<int> TrigramIndex::Search(const std::string& query) const {
+    std::string folded = Fold(query);
+    std::vector<int> result;
+    
+    std::vector<std::uint32_t> grams = Grams(folded);
+    if (grams.empty()) {
+        // Too short to index: check every entry
+        for (const auto& entry : foldedById_) {
+            if (entry.second.find(folded) != std::string::npos) {
+                result.push_back(entry.first);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+    
+    std::vector<const std::vector<int>*> lists;
+    for (std::uint32_t gram : grams) {
+        auto it = postings_.find(gram);
+        if (it == postings_.end()) {
+            return result;
+        }
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<int>* a, const std::vector<int>* b) {
+        return a->size() < b->size();
+    });
+    
+    // Intersect shortest-first so the working set only shrinks
+    std::vector<int> candidates = *lists.front();
+    std::vector<int> next;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        next.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(next));
+        candidates.swap(next);
+    }
+    
+    // Every gram present does not mean they are adjacent; confirm on the text
+    if (grams.size() == 1 && folded.size() == 3) {
+        return candidates;
+    }
+    for (int id : candidates) {
+        if (Contains(id, folded)) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+
+std::vector<int> TrigramIndex::Refine(const std::vector<int>& candidates, const std::string& query) const {
+    std::string folded = Fold(query);
+    std::vector<int> result;
+    result.reserve(candidates.size());
+    
+    for (int id : candidates) {
+        if (Contains(id, folded)) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+
+bool TrigramIndex::Contains(int id, const std::string& foldedQuery) const {
+    auto entry = foldedById_.find(id);
+    return entry != foldedById_.end() && entry->second.find(foldedQuery) != std::string::npos;
+}
+
+std::string TrigramIndex::Fold(const std::string& text) {
+    std::string folded(text.size(), '\0');
+    std::transform(text.begin(), text.end(), folded.begin(), [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+    return folded;
+}
+
+std::vector<std::uint32_t> TrigramIndex::Grams(const std::string& folded) {
+    std::vector<std::uint32_t> grams;
+    if (folded.size() < 3) {
+        return grams;
+    }
+    
+    grams.reserve(folded.size() - 2);
+    for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+        grams.push_back((static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i])) << 16) |
+                        (static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i + 1])) << 8) |
+                        static_cast<std::uint32_t>(static_cast<unsigned char>(folded[i + 2])));
+    }
+    
+    // A repeated gram contributes one posting
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
\ No newline at end of file
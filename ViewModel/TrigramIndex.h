@@ -0,0 +1,54 @@
+#pragma once
+#include "../Model/Transaction.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <algorithm>
+
+// Case-insensitive substring index over transaction descriptions.
+// Each folded description is split into overlapping 3-byte grams with a
+// posting list of ids per gram. A query intersects the postings of its own
+// grams, shortest first, and then checks the few survivors directly.
+// Add/Update/Remove keep the index current without a rebuild.
+class TrigramIndex {
+public:
+    template <typename Range>
+    void Build(const Range& transactions) {
+        Clear();
+        // Ascending ids keep every posting insert a push_back; the cache
+        // order (newest first) would make each one an insert at the front
+        std::vector<const Transaction*> ordered;
+        for (const auto& transaction : transactions) {
+            ordered.push_back(&transaction);
+        }
+        std::sort(ordered.begin(), ordered.end(), [](const Transaction* a, const Transaction* b) {
+            return a->id < b->id;
+        });
+        for (const Transaction* transaction : ordered) {
+            Add(transaction->id, transaction->description);
+        }
+    }
+    void Clear();
+    
+    void Add(int id, const std::string& text);
+    void Remove(int id);
+    void Update(int id, const std::string& text);
+    
+    // Ids whose text contains query, ascending
+    std::vector<int> Search(const std::string& query) const;
+    
+    // Subset of candidates whose text contains query. Used when a query
+    // extends the previous one, so each keystroke narrows the last result.
+    std::vector<int> Refine(const std::vector<int>& candidates, const std::string& query) const;
+    
+    size_t Size() const { return foldedById_.size(); }
+
+private:
+    std::unordered_map<std::uint32_t, std::vector<int>> postings_;  // Sorted ids per gram
+    std::unordered_map<int, std::string> foldedById_;                // Keyed, not indexed: ids can be sparse
+    
+    bool Contains(int id, const std::string& foldedQuery) const;
+    static std::string Fold(const std::string& text);
+    static std::vector<std::uint32_t> Grams(const std::string& folded);
+};
\ No newline at end of file
@@ -1,7 +1,19 @@
 #include <wx/wx.h>
 #include "View/MainWindow.h"
 #include "ViewModel/TransactionManager.h"
+#include "ViewModel/LedgerRegistry.h"
+#ifndef _WIN32
+#include "Server/QueryServer.h"
+#include <csignal>
+#include <cstdlib>
+#endif
 #include <iostream>
+#include <string>
+
+namespace {
+    const char* const kDatabasePath = "finance_tracker.db";
+    const char* const kLedgerListPath = "ledgers.conf";
+}
 
 class PersonalFinanceApp : public wxApp {
 public:
@@ -9,31 +21,164 @@ public:
     virtual int OnExit() override;
 
 private:
-    std::unique_ptr<TransactionManager> transactionManager_;
+    std::unique_ptr<LedgerRegistry> ledgers_;
 };
 
 bool PersonalFinanceApp::OnInit() {
-    // Initialize the transaction manager with database
-    std::string dbPath = "finance_tracker.db";
-    transactionManager_ = std::make_unique<TransactionManager>(dbPath);
+    // Without a ledger list this is a single-ledger install
+    ledgers_ = std::make_unique<LedgerRegistry>(kLedgerListPath);
+    if (!ledgers_->Load()) {
+        ledgers_->AddLedger("Personal", kDatabasePath);
+    }
+    
+    // Reopen the ledger used last, falling back to the others in list order.
+    // Opening catches up on recurring transactions that fell due while the
+    // app was closed and starts daily backups.
+    std::vector<std::string> candidates{ledgers_->GetCurrentName()};
+    for (const auto& ledger : ledgers_->GetLedgers()) {
+        candidates.push_back(ledger.name);
+    }
+    size_t recurringAdded = 0;
+    TransactionManager* manager = nullptr;
+    for (size_t i = 0; i < candidates.size() && !manager; ++i) {
+        manager = ledgers_->Open(candidates[i], &recurringAdded);
+    }
     
-    if (!transactionManager_->IsInitialized()) {
+    if (!manager) {
         wxMessageBox("Failed to initialize database. The application will exit.", 
                      "Database Error", wxOK | wxICON_ERROR);
         return false;
     }
     
     // Create and show the main window
-    MainWindow* mainWindow = new MainWindow(*transactionManager_);
+    MainWindow* mainWindow = new MainWindow(*ledgers_);
     mainWindow->Show(true);
     
+    if (recurringAdded > 0) {
+        mainWindow->SetStatusText(wxString::Format("Added %lu recurring transactions",
+                                                   static_cast<unsigned long>(recurringAdded)));
+    }
+    
     return true;
 }
 
 int PersonalFinanceApp::OnExit() {
-    // Cleanup will be handled automatically by smart pointers
+    // Remember the ledger in use for next time; the rest is cleaned up by
+    // smart pointers
+    if (ledgers_) {
+        ledgers_->Save();
+    }
     return wxApp::OnExit();
 }
 
+#ifdef _WIN32
+
 // Implement the application
-wxIMPLEMENT_APP(PersonalFinanceApp); 
\ No newline at end of file
+wxIMPLEMENT_APP(PersonalFinanceApp);
+
+#else
+
+namespace {
+    QueryServer* activeServer = nullptr;
+    
+    void StopServer(int) {
+        if (activeServer) {
+            activeServer->Stop();
+        }
+    }
+    
+    // Headless mode: serve the ledger over a local socket without starting wx,
+    // so it also runs where there is no display.
+    //   --server [--db PATH] [--socket PATH] [--readers N] [--durability strict|group|relaxed] [--compact]
+    // --compact rewrites the ledger in its compact form (see
+    // DatabaseHandler::CompactStorage()) before serving it; a ledger with
+    // no free space to give back can come out slightly larger.
+    int RunServer(int argc, char* argv[]) {
+        const char* const usage = " --server [--db PATH] [--socket PATH] [--readers N]"
+                                  " [--durability strict|group|relaxed] [--compact]";
+        std::string dbPath = kDatabasePath;
+        QueryServer::Options options;
+        WriteBatching batching;
+        bool compact = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument == "--server") {
+                continue;
+            }
+            if (argument == "--compact") {
+                compact = true;
+                continue;
+            }
+            if (i + 1 >= argc || (argument != "--db" && argument != "--socket" && argument != "--readers" &&
+                                  argument != "--durability")) {
+                std::cerr << "Usage: " << argv[0] << usage << std::endl;
+                return 2;
+            }
+            
+            std::string value = argv[++i];
+            if (argument == "--db") {
+                dbPath = value;
+            } else if (argument == "--socket") {
+                options.socketPath = value;
+            } else if (argument == "--readers") {
+                options.readers = static_cast<size_t>(std::strtoul(value.c_str(), nullptr, 10));
+            } else if (value == "strict" || value == "group" || value == "relaxed") {
+                batching.durability = value == "strict" ? Durability::Strict
+                                      : value == "group" ? Durability::Group : Durability::Relaxed;
+            } else {
+                std::cerr << "Usage: " << argv[0] << usage << std::endl;
+                return 2;
+            }
+        }
+        
+        TransactionManager manager(dbPath);
+        if (!manager.IsInitialized()) {
+            std::cerr << "Failed to open " << dbPath << std::endl;
+            return 1;
+        }
+        if (compact) {
+            StorageStats before, after;
+            if (!manager.CompactStorage(before, after)) {
+                std::cerr << "Failed to compact " << dbPath << std::endl;
+                return 1;
+            }
+            std::cout << "Compacted " << dbPath << ": " << before.GetBytes() << " bytes in " << before.pages
+                      << " pages (" << before.freePages << " free) before, " << after.GetBytes() << " bytes in "
+                      << after.pages << " pages after" << std::endl;
+        }
+        if (!manager.SetDurability(batching)) {
+            std::cerr << "Failed to set durability on " << dbPath << std::endl;
+            return 1;
+        }
+        manager.GetBackups().SetSchedule("backups", "finance_tracker", 24 * 60 * 60, 7);
+        manager.MaterializeRecurring();
+        
+        QueryServer server(manager, options);
+        if (!server.Start()) {
+            return 1;
+        }
+        
+        activeServer = &server;
+        std::signal(SIGINT, StopServer);
+        std::signal(SIGTERM, StopServer);
+        std::cout << "Serving " << dbPath << " on " << options.socketPath << std::endl;
+        server.Run();
+        activeServer = nullptr;
+        return 0;
+    }
+}
+
+// wxWidgets is only started for the window; --server runs without it
+wxIMPLEMENT_APP_NO_MAIN(PersonalFinanceApp);
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--server") {
+            return RunServer(argc, argv);
+        }
+    }
+    
+    return wxEntry(argc, argv);
+}
+
+#endif
\ No newline at end of file